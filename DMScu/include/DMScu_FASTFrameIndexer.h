@@ -0,0 +1,248 @@
+// Hossein Moein
+// March 25, 2018
+// Copyright (C) 2018-2019 Hossein Moein
+// Distributed under the BSD Software License (see file License)
+
+// ----------------------------------------------------------------------------
+
+#pragma once
+
+#include <stdint.h>
+#include <stdexcept>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif // __SSE2__
+
+#include <DMScu_FixedSizeString.h>
+#include <DMScu_FASTProtocolUtilities.h>
+
+// ----------------------------------------------------------------------------
+
+// This class finds the frames in a buffer of FAST framed messages, the
+// way FixedSizeSocket and Framer send them: each message is a FAST
+// encoded unsigned length followed by that many bytes of body. One
+// index() call walks the whole buffer and fills an array of frame
+// descriptors, so a batch of messages can be handed to worker threads or
+// processed in a tight loop without parsing headers in between, e.g.
+//
+//     DMScu_FASTFrameIndexer::Frame   frames [256];
+//     unsigned int                    consumed;
+//     const   unsigned int            count =
+//         DMScu_FASTFrameIndexer::index (buffer, received,
+//                                        frames, 256, consumed);
+//
+//     for (unsigned int i = 0; i < count; ++i)  {
+//         if (i + DMScu_FASTFrameIndexer::PREFETCH_DISTANCE < count)
+//             DMScu_FASTFrameIndexer::prefetch (
+//                 buffer,
+//                 frames [i + DMScu_FASTFrameIndexer::PREFETCH_DISTANCE]);
+//         process (buffer + frames [i].offset, frames [i].length);
+//     }
+//     ::memmove (buffer, buffer + consumed, received - consumed);
+//
+// index() prefetches the buffer ahead of the header it is at, so it runs
+// at about memory speed over buffers much larger than the cache.
+// Headers of 1 or 2 bytes (messages under 16K) are tested byte by byte.
+// Longer headers are found with one SSE2 load and movemask, which gives
+// the stop bits of 16 bytes at once and also rejects overlong headers,
+// and their groups are packed without a loop. The body of a frame is
+// never read.
+//
+class   DMScu_FASTFrameIndexer  {
+
+    public:
+
+        typedef DMScu_FASTProtocolUtilities FAST;
+        typedef FAST::size_type             size_type;
+        typedef unsigned char               uchar;
+
+       // offset is where the body starts in the buffer, after the header
+       //
+        struct  Frame  {
+
+            size_type   offset;
+            size_type   length;
+        };
+
+        static  const   size_type   MAX_HEADER_SIZE =
+            FAST::bytes_required (sizeof (size_type), false);
+
+       // How many frames ahead of the one being processed to prefetch
+       //
+        static  const   size_type   PREFETCH_DISTANCE = 8;
+
+       // Indexes the complete frames at the front of buffer, at most
+       // max_frames of them, and returns how many were indexed. consumed
+       // is set to the number of bytes they take. A frame that is cut off
+       // by the end of the buffer is not indexed. It is left for the next
+       // call, after more bytes are received.
+       // It throws std::runtime_error if a header is longer than
+       // MAX_HEADER_SIZE bytes or its value does not fit in a size_type.
+       //
+        static inline size_type
+        index (const uchar *buffer,
+               size_type buffer_size,
+               Frame *frames,
+               size_type max_frames,
+               size_type &consumed)  {
+
+            size_type   pos = 0;
+            size_type   count = 0;
+
+            while (count < max_frames && pos < buffer_size)  {
+                const   size_type   avail = buffer_size - pos;
+                uint64_t            length;
+                const   size_type   header_len =
+                    _header_length (buffer + pos, avail, length);
+
+                if (header_len == 0)
+                    break;
+                if (length > avail - header_len)  {
+                    if (length > static_cast<size_type>(-1))
+                        _throw_too_long (length);
+                    break;
+                }
+
+#ifdef __GNUC__
+                __builtin_prefetch (buffer + pos + PREFETCH_AHEAD);
+#endif // __GNUC__
+                frames [count].offset = pos + header_len;
+                frames [count].length = static_cast<size_type>(length);
+                count += 1;
+                pos += header_len + length;
+            }
+
+            consumed = pos;
+            return (count);
+        }
+
+       // Brings the start of a frame's body into the cache
+       //
+        static inline void
+        prefetch (const uchar *buffer, const Frame &frame) throw ()  {
+
+#ifdef __GNUC__
+            __builtin_prefetch (buffer + frame.offset);
+#endif // __GNUC__
+        }
+
+    private:
+
+       // index() reads the buffer front to back but hops from header to
+       // header, so it prefetches this many bytes ahead of the frame it
+       // is at
+       //
+        static  const   size_type   PREFETCH_AHEAD = 1024;
+
+       // Returns the header length, or 0 if the header does not end within
+       // avail bytes. Otherwise value is set to the frame length.
+       //
+        DMScu_FAST_ALWAYS_INLINE
+        static inline size_type
+        _header_length (const uchar *buffer, size_type avail, uint64_t &value)
+        {
+
+           // Messages under 16K have a 1 or 2 byte header. Those are
+           // tested byte by byte, since the branches predict well and keep
+           // the chain from one header to the next short.
+           //
+            if (FAST::is_final (buffer [0]))  {
+                value = buffer [0] & FAST::AND_7;
+                return (1);
+            }
+            if (avail > 1 && FAST::is_final (buffer [1]))  {
+                value = ((buffer [0] & FAST::AND_7) << 7) |
+                        (buffer [1] & FAST::AND_7);
+                return (2);
+            }
+
+            unsigned int    stops = 0;
+
+#ifdef __SSE2__
+            if (avail >= 16)  {
+                const   __m128i block = _mm_loadu_si128 (
+                    reinterpret_cast<const __m128i *>(buffer));
+
+               // movemask collects the top (stop) bit of every byte
+               //
+                stops = static_cast<unsigned int>(_mm_movemask_epi8 (block)) &
+                        ((1U << MAX_HEADER_SIZE) - 1);
+                if (stops != 0)  {
+                    const   size_type   header_len = __builtin_ctz (stops) + 1;
+
+                    value = _compact (
+                        static_cast<uint64_t>(_mm_cvtsi128_si64 (block)),
+                        header_len);
+                    return (header_len);
+                }
+            }
+            else
+#endif // __SSE2__
+            {
+                const   size_type   end =
+                    avail < MAX_HEADER_SIZE ? avail : MAX_HEADER_SIZE;
+
+                value = 0;
+                for (size_type i = 0; i < end; ++i)  {
+                    value = (value << 7) | (buffer [i] & FAST::AND_7);
+                    if (FAST::is_final (buffer [i]))
+                        return (i + 1);
+                }
+            }
+
+            if (avail >= MAX_HEADER_SIZE)
+                _throw_too_big ();
+            return (0);
+        }
+
+       // Takes the first header_len bytes of a little-endian word, the
+       // first byte the most significant group, and packs their 7-bit
+       // groups without a loop
+       //
+        static inline uint64_t
+        _compact (uint64_t word, size_type header_len) throw ()  {
+
+            word = __builtin_bswap64 (word) >> (64 - 8 * header_len);
+            return (((word & 0x000000007FULL)) |
+                    ((word & 0x0000007F00ULL) >> 1) |
+                    ((word & 0x00007F0000ULL) >> 2) |
+                    ((word & 0x007F000000ULL) >> 3) |
+                    ((word & 0x7F00000000ULL) >> 4));
+        }
+
+        static void _throw_too_big ()  {
+
+            DMScu_FixedSizeString<1023> err;
+
+            err.printf ("DMScu_FASTFrameIndexer::index(): "
+                        "Header was too big.  Expected max %u bytes.",
+                        MAX_HEADER_SIZE);
+            throw std::runtime_error(err.c_str ());
+        }
+
+        static void _throw_too_long (uint64_t length)  {
+
+            DMScu_FixedSizeString<1023> err;
+
+            err.printf ("DMScu_FASTFrameIndexer::index(): "
+                        "Frame length %llu does not fit in %u bytes",
+                        static_cast<unsigned long long>(length),
+                        static_cast<unsigned int>(sizeof (size_type)));
+            throw std::runtime_error(err.c_str ());
+        }
+
+       // These are not implemented
+       //
+        DMScu_FASTFrameIndexer ();
+        DMScu_FASTFrameIndexer (const DMScu_FASTFrameIndexer &);
+        DMScu_FASTFrameIndexer &operator = (const DMScu_FASTFrameIndexer &);
+};
+
+// ----------------------------------------------------------------------------
+
+// Local Variables:
+// mode:C++
+// tab-width:4
+// c-basic-offset:4
+// End:
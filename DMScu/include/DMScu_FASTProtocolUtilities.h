@@ -8,8 +8,27 @@
 #pragma once
 
 #include <limits.h>
+#include <stdint.h>
+#include <string.h>
+#include <charconv>
 #include <cmath>
 
+#include <type_traits>
+
+#if defined (__x86_64__) && defined (__GNUC__)
+#include <immintrin.h>
+#define DMScu_FAST_HAS_BMI2
+#define DMScu_FAST_BMI2_TARGET __attribute__ ((target ("bmi2")))
+#else
+#define DMScu_FAST_BMI2_TARGET
+#endif // defined (__x86_64__) && defined (__GNUC__)
+
+#ifdef __GNUC__
+#define DMScu_FAST_ALWAYS_INLINE __attribute__ ((always_inline))
+#else
+#define DMScu_FAST_ALWAYS_INLINE
+#endif // __GNUC__
+
 #include <DMScu_FixedSizeString.h>
 
 #if defined (DMS_SunOS_GCC64__) || defined (DMS_SunOS_GCC32__)
@@ -37,7 +56,9 @@ class   DMScu_FASTProtocolUtilities  {
             return ((c & 0x80) != 0);
         }
 
-        static inline size_type
+       // This is constexpr, so it can size buffers at compile time
+       //
+        static constexpr size_type
         bytes_required (size_type size, bool signed_value = true) throw ()  {
 
             if (size < 1)
@@ -199,200 +220,815 @@ class   DMScu_FASTProtocolUtilities  {
             return (idx);
         }
 
-       // This is the slowest method (along with decode_float), so I'm
-       // focusing on their performance over the integer methods.
-       // They may still allow performance improvement, but it's not
-       // worth the time investment right now.
+       // The _wide decoders below load a whole 8-byte word, find the stop
+       // bit with one ctz and compact the 7-bit groups without a loop.
+       // The 9th and 10th bytes of long 64-bit fields are added on
+       // separately. The caller must make sure DECODE_PADDING bytes are
+       // readable from buffer, even if the field itself is shorter (e.g. by
+       // allocating the receive buffer DECODE_PADDING bytes larger).
+       // Overlong encodings go to the scalar decoders above, so the results
+       // are always identical to theirs.
        //
+        static  const   size_type   DECODE_PADDING = 16;
+
+        enum DECODER_TYPE { _scalar_ = 0, _swar_ = 1, _bmi2_ = 2 };
+
+       // The fastest decoder that runs on this CPU. It is detected once.
+       // The array encoders below use the same choice.
+       //
+        static inline DECODER_TYPE best_decoder () throw ()  {
+
+            static  const   DECODER_TYPE    decoder = _detect_decoder ();
+
+            return (decoder);
+        }
+
         template<class cu_TYPE>
         static inline size_type
-        encode_real (uchar *buffer, cu_TYPE val) throw ()  {
+        decode_uinteger_wide (const uchar *buffer, cu_TYPE &x) throw ()  {
 
-            if (! finite (val))  {
-                buffer [0] = 0xFF;
-                return (1);
+            switch (best_decoder ())  {
+                case _bmi2_: return (decode_uinteger_bmi2 (buffer, x));
+                case _swar_: return (decode_uinteger_swar (buffer, x));
+                default: return (decode_uinteger (buffer, x));
             }
+        }
 
-            int     exponent = 0;
-            cu_TYPE tmp_value = 0;
+        template<class cu_TYPE>
+        static inline size_type
+        decode_integer_wide (const uchar *buffer, cu_TYPE &x) throw ()  {
 
-            if (val != 0)  {
-                tmp_value = val;
+            switch (best_decoder ())  {
+                case _bmi2_: return (decode_integer_bmi2 (buffer, x));
+                case _swar_: return (decode_integer_swar (buffer, x));
+                default: return (decode_integer (buffer, x));
+            }
+        }
 
-                cu_TYPE floor = static_cast<long long int>(val);
+       // Compacts the groups with shifts and masks. It runs on any
+       // little-endian CPU.
+       //
+        template<class cu_TYPE>
+        static inline size_type
+        decode_uinteger_swar (const uchar *buffer, cu_TYPE &x) throw ()  {
 
-                if (floor != tmp_value)  {
-                    exponent = -1;
+            return (_decode_one<_SwarCodec, false>(buffer, x));
+        }
 
-                    cu_TYPE mult = static_cast<cu_TYPE>(1.0);
+        template<class cu_TYPE>
+        static inline size_type
+        decode_integer_swar (const uchar *buffer, cu_TYPE &x) throw ()  {
 
-                    while (floor != tmp_value)  {
-                       // NOTE: don't multiply the original value by
-                       // a power of 10.0 (must be double!) each time, or else
-                       // much efficiency in the compression is lost
-                       // due to the typically long representation of
-                       // decimals in binary.
-                       // This way is faster than pow(10.0, exponent + 1) and
-                       // works exactly the same way.
-                       //
-                        tmp_value = val * mult;
-                        floor = static_cast<long long int>(tmp_value);
-                        exponent += 1;
-                        mult *= static_cast<cu_TYPE>(10.0);
-                    }
-                    exponent = -exponent;
-                }
-            }
+            return (_decode_one<_SwarCodec, true>(buffer, x));
+        }
 
-            long long int   mantissa = static_cast<long long int>(tmp_value);
+       // Compacts the groups with one pext instruction. Only call these
+       // if best_decoder() returned _bmi2_. Note that pext is microcoded
+       // (slow) on AMD CPUs before Zen 3, the benchmark in
+       // fastproto_tester shows which one wins on a given machine.
+       //
+        template<class cu_TYPE>
+        DMScu_FAST_BMI2_TARGET
+        static inline size_type
+        decode_uinteger_bmi2 (const uchar *buffer, cu_TYPE &x) throw ()  {
 
-            while (mantissa != 0 && mantissa % 10 == 0)  {
-                mantissa /= 10;
-                exponent += 1;
-            }
+            return (_decode_one<_Bmi2Codec, false>(buffer, x));
+        }
 
-            // if (actual_bytes_required_int (exponent) > 1)  {
-            //     DMScu_FixedSizeString<1023> err;
+        template<class cu_TYPE>
+        DMScu_FAST_BMI2_TARGET
+        static inline size_type
+        decode_integer_bmi2 (const uchar *buffer, cu_TYPE &x) throw ()  {
 
-            //     err.printf ("DMScu_FASTProtocolUtilities::encode_real(): "
-            //                 "Too many bytes required for exponent for "
-            //                 "number %lf", static_cast<double>(val));
-            //     throw Exception (err.c_str ());
-            // }
+            return (_decode_one<_Bmi2Codec, true>(buffer, x));
+        }
 
-            buffer [0] = static_cast<uchar>(exponent & AND_7);
+       // The array methods below encode/decode count values in one call.
+       // The field lengths are computed without branches, so the compiler
+       // can vectorize the length pass, and every field that fits in 8
+       // bytes is written/read with one unaligned 8-byte store/load.
+       // The integer (signed) encoders always produce the shortest
+       // encoding.
+       //
+       // The checked versions take the buffer size. The encoders return
+       // the number of bytes written, or 0 (writing nothing) if the values
+       // do not fit. The decoders return the number of bytes consumed, or
+       // 0 if the buffer ends before count fields were decoded.
+       //
+       // The _unchecked versions are for hot loops that size their
+       // buffers up front. The encoders need room for
+       // max_encoded_size<cu_TYPE>(count) bytes, the decoders need
+       // DECODE_PADDING readable bytes after the last field.
+       //
+        static  const   size_type   ENCODE_PADDING = 8;
+
+        template<class cu_TYPE>
+        static constexpr size_type
+        max_encoded_size (size_type count, bool signed_value = true)
+            throw ()  {
 
-            return (1 + encode_integer (buffer + 1, mantissa));
+            return (count * bytes_required (sizeof (cu_TYPE), signed_value) +
+                    ENCODE_PADDING);
         }
 
-       // Allow the limiting of the number of significant digits after
-       // the decimal.
+       // Exact number of bytes encode_uintegers()/encode_integers() write
        //
         template<class cu_TYPE>
         static inline size_type
-        encode_real (uchar *buffer, cu_TYPE val, size_type precision)
+        encoded_size_uintegers (const cu_TYPE *values, size_type count)
             throw ()  {
 
-            if (! finite (val))  {
-                buffer [0] = 0xFF;
-                return (1);
-            }
+            size_type   total = 0;
+
+            for (size_type i = 0; i < count; ++i)
+                total += _uint_length (values [i]);
+            return (total);
+        }
+
+        template<class cu_TYPE>
+        static inline size_type
+        encoded_size_integers (const cu_TYPE *values, size_type count)
+            throw ()  {
+
+            size_type   total = 0;
+
+            for (size_type i = 0; i < count; ++i)
+                total += _int_length (values [i]);
+            return (total);
+        }
+
+        template<class cu_TYPE>
+        static inline size_type
+        encode_uintegers (uchar *buffer, size_type buffer_size,
+                          const cu_TYPE *values, size_type count) throw ()  {
+
+            if (encoded_size_uintegers (values, count) > buffer_size)
+                return (0);
+            return (_encode_array<false>(buffer, buffer_size, values, count));
+        }
+
+        template<class cu_TYPE>
+        static inline size_type
+        encode_uintegers_unchecked (uchar *buffer,
+                                    const cu_TYPE *values,
+                                    size_type count) throw ()  {
+
+            return (_encode_array<false>(buffer, UINT_MAX, values, count));
+        }
+
+        template<class cu_TYPE>
+        static inline size_type
+        encode_integers (uchar *buffer, size_type buffer_size,
+                         const cu_TYPE *values, size_type count) throw ()  {
+
+            if (encoded_size_integers (values, count) > buffer_size)
+                return (0);
+            return (_encode_array<true>(buffer, buffer_size, values, count));
+        }
+
+        template<class cu_TYPE>
+        static inline size_type
+        encode_integers_unchecked (uchar *buffer,
+                                   const cu_TYPE *values,
+                                   size_type count) throw ()  {
+
+            return (_encode_array<true>(buffer, UINT_MAX, values, count));
+        }
 
-            int     exponent = 0;
-            cu_TYPE tmp_value = 0;
+        template<class cu_TYPE>
+        static inline size_type
+        decode_uintegers (const uchar *buffer, size_type buffer_size,
+                          cu_TYPE *values, size_type count) throw ()  {
 
-            if (val != 0)  {
-                tmp_value = val;
+            return (_decode_array<false>(buffer, buffer_size, values, count));
+        }
 
-                cu_TYPE floor = static_cast<long long int>(val);
+        template<class cu_TYPE>
+        static inline size_type
+        decode_uintegers_unchecked (const uchar *buffer,
+                                    cu_TYPE *values,
+                                    size_type count) throw ()  {
 
-                if (floor != tmp_value)  {
-                    exponent = -1;
+            return (_decode_array<false>(buffer, UINT_MAX, values, count));
+        }
 
-                    cu_TYPE mult = static_cast<cu_TYPE>(1.0);
+        template<class cu_TYPE>
+        static inline size_type
+        decode_integers (const uchar *buffer, size_type buffer_size,
+                         cu_TYPE *values, size_type count) throw ()  {
 
-                    while (floor != tmp_value && exponent < precision)  {
-                       // NOTE: don't multiply the original value by
-                       // a power of 10.0 (must be double!) each time, or else
-                       // much efficiency in the compression is lost
-                       // due to the typically long representation of
-                       // decimals in binary.
-                       // This way is faster than pow(10.0, exponent + 1) and
-                       // works exactly the same way.
-                       //
-                        tmp_value = val * mult;
-                        floor = static_cast<long long int> (tmp_value);
-                        exponent += 1;
-                        mult *= static_cast<cu_TYPE>(10.0);
+            return (_decode_array<true>(buffer, buffer_size, values, count));
+        }
+
+        template<class cu_TYPE>
+        static inline size_type
+        decode_integers_unchecked (const uchar *buffer,
+                                   cu_TYPE *values,
+                                   size_type count) throw ()  {
+
+            return (_decode_array<true>(buffer, UINT_MAX, values, count));
+        }
+
+       // A decimal number as FAST sends it, mantissa * 10^exponent. Prices
+       // kept in this form are encoded and decoded exactly.
+       //
+       // encode_decimal() sends an exponent within -64 to 63 in one byte.
+       // Other exponents, e.g. of 1e100 or DBL_MAX, are sent as the
+       // WIDE_EXPONENT byte followed by the exponent as a signed integer.
+       // A first byte of NAN_EXPONENT is a NaN.
+       //
+        static  const   unsigned    short   WIDE_EXPONENT = 0xFE;
+        static  const   unsigned    short   NAN_EXPONENT = 0xFF;
+
+        struct  Decimal  {
+
+            long long int   mantissa;
+            int             exponent;
+
+            inline Decimal () throw () : mantissa (0), exponent (0)  {   }
+            inline Decimal (long long int m, int e) throw ()
+                : mantissa (m), exponent (e)  {   }
+        };
+
+       // to_decimal() finds the shortest decimal that reads back as val,
+       // e.g. 0.1 becomes 1 * 10^-1 even though the double is not exactly
+       // 0.1. Values with up to 8 decimals, like prices, are tried first,
+       // by scaling and reading back the way from_decimal() does. The rest
+       // go through std::to_chars(), which does it with an integer (Ryu)
+       // algorithm. val must be finite.
+       //
+        template<class cu_TYPE>
+        static inline void to_decimal (cu_TYPE val, Decimal &dec) throw ()  {
+
+            static_assert (std::is_floating_point<cu_TYPE>::value &&
+                               sizeof (cu_TYPE) <= sizeof (double),
+                           "The mantissa of a long double may not fit");
+
+            static  const   double  pow10 [] = {
+                1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8
+            };
+            static  const   double  MAX_EXACT = 9007199254740992.0;  // 2^53
+
+            const   double  abs_val = val < 0 ? -val : val;
+
+            for (int k = 0; k <= 8 && abs_val * pow10 [k] < MAX_EXACT; ++k)  {
+                const   double  scaled = val * pow10 [k];
+
+                dec.mantissa = static_cast<long long int>(
+                    scaled < 0 ? scaled - 0.5 : scaled + 0.5);
+                dec.exponent = -k;
+                if (static_cast<cu_TYPE>(
+                        static_cast<double>(dec.mantissa) / pow10 [k]) ==
+                        val)  {
+                    while (dec.mantissa != 0 && dec.mantissa % 10 == 0)  {
+                        dec.mantissa /= 10;
+                        dec.exponent += 1;
                     }
-                    exponent = -exponent;
+                    if (dec.mantissa == 0)
+                        dec.exponent = 0;
+                    return;
                 }
             }
 
-            long long int   mantissa = static_cast<long long int>(tmp_value);
+           // The shortest scientific form, e.g. -1.2345e-07
+           //
+            char                        buffer [32];
+            const   std::to_chars_result    result =
+                std::to_chars (buffer, buffer + sizeof (buffer), val,
+                               std::chars_format::scientific);
+            const   char                *cursor = buffer;
+            const   bool                negative = *cursor == '-';
+            int                         digits = 0;
+
+            if (negative)
+                ++cursor;
+            dec.mantissa = 0;
+            for (; cursor < result.ptr && *cursor != 'e'; ++cursor)
+                if (*cursor != '.')  {
+                    dec.mantissa = dec.mantissa * 10 + (*cursor - '0');
+                    digits += 1;
+                }
+
+           // cursor is at the 'e', which is followed by a sign
+           //
+            const   bool    negative_exp = cursor [1] == '-';
+            int             exponent = 0;
+
+            for (cursor += 2; cursor < result.ptr; ++cursor)
+                exponent = exponent * 10 + (*cursor - '0');
+
+            dec.exponent = dec.mantissa == 0
+                ? 0 : (negative_exp ? -exponent : exponent) - (digits - 1);
+            if (negative)
+                dec.mantissa = -dec.mantissa;
+            return;
+        }
+
+       // from_decimal() is always correctly rounded, so decimals from
+       // to_decimal() read back as the same value. When the mantissa is
+       // below 2^53 and the exponent is within +/-22 it takes one
+       // multiplication or division, since those powers of 10 are exact in
+       // a double. Otherwise it parses the decimal with std::from_chars().
+       //
+        template<class cu_TYPE>
+        static inline cu_TYPE from_decimal (const Decimal &dec) throw ()  {
+
+            static  const   double  pow10 [] = {
+                1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+                1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20,
+                1e21, 1e22
+            };
+            static  const   long long int   MAX_EXACT = 1LL << 53;
 
-            while (mantissa != 0 && mantissa % 10 == 0)  {
-                mantissa /= 10;
-                exponent += 1;
+            const   int exponent = dec.exponent;
+
+            if (dec.mantissa < MAX_EXACT && dec.mantissa > -MAX_EXACT &&
+                exponent <= 22 && exponent >= -22)  {
+                const   double  mantissa = static_cast<double>(dec.mantissa);
+
+                return (static_cast<cu_TYPE>(
+                    exponent >= 0 ? mantissa * pow10 [exponent]
+                                  : mantissa / pow10 [-exponent]));
             }
 
-            // if (actual_bytes_required_int (exponent) > 1)  {
-            //     DMScu_FixedSizeString<1023> err;
+            char    buffer [48];
+            char    *end =
+                std::to_chars (buffer, buffer + 24, dec.mantissa).ptr;
 
-            //     err.printf ("DMScu_FASTProtocolUtilities::encode_real(): "
-            //                 "Too many bytes required for exponent for "
-            //                 "number %lf", static_cast<double>(val));
-            //     throw Exception (err.c_str ());
-            // }
+            *end++ = 'e';
+            end = std::to_chars (end, buffer + sizeof (buffer), exponent).ptr;
 
-            buffer [0] = static_cast<uchar>(exponent & AND_7);
+            cu_TYPE value = 0;
 
-            return (1 + encode_integer (buffer + 1, mantissa));
+            std::from_chars (buffer, end, value);
+            return (value);
         }
 
-       // Please see comment above regarding encode_float.
+       // At most 16 bytes are written, 1 + 5 for the exponent and 10 for
+       // the mantissa
        //
-        template<class cu_TYPE>
         static inline size_type
-        decode_real (const uchar *buffer, cu_TYPE &x) throw ()  {
+        encode_decimal (uchar *buffer, const Decimal &dec) throw ()  {
 
-            static  const   cu_TYPE nan = ::sqrt (-1);
+            size_type   idx = 1;
 
-            unsigned char   c = buffer [0];
+            if (dec.exponent >= -64 && dec.exponent <= 63)
+                buffer [0] = static_cast<uchar>(dec.exponent & AND_7);
+            else  {
+                buffer [0] = WIDE_EXPONENT;
+                idx += encode_integer (buffer + 1, dec.exponent);
+            }
 
-            if (c == 0xFF)  {
-                x = nan;
-                return (1);
+            return (idx + encode_integer (buffer + idx, dec.mantissa));
+        }
+
+       // A NaN, sent by encode_real(), reads as 0
+       //
+        static inline size_type
+        decode_decimal (const uchar *buffer, Decimal &dec) throw ()  {
+
+            const   uchar   c = buffer [0];
+
+            if (c == WIDE_EXPONENT)  {
+                const   size_type   idx =
+                    1 + decode_integer (buffer + 1, dec.exponent);
+
+                return (idx + decode_integer (buffer + idx, dec.mantissa));
             }
 
            // if the first byte has stop bit then no mantissa
            //
             if ((c & 0x80) != 0)  {
-                x = 0;
+                dec.mantissa = 0;
+                dec.exponent = 0;
                 return (1);
             }
 
-            int exponent = 0;
-
            // check sign bit
            //
-            if ((c & 0x40) != 0)
-                exponent = ~AND_7;
-            exponent |= (c & AND_7);
+            dec.exponent = (c & 0x40) != 0 ? ~AND_7 : 0;
+            dec.exponent |= (c & AND_7);
 
            // the rest of the bytes make up the mantissa
            //
-            long long int   mantissa  = 0;
-            size_type       ret_val =
-                decode_integer (buffer + 1, mantissa) + 1;
+            return (decode_integer (buffer + 1, dec.mantissa) + 1);
+        }
 
-            if (exponent == 0)
-                x = mantissa;
-            else  {
-               // Compute multiplier iteratively instead of using pow
-               // for small exponents
-               //
-                cu_TYPE multiplier = static_cast<cu_TYPE>(1.0);
+       // Reals are sent as the decimal from to_decimal(), so every finite
+       // value round-trips exactly, down to the denormals and up to the
+       // max of the type
+       //
+        template<class cu_TYPE>
+        static inline size_type
+        encode_real (uchar *buffer, cu_TYPE val) throw ()  {
 
-                if (::llabs (exponent) >= 9)
-                    multiplier = ::pow (10.0, ::llabs (exponent));
+            if (! finite (val))  {
+                buffer [0] = NAN_EXPONENT;
+                return (1);
+            }
 
-                if (exponent > 0)  {
-                    if (exponent < 9)
-                        for (int i = 0; i < exponent; i++)
-                            multiplier *= static_cast<cu_TYPE>(10.0);
-                    x = mantissa * multiplier;
-                }
-                else  {
-                    if (exponent > -9)
-                        for (int i = 0; i < -exponent; i++)
-                            multiplier *= static_cast<cu_TYPE>(10.0);
-                    x = mantissa / multiplier;
+            Decimal dec;
+
+            to_decimal (val, dec);
+            return (encode_decimal (buffer, dec));
+        }
+
+       // Allow the limiting of the number of significant digits after
+       // the decimal. The extra digits are truncated.
+       //
+        template<class cu_TYPE>
+        static inline size_type
+        encode_real (uchar *buffer, cu_TYPE val, size_type precision)
+            throw ()  {
+
+            static  const   long long int   pow10 [] = {
+                1LL, 10LL, 100LL, 1000LL, 10000LL, 100000LL, 1000000LL,
+                10000000LL, 100000000LL, 1000000000LL, 10000000000LL,
+                100000000000LL, 1000000000000LL, 10000000000000LL,
+                100000000000000LL, 1000000000000000LL,
+                10000000000000000LL, 100000000000000000LL,
+                1000000000000000000LL
+            };
+
+            if (! finite (val))  {
+                buffer [0] = NAN_EXPONENT;
+                return (1);
+            }
+
+            Decimal dec;
+
+            to_decimal (val, dec);
+            if (dec.exponent < -static_cast<int>(precision))  {
+                const   int drop = -static_cast<int>(precision) - dec.exponent;
+
+                dec.mantissa = drop <= 18 ? dec.mantissa / pow10 [drop] : 0;
+                dec.exponent =
+                    dec.mantissa != 0 ? -static_cast<int>(precision) : 0;
+                while (dec.mantissa != 0 && dec.mantissa % 10 == 0)  {
+                    dec.mantissa /= 10;
+                    dec.exponent += 1;
                 }
             }
 
+            return (encode_decimal (buffer, dec));
+        }
+
+        template<class cu_TYPE>
+        static inline size_type
+        decode_real (const uchar *buffer, cu_TYPE &x) throw ()  {
+
+            static  const   cu_TYPE nan = ::sqrt (-1);
+
+            if (buffer [0] == NAN_EXPONENT)  {
+                x = nan;
+                return (1);
+            }
+
+            Decimal         dec;
+            const   size_type   ret_val = decode_decimal (buffer, dec);
+
+            x = from_decimal<cu_TYPE>(dec);
             return (ret_val);
         }
+
+    private:
+
+        static  const   uint64_t    STOP_BITS_MASK = 0x8080808080808080ULL;
+        static  const   uint64_t    GROUPS_MASK = 0x7f7f7f7f7f7f7f7fULL;
+
+       // These move 7-bit groups between the low bits of a value and the
+       // low 7 bits of each byte of a word, the lowest group in the lowest
+       // byte. Only 8 groups (56 bits) fit in a word.
+       //
+        struct  _SwarCodec  {
+
+           // Squeezes the groups together, in pairs, quads and then the
+           // two halves. expand() does the reverse.
+           //
+            static inline uint64_t compact (uint64_t word) throw ()  {
+
+                word = (word & 0x007f007f007f007fULL) |
+                       ((word & 0x7f007f007f007f00ULL) >> 1);
+                word = (word & 0x00003fff00003fffULL) |
+                       ((word & 0x3fff00003fff0000ULL) >> 2);
+                word = (word & 0x000000000fffffffULL) |
+                       ((word & 0x0fffffff00000000ULL) >> 4);
+                return (word);
+            }
+            static inline uint64_t expand (uint64_t value) throw ()  {
+
+                value = (value & 0x000000000fffffffULL) |
+                        ((value & 0x00fffffff0000000ULL) << 4);
+                value = (value & 0x00003fff00003fffULL) |
+                        ((value & 0x0fffc0000fffc000ULL) << 2);
+                value = (value & 0x007f007f007f007fULL) |
+                        ((value & 0x3f803f803f803f80ULL) << 1);
+                return (value);
+            }
+        };
+
+#ifdef DMScu_FAST_HAS_BMI2
+        struct  _Bmi2Codec  {
+
+            DMScu_FAST_BMI2_TARGET
+            static inline uint64_t compact (uint64_t word) throw ()  {
+
+                return (_pext_u64 (word, GROUPS_MASK));
+            }
+            DMScu_FAST_BMI2_TARGET
+            static inline uint64_t expand (uint64_t value) throw ()  {
+
+                return (_pdep_u64 (value, GROUPS_MASK));
+            }
+        };
+#else
+        typedef _SwarCodec  _Bmi2Codec;
+#endif // DMScu_FAST_HAS_BMI2
+
+        static inline DECODER_TYPE _detect_decoder () throw ()  {
+
+#ifdef DMScu_FAST_HAS_BMI2
+            __builtin_cpu_init ();
+            if (__builtin_cpu_supports ("bmi2"))
+                return (_bmi2_);
+#endif // DMScu_FAST_HAS_BMI2
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+            return (_swar_);
+#else
+            return (_scalar_);
+#endif // __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+        }
+
+        static inline uint64_t _load_word (const uchar *buffer) throw ()  {
+
+            uint64_t    word;
+
+            ::memcpy (&word, buffer, sizeof (word));
+            return (word);
+        }
+
+       // Returns the field length in bytes, or 0 if there is no stop bit
+       // in the first 8 bytes. The first byte is the least significant
+       // one in a little-endian word.
+       //
+        static inline size_type _stop_bit_length (uint64_t word) throw ()  {
+
+            const   uint64_t    stops = word & STOP_BITS_MASK;
+
+            return (stops == 0 ? 0 : (__builtin_ctzll (stops) >> 3) + 1);
+        }
+
+       // Puts the first len bytes in big-endian order at the bottom of
+       // the word and clears the stop bit
+       //
+        static inline uint64_t
+        _align_groups (uint64_t word, size_type len) throw ()  {
+
+            return ((__builtin_bswap64 (word) >> ((8 - len) * 8)) &
+                    GROUPS_MASK);
+        }
+
+       // Adds the 9th and 10th bytes to the first 8 compacted groups.
+       // Returns 0 if there is no stop bit in them either.
+       //
+        static inline size_type
+        _long_tail (const uchar *buffer, uint64_t head, uint64_t &value)
+            throw ()  {
+
+            if ((buffer [8] & 0x80) != 0)  {
+                value = (head << 7) | (buffer [8] & AND_7);
+                return (9);
+            }
+            if ((buffer [9] & 0x80) != 0)  {
+                value = (head << 14) | ((buffer [8] & AND_7) << 7) |
+                        (buffer [9] & AND_7);
+                return (10);
+            }
+
+            return (0);
+        }
+
+        template<class cu_TYPE>
+        static inline cu_TYPE
+        _sign_extend (uint64_t value, size_type len) throw ()  {
+
+            const   int unused = 64 - static_cast<int>(len) * 7;
+
+            if (unused <= 0)
+                return (static_cast<cu_TYPE>(value));
+            return (static_cast<cu_TYPE>(
+                        static_cast<int64_t>(value << unused) >> unused));
+        }
+
+        template<bool SIGNED, class cu_TYPE>
+        static inline size_type
+        _decode_scalar (const uchar *buffer, cu_TYPE &x) throw ()  {
+
+            return (SIGNED ? decode_integer (buffer, x)
+                           : decode_uinteger (buffer, x));
+        }
+
+       // This is forced inline, so CODEC::compact() is inlined too when
+       // the caller is compiled for BMI2
+       //
+        template<class CODEC, bool SIGNED, class cu_TYPE>
+        DMScu_FAST_ALWAYS_INLINE
+        static inline size_type
+        _decode_one (const uchar *buffer, cu_TYPE &x) throw ()  {
+
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+            const   uint64_t    word = _load_word (buffer);
+            size_type           len = _stop_bit_length (word);
+            uint64_t            value;
+
+            if (len != 0)
+                value = CODEC::compact (_align_groups (word, len));
+            else if (sizeof (cu_TYPE) < 8 ||
+                     (len = _long_tail (
+                          buffer,
+                          CODEC::compact (_align_groups (word, 8)),
+                          value)) == 0)
+                return (_decode_scalar<SIGNED>(buffer, x));
+            if (len > bytes_required (sizeof (cu_TYPE), false))
+                return (_decode_scalar<SIGNED>(buffer, x));
+
+            x = SIGNED ? _sign_extend<cu_TYPE>(value, len)
+                       : static_cast<cu_TYPE>(value);
+            return (len);
+#else
+            return (_decode_scalar<SIGNED>(buffer, x));
+#endif // __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+        }
+
+       // The shortest length of x. There are no branches here, so that
+       // the length loops can be vectorized.
+       //
+        template<class cu_TYPE>
+        static inline size_type _uint_length (cu_TYPE x) throw ()  {
+
+            typedef typename std::make_unsigned<cu_TYPE>::type  utype;
+
+            const   utype       value = static_cast<utype>(x);
+            const   size_type   max_bytes =
+                bytes_required (sizeof (cu_TYPE), false);
+            size_type           len = 1;
+
+            for (size_type i = 1; i < max_bytes; ++i)
+                len += (value >> (i * 7)) != 0;
+            return (len);
+        }
+
+       // A signed field of len bytes holds 7 * len - 1 bits plus the sign
+       //
+        template<class cu_TYPE>
+        static inline size_type _int_length (cu_TYPE x) throw ()  {
+
+            typedef typename std::make_unsigned<cu_TYPE>::type  utype;
+            typedef typename std::make_signed<cu_TYPE>::type    stype;
+
+            const   stype       sx = static_cast<stype>(x);
+            const   utype       magnitude =
+                static_cast<utype>(sx ^ (sx >> (sizeof (cu_TYPE) * 8 - 1)));
+            const   size_type   max_bytes =
+                bytes_required (sizeof (cu_TYPE), true);
+            size_type           len = 1;
+
+            for (size_type i = 1; i < max_bytes; ++i)
+                len += (magnitude >> (i * 7 - 1)) != 0;
+            return (len);
+        }
+
+        template<bool SIGNED, class cu_TYPE>
+        static inline void
+        _write_groups (uchar *buffer, cu_TYPE x, size_type len) throw ()  {
+
+            typedef typename std::conditional<SIGNED, int64_t, uint64_t>::type
+                word_type;
+
+            const   word_type   value = static_cast<word_type>(x);
+            size_type           idx = 0;
+
+            for (int shift = (len - 1) * 7; shift > 0; shift -= 7)
+                buffer [idx++] = static_cast<uchar>((value >> shift) & AND_7);
+            buffer [idx] = static_cast<uchar>((value & AND_7) | 0x80);
+            return;
+        }
+
+       // Spreads the groups over a word, sets the stop bit in the lowest
+       // one and stores the word big-end first with the unused high bytes
+       // shifted out. A field of up to 8 bytes is one store that way.
+       //
+        template<class CODEC, bool SIGNED, class cu_TYPE>
+        DMScu_FAST_ALWAYS_INLINE
+        static inline size_type
+        _encode_array_with (uchar *buffer, size_type buffer_size,
+                            const cu_TYPE *values, size_type count) throw ()  {
+
+            size_type   pos = 0;
+
+            for (size_type i = 0; i < count; ++i)  {
+                const   cu_TYPE     x = values [i];
+                const   size_type   len =
+                    SIGNED ? _int_length (x) : _uint_length (x);
+
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+                if (len <= 8 && buffer_size - pos >= ENCODE_PADDING)  {
+                    const   uint64_t    word =
+                        __builtin_bswap64 (
+                            CODEC::expand (static_cast<uint64_t>(x)) | 0x80) >>
+                        ((8 - len) * 8);
+
+                    ::memcpy (buffer + pos, &word, sizeof (word));
+                }
+                else
+#endif // __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+                    _write_groups<SIGNED>(buffer + pos, x, len);
+                pos += len;
+            }
+
+            return (pos);
+        }
+
+        template<bool SIGNED, class cu_TYPE>
+        DMScu_FAST_BMI2_TARGET
+        static size_type
+        _encode_array_bmi2 (uchar *buffer, size_type buffer_size,
+                            const cu_TYPE *values, size_type count) throw ()  {
+
+            return (_encode_array_with<_Bmi2Codec, SIGNED>
+                        (buffer, buffer_size, values, count));
+        }
+
+        template<bool SIGNED, class cu_TYPE>
+        static inline size_type
+        _encode_array (uchar *buffer, size_type buffer_size,
+                       const cu_TYPE *values, size_type count) throw ()  {
+
+            if (best_decoder () == _bmi2_)
+                return (_encode_array_bmi2<SIGNED>
+                            (buffer, buffer_size, values, count));
+            return (_encode_array_with<_SwarCodec, SIGNED>
+                        (buffer, buffer_size, values, count));
+        }
+
+       // Returns false if the field at buffer may run past remaining
+       // bytes. The scalar decoders read up to max_bytes + 1 bytes.
+       //
+        static inline bool
+        _field_fits (const uchar *buffer, size_type remaining,
+                     size_type max_bytes) throw ()  {
+
+            for (size_type i = 0; i < remaining; ++i)
+                if (is_final (buffer [i]) || i == max_bytes)
+                    return (true);
+            return (false);
+        }
+
+        template<class CODEC, bool SIGNED, class cu_TYPE>
+        DMScu_FAST_ALWAYS_INLINE
+        static inline size_type
+        _decode_array_with (const uchar *buffer, size_type buffer_size,
+                            cu_TYPE *values, size_type count) throw ()  {
+
+            size_type   pos = 0;
+            size_type   i = 0;
+
+            for (; i < count && buffer_size - pos >= DECODE_PADDING; ++i)
+                pos += _decode_one<CODEC, SIGNED>(buffer + pos, values [i]);
+
+           // Near the end of the buffer
+           //
+            for (; i < count; ++i)  {
+                if (! _field_fits (buffer + pos, buffer_size - pos,
+                                   bytes_required (sizeof (cu_TYPE), false)))
+                    return (0);
+                pos += _decode_scalar<SIGNED>(buffer + pos, values [i]);
+            }
+
+            return (pos);
+        }
+
+        template<bool SIGNED, class cu_TYPE>
+        DMScu_FAST_BMI2_TARGET
+        static size_type
+        _decode_array_bmi2 (const uchar *buffer, size_type buffer_size,
+                            cu_TYPE *values, size_type count) throw ()  {
+
+            return (_decode_array_with<_Bmi2Codec, SIGNED>
+                        (buffer, buffer_size, values, count));
+        }
+
+        template<bool SIGNED, class cu_TYPE>
+        static inline size_type
+        _decode_array (const uchar *buffer, size_type buffer_size,
+                       cu_TYPE *values, size_type count) throw ()  {
+
+            if (best_decoder () == _bmi2_)
+                return (_decode_array_bmi2<SIGNED>
+                            (buffer, buffer_size, values, count));
+            return (_decode_array_with<_SwarCodec, SIGNED>
+                        (buffer, buffer_size, values, count));
+        }
 };
 
 // ----------------------------------------------------------------------------
@@ -0,0 +1,326 @@
+// Hossein Moein
+// March 25, 2018
+// Copyright (C) 2018-2019 Hossein Moein
+// Distributed under the BSD Software License (see file License)
+
+// ----------------------------------------------------------------------------
+
+#pragma once
+
+#include <type_traits>
+
+#include <DMScu_FASTProtocolUtilities.h>
+#include <DMScu_FASTStreamDecoder.h>
+
+// ----------------------------------------------------------------------------
+
+// These templates describe a message as a list of struct members and let
+// the compiler generate its FAST encoder and decoder, e.g.
+//
+//     struct  Order  {
+//         uint32_t    id;
+//         int64_t     quantity;
+//         double      price;
+//     };
+//
+//     typedef DMScu_FASTSchema<DMScu_FASTField<&Order::id>,
+//                              DMScu_FASTField<&Order::quantity>,
+//                              DMScu_FASTField<&Order::price>> OrderSchema;
+//
+//     OrderSchema::buffer_type    buffer;  // OrderSchema::MAX_SIZE bytes
+//     const   unsigned int        size = OrderSchema::encode (buffer, order);
+//
+// The fields are sent in the listed order, with no presence map, by the
+// DMScu_FASTProtocolUtilities primitives: unsigned integers with
+// encode_uinteger(), signed integers with encode_integer() and floating
+// point members with encode_real(). There is no field table at runtime.
+// Each encode() and decode() is the fields' primitives, inlined one after
+// the other.
+//
+// MAX_SIZE is a compile time constant, so encode() does no bounds checks.
+// It needs a buffer of MAX_SIZE bytes.
+//
+
+// ----------------------------------------------------------------------------
+
+template<auto cu_MEMBER>
+struct  DMScu_FASTField;
+
+template<class cu_STRUCT, class cu_TYPE, cu_TYPE cu_STRUCT::*cu_MEMBER>
+struct  DMScu_FASTField<cu_MEMBER>  {
+
+    private:
+
+        typedef DMScu_FASTProtocolUtilities FAST;
+        typedef unsigned char               uchar;
+
+        static_assert (std::is_arithmetic<cu_TYPE>::value &&
+                           ! std::is_same<cu_TYPE, bool>::value,
+                       "FAST fields must be integer or floating point");
+
+        enum  { _real_ = std::is_floating_point<cu_TYPE>::value,
+                _signed_ = std::is_signed<cu_TYPE>::value };
+
+    public:
+
+        typedef cu_STRUCT               struct_type;
+        typedef cu_TYPE                 value_type;
+        typedef FAST::size_type         size_type;
+
+       // encode_real() sends an exponent byte, an int exponent if that
+       // byte is WIDE_EXPONENT, and a long long mantissa
+       //
+        static  constexpr   size_type   MAX_SIZE =
+            _real_ ? 1 + FAST::bytes_required (sizeof (int), true) +
+                         FAST::bytes_required (sizeof (long long int), true)
+                   : FAST::bytes_required (sizeof (cu_TYPE), _signed_);
+
+       // The scalar decoders read at most one byte past the maximum size
+       // of an integer, so a malformed real, with its exponent and mantissa
+       // integers, may be read up to two bytes past MAX_SIZE
+       //
+        static  constexpr   size_type   MAX_READ = MAX_SIZE + (_real_ ? 2 : 1);
+
+       // length() of a field longer than its type allows
+       //
+        static  constexpr   size_type   MALFORMED = static_cast<size_type>(-1);
+
+        static inline size_type
+        encode (uchar *buffer, const cu_STRUCT &msg) throw ()  {
+
+            if constexpr (_real_)
+                return (FAST::encode_real (buffer, msg.*cu_MEMBER));
+            else if constexpr (_signed_)
+                return (FAST::encode_integer (buffer, msg.*cu_MEMBER));
+            else
+                return (FAST::encode_uinteger (buffer, msg.*cu_MEMBER));
+        }
+
+        static inline size_type
+        decode (const uchar *buffer, cu_STRUCT &msg) throw ()  {
+
+            if constexpr (_real_)
+                return (FAST::decode_real (buffer, msg.*cu_MEMBER));
+            else if constexpr (_signed_)
+                return (FAST::decode_integer (buffer, msg.*cu_MEMBER));
+            else
+                return (FAST::decode_uinteger (buffer, msg.*cu_MEMBER));
+        }
+
+        static inline DMScu_FASTStreamDecoder::STATUS
+        decode (DMScu_FASTStreamDecoder &stream, cu_STRUCT &msg) throw ()  {
+
+            if constexpr (_real_)
+                return (stream.decode_real (msg.*cu_MEMBER));
+            else if constexpr (_signed_)
+                return (stream.decode_integer (msg.*cu_MEMBER));
+            else
+                return (stream.decode_uinteger (msg.*cu_MEMBER));
+        }
+
+       // Returns the length of the field at buffer, 0 if it does not end
+       // within buffer_size bytes, or MALFORMED if it is overlong
+       //
+        static inline size_type
+        length (const uchar *buffer, size_type buffer_size) throw ()  {
+
+           // A real is an exponent byte and an integer mantissa, unless the
+           // exponent byte has the stop bit (zero or NaN). A WIDE_EXPONENT
+           // byte is followed by an integer exponent and the mantissa.
+           //
+            if constexpr (_real_)  {
+                if (buffer_size == 0)
+                    return (0);
+
+                size_type   idx = 1;
+
+                if (buffer [0] == FAST::WIDE_EXPONENT)  {
+                    const   size_type   len =
+                        _int_length (buffer + 1, buffer_size - 1,
+                                     FAST::bytes_required (sizeof (int),
+                                                           true));
+
+                    if (len == 0 || len == MALFORMED)
+                        return (len);
+                    idx += len;
+                }
+                else if (FAST::is_final (buffer [0]))
+                    return (1);
+
+                const   size_type   len =
+                    _int_length (buffer + idx, buffer_size - idx,
+                                 FAST::bytes_required (sizeof (long long int),
+                                                       true));
+
+                return (len == 0 || len == MALFORMED ? len : idx + len);
+            }
+            else
+                return (_int_length (buffer, buffer_size, MAX_SIZE));
+        }
+
+    private:
+
+        static inline size_type
+        _int_length (const uchar *buffer,
+                     size_type buffer_size,
+                     size_type max_bytes) throw ()  {
+
+            const   size_type   end =
+                buffer_size < max_bytes ? buffer_size : max_bytes;
+
+            for (size_type idx = 0; idx < end; ++idx)
+                if (FAST::is_final (buffer [idx]))
+                    return (idx + 1);
+            return (buffer_size >= max_bytes ? MALFORMED : 0);
+        }
+};
+
+// ----------------------------------------------------------------------------
+
+template<class ... cu_FIELDS>
+class   DMScu_FASTSchema;
+
+template<class cu_FIRST, class ... cu_REST>
+class   DMScu_FASTSchema<cu_FIRST, cu_REST ...>  {
+
+    private:
+
+        typedef unsigned char   uchar;
+
+        static_assert ((std::is_same<typename cu_FIRST::struct_type,
+                                     typename cu_REST::struct_type>::value
+                        && ...),
+                       "All fields of a schema must be of the same struct");
+
+    public:
+
+        typedef typename cu_FIRST::struct_type  struct_type;
+        typedef typename cu_FIRST::size_type    size_type;
+
+        static  constexpr   size_type   FIELD_COUNT = 1 + sizeof... (cu_REST);
+        static  constexpr   size_type   MAX_SIZE =
+            (cu_FIRST::MAX_SIZE + ... + cu_REST::MAX_SIZE);
+        static  constexpr   size_type   MAX_READ =
+            (cu_FIRST::MAX_READ + ... + cu_REST::MAX_READ);
+        static  constexpr   size_type   MALFORMED = cu_FIRST::MALFORMED;
+
+        typedef uchar   buffer_type [MAX_SIZE];
+
+       // Returns the number of bytes written. buffer must have room for
+       // MAX_SIZE bytes.
+       //
+        static inline size_type
+        encode (uchar *buffer, const struct_type &msg) throw ()  {
+
+            size_type   pos = cu_FIRST::encode (buffer, msg);
+
+            ((pos += cu_REST::encode (buffer + pos, msg)), ...);
+            return (pos);
+        }
+
+       // Returns the number of bytes consumed. The message must be complete
+       // in buffer.
+       //
+        static inline size_type
+        decode (const uchar *buffer, struct_type &msg) throw ()  {
+
+            size_type   pos = cu_FIRST::decode (buffer, msg);
+
+            ((pos += cu_REST::decode (buffer + pos, msg)), ...);
+            return (pos);
+        }
+
+       // For buffers that may end in the middle of a message, e.g. socket
+       // reads. Returns 0, and leaves msg alone, if the message is not
+       // complete in buffer_size bytes, or MALFORMED if a field in it is
+       // overlong. The fields are only scanned for their stop bits when
+       // the buffer is shorter than MAX_READ, the most the decoders can
+       // read of a message, malformed or not.
+       //
+        static inline size_type
+        decode (const uchar *buffer,
+                size_type buffer_size,
+                struct_type &msg) throw ()  {
+
+            if (buffer_size < MAX_READ)  {
+                const   size_type   len = _length (buffer, buffer_size);
+
+                if (len == 0 || len == MALFORMED)
+                    return (len);
+            }
+            return (decode (buffer, msg));
+        }
+
+       // Decodes a message as it arrives, see DMScu_FASTStreamDecoder.
+       // Returns _need_more_ when the chunk is used up, and resumes at the
+       // same field after the next feed(). msg must be the same object
+       // until _done_ is returned. The stream is reset on _malformed_.
+       //
+        static inline DMScu_FASTStreamDecoder::STATUS
+        decode (DMScu_FASTStreamDecoder &stream, struct_type &msg) throw ()  {
+
+            typedef DMScu_FASTStreamDecoder::STATUS
+                (*_FieldDecoder) (DMScu_FASTStreamDecoder &, struct_type &);
+
+            static  const   _FieldDecoder   decoders [] = {
+                &cu_FIRST::decode, &cu_REST::decode ...
+            };
+
+            for (size_type i = stream.field_index (); i < FIELD_COUNT; ++i)  {
+                const   DMScu_FASTStreamDecoder::STATUS status =
+                    (*decoders [i]) (stream, msg);
+
+                if (status != DMScu_FASTStreamDecoder::_done_)  {
+                    if (status == DMScu_FASTStreamDecoder::_malformed_)
+                        stream.reset ();
+                    return (status);
+                }
+                stream.next_field ();
+            }
+
+            stream.end_message ();
+            return (DMScu_FASTStreamDecoder::_done_);
+        }
+
+    private:
+
+       // The length of the message, or 0 or MALFORMED as the first field
+       // that is not complete or is overlong
+       //
+        static inline size_type
+        _length (const uchar *buffer, size_type buffer_size) throw ()  {
+
+            size_type   pos = cu_FIRST::length (buffer, buffer_size);
+            bool        complete = pos != 0 && pos != MALFORMED;
+
+            ((complete = complete && _add_length<cu_REST>(buffer,
+                                                          buffer_size,
+                                                          pos)), ...);
+            return (pos);
+        }
+
+        template<class cu_FIELD>
+        static inline bool
+        _add_length (const uchar *buffer,
+                     size_type buffer_size,
+                     size_type &pos) throw ()  {
+
+            const   size_type   len =
+                cu_FIELD::length (buffer + pos, buffer_size - pos);
+
+            if (len == 0 || len == MALFORMED)  {
+                pos = len;
+                return (false);
+            }
+            pos += len;
+            return (true);
+        }
+};
+
+// ----------------------------------------------------------------------------
+
+// Local Variables:
+// mode:C++
+// tab-width:4
+// c-basic-offset:4
+// End:
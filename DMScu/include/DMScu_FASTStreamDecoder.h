@@ -0,0 +1,310 @@
+// Hossein Moein
+// March 25, 2018
+// Copyright (C) 2018-2019 Hossein Moein
+// Distributed under the BSD Software License (see file License)
+
+// ----------------------------------------------------------------------------
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#include <DMScu_FASTProtocolUtilities.h>
+
+// ----------------------------------------------------------------------------
+
+// This class decodes FAST fields out of input that arrives in chunks of any
+// size, e.g. straight out of a socket receive ring. A field may straddle
+// two (or more) chunks. When a chunk ends in the middle of a field, the
+// decode method returns _need_more_ and keeps what it has decoded so far.
+// After the next feed(), the same method is called again for the same field
+// and picks up where it stopped. Nothing is re-parsed.
+//
+// The decoder also keeps a field cursor for the caller, so a message
+// decoder can be written as a switch on field_index() that resumes at the
+// field it stopped in, e.g.
+//
+//     switch (stream.field_index ())  {
+//         case 0:
+//             if ((status = stream.decode_uinteger (msg.id)) != _done_)
+//                 return (status);
+//             stream.next_field ();
+//             [[fallthrough]];
+//         case 1:
+//             ...
+//     }
+//     stream.end_message ();
+//
+// DMScu_FASTSchema::decode() does this for schema messages.
+//
+// Where at least DECODE_PADDING bytes of the chunk are left, fields are
+// decoded with the word-at-a-time decoders, so input that arrives in large
+// chunks is decoded as fast as a complete buffer.
+//
+class   DMScu_FASTStreamDecoder  {
+
+    public:
+
+        typedef DMScu_FASTProtocolUtilities FAST;
+        typedef FAST::size_type             size_type;
+        typedef unsigned char               uchar;
+
+        enum STATUS  { _done_ = 0, _need_more_ = 1, _malformed_ = 2 };
+
+        inline DMScu_FASTStreamDecoder () throw ()
+            : data_ (NULL), size_ (0), pos_ (0), field_index_ (0)  {
+
+            _reset_field ();
+        }
+
+       // The chunk is not copied. It must stay valid until it is used up,
+       // that is until a decode method returns _need_more_ (or available()
+       // is 0). A field in progress continues into the new chunk.
+       //
+        inline void feed (const uchar *data, size_type size) throw ()  {
+
+            data_ = data;
+            size_ = size;
+            pos_ = 0;
+        }
+
+       // Bytes of the current chunk that are consumed, and still to go
+       //
+        inline size_type consumed () const throw ()  { return (pos_); }
+        inline size_type available () const throw ()  {
+
+            return (size_ - pos_);
+        }
+
+       // The field cursor, see above
+       //
+        inline size_type field_index () const throw ()  {
+
+            return (field_index_);
+        }
+        inline void next_field () throw ()  { field_index_ += 1; }
+        inline void end_message () throw ()  { field_index_ = 0; }
+
+       // Drops the field in progress and the field cursor, e.g. after
+       // _malformed_ or a reconnect
+       //
+        inline void reset () throw ()  {
+
+            field_index_ = 0;
+            _reset_field ();
+        }
+
+        template<class cu_TYPE>
+        inline STATUS decode_uinteger (cu_TYPE &x) throw ()  {
+
+            return (_decode_int<false>(x));
+        }
+
+        template<class cu_TYPE>
+        inline STATUS decode_integer (cu_TYPE &x) throw ()  {
+
+            return (_decode_int<true>(x));
+        }
+
+       // The same wire format as FAST::encode_decimal()/encode_real(), an
+       // exponent byte, or WIDE_EXPONENT and an integer exponent, and then
+       // the mantissa
+       //
+        inline STATUS decode_decimal (FAST::Decimal &dec) throw ()  {
+
+            if (stage_ == 0)  {
+                if (pos_ == size_)
+                    return (_need_more_);
+
+                const   uchar   c = data_ [pos_++];
+
+                if (c == FAST::WIDE_EXPONENT)
+                    stage_ = 2;
+
+               // if the first byte has stop bit then no mantissa
+               //
+                else if ((c & 0x80) != 0)  {
+                    dec.mantissa = 0;
+                    dec.exponent = 0;
+                    is_nan_ = c == FAST::NAN_EXPONENT;
+                    return (_done_);
+                }
+                else  {
+                    exponent_ = (c & 0x40) != 0 ? ~FAST::AND_7 : 0;
+                    exponent_ |= (c & FAST::AND_7);
+                    stage_ = 1;
+                }
+            }
+            if (stage_ == 2)  {
+                const   STATUS  status = _decode_int<true>(exponent_);
+
+                if (status != _done_)
+                    return (status);
+                stage_ = 1;
+            }
+
+            const   STATUS  status = _decode_int<true>(dec.mantissa);
+
+            if (status == _done_)  {
+                dec.exponent = exponent_;
+                is_nan_ = false;
+                stage_ = 0;
+            }
+            return (status);
+        }
+
+        template<class cu_TYPE>
+        inline STATUS decode_real (cu_TYPE &x) throw ()  {
+
+            FAST::Decimal   dec;
+            const   STATUS  status = decode_decimal (dec);
+
+            if (status == _done_)
+                x = is_nan_ ? static_cast<cu_TYPE>(::sqrt (-1))
+                            : FAST::from_decimal<cu_TYPE>(dec);
+            return (status);
+        }
+
+       // Copies an ASCII string into str, NUL terminated. Characters that
+       // do not fit in capacity - 1 are dropped. length is set to the
+       // number of characters kept.
+       //
+        inline STATUS
+        decode_ascii (char *str, size_type capacity, size_type &length)
+            throw ()  {
+
+           // acc_ counts the bytes of the field, bytes_ the characters kept
+           //
+            while (pos_ < size_)  {
+                const   uchar   c = data_ [pos_++];
+
+                acc_ += 1;
+                if (bytes_ + 1 < capacity)
+                    str [bytes_++] = static_cast<char>(c & FAST::AND_7);
+                if ((c & 0x80) != 0)  {
+                   // A lone 0x80 is the empty string
+                   //
+                    if (acc_ == 1 && (c & FAST::AND_7) == 0)
+                        bytes_ = 0;
+                    if (capacity > 0)
+                        str [bytes_] = 0;
+                    length = bytes_;
+                    acc_ = 0;
+                    bytes_ = 0;
+                    return (_done_);
+                }
+            }
+
+            return (_need_more_);
+        }
+
+       // The presence map bits are returned left aligned, the first bit in
+       // the most significant bit of pmap. Maps of up to 9 bytes (63 bits)
+       // are supported.
+       //
+        inline STATUS decode_pmap (uint64_t &pmap) throw ()  {
+
+            while (pos_ < size_)  {
+                const   uchar   c = data_ [pos_++];
+
+                if (bytes_ == 9)  {
+                    _reset_field ();
+                    return (_malformed_);
+                }
+                acc_ |= static_cast<uint64_t>(c & FAST::AND_7) <<
+                            (57 - bytes_ * 7);
+                bytes_ += 1;
+                if ((c & 0x80) != 0)  {
+                    pmap = acc_;
+                    _reset_field ();
+                    return (_done_);
+                }
+            }
+
+            return (_need_more_);
+        }
+
+    private:
+
+        template<bool SIGNED, class cu_TYPE>
+        inline STATUS _decode_int (cu_TYPE &x) throw ()  {
+
+            const   size_type   max_bytes =
+                FAST::bytes_required (sizeof (cu_TYPE), SIGNED);
+
+           // Whole field in the chunk, and no field in progress. An overlong
+           // field is truncated by the wide decoders, so it is checked here
+           // the same as below.
+           //
+            if (bytes_ == 0 && size_ - pos_ >= FAST::DECODE_PADDING)  {
+                const   size_type   len =
+                    SIGNED ? FAST::decode_integer_wide (data_ + pos_, x)
+                           : FAST::decode_uinteger_wide (data_ + pos_, x);
+
+                if (len > max_bytes)  {
+                    pos_ += max_bytes;
+                    _reset_field ();
+                    return (_malformed_);
+                }
+                pos_ += len;
+                return (_done_);
+            }
+
+            while (pos_ < size_)  {
+                const   uchar   c = data_ [pos_++];
+
+                if (bytes_ == 0 && SIGNED && (c & 0x40) != 0)
+                    acc_ = ~static_cast<uint64_t>(0);
+                acc_ = (acc_ << 7) | (c & FAST::AND_7);
+                bytes_ += 1;
+                if ((c & 0x80) != 0)  {
+                    x = static_cast<cu_TYPE>(acc_);
+                    acc_ = 0;
+                    bytes_ = 0;
+                    return (_done_);
+                }
+                if (bytes_ == max_bytes)  {
+                    _reset_field ();
+                    return (_malformed_);
+                }
+            }
+
+            return (_need_more_);
+        }
+
+        inline void _reset_field () throw ()  {
+
+            acc_ = 0;
+            bytes_ = 0;
+            stage_ = 0;
+            exponent_ = 0;
+            is_nan_ = false;
+        }
+
+        const   uchar   *data_;
+        size_type       size_;
+        size_type       pos_;
+        size_type       field_index_;
+
+       // The field in progress
+       //
+        uint64_t        acc_;
+        size_type       bytes_;
+        int             stage_;
+        int             exponent_;
+        bool            is_nan_;
+
+      // These are not implemented
+      //
+        DMScu_FASTStreamDecoder (const DMScu_FASTStreamDecoder &);
+        DMScu_FASTStreamDecoder &operator = (const DMScu_FASTStreamDecoder &);
+};
+
+// ----------------------------------------------------------------------------
+
+// Local Variables:
+// mode:C++
+// tab-width:4
+// c-basic-offset:4
+// End:
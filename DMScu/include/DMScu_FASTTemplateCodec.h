@@ -0,0 +1,530 @@
+// Hossein Moein
+// March 25, 2018
+// Copyright (C) 2018-2019 Hossein Moein
+// Distributed under the BSD Software License (see file License)
+
+// ----------------------------------------------------------------------------
+
+#pragma once
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <cmath>
+#include <cstddef>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <DMScu_FASTProtocolUtilities.h>
+#include <DMScu_FixedSizeString.h>
+
+// ----------------------------------------------------------------------------
+
+// This class encodes and decodes FAST 1.1 messages described by FAST XML
+// templates. load_templates() parses the XML and compiles every template
+// into a flat list of instructions, with the presence map bits, the
+// dictionary slots and the initial values all resolved. encode() and
+// decode() only walk those lists.
+//
+// Messages are decoded into (and encoded from) user structs. Each field of
+// interest is bound to a struct member with bind(). Fields that are not
+// bound are still decoded, since they may feed dictionaries, but dropped.
+// The members must be of these types:
+//
+//     uInt32, int32     4-byte integers of the same signedness
+//     uInt64, int64     8-byte integers of the same signedness
+//     decimal           double
+//     string            DMScu_FixedSizeString<N> (ASCII only)
+//     sequence          an array of element structs plus a uint32_t length,
+//                       see bind_sequence()
+//
+// Optional fields can also be bound to a bool with bind_presence(), which
+// is false when the field was null. Otherwise a null field reads as 0 or an
+// empty string.
+//
+// The constant, default, copy, increment, delta and tail operators are
+// supported, with the global, template and named dictionaries. Groups,
+// template references, byte vectors, unicode strings and decimals with
+// separate exponent/mantissa operators are not, and load_templates()
+// refuses templates that use them.
+//
+// An instance keeps the dictionaries of one stream, so use one instance
+// per direction. All errors, bad templates, bad bindings and malformed or
+// truncated messages, are thrown as std::runtime_error. A message must be
+// complete in the buffer given to decode(). After an error the dictionaries
+// are undefined and reset() must be called, like on a FAST stream restart.
+//
+class   DMScu_FASTTemplateCodec  {
+
+    public:
+
+        typedef unsigned int    size_type;
+        typedef unsigned char   uchar;
+
+        enum FIELD_TYPE  {
+            _uint32_ = 0, _int32_ = 1, _uint64_ = 2, _int64_ = 3,
+            _decimal_ = 4, _ascii_ = 5, _sequence_ = 6
+        };
+        enum OPERATOR_TYPE  {
+            _none_ = 0, _constant_ = 1, _default_ = 2, _copy_ = 3,
+            _increment_ = 4, _delta_ = 5, _tail_ = 6
+        };
+
+        static  const   size_type   NOT_BOUND = UINT_MAX;
+
+        inline DMScu_FASTTemplateCodec ()
+            : last_template_id_ (0),
+              has_last_template_id_ (false),
+              last_template_ (NULL)  { zero_.state = _assigned_; }
+
+       // Templates can be loaded in several calls. A template id that is
+       // loaded again replaces the old template and its bindings.
+       //
+        inline void load_templates (const char *xml);
+        inline void load_template_file (const char *file_name);
+
+        inline bool has_template (size_type template_id) const throw ()  {
+
+            return (templates_.find (template_id) != templates_.end ());
+        }
+
+       // field_path is the field name. Fields inside sequences are named
+       // "Sequence.Field", and their members belong to the element struct.
+       //
+        template<class cu_STRUCT, class cu_FIELD>
+        inline void bind (size_type template_id,
+                          const char *field_path,
+                          cu_FIELD cu_STRUCT::*member);
+
+        template<class cu_STRUCT>
+        inline void bind_presence (size_type template_id,
+                                   const char *field_path,
+                                   bool cu_STRUCT::*member);
+
+       // A sequence is bound to an array of element structs and the
+       // uint32_t that holds the number of elements in it. A message with
+       // more elements than the array holds is an error.
+       //
+        template<class cu_STRUCT, class cu_ELEMENT, std::size_t cu_CAPACITY>
+        inline void bind_sequence (size_type template_id,
+                                   const char *field_path,
+                                   cu_ELEMENT (cu_STRUCT::*elements)
+                                       [cu_CAPACITY],
+                                   uint32_t cu_STRUCT::*length);
+
+       // Resets all dictionary entries and the previous template id to
+       // undefined
+       //
+        inline void reset () throw ();
+
+       // Returns the number of bytes written into buffer. msg must be the
+       // struct bound to template_id.
+       //
+        inline size_type encode (uchar *buffer,
+                                 size_type buffer_size,
+                                 size_type template_id,
+                                 const void *msg);
+
+       // Returns the template id of the message at buffer, without
+       // decoding it, so the caller can pick the struct to decode into
+       //
+        inline size_type peek_template_id (const uchar *buffer,
+                                           size_type buffer_size) const;
+
+       // Returns the number of bytes consumed from buffer. template_id
+       // is set to the id of the decoded message.
+       //
+        inline size_type decode (const uchar *buffer,
+                                 size_type buffer_size,
+                                 size_type &template_id,
+                                 void *msg);
+
+    private:
+
+        typedef DMScu_FASTProtocolUtilities FAST;
+
+        typedef void (*_StringSetter) (void *, const char *, size_type);
+        typedef void (*_StringGetter) (const void *,
+                                       const char *&,
+                                       size_type &);
+
+        enum _STATE  { _undefined_ = 0, _empty_ = 1, _assigned_ = 2 };
+
+       // A field value, a dictionary entry or an initial value. _empty_ is
+       // null. Decimals keep the mantissa in integer.
+       //
+        struct  _Value  {
+
+            _STATE      state;
+            int64_t     integer;
+            int32_t     exponent;
+            std::string str;
+
+            inline _Value () : state (_undefined_), integer (0), exponent (0)
+                {   }
+        };
+
+        struct  _Instruction  {
+
+            std::string     name;
+            FIELD_TYPE      type;
+            OPERATOR_TYPE   op;
+            bool            optional;
+            bool            pmap_bit;
+            bool            has_initial;
+            _Value          initial;
+            size_type       slot;
+            size_type       offset;
+            size_type       presence_offset;
+            _StringSetter   set_string;
+            _StringGetter   get_string;
+
+           // Sequences only. The operator and initial value above are the
+           // length's. The element instructions follow this one.
+           //
+            size_type       children;
+            size_type       element_pmap_bits;
+            size_type       length_offset;
+            size_type       stride;
+            size_type       capacity;
+
+            inline _Instruction ()
+                : type (_uint32_), op (_none_), optional (false),
+                  pmap_bit (false), has_initial (false),
+                  slot (NOT_BOUND), offset (NOT_BOUND),
+                  presence_offset (NOT_BOUND),
+                  set_string (NULL), get_string (NULL),
+                  children (0), element_pmap_bits (0),
+                  length_offset (NOT_BOUND), stride (0), capacity (0)  {   }
+        };
+
+        typedef std::vector<_Instruction>   _InstructionVector;
+
+        struct  _Template  {
+
+            size_type           id;
+            std::string         name;
+            size_type           pmap_bits;
+            _InstructionVector  instructions;
+        };
+
+        struct  _XmlNode  {
+
+            typedef std::pair<std::string, std::string> Attribute;
+
+            std::string             tag;
+            std::vector<Attribute>  attributes;
+            std::vector<_XmlNode>   children;
+
+            inline const char *attribute (const char *name) const throw ()  {
+
+                for (size_type i = 0; i < attributes.size (); ++i)
+                    if (attributes [i].first == name)
+                        return (attributes [i].second.c_str ());
+                return (NULL);
+            }
+        };
+
+        struct  _Reader  {
+
+            const   uchar   *buffer;
+            size_type       size;
+            size_type       pos;
+        };
+
+        struct  _Writer  {
+
+            uchar       *buffer;
+            size_type   size;
+            size_type   pos;
+        };
+
+        struct  _PmapReader  {
+
+            const   uchar   *bytes;
+            size_type       length;
+            size_type       bit;
+
+            inline bool next () throw ()  {
+
+                const   size_type   i = bit++;
+
+                return (i / 7 < length &&
+                        (bytes [i / 7] & (0x40 >> (i % 7))) != 0);
+            }
+        };
+
+        struct  _PmapWriter  {
+
+            size_type   start;
+            size_type   max_bytes;
+            size_type   bit;
+        };
+
+        typedef std::unordered_map<size_type, _Template>    _TemplateMap;
+        typedef std::map<std::string, size_type>            _SlotMap;
+
+        _TemplateMap        templates_;
+        _SlotMap            slots_;
+        std::vector<_Value> dictionary_;
+        size_type           last_template_id_;
+        bool                has_last_template_id_;
+        const   _Template   *last_template_;
+        _Value              zero_;
+        _Value              current_;
+        _Value              implied_;
+        std::string         scratch_;
+
+        static inline void _error (const char *format, const char *arg)  {
+
+            DMScu_FixedSizeString<1023> err;
+
+            err.printf (format, arg);
+            throw std::runtime_error (err.c_str ());
+        }
+
+       // XML parsing and template compilation
+       //
+        static inline void
+        _skip_space (const char *&cursor) throw ()  {
+
+            while (*cursor == ' ' || *cursor == '\t' ||
+                   *cursor == '\n' || *cursor == '\r')
+                ++cursor;
+        }
+        static inline std::string _unescape (const std::string &text);
+        static inline void _parse_element (const char *&cursor,
+                                           _XmlNode &node);
+        static inline void _parse_xml (const char *xml, _XmlNode &root);
+
+        static inline bool _parse_field_type (const std::string &tag,
+                                              FIELD_TYPE &type) throw ();
+        static inline void _parse_initial (const _XmlNode &node,
+                                           const char *text,
+                                           FIELD_TYPE type,
+                                           _Value &value);
+        inline void _compile_operator (const _XmlNode &op_node,
+                                       const std::string &field_name,
+                                       FIELD_TYPE type,
+                                       const std::string &dictionary,
+                                       size_type template_id,
+                                       _Instruction &ins);
+        inline void _compile_fields (const _XmlNode &parent,
+                                     const std::string &dictionary,
+                                     size_type template_id,
+                                     _InstructionVector &instructions,
+                                     size_type &pmap_bits);
+        inline void _compile_template (const _XmlNode &node,
+                                       const std::string &dictionary);
+
+       // Bindings
+       //
+        template<class cu_STRUCT, class cu_FIELD>
+        static inline size_type _offset_of (cu_FIELD cu_STRUCT::*member)
+            throw ()  {
+
+            alignas (cu_STRUCT) static  char    dummy [sizeof (cu_STRUCT)];
+            const   cu_STRUCT                   *obj =
+                reinterpret_cast<const cu_STRUCT *>(dummy);
+
+            return (static_cast<size_type>(
+                        reinterpret_cast<const char *>(&(obj->*member)) -
+                        dummy));
+        }
+
+        template<class cu_FIELD>
+        static inline
+        typename std::enable_if<std::is_integral<cu_FIELD>::value,
+                                FIELD_TYPE>::type
+        _field_type (const cu_FIELD *) throw ()  {
+
+            static_assert (sizeof (cu_FIELD) == 4 || sizeof (cu_FIELD) == 8,
+                           "FAST integers bind to 4 or 8 byte members");
+
+            if (sizeof (cu_FIELD) == 4)
+                return (std::is_signed<cu_FIELD>::value ? _int32_ : _uint32_);
+            return (std::is_signed<cu_FIELD>::value ? _int64_ : _uint64_);
+        }
+        static inline FIELD_TYPE _field_type (const double *) throw ()  {
+
+            return (_decimal_);
+        }
+        template<unsigned int cu_SIZE>
+        static inline FIELD_TYPE
+        _field_type (const DMScu_FixedSizeString<cu_SIZE> *) throw ()  {
+
+            return (_ascii_);
+        }
+
+        template<class cu_FIELD>
+        static inline _StringSetter _string_setter (const cu_FIELD *)
+            throw ()  { return (NULL); }
+        template<unsigned int cu_SIZE>
+        static inline _StringSetter
+        _string_setter (const DMScu_FixedSizeString<cu_SIZE> *) throw ()  {
+
+            return (&_set_fixed_string<cu_SIZE>);
+        }
+
+        template<class cu_FIELD>
+        static inline _StringGetter _string_getter (const cu_FIELD *)
+            throw ()  { return (NULL); }
+        template<unsigned int cu_SIZE>
+        static inline _StringGetter
+        _string_getter (const DMScu_FixedSizeString<cu_SIZE> *) throw ()  {
+
+            return (&_get_fixed_string<cu_SIZE>);
+        }
+
+       // Strings longer than the capacity are truncated
+       //
+        template<unsigned int cu_SIZE>
+        static inline void
+        _set_fixed_string (void *member, const char *str, size_type size)
+            throw ()  {
+
+            static_cast<DMScu_FixedSizeString<cu_SIZE> *>(member)->ncopy (
+                str, size < cu_SIZE ? size : cu_SIZE);
+        }
+        template<unsigned int cu_SIZE>
+        static inline void
+        _get_fixed_string (const void *member,
+                           const char *&str,
+                           size_type &size) throw ()  {
+
+            const   DMScu_FixedSizeString<cu_SIZE>  &fs =
+                *static_cast<const DMScu_FixedSizeString<cu_SIZE> *>(member);
+
+            str = fs.c_str ();
+            size = fs.size ();
+        }
+
+        inline _Instruction &_find_instruction (size_type template_id,
+                                                const char *field_path);
+
+       // Wire primitives
+       //
+        static inline size_type _stop_bit_field (const _Reader &reader);
+        static inline void _reserve (const _Writer &writer, size_type bytes);
+        static inline uint64_t _read_uint64 (_Reader &reader);
+        static inline int64_t _read_int64 (_Reader &reader);
+        static inline bool _read_uint (_Reader &reader,
+                                       bool nullable,
+                                       uint64_t &value);
+        static inline bool _read_int (_Reader &reader,
+                                      bool nullable,
+                                      int64_t &value);
+        static inline bool _read_ascii (_Reader &reader,
+                                        bool nullable,
+                                        std::string &str);
+        static inline void _read_pmap (_Reader &reader, _PmapReader &pmap);
+
+        static inline void _write_uint (_Writer &writer,
+                                        bool nullable,
+                                        bool null,
+                                        uint64_t value);
+        static inline void _write_int (_Writer &writer,
+                                       bool nullable,
+                                       bool null,
+                                       int64_t value);
+        static inline void _write_ascii (_Writer &writer,
+                                         bool nullable,
+                                         bool null,
+                                         const char *str,
+                                         size_type size);
+        static inline void _begin_pmap (_Writer &writer,
+                                        size_type bits,
+                                        _PmapWriter &pmap);
+        static inline void _set_pmap_bit (_Writer &writer,
+                                          _PmapWriter &pmap,
+                                          bool bit) throw ();
+        static inline void _end_pmap (_Writer &writer,
+                                      const _PmapWriter &pmap) throw ();
+
+       // Field values
+       //
+        static inline bool _equal (const _Instruction &ins,
+                                   const _Value &lhs,
+                                   const _Value &rhs) throw ();
+        static inline void _assign (_Value &lhs, const _Value &rhs);
+        inline bool _implied (const _Instruction &ins, _Value &value) const;
+        inline void _no_value (const _Instruction &ins) const;
+        inline const _Value &_delta_base (const _Instruction &ins) const;
+        inline const std::string &_tail_base (const _Instruction &ins) const;
+
+        inline void _read_value (_Reader &reader,
+                                 const _Instruction &ins,
+                                 _Value &value);
+        inline void _write_value (_Writer &writer,
+                                  const _Instruction &ins,
+                                  const _Value &value);
+        inline void _read_delta (_Reader &reader,
+                                 const _Instruction &ins,
+                                 _Value &value);
+        inline void _write_delta (_Writer &writer,
+                                  const _Instruction &ins,
+                                  const _Value &value);
+        inline void _read_tail (_Reader &reader,
+                                const _Instruction &ins,
+                                _Value &value);
+        inline void _write_tail (_Writer &writer,
+                                 const _Instruction &ins,
+                                 const _Value &value);
+
+        inline void _decode_field (_Reader &reader,
+                                   const _Instruction &ins,
+                                   bool bit,
+                                   _Value &value);
+        inline void _encode_field (_Writer &writer,
+                                   _PmapWriter &pmap,
+                                   const _Instruction &ins,
+                                   const _Value &value);
+
+        static inline void _store (const _Instruction &ins,
+                                   const _Value &value,
+                                   char *base);
+        static inline void _load (const _Instruction &ins,
+                                  const char *base,
+                                  _Value &value);
+
+        inline void _decode_fields (_Reader &reader,
+                                    _PmapReader &pmap,
+                                    const _InstructionVector &instructions,
+                                    size_type begin,
+                                    size_type end,
+                                    char *base);
+        inline void _encode_fields (_Writer &writer,
+                                    _PmapWriter &pmap,
+                                    const _InstructionVector &instructions,
+                                    size_type begin,
+                                    size_type end,
+                                    const char *base);
+
+        inline const _Template &_get_template (size_type template_id);
+
+      // These are not implemented
+      //
+        DMScu_FASTTemplateCodec (const DMScu_FASTTemplateCodec &);
+        DMScu_FASTTemplateCodec &operator = (const DMScu_FASTTemplateCodec &);
+};
+
+// ----------------------------------------------------------------------------
+
+#  ifdef DMS_INCLUDE_SOURCE
+#    include <DMScu_FASTTemplateCodec.tcc>
+#  endif // DMS_INCLUDE_SOURCE
+
+// ----------------------------------------------------------------------------
+
+// Local Variables:
+// mode:C++
+// tab-width:4
+// c-basic-offset:4
+// End:
@@ -0,0 +1,1730 @@
+// Hossein Moein
+// March 25, 2018
+// Copyright (C) 2018-2019 Hossein Moein
+// Distributed under the BSD Software License (see file License)
+
+#include <DMScu_FASTTemplateCodec.h>
+
+// ----------------------------------------------------------------------------
+
+std::string DMScu_FASTTemplateCodec::_unescape (const std::string &text)  {
+
+    static  const   char    *entities [][2] = {
+        { "&lt;", "<" }, { "&gt;", ">" }, { "&amp;", "&" },
+        { "&quot;", "\"" }, { "&apos;", "'" }
+    };
+
+    std::string result;
+
+    for (std::string::size_type i = 0; i < text.size (); )  {
+        bool    found = false;
+
+        if (text [i] == '&')
+            for (size_type e = 0; e < 5 && ! found; ++e)  {
+                const   size_type   len = ::strlen (entities [e][0]);
+
+                if (text.compare (i, len, entities [e][0]) == 0)  {
+                    result += entities [e][1];
+                    i += len;
+                    found = true;
+                }
+            }
+        if (! found)
+            result += text [i++];
+    }
+
+    return (result);
+}
+
+// ----------------------------------------------------------------------------
+
+void DMScu_FASTTemplateCodec::
+_parse_element (const char *&cursor, _XmlNode &node)  {
+
+   // cursor is at the '<' of the start tag
+   //
+    const   char    *start = ++cursor;
+
+    while (*cursor && ::strchr (" \t\r\n/>", *cursor) == NULL)
+        ++cursor;
+    node.tag.assign (start, cursor - start);
+
+   // Drop the namespace prefix
+   //
+    const   std::string::size_type  colon = node.tag.find (':');
+
+    if (colon != std::string::npos)
+        node.tag.erase (0, colon + 1);
+
+    while (true)  {
+        _skip_space (cursor);
+        if (*cursor == '/' && cursor [1] == '>')  {
+            cursor += 2;
+            return;
+        }
+        if (*cursor == '>')  {
+            ++cursor;
+            break;
+        }
+        if (*cursor == 0)
+            _error ("DMScu_FASTTemplateCodec::_parse_element(): "
+                    "Unterminated tag <%s>", node.tag.c_str ());
+
+        start = cursor;
+        while (*cursor && ::strchr (" \t\r\n=/>", *cursor) == NULL)
+            ++cursor;
+
+        _XmlNode::Attribute attr;
+
+        attr.first.assign (start, cursor - start);
+        _skip_space (cursor);
+        if (*cursor != '=')
+            _error ("DMScu_FASTTemplateCodec::_parse_element(): "
+                    "Attribute without a value in <%s>", node.tag.c_str ());
+        ++cursor;
+        _skip_space (cursor);
+
+        const   char    quote = *cursor;
+
+        if (quote != '"' && quote != '\'')
+            _error ("DMScu_FASTTemplateCodec::_parse_element(): "
+                    "Unquoted attribute value in <%s>", node.tag.c_str ());
+        start = ++cursor;
+        while (*cursor && *cursor != quote)
+            ++cursor;
+        if (*cursor == 0)
+            _error ("DMScu_FASTTemplateCodec::_parse_element(): "
+                    "Unterminated attribute value in <%s>",
+                    node.tag.c_str ());
+        attr.second = _unescape (std::string (start, cursor - start));
+        ++cursor;
+        node.attributes.push_back (attr);
+    }
+
+   // Children, up to the end tag. Text is ignored.
+   //
+    while (true)  {
+        while (*cursor && *cursor != '<')
+            ++cursor;
+        if (*cursor == 0)
+            _error ("DMScu_FASTTemplateCodec::_parse_element(): "
+                    "No end tag for <%s>", node.tag.c_str ());
+
+        const   char    *skip_to = NULL;
+
+        if (::strncmp (cursor, "<!--", 4) == 0)
+            skip_to = "-->";
+        else if (::strncmp (cursor, "<![CDATA[", 9) == 0)
+            skip_to = "]]>";
+        else if (::strncmp (cursor, "<?", 2) == 0)
+            skip_to = "?>";
+        if (skip_to != NULL)  {
+            const   char    *end = ::strstr (cursor, skip_to);
+
+            if (end == NULL)
+                _error ("DMScu_FASTTemplateCodec::_parse_element(): "
+                        "Unterminated markup in <%s>", node.tag.c_str ());
+            cursor = end + ::strlen (skip_to);
+            continue;
+        }
+
+        if (cursor [1] == '/')  {
+            start = cursor += 2;
+            while (*cursor && ::strchr (" \t\r\n>", *cursor) == NULL)
+                ++cursor;
+
+            std::string end_tag (start, cursor - start);
+            const   std::string::size_type  end_colon = end_tag.find (':');
+
+            if (end_colon != std::string::npos)
+                end_tag.erase (0, end_colon + 1);
+            if (end_tag != node.tag)
+                _error ("DMScu_FASTTemplateCodec::_parse_element(): "
+                        "Mismatched end tag of <%s>", node.tag.c_str ());
+            _skip_space (cursor);
+            if (*cursor != '>')
+                _error ("DMScu_FASTTemplateCodec::_parse_element(): "
+                        "Unterminated end tag of <%s>", node.tag.c_str ());
+            ++cursor;
+            return;
+        }
+
+        node.children.push_back (_XmlNode ());
+        _parse_element (cursor, node.children.back ());
+    }
+}
+
+// ----------------------------------------------------------------------------
+
+void DMScu_FASTTemplateCodec::_parse_xml (const char *xml, _XmlNode &root)  {
+
+    const   char    *cursor = xml;
+
+   // The prolog: declarations, comments and doctype
+   //
+    while (true)  {
+        _skip_space (cursor);
+        if (*cursor != '<')
+            _error ("DMScu_FASTTemplateCodec::_parse_xml(): "
+                    "No root element%s", "");
+
+        const   char    *skip_to = NULL;
+
+        if (::strncmp (cursor, "<?", 2) == 0)
+            skip_to = "?>";
+        else if (::strncmp (cursor, "<!--", 4) == 0)
+            skip_to = "-->";
+        else if (::strncmp (cursor, "<!", 2) == 0)
+            skip_to = ">";
+        if (skip_to == NULL)
+            break;
+
+        const   char    *end = ::strstr (cursor, skip_to);
+
+        if (end == NULL)
+            _error ("DMScu_FASTTemplateCodec::_parse_xml(): "
+                    "Unterminated markup%s", "");
+        cursor = end + ::strlen (skip_to);
+    }
+
+    _parse_element (cursor, root);
+    return;
+}
+
+// ----------------------------------------------------------------------------
+
+bool DMScu_FASTTemplateCodec::
+_parse_field_type (const std::string &tag, FIELD_TYPE &type) throw ()  {
+
+    if (tag == "uInt32")
+        type = _uint32_;
+    else if (tag == "int32")
+        type = _int32_;
+    else if (tag == "uInt64")
+        type = _uint64_;
+    else if (tag == "int64")
+        type = _int64_;
+    else if (tag == "decimal")
+        type = _decimal_;
+    else if (tag == "string")
+        type = _ascii_;
+    else if (tag == "sequence")
+        type = _sequence_;
+    else
+        return (false);
+
+    return (true);
+}
+
+// ----------------------------------------------------------------------------
+
+void DMScu_FASTTemplateCodec::
+_parse_initial (const _XmlNode &node,
+                const char *text,
+                FIELD_TYPE type,
+                _Value &value)  {
+
+    char    *end = NULL;
+
+    value.state = _assigned_;
+    switch (type)  {
+        case _ascii_:
+            value.str = text;
+            return;
+
+        case _decimal_:  {
+           // Exact, as digits and a power of 10, not through a double
+           //
+            const   char    *cursor = text;
+            const   bool    negative = *cursor == '-';
+            bool            has_digits = false;
+
+            if (*cursor == '-' || *cursor == '+')
+                ++cursor;
+            value.integer = 0;
+            value.exponent = 0;
+            for (; *cursor >= '0' && *cursor <= '9'; ++cursor)  {
+                value.integer = value.integer * 10 + (*cursor - '0');
+                has_digits = true;
+            }
+            if (*cursor == '.')
+                for (++cursor; *cursor >= '0' && *cursor <= '9'; ++cursor)  {
+                    value.integer = value.integer * 10 + (*cursor - '0');
+                    value.exponent -= 1;
+                    has_digits = true;
+                }
+            if (has_digits && (*cursor == 'e' || *cursor == 'E'))  {
+                value.exponent +=
+                    static_cast<int32_t>(::strtol (cursor + 1, &end, 10));
+                cursor = end;
+            }
+            if (! has_digits || *cursor != 0)
+                break;
+
+            while (value.integer != 0 && value.integer % 10 == 0)  {
+                value.integer /= 10;
+                value.exponent += 1;
+            }
+            if (value.integer == 0)
+                value.exponent = 0;
+            if (negative)
+                value.integer = -value.integer;
+            return;
+        }
+
+        case _int32_:
+        case _int64_:
+            value.integer = ::strtoll (text, &end, 10);
+            if (*text != 0 && *end == 0)
+                return;
+            break;
+
+        default:
+            value.integer =
+                static_cast<int64_t>(::strtoull (text, &end, 10));
+            if (*text != 0 && *end == 0)
+                return;
+            break;
+    }
+
+    DMScu_FixedSizeString<1023> err;
+
+    err.printf ("DMScu_FASTTemplateCodec::_parse_initial(): "
+                "Bad value '%s' in <%s>", text, node.tag.c_str ());
+    throw std::runtime_error (err.c_str ());
+}
+
+// ----------------------------------------------------------------------------
+
+void DMScu_FASTTemplateCodec::
+_compile_operator (const _XmlNode &op_node,
+                   const std::string &field_name,
+                   FIELD_TYPE type,
+                   const std::string &dictionary,
+                   size_type template_id,
+                   _Instruction &ins)  {
+
+    const   std::string &tag = op_node.tag;
+
+    if (tag == "constant")
+        ins.op = _constant_;
+    else if (tag == "default")
+        ins.op = _default_;
+    else if (tag == "copy")
+        ins.op = _copy_;
+    else if (tag == "increment")
+        ins.op = _increment_;
+    else if (tag == "delta")
+        ins.op = _delta_;
+    else if (tag == "tail")
+        ins.op = _tail_;
+
+    if ((ins.op == _increment_ && (type == _decimal_ || type == _ascii_)) ||
+        (ins.op == _tail_ && type != _ascii_))
+        _error ("DMScu_FASTTemplateCodec::_compile_operator(): "
+                "Operator not allowed on field '%s'", field_name.c_str ());
+
+    const   char    *value = op_node.attribute ("value");
+
+    if (value != NULL)  {
+        _parse_initial (op_node, value, type, ins.initial);
+        ins.has_initial = true;
+    }
+    else if (ins.op == _constant_)
+        _error ("DMScu_FASTTemplateCodec::_compile_operator(): "
+                "Constant field '%s' has no value", field_name.c_str ());
+
+   // See the presence map table of the FAST spec
+   //
+    ins.pmap_bit = ins.op == _default_ || ins.op == _copy_ ||
+                   ins.op == _increment_ || ins.op == _tail_ ||
+                   (ins.op == _constant_ && ins.optional);
+
+    if (ins.op == _copy_ || ins.op == _increment_ ||
+        ins.op == _delta_ || ins.op == _tail_)  {
+        const   char    *dict_attr = op_node.attribute ("dictionary");
+        const   char    *key_attr = op_node.attribute ("key");
+        std::string     dict = dict_attr != NULL ? dict_attr : dictionary;
+
+        if (dict == "template")  {
+            DMScu_FixedSizeString<63>   scope;
+
+            scope.printf ("template:%u", template_id);
+            dict = scope.c_str ();
+        }
+
+        const   std::string key =
+            dict + "/" + (key_attr != NULL ? key_attr : field_name);
+        const   _SlotMap::const_iterator    citer = slots_.find (key);
+
+        if (citer != slots_.end ())
+            ins.slot = citer->second;
+        else  {
+            ins.slot = static_cast<size_type>(dictionary_.size ());
+            slots_.insert (_SlotMap::value_type (key, ins.slot));
+            dictionary_.push_back (_Value ());
+        }
+    }
+
+    return;
+}
+
+// ----------------------------------------------------------------------------
+
+void DMScu_FASTTemplateCodec::
+_compile_fields (const _XmlNode &parent,
+                 const std::string &dictionary,
+                 size_type template_id,
+                 _InstructionVector &instructions,
+                 size_type &pmap_bits)  {
+
+    for (size_type i = 0; i < parent.children.size (); ++i)  {
+        const   _XmlNode    &node = parent.children [i];
+        FIELD_TYPE          type;
+
+        if (node.tag == "length" || node.tag == "typeRef")
+            continue;
+        if (! _parse_field_type (node.tag, type))
+            _error ("DMScu_FASTTemplateCodec::_compile_fields(): "
+                    "<%s> is not supported", node.tag.c_str ());
+
+        const   char    *name = node.attribute ("name");
+        const   char    *presence = node.attribute ("presence");
+        const   char    *charset = node.attribute ("charset");
+        const   char    *dict_attr = node.attribute ("dictionary");
+        const   std::string dict = dict_attr != NULL ? dict_attr : dictionary;
+
+        if (name == NULL)
+            _error ("DMScu_FASTTemplateCodec::_compile_fields(): "
+                    "<%s> has no name", node.tag.c_str ());
+        if (charset != NULL && ::strcmp (charset, "ascii") != 0)
+            _error ("DMScu_FASTTemplateCodec::_compile_fields(): "
+                    "Unicode string '%s' is not supported", name);
+
+        _Instruction    ins;
+
+        ins.name = name;
+        ins.type = type;
+        ins.optional =
+            presence != NULL && ::strcmp (presence, "optional") == 0;
+
+       // A sequence's operator is on its <length>, and it is an uInt32
+       //
+        const   _XmlNode    *op_parent = &node;
+        std::string         op_name = ins.name;
+
+        if (type == _sequence_)  {
+            op_parent = NULL;
+            for (size_type c = 0; c < node.children.size (); ++c)
+                if (node.children [c].tag == "length")  {
+                    const   char    *length_name =
+                        node.children [c].attribute ("name");
+
+                    op_parent = &(node.children [c]);
+                    if (length_name != NULL)
+                        op_name = length_name;
+                    break;
+                }
+        }
+
+        for (size_type c = 0; op_parent && c < op_parent->children.size ();
+             ++c)  {
+            const   _XmlNode    &child = op_parent->children [c];
+
+            if (child.tag == "exponent" || child.tag == "mantissa")
+                _error ("DMScu_FASTTemplateCodec::_compile_fields(): "
+                        "Decimal '%s' with separate operators is not "
+                        "supported", name);
+            if (child.tag == "constant" || child.tag == "default" ||
+                child.tag == "copy" || child.tag == "increment" ||
+                child.tag == "delta" || child.tag == "tail")  {
+                _compile_operator (child, op_name,
+                                   type == _sequence_ ? _uint32_ : type,
+                                   dict, template_id, ins);
+                break;
+            }
+        }
+
+        if (ins.pmap_bit)
+            pmap_bits += 1;
+
+        const   size_type   index =
+            static_cast<size_type>(instructions.size ());
+
+        instructions.push_back (ins);
+        if (type == _sequence_)  {
+            size_type   element_bits = 0;
+
+            _compile_fields (node, dict, template_id,
+                             instructions, element_bits);
+            instructions [index].children =
+                static_cast<size_type>(instructions.size ()) - index - 1;
+            instructions [index].element_pmap_bits = element_bits;
+        }
+    }
+
+    return;
+}
+
+// ----------------------------------------------------------------------------
+
+void DMScu_FASTTemplateCodec::
+_compile_template (const _XmlNode &node, const std::string &dictionary)  {
+
+    const   char    *id = node.attribute ("id");
+    const   char    *name = node.attribute ("name");
+    const   char    *dict_attr = node.attribute ("dictionary");
+    char            *end = NULL;
+
+    if (id == NULL)
+        _error ("DMScu_FASTTemplateCodec::_compile_template(): "
+                "Template '%s' has no id", name != NULL ? name : "");
+
+    _Template   tmpl;
+
+    tmpl.id = static_cast<size_type>(::strtoul (id, &end, 10));
+    if (*id == 0 || *end != 0)
+        _error ("DMScu_FASTTemplateCodec::_compile_template(): "
+                "Bad template id '%s'", id);
+    tmpl.name = name != NULL ? name : "";
+    tmpl.pmap_bits = 1;  // The template id
+    _compile_fields (node,
+                     dict_attr != NULL ? dict_attr : dictionary,
+                     tmpl.id,
+                     tmpl.instructions,
+                     tmpl.pmap_bits);
+
+    templates_ [tmpl.id] = tmpl;
+    last_template_ = NULL;
+    return;
+}
+
+// ----------------------------------------------------------------------------
+
+void DMScu_FASTTemplateCodec::load_templates (const char *xml)  {
+
+    _XmlNode    root;
+
+    _parse_xml (xml, root);
+
+    const   char        *dict_attr = root.attribute ("dictionary");
+    const   std::string dictionary = dict_attr != NULL ? dict_attr : "global";
+
+    if (root.tag == "template")
+        _compile_template (root, dictionary);
+    else if (root.tag == "templates")  {
+        for (size_type i = 0; i < root.children.size (); ++i)
+            if (root.children [i].tag == "template")
+                _compile_template (root.children [i], dictionary);
+    }
+    else
+        _error ("DMScu_FASTTemplateCodec::load_templates(): "
+                "Unexpected root element <%s>", root.tag.c_str ());
+
+    return;
+}
+
+// ----------------------------------------------------------------------------
+
+void DMScu_FASTTemplateCodec::load_template_file (const char *file_name)  {
+
+    std::ifstream   file (file_name);
+
+    if (! file)
+        _error ("DMScu_FASTTemplateCodec::load_template_file(): "
+                "Cannot open '%s'", file_name);
+
+    std::stringstream   content;
+
+    content << file.rdbuf ();
+    load_templates (content.str ().c_str ());
+    return;
+}
+
+// ----------------------------------------------------------------------------
+
+DMScu_FASTTemplateCodec::_Instruction &DMScu_FASTTemplateCodec::
+_find_instruction (size_type template_id, const char *field_path)  {
+
+    const   _TemplateMap::iterator  iter = templates_.find (template_id);
+
+    if (iter == templates_.end ())
+        _error ("DMScu_FASTTemplateCodec::_find_instruction(): "
+                "No template for field '%s'", field_path);
+
+    _InstructionVector  &instructions = iter->second.instructions;
+    size_type           begin = 0;
+    size_type           end = static_cast<size_type>(instructions.size ());
+    const   char        *part = field_path;
+
+    while (true)  {
+        const   char        *dot = ::strchr (part, '.');
+        const   std::string name =
+            dot != NULL ? std::string (part, dot - part) : std::string (part);
+        size_type           i = begin;
+
+        for (; i < end; i += 1 + instructions [i].children)
+            if (instructions [i].name == name)
+                break;
+        if (i >= end)
+            _error ("DMScu_FASTTemplateCodec::_find_instruction(): "
+                    "No field '%s'", field_path);
+        if (dot == NULL)
+            return (instructions [i]);
+        if (instructions [i].type != _sequence_)
+            _error ("DMScu_FASTTemplateCodec::_find_instruction(): "
+                    "'%s' goes through a field that is not a sequence",
+                    field_path);
+
+        begin = i + 1;
+        end = begin + instructions [i].children;
+        part = dot + 1;
+    }
+}
+
+// ----------------------------------------------------------------------------
+
+template<class cu_STRUCT, class cu_FIELD>
+void DMScu_FASTTemplateCodec::bind (size_type template_id,
+                                    const char *field_path,
+                                    cu_FIELD cu_STRUCT::*member)  {
+
+    _Instruction    &ins = _find_instruction (template_id, field_path);
+    const   cu_FIELD    *type_tag = NULL;
+
+    if (_field_type (type_tag) != ins.type)
+        _error ("DMScu_FASTTemplateCodec::bind(): "
+                "The member type does not match field '%s'", field_path);
+
+    ins.offset = _offset_of (member);
+    ins.set_string = _string_setter (type_tag);
+    ins.get_string = _string_getter (type_tag);
+    return;
+}
+
+// ----------------------------------------------------------------------------
+
+template<class cu_STRUCT>
+void DMScu_FASTTemplateCodec::bind_presence (size_type template_id,
+                                             const char *field_path,
+                                             bool cu_STRUCT::*member)  {
+
+    _Instruction    &ins = _find_instruction (template_id, field_path);
+
+    if (! ins.optional)
+        _error ("DMScu_FASTTemplateCodec::bind_presence(): "
+                "Field '%s' is not optional", field_path);
+
+    ins.presence_offset = _offset_of (member);
+    return;
+}
+
+// ----------------------------------------------------------------------------
+
+template<class cu_STRUCT, class cu_ELEMENT, std::size_t cu_CAPACITY>
+void DMScu_FASTTemplateCodec::
+bind_sequence (size_type template_id,
+               const char *field_path,
+               cu_ELEMENT (cu_STRUCT::*elements) [cu_CAPACITY],
+               uint32_t cu_STRUCT::*length)  {
+
+    _Instruction    &ins = _find_instruction (template_id, field_path);
+
+    if (ins.type != _sequence_)
+        _error ("DMScu_FASTTemplateCodec::bind_sequence(): "
+                "Field '%s' is not a sequence", field_path);
+
+    ins.offset = _offset_of (elements);
+    ins.length_offset = _offset_of (length);
+    ins.stride = sizeof (cu_ELEMENT);
+    ins.capacity = cu_CAPACITY;
+    return;
+}
+
+// ----------------------------------------------------------------------------
+
+void DMScu_FASTTemplateCodec::reset () throw ()  {
+
+    for (size_type i = 0; i < dictionary_.size (); ++i)  {
+        dictionary_ [i].state = _undefined_;
+        dictionary_ [i].str.clear ();
+    }
+    has_last_template_id_ = false;
+    return;
+}
+
+// ----------------------------------------------------------------------------
+
+DMScu_FASTTemplateCodec::size_type DMScu_FASTTemplateCodec::
+_stop_bit_field (const _Reader &reader)  {
+
+    const   uchar       *field = reader.buffer + reader.pos;
+    const   size_type   remaining = reader.size - reader.pos;
+
+    for (size_type i = 0; i < remaining; ++i)
+        if (FAST::is_final (field [i]))
+            return (i + 1);
+
+    _error ("DMScu_FASTTemplateCodec::_stop_bit_field(): "
+            "Truncated message%s", "");
+    return (0);
+}
+
+// ----------------------------------------------------------------------------
+
+void DMScu_FASTTemplateCodec::
+_reserve (const _Writer &writer, size_type bytes)  {
+
+    if (writer.size - writer.pos < bytes)
+        _error ("DMScu_FASTTemplateCodec::_reserve(): "
+                "The buffer is too small%s", "");
+    return;
+}
+
+// ----------------------------------------------------------------------------
+
+uint64_t DMScu_FASTTemplateCodec::_read_uint64 (_Reader &reader)  {
+
+    uint64_t    value;
+    size_type   len;
+
+   // The word-at-a-time decoder, unless it would read past the end.
+   // Both decoders stop at an overlong field, so its length is checked
+   // after either.
+   //
+    if (reader.size - reader.pos >= FAST::DECODE_PADDING)
+        len = FAST::decode_uinteger_wide (reader.buffer + reader.pos, value);
+    else  {
+        len = _stop_bit_field (reader);
+        FAST::decode_uinteger (reader.buffer + reader.pos, value);
+    }
+    if (len > FAST::bytes_required (sizeof (value), false))
+        _error ("DMScu_FASTTemplateCodec::_read_uint64(): "
+                "Integer overflow%s", "");
+    reader.pos += len;
+    return (value);
+}
+
+// ----------------------------------------------------------------------------
+
+int64_t DMScu_FASTTemplateCodec::_read_int64 (_Reader &reader)  {
+
+    int64_t     value;
+    size_type   len;
+
+    if (reader.size - reader.pos >= FAST::DECODE_PADDING)
+        len = FAST::decode_integer_wide (reader.buffer + reader.pos, value);
+    else  {
+        len = _stop_bit_field (reader);
+        FAST::decode_integer (reader.buffer + reader.pos, value);
+    }
+    if (len > FAST::bytes_required (sizeof (value), false))
+        _error ("DMScu_FASTTemplateCodec::_read_int64(): "
+                "Integer overflow%s", "");
+    reader.pos += len;
+    return (value);
+}
+
+// ----------------------------------------------------------------------------
+
+// Nullable integers are sent plus one, if they are not negative, so that 0
+// can be null. These return false for null.
+//
+bool DMScu_FASTTemplateCodec::
+_read_uint (_Reader &reader, bool nullable, uint64_t &value)  {
+
+    value = _read_uint64 (reader);
+    if (nullable)  {
+        if (value == 0)
+            return (false);
+        value -= 1;
+    }
+
+    return (true);
+}
+
+// ----------------------------------------------------------------------------
+
+bool DMScu_FASTTemplateCodec::
+_read_int (_Reader &reader, bool nullable, int64_t &value)  {
+
+    value = _read_int64 (reader);
+    if (nullable)  {
+        if (value == 0)
+            return (false);
+        if (value > 0)
+            value -= 1;
+    }
+
+    return (true);
+}
+
+// ----------------------------------------------------------------------------
+
+// A single 0x80 is the empty string, or null if nullable. The empty
+// nullable string is 0x00 0x80.
+//
+bool DMScu_FASTTemplateCodec::
+_read_ascii (_Reader &reader, bool nullable, std::string &str)  {
+
+    const   size_type   len = _stop_bit_field (reader);
+    const   uchar       *field = reader.buffer + reader.pos;
+
+    reader.pos += len;
+    if (len == 1 && field [0] == 0x80)  {
+        str.clear ();
+        return (! nullable);
+    }
+    if (nullable && len == 2 && field [0] == 0 && field [1] == 0x80)  {
+        str.clear ();
+        return (true);
+    }
+
+    str.assign (reinterpret_cast<const char *>(field), len);
+    str [len - 1] &= FAST::AND_7;
+    return (true);
+}
+
+// ----------------------------------------------------------------------------
+
+void DMScu_FASTTemplateCodec::
+_read_pmap (_Reader &reader, _PmapReader &pmap)  {
+
+    pmap.length = _stop_bit_field (reader);
+    pmap.bytes = reader.buffer + reader.pos;
+    pmap.bit = 0;
+    reader.pos += pmap.length;
+    return;
+}
+
+// ----------------------------------------------------------------------------
+
+void DMScu_FASTTemplateCodec::
+_write_uint (_Writer &writer, bool nullable, bool null, uint64_t value)  {
+
+    if (null)
+        value = 0;
+    else if (nullable)
+        value += 1;
+
+    const   size_type   bytes =
+        FAST::encode_uintegers (writer.buffer + writer.pos,
+                                writer.size - writer.pos, &value, 1);
+
+    if (bytes == 0)
+        _error ("DMScu_FASTTemplateCodec::_write_%s(): "
+                "The buffer is too small", "uint");
+    writer.pos += bytes;
+    return;
+}
+
+// ----------------------------------------------------------------------------
+
+void DMScu_FASTTemplateCodec::
+_write_int (_Writer &writer, bool nullable, bool null, int64_t value)  {
+
+    if (null)
+        value = 0;
+    else if (nullable && value >= 0)
+        value += 1;
+
+    const   size_type   bytes =
+        FAST::encode_integers (writer.buffer + writer.pos,
+                               writer.size - writer.pos, &value, 1);
+
+    if (bytes == 0)
+        _error ("DMScu_FASTTemplateCodec::_write_%s(): "
+                "The buffer is too small", "int");
+    writer.pos += bytes;
+    return;
+}
+
+// ----------------------------------------------------------------------------
+
+void DMScu_FASTTemplateCodec::
+_write_ascii (_Writer &writer,
+              bool nullable,
+              bool null,
+              const char *str,
+              size_type size)  {
+
+    uchar   *field = writer.buffer + writer.pos;
+
+    if (null || (size == 0 && ! nullable))  {
+        _reserve (writer, 1);
+        field [0] = 0x80;
+        writer.pos += 1;
+    }
+    else if (size == 0)  {
+        _reserve (writer, 2);
+        field [0] = 0;
+        field [1] = 0x80;
+        writer.pos += 2;
+    }
+    else  {
+        _reserve (writer, size);
+        for (size_type i = 0; i < size; ++i)
+            field [i] = static_cast<uchar>(str [i]) & FAST::AND_7;
+        field [size - 1] |= 0x80;
+        writer.pos += size;
+    }
+
+    return;
+}
+
+// ----------------------------------------------------------------------------
+
+// The presence map space is reserved for all bits first, and what is not
+// used is given back in _end_pmap(), since trailing zero bytes are not sent
+//
+void DMScu_FASTTemplateCodec::
+_begin_pmap (_Writer &writer, size_type bits, _PmapWriter &pmap)  {
+
+    pmap.start = writer.pos;
+    pmap.max_bytes = bits == 0 ? 1 : (bits + 6) / 7;
+    pmap.bit = 0;
+    _reserve (writer, pmap.max_bytes);
+    ::memset (writer.buffer + pmap.start, 0, pmap.max_bytes);
+    writer.pos += pmap.max_bytes;
+    return;
+}
+
+// ----------------------------------------------------------------------------
+
+void DMScu_FASTTemplateCodec::
+_set_pmap_bit (_Writer &writer, _PmapWriter &pmap, bool bit) throw ()  {
+
+    const   size_type   i = pmap.bit++;
+
+    if (bit)
+        writer.buffer [pmap.start + i / 7] |= 0x40 >> (i % 7);
+    return;
+}
+
+// ----------------------------------------------------------------------------
+
+void DMScu_FASTTemplateCodec::
+_end_pmap (_Writer &writer, const _PmapWriter &pmap) throw ()  {
+
+    uchar       *bytes = writer.buffer + pmap.start;
+    size_type   used = pmap.max_bytes;
+
+    while (used > 1 && bytes [used - 1] == 0)
+        used -= 1;
+    bytes [used - 1] |= 0x80;
+
+    if (used < pmap.max_bytes)  {
+        const   size_type   body = pmap.start + pmap.max_bytes;
+
+        ::memmove (bytes + used, writer.buffer + body, writer.pos - body);
+        writer.pos -= pmap.max_bytes - used;
+    }
+
+    return;
+}
+
+// ----------------------------------------------------------------------------
+
+bool DMScu_FASTTemplateCodec::
+_equal (const _Instruction &ins, const _Value &lhs, const _Value &rhs)
+    throw ()  {
+
+    if (lhs.state != rhs.state)
+        return (false);
+    if (lhs.state != _assigned_)
+        return (true);
+
+    switch (ins.type)  {
+        case _ascii_:
+            return (lhs.str == rhs.str);
+        case _decimal_:
+            return (lhs.integer == rhs.integer &&
+                    lhs.exponent == rhs.exponent);
+        default:
+            return (lhs.integer == rhs.integer);
+    }
+}
+
+// ----------------------------------------------------------------------------
+
+void DMScu_FASTTemplateCodec::_assign (_Value &lhs, const _Value &rhs)  {
+
+    lhs.state = rhs.state;
+    lhs.integer = rhs.integer;
+    lhs.exponent = rhs.exponent;
+    lhs.str = rhs.str;
+    return;
+}
+
+// ----------------------------------------------------------------------------
+
+// The value of a field that is not on the wire (its presence map bit is 0).
+// Returns false if there is none, which is an error for mandatory fields.
+//
+bool DMScu_FASTTemplateCodec::
+_implied (const _Instruction &ins, _Value &value) const  {
+
+    if (ins.op == _copy_ || ins.op == _increment_ || ins.op == _tail_)  {
+        const   _Value  &prev = dictionary_ [ins.slot];
+
+        if (prev.state == _assigned_)  {
+            _assign (value, prev);
+            if (ins.op == _increment_)
+                value.integer += 1;
+            return (true);
+        }
+        if (prev.state == _empty_)  {
+            value.state = _empty_;
+            return (ins.optional);
+        }
+    }
+
+   // default, or an undefined dictionary entry
+   //
+    if (ins.has_initial)  {
+        _assign (value, ins.initial);
+        return (true);
+    }
+
+    value.state = _empty_;
+    return (ins.optional);
+}
+
+// ----------------------------------------------------------------------------
+
+void DMScu_FASTTemplateCodec::_no_value (const _Instruction &ins) const  {
+
+    _error ("DMScu_FASTTemplateCodec::_no_value(): "
+            "Mandatory field '%s' has no value", ins.name.c_str ());
+    return;
+}
+
+// ----------------------------------------------------------------------------
+
+const DMScu_FASTTemplateCodec::_Value &DMScu_FASTTemplateCodec::
+_delta_base (const _Instruction &ins) const  {
+
+    const   _Value  &prev = dictionary_ [ins.slot];
+
+    if (prev.state == _assigned_)
+        return (prev);
+    if (prev.state == _empty_)
+        _error ("DMScu_FASTTemplateCodec::_delta_base(): "
+                "Delta of '%s' has an empty base", ins.name.c_str ());
+
+    return (ins.has_initial ? ins.initial : zero_);
+}
+
+// ----------------------------------------------------------------------------
+
+const std::string &DMScu_FASTTemplateCodec::
+_tail_base (const _Instruction &ins) const  {
+
+    const   _Value  &prev = dictionary_ [ins.slot];
+
+    if (prev.state == _assigned_)
+        return (prev.str);
+    return (ins.has_initial ? ins.initial.str : zero_.str);
+}
+
+// ----------------------------------------------------------------------------
+
+void DMScu_FASTTemplateCodec::
+_read_value (_Reader &reader, const _Instruction &ins, _Value &value)  {
+
+    bool    present;
+
+    switch (ins.type)  {
+        case _ascii_:
+            present = _read_ascii (reader, ins.optional, value.str);
+            break;
+
+        case _decimal_:  {
+            int64_t exponent;
+
+            present = _read_int (reader, ins.optional, exponent);
+            if (present)  {
+                if (exponent < INT32_MIN || exponent > INT32_MAX)
+                    _error ("DMScu_FASTTemplateCodec::_read_value(): "
+                            "Exponent of '%s' is out of range",
+                            ins.name.c_str ());
+                value.exponent = static_cast<int32_t>(exponent);
+                value.integer = _read_int64 (reader);
+            }
+        } break;
+
+        case _int32_:
+        case _int64_:
+            present = _read_int (reader, ins.optional, value.integer);
+            break;
+
+        default:  {
+            uint64_t    integer;
+
+            present = _read_uint (reader, ins.optional, integer);
+            value.integer = static_cast<int64_t>(integer);
+        } break;
+    }
+
+    value.state = present ? _assigned_ : _empty_;
+    return;
+}
+
+// ----------------------------------------------------------------------------
+
+void DMScu_FASTTemplateCodec::
+_write_value (_Writer &writer, const _Instruction &ins, const _Value &value)  {
+
+    const   bool    null = value.state != _assigned_;
+
+    switch (ins.type)  {
+        case _ascii_:
+            _write_ascii (writer, ins.optional, null, value.str.data (),
+                          static_cast<size_type>(value.str.size ()));
+            break;
+
+        case _decimal_:
+            _write_int (writer, ins.optional, null, value.exponent);
+            if (! null)
+                _write_int (writer, false, false, value.integer);
+            break;
+
+        case _int32_:
+        case _int64_:
+            _write_int (writer, ins.optional, null, value.integer);
+            break;
+
+        default:
+            _write_uint (writer, ins.optional, null,
+                         static_cast<uint64_t>(value.integer));
+            break;
+    }
+
+    return;
+}
+
+// ----------------------------------------------------------------------------
+
+// Integers and decimals are sent as the difference from the dictionary
+// value. Strings are sent as a number of characters to remove from the
+// back (or, if negative, from the front) of the dictionary value and the
+// characters to append (or prepend) instead.
+//
+void DMScu_FASTTemplateCodec::
+_read_delta (_Reader &reader, const _Instruction &ins, _Value &value)  {
+
+    int64_t delta;
+
+    if (! _read_int (reader, ins.optional, delta))  {
+        value.state = _empty_;
+        return;
+    }
+
+    const   _Value  &base = _delta_base (ins);
+
+    switch (ins.type)  {
+        case _ascii_:  {
+            const   uint64_t    base_size = base.str.size ();
+
+            _read_ascii (reader, false, scratch_);
+            if (delta >= 0)  {
+                if (static_cast<uint64_t>(delta) > base_size)
+                    _error ("DMScu_FASTTemplateCodec::_read_delta(): "
+                            "Bad subtraction length for '%s'",
+                            ins.name.c_str ());
+                value.str.assign (base.str, 0, base_size - delta);
+                value.str += scratch_;
+            }
+            else  {
+                const   uint64_t    front =
+                    static_cast<uint64_t>(-(delta + 1));
+
+                if (front > base_size)
+                    _error ("DMScu_FASTTemplateCodec::_read_delta(): "
+                            "Bad subtraction length for '%s'",
+                            ins.name.c_str ());
+                value.str = scratch_;
+                value.str.append (base.str, front, std::string::npos);
+            }
+        } break;
+
+        case _decimal_:  {
+            const   int64_t exponent =
+                delta < INT32_MIN || delta > INT32_MAX
+                    ? delta : base.exponent + delta;
+
+            if (exponent < INT32_MIN || exponent > INT32_MAX)
+                _error ("DMScu_FASTTemplateCodec::_read_delta(): "
+                        "Exponent of '%s' is out of range", ins.name.c_str ());
+            value.exponent = static_cast<int32_t>(exponent);
+            value.integer = static_cast<int64_t>(
+                static_cast<uint64_t>(base.integer) +
+                static_cast<uint64_t>(_read_int64 (reader)));
+        } break;
+
+        default:
+            value.integer = static_cast<int64_t>(
+                static_cast<uint64_t>(base.integer) +
+                static_cast<uint64_t>(delta));
+            break;
+    }
+
+    value.state = _assigned_;
+    return;
+}
+
+// ----------------------------------------------------------------------------
+
+void DMScu_FASTTemplateCodec::
+_write_delta (_Writer &writer, const _Instruction &ins, const _Value &value)  {
+
+    if (value.state != _assigned_)  {
+        _write_int (writer, true, true, 0);
+        return;
+    }
+
+    const   _Value  &base = _delta_base (ins);
+
+    switch (ins.type)  {
+        case _ascii_:  {
+            const   std::string &str = value.str;
+            const   size_type   base_size =
+                static_cast<size_type>(base.str.size ());
+            const   size_type   size = static_cast<size_type>(str.size ());
+            const   size_type   common = size < base_size ? size : base_size;
+            size_type           prefix = 0;
+            size_type           suffix = 0;
+
+            while (prefix < common && base.str [prefix] == str [prefix])
+                prefix += 1;
+            while (suffix < common &&
+                   base.str [base_size - 1 - suffix] ==
+                       str [size - 1 - suffix])
+                suffix += 1;
+
+            if (prefix >= suffix)  {
+                _write_int (writer, ins.optional, false, base_size - prefix);
+                _write_ascii (writer, false, false,
+                              str.data () + prefix, size - prefix);
+            }
+            else  {
+                _write_int (writer, ins.optional, false,
+                            -static_cast<int64_t>(base_size - suffix) - 1);
+                _write_ascii (writer, false, false,
+                              str.data (), size - suffix);
+            }
+        } break;
+
+        case _decimal_:
+            _write_int (writer, ins.optional, false,
+                        value.exponent - base.exponent);
+            _write_int (writer, false, false,
+                        static_cast<int64_t>(
+                            static_cast<uint64_t>(value.integer) -
+                            static_cast<uint64_t>(base.integer)));
+            break;
+
+        default:
+            _write_int (writer, ins.optional, false,
+                        static_cast<int64_t>(
+                            static_cast<uint64_t>(value.integer) -
+                            static_cast<uint64_t>(base.integer)));
+            break;
+    }
+
+    return;
+}
+
+// ----------------------------------------------------------------------------
+
+// The tail replaces as many characters at the end of the dictionary value.
+// A tail at least as long as that value replaces it all.
+//
+void DMScu_FASTTemplateCodec::
+_read_tail (_Reader &reader, const _Instruction &ins, _Value &value)  {
+
+    if (! _read_ascii (reader, ins.optional, scratch_))  {
+        value.state = _empty_;
+        return;
+    }
+
+    const   std::string &base = _tail_base (ins);
+
+    if (scratch_.size () >= base.size ())
+        value.str = scratch_;
+    else  {
+        value.str.assign (base, 0, base.size () - scratch_.size ());
+        value.str += scratch_;
+    }
+    value.state = _assigned_;
+    return;
+}
+
+// ----------------------------------------------------------------------------
+
+void DMScu_FASTTemplateCodec::
+_write_tail (_Writer &writer, const _Instruction &ins, const _Value &value)  {
+
+    if (value.state != _assigned_)  {
+        _write_ascii (writer, true, true, NULL, 0);
+        return;
+    }
+
+    const   std::string &base = _tail_base (ins);
+    const   std::string &str = value.str;
+    size_type           prefix = 0;
+
+    if (str.size () < base.size ())
+        _error ("DMScu_FASTTemplateCodec::_write_tail(): "
+                "The tail operator cannot shorten '%s'", ins.name.c_str ());
+    if (str.size () == base.size ())
+        while (prefix < str.size () && base [prefix] == str [prefix])
+            prefix += 1;
+
+    _write_ascii (writer, ins.optional, false, str.data () + prefix,
+                  static_cast<size_type>(str.size ()) - prefix);
+    return;
+}
+
+// ----------------------------------------------------------------------------
+
+void DMScu_FASTTemplateCodec::
+_decode_field (_Reader &reader,
+               const _Instruction &ins,
+               bool bit,
+               _Value &value)  {
+
+    switch (ins.op)  {
+        case _none_:
+            _read_value (reader, ins, value);
+            break;
+
+        case _constant_:
+            if (ins.optional && ! bit)
+                value.state = _empty_;
+            else
+                _assign (value, ins.initial);
+            break;
+
+        case _default_:
+            if (bit)
+                _read_value (reader, ins, value);
+            else if (! _implied (ins, value))
+                _no_value (ins);
+            break;
+
+        case _copy_:
+        case _increment_:
+        case _tail_:
+            if (bit)  {
+                if (ins.op == _tail_)
+                    _read_tail (reader, ins, value);
+                else
+                    _read_value (reader, ins, value);
+            }
+            else if (! _implied (ins, value))
+                _no_value (ins);
+            _assign (dictionary_ [ins.slot], value);
+            break;
+
+        case _delta_:
+            _read_delta (reader, ins, value);
+            if (value.state == _assigned_)
+                _assign (dictionary_ [ins.slot], value);
+            break;
+    }
+
+    if (value.state != _assigned_ && ! ins.optional)
+        _no_value (ins);
+    return;
+}
+
+// ----------------------------------------------------------------------------
+
+// Fields that are equal to what the decoder would infer are left out, with
+// a 0 presence map bit
+//
+void DMScu_FASTTemplateCodec::
+_encode_field (_Writer &writer,
+               _PmapWriter &pmap,
+               const _Instruction &ins,
+               const _Value &value)  {
+
+    switch (ins.op)  {
+        case _none_:
+            _write_value (writer, ins, value);
+            break;
+
+        case _constant_:  // Only its presence is sent
+            if (ins.optional)
+                _set_pmap_bit (writer, pmap, value.state == _assigned_);
+            break;
+
+        case _default_:
+        case _copy_:
+        case _increment_:
+        case _tail_:  {
+            const   bool    implied =
+                _implied (ins, implied_) && _equal (ins, implied_, value);
+
+            _set_pmap_bit (writer, pmap, ! implied);
+            if (! implied)  {
+                if (ins.op == _tail_)
+                    _write_tail (writer, ins, value);
+                else
+                    _write_value (writer, ins, value);
+            }
+            if (ins.op != _default_)
+                _assign (dictionary_ [ins.slot], value);
+        } break;
+
+        case _delta_:
+            _write_delta (writer, ins, value);
+            if (value.state == _assigned_)
+                _assign (dictionary_ [ins.slot], value);
+            break;
+    }
+
+    return;
+}
+
+// ----------------------------------------------------------------------------
+
+void DMScu_FASTTemplateCodec::
+_store (const _Instruction &ins, const _Value &value, char *base)  {
+
+    const   bool    null = value.state != _assigned_;
+
+   // Whatever operator produced it, a 32-bit value must fit its type
+   //
+    if (! null &&
+        ((ins.type == _uint32_ &&
+          static_cast<uint64_t>(value.integer) > UINT32_MAX) ||
+         (ins.type == _int32_ &&
+          (value.integer < INT32_MIN || value.integer > INT32_MAX))))
+        _error ("DMScu_FASTTemplateCodec::_store(): "
+                "Value of '%s' is out of range", ins.name.c_str ());
+    if (base == NULL)
+        return;
+
+    if (ins.presence_offset != NOT_BOUND)
+        *reinterpret_cast<bool *>(base + ins.presence_offset) = ! null;
+    if (ins.offset == NOT_BOUND)
+        return;
+
+    char    *member = base + ins.offset;
+
+    switch (ins.type)  {
+        case _uint32_:
+            *reinterpret_cast<uint32_t *>(member) =
+                null ? 0 : static_cast<uint32_t>(value.integer);
+            break;
+        case _int32_:
+            *reinterpret_cast<int32_t *>(member) =
+                null ? 0 : static_cast<int32_t>(value.integer);
+            break;
+        case _uint64_:
+            *reinterpret_cast<uint64_t *>(member) =
+                null ? 0 : static_cast<uint64_t>(value.integer);
+            break;
+        case _int64_:
+            *reinterpret_cast<int64_t *>(member) = null ? 0 : value.integer;
+            break;
+        case _decimal_:
+            *reinterpret_cast<double *>(member) =
+                null ? 0 : FAST::from_decimal<double>(
+                               FAST::Decimal (value.integer, value.exponent));
+            break;
+        case _ascii_:
+            (*ins.set_string) (
+                member, value.str.data (),
+                null ? 0 : static_cast<size_type>(value.str.size ()));
+            break;
+        default:
+            break;
+    }
+
+    return;
+}
+
+// ----------------------------------------------------------------------------
+
+// Unbound optional fields are encoded as null and unbound mandatory fields
+// as 0 or the empty string
+//
+void DMScu_FASTTemplateCodec::
+_load (const _Instruction &ins, const char *base, _Value &value)  {
+
+    value.integer = 0;
+    value.exponent = 0;
+    value.str.clear ();
+
+    const   bool    present =
+        base != NULL && ins.presence_offset != NOT_BOUND
+            ? *reinterpret_cast<const bool *>(base + ins.presence_offset)
+            : base != NULL && ins.offset != NOT_BOUND;
+
+    if (ins.optional && ! present)  {
+        value.state = _empty_;
+        return;
+    }
+    value.state = _assigned_;
+    if (base == NULL || ins.offset == NOT_BOUND)
+        return;
+
+    const   char    *member = base + ins.offset;
+
+    switch (ins.type)  {
+        case _uint32_:
+            value.integer = *reinterpret_cast<const uint32_t *>(member);
+            break;
+        case _int32_:
+            value.integer = *reinterpret_cast<const int32_t *>(member);
+            break;
+        case _uint64_:
+            value.integer = static_cast<int64_t>(
+                *reinterpret_cast<const uint64_t *>(member));
+            break;
+        case _int64_:
+            value.integer = *reinterpret_cast<const int64_t *>(member);
+            break;
+        case _decimal_:  {
+            const   double  real = *reinterpret_cast<const double *>(member);
+            FAST::Decimal   dec;
+
+            if (! std::isfinite (real))
+                _error ("DMScu_FASTTemplateCodec::_load(): "
+                        "Decimal '%s' is not finite", ins.name.c_str ());
+            FAST::to_decimal (real, dec);
+            value.exponent = dec.exponent;
+            value.integer = dec.mantissa;
+        } break;
+        case _ascii_:  {
+            const   char    *str;
+            size_type       size;
+
+            (*ins.get_string) (member, str, size);
+            value.str.assign (str, size);
+        } break;
+        default:
+            break;
+    }
+
+    return;
+}
+
+// ----------------------------------------------------------------------------
+
+void DMScu_FASTTemplateCodec::
+_decode_fields (_Reader &reader,
+                _PmapReader &pmap,
+                const _InstructionVector &instructions,
+                size_type begin,
+                size_type end,
+                char *base)  {
+
+    for (size_type i = begin; i < end; ++i)  {
+        const   _Instruction    &ins = instructions [i];
+        const   bool            bit = ins.pmap_bit ? pmap.next () : false;
+
+        _decode_field (reader, ins, bit, current_);
+        _store (ins, current_, base);
+        if (ins.type != _sequence_)
+            continue;
+
+        const   uint64_t    length =
+            current_.state == _assigned_
+                ? static_cast<uint64_t>(current_.integer) : 0;
+        char                *elements = NULL;
+
+        if (base != NULL && ins.offset != NOT_BOUND)  {
+            if (length > ins.capacity)
+                _error ("DMScu_FASTTemplateCodec::_decode_fields(): "
+                        "Sequence '%s' does not fit in its array",
+                        ins.name.c_str ());
+            *reinterpret_cast<uint32_t *>(base + ins.length_offset) =
+                static_cast<uint32_t>(length);
+            elements = base + ins.offset;
+        }
+
+        for (uint64_t e = 0; e < length; ++e)  {
+            _PmapReader element_pmap = { NULL, 0, 0 };
+
+            if (ins.element_pmap_bits > 0)
+                _read_pmap (reader, element_pmap);
+            _decode_fields (reader, element_pmap, instructions,
+                            i + 1, i + 1 + ins.children,
+                            elements != NULL ? elements + e * ins.stride
+                                             : NULL);
+        }
+        i += ins.children;
+    }
+
+    return;
+}
+
+// ----------------------------------------------------------------------------
+
+void DMScu_FASTTemplateCodec::
+_encode_fields (_Writer &writer,
+                _PmapWriter &pmap,
+                const _InstructionVector &instructions,
+                size_type begin,
+                size_type end,
+                const char *base)  {
+
+    for (size_type i = begin; i < end; ++i)  {
+        const   _Instruction    &ins = instructions [i];
+
+        if (ins.type != _sequence_)  {
+            _load (ins, base, current_);
+            _encode_field (writer, pmap, ins, current_);
+            continue;
+        }
+
+        const   char    *elements = NULL;
+        size_type       length = 0;
+
+        if (base != NULL && ins.offset != NOT_BOUND)  {
+            length = *reinterpret_cast<const uint32_t *>(
+                         base + ins.length_offset);
+            if (length > ins.capacity)
+                _error ("DMScu_FASTTemplateCodec::_encode_fields(): "
+                        "Sequence '%s' is longer than its array",
+                        ins.name.c_str ());
+            elements = base + ins.offset;
+        }
+
+        _load (ins, base, current_);
+        if (current_.state != _assigned_)
+            length = 0;
+        current_.integer = length;
+        _encode_field (writer, pmap, ins, current_);
+
+        for (size_type e = 0; e < length; ++e)  {
+            _PmapWriter element_pmap = { 0, 0, 0 };
+
+            if (ins.element_pmap_bits > 0)
+                _begin_pmap (writer, ins.element_pmap_bits, element_pmap);
+            _encode_fields (writer, element_pmap, instructions,
+                            i + 1, i + 1 + ins.children,
+                            elements + e * ins.stride);
+            if (ins.element_pmap_bits > 0)
+                _end_pmap (writer, element_pmap);
+        }
+        i += ins.children;
+    }
+
+    return;
+}
+
+// ----------------------------------------------------------------------------
+
+const DMScu_FASTTemplateCodec::_Template &DMScu_FASTTemplateCodec::
+_get_template (size_type template_id)  {
+
+    if (last_template_ != NULL && last_template_->id == template_id)
+        return (*last_template_);
+
+    const   _TemplateMap::const_iterator    citer =
+        templates_.find (template_id);
+
+    if (citer == templates_.end ())  {
+        DMScu_FixedSizeString<1023> err;
+
+        err.printf ("DMScu_FASTTemplateCodec::_get_template(): "
+                    "Unknown template id %u", template_id);
+        throw std::runtime_error (err.c_str ());
+    }
+
+    last_template_ = &(citer->second);
+    return (citer->second);
+}
+
+// ----------------------------------------------------------------------------
+
+DMScu_FASTTemplateCodec::size_type DMScu_FASTTemplateCodec::
+encode (uchar *buffer,
+        size_type buffer_size,
+        size_type template_id,
+        const void *msg)  {
+
+    const   _Template   &tmpl = _get_template (template_id);
+    _Writer             writer = { buffer, buffer_size, 0 };
+    _PmapWriter         pmap;
+
+    _begin_pmap (writer, tmpl.pmap_bits, pmap);
+
+   // The template id has the copy operator
+   //
+    if (has_last_template_id_ && last_template_id_ == template_id)
+        _set_pmap_bit (writer, pmap, false);
+    else  {
+        _set_pmap_bit (writer, pmap, true);
+        _write_uint (writer, false, false, template_id);
+    }
+    last_template_id_ = template_id;
+    has_last_template_id_ = true;
+
+    _encode_fields (writer, pmap, tmpl.instructions,
+                    0, static_cast<size_type>(tmpl.instructions.size ()),
+                    static_cast<const char *>(msg));
+    _end_pmap (writer, pmap);
+    return (writer.pos);
+}
+
+// ----------------------------------------------------------------------------
+
+DMScu_FASTTemplateCodec::size_type DMScu_FASTTemplateCodec::
+peek_template_id (const uchar *buffer, size_type buffer_size) const  {
+
+    _Reader     reader = { buffer, buffer_size, 0 };
+    _PmapReader pmap;
+
+    _read_pmap (reader, pmap);
+    if (pmap.next ())
+        return (static_cast<size_type>(_read_uint64 (reader)));
+    if (! has_last_template_id_)
+        _error ("DMScu_FASTTemplateCodec::peek_template_id(): "
+                "The first message has no template id%s", "");
+
+    return (last_template_id_);
+}
+
+// ----------------------------------------------------------------------------
+
+DMScu_FASTTemplateCodec::size_type DMScu_FASTTemplateCodec::
+decode (const uchar *buffer,
+        size_type buffer_size,
+        size_type &template_id,
+        void *msg)  {
+
+    _Reader     reader = { buffer, buffer_size, 0 };
+    _PmapReader pmap;
+
+    _read_pmap (reader, pmap);
+    if (pmap.next ())
+        template_id = static_cast<size_type>(_read_uint64 (reader));
+    else if (has_last_template_id_)
+        template_id = last_template_id_;
+    else
+        _error ("DMScu_FASTTemplateCodec::decode(): "
+                "The first message has no template id%s", "");
+
+    const   _Template   &tmpl = _get_template (template_id);
+
+    last_template_id_ = template_id;
+    has_last_template_id_ = true;
+    _decode_fields (reader, pmap, tmpl.instructions,
+                    0, static_cast<size_type>(tmpl.instructions.size ()),
+                    static_cast<char *>(msg));
+    return (reader.pos);
+}
+
+// ----------------------------------------------------------------------------
+
+// Local Variables:
+// mode:C++
+// tab-width:4
+// c-basic-offset:4
+// End:
@@ -10,19 +10,83 @@
 #include <iostream>
 #include <cstdarg>
 #include <algorithm>
+#include <charconv>
+#include <type_traits>
 
 #include <string.h>
 
+#include <DMScu_StringSearch.h>
+
+// ----------------------------------------------------------------------------
+
+// Marks a printf like method, so the compiler checks its arguments against
+// the format string. The indices count this as argument 1.
+//
+#ifdef __GNUC__
+#define DMScu_FORMAT(fmt_idx, arg_idx) \
+    __attribute__ ((format (printf, fmt_idx, arg_idx)))
+#else
+#define DMScu_FORMAT(fmt_idx, arg_idx)
+#endif // __GNUC__
+
+// ----------------------------------------------------------------------------
+
+// These wrap a value for DMScu_VirtualString::format()/append_format().
+// DMScu_hex() prints an integer in lower case hex, zero padded to width
+// digits. DMScu_fixed() prints a floating point value with precision
+// digits after the point.
+//
+template<class cu_TYPE>
+struct  DMScu_Hex  {
+
+    cu_TYPE         value;
+    unsigned int    width;
+};
+
+template<class cu_TYPE>
+inline DMScu_Hex<cu_TYPE> DMScu_hex (cu_TYPE value, unsigned int width = 0)  {
+
+    static_assert (std::is_integral<cu_TYPE>::value,
+                   "DMScu_hex() takes an integer");
+    return (DMScu_Hex<cu_TYPE> { value, width });
+}
+
+struct  DMScu_Fixed  {
+
+    double  value;
+    int     precision;
+};
+
+inline DMScu_Fixed DMScu_fixed (double value, int precision)  {
+
+    return (DMScu_Fixed { value, precision });
+}
+
 // ----------------------------------------------------------------------------
 
 // This abstract base class makes it possible to pass different template
 // instances around as one type and to be able to assign them interchangeably.
-// The only penalty paid for having this base class is to carry around one
-// additional (pointer size) member. There shouldn't be any performace
-// penalty, since everything is still stack based and there is no virtuality.
+// The only penalty paid for having this base class is to carry around two
+// additional members, a pointer to the buffer and the string length. There
+// shouldn't be any performace penalty, since everything is still stack based
+// and there is no virtuality.
+//
+// The length is kept current by every method, so size(), end(), append(),
+// find() and the comparisons never rescan the string. If the length is
+// changed behind the class's back, by writing a NUL through operator [] or
+// an iterator, or by handing the buffer to a C function, call sync_size()
+// afterwards.
+//
+// printf() and format() (and their append_ versions) stop at the capacity.
+// format() is the cheap one. It formats each value with std::to_chars(),
+// straight into the buffer, with no format string to parse and no locale,
+// e.g.
 //
-// NOTE: DMScu_VirtualString MAKES NO BOUNDARY CHECKS. IT IS THE RESPONSIBILITY
-//       OF THE PROGRAMMER TO TAKE CARE OF THAT.
+//     err.format ("Header of ", size, " bytes at 0x", DMScu_hex (addr, 8),
+//                 " is over ", DMScu_fixed (ratio, 2), " full");
+//
+// NOTE: OTHER THAN THAT, DMScu_VirtualString MAKES NO BOUNDARY CHECKS. IT IS
+//       THE RESPONSIBILITY OF THE PROGRAMMER TO TAKE CARE OF THAT.
 //
 class   DMScu_VirtualString  {
 
@@ -43,18 +107,25 @@ class   DMScu_VirtualString  {
         inline iterator begin () throw ()  { return (string_); }
         inline const_iterator begin () const throw ()  { return (string_); }
 
-       // Unfortunately, the following two methods are not as cheap as they are
-       // supposed to be.
-       //
-        inline iterator end () throw ()  { return (string_ + size ()); }
+        inline iterator end () throw ()  { return (string_ + size_); }
         inline const_iterator end () const throw ()  {
 
-            return (string_ + size ());
+            return (string_ + size_);
         }
 
     protected:
 
-        inline DMScu_VirtualString (pointer str) throw () : string_ (str)  {  }
+        inline DMScu_VirtualString (pointer str, size_type capacity) throw ()
+            : string_ (str), size_ (0), capacity_ (capacity)  {  }
+
+       // Copies len characters of str and terminates them
+       //
+        inline void _assign (const_pointer str, size_type len) throw ()  {
+
+            ::memmove (string_, str, len);
+            string_ [len] = 0;
+            size_ = len;
+        }
 
     public:
 
@@ -62,19 +133,19 @@ class   DMScu_VirtualString  {
        //
         inline DMScu_VirtualString &operator = (const_pointer rhs) throw ()  {
 
-            ::strcpy (string_, rhs);
+            _assign (rhs, ::strlen (rhs));
             return (*this);
         }
         inline DMScu_VirtualString &
         operator = (const DMScu_VirtualString &rhs) throw ()  {
 
-            return (*this = rhs.c_str ());
+            _assign (rhs.string_, rhs.size_);
+            return (*this);
         }
         inline DMScu_VirtualString &
         ncopy (const_pointer rhs, size_type len) throw ()  {
 
-            ::strncpy (string_, rhs, len);
-            string_ [len] = 0;
+            _assign (rhs, ::strnlen (rhs, len));
             return (*this);
         }
 
@@ -84,13 +155,22 @@ class   DMScu_VirtualString  {
 
         inline DMScu_VirtualString &append (const_pointer rhs) throw ()  {
 
-            ::strcat (string_, rhs);
-            return (*this);
+            return (append (rhs, ::strlen (rhs)));
         }
         inline DMScu_VirtualString &
         append (const DMScu_VirtualString &rhs) throw ()  {
 
-            return (append (rhs.c_str ()));
+            return (append (rhs.string_, rhs.size_));
+        }
+        inline DMScu_VirtualString &
+        append (const_pointer rhs, size_type len) throw ()  {
+
+           // rhs may be this string, whose NUL is about to be overwritten
+           //
+            ::memmove (string_ + size_, rhs, len);
+            size_ += len;
+            string_ [size_] = 0;
+            return (*this);
         }
         inline DMScu_VirtualString &operator += (const_pointer rhs) throw ()  {
 
@@ -99,102 +179,143 @@ class   DMScu_VirtualString  {
         inline DMScu_VirtualString &
         operator += (const DMScu_VirtualString &rhs) throw ()  {
 
-            return (append (rhs.c_str ()));
+            return (append (rhs));
         }
 
         inline size_type
         find (const_reference token, size_type pos = 0) const throw ()  {
 
-            size_type   counter = 0;
-
-            for (const_pointer itr = &(string_ [pos]); *itr; ++itr, ++counter)
-                if (string_ [pos + counter] == token)
-                    return (pos + counter);
-
-            return (npos);
+            if (pos >= size_)
+                return (npos);
+            return (_offset (pos, DMScu_StringSearch::find_char (
+                                      string_ + pos, size_ - pos, token)));
         }
         inline size_type
         find (const_pointer token, size_type pos = 0) const throw ()  {
 
-            const   size_type   token_len = ::strlen (token);
-            const   size_type   self_len = size ();
+            return (find (token, ::strlen (token), pos));
+        }
+        inline size_type find (const DMScu_VirtualString &token,
+                               size_type pos = 0) const throw ()  {
 
-            if ((token_len + pos) > self_len)
-                return (npos);
+            return (find (token.string_, token.size_, pos));
+        }
+        inline size_type find (const_pointer token,
+                               size_type token_len,
+                               size_type pos) const throw ()  {
 
-            size_type   counter = 0;
+            if (pos > size_)
+                return (npos);
+            return (_offset (pos, DMScu_StringSearch::find (string_ + pos,
+                                                            size_ - pos,
+                                                            token,
+                                                            token_len)));
+        }
 
-            for (const_pointer itr = &(string_ [pos]);
-                 itr + token_len - begin () <= self_len; ++itr, ++counter)
-                if (! ::strncmp (token, itr, token_len))
-                    return (pos + counter);
+       // Returns the position of the first character that is in set
+       //
+        inline size_type
+        find_first_of (const_pointer set, size_type pos = 0) const throw ()  {
 
-            return (npos);
+            return (find_first_of (set, ::strlen (set), pos));
         }
-        inline size_type find (const DMScu_VirtualString &token,
-                               size_type pos = 0) const throw ()  {
+        inline size_type find_first_of (const DMScu_VirtualString &set,
+                                        size_type pos = 0) const throw ()  {
 
-            const   size_type   len = size ();
+            return (find_first_of (set.string_, set.size_, pos));
+        }
+        inline size_type find_first_of (const_pointer set,
+                                        size_type set_len,
+                                        size_type pos) const throw ()  {
 
-            return (find (token.c_str (), pos));
+            if (pos >= size_)
+                return (npos);
+            return (_offset (pos, DMScu_StringSearch::find_first_of (
+                                      string_ + pos, size_ - pos,
+                                      set, set_len)));
         }
 
-       // Replaces the substring statring at pos with length n with s
+       // Replaces the substring statring at pos with length n with s, the
+       // same as std::string::replace(). A pos past the end appends. What
+       // does not fit in the capacity, of s and then of the tail behind
+       // it, is cut like the formatters do.
        //
         inline DMScu_VirtualString &
         replace (size_type pos, size_type n, const_pointer s)  {
 
-            if (*s == 0)  {
-                size_type   i = pos;
-
-                for (; string_ [i]; ++i)
-                    string_ [i] = string_ [i + 1];
-                string_ [i] = string_ [i + 1];
-            }
-            else  {
-                bool        overwrote_null = false;
-                size_type   i = 0;
-
-                while (s [i])  {
-                    if (string_ [i + pos] == 0)
-                        overwrote_null = 0;
-                    if (i >= n)
-                        string_ [i + pos + 1] = string_ [i + pos];
-                    string_ [i + pos] = s [i];
-                    ++i;
-                }
-                if (overwrote_null)
-                    string_ [i + pos] = 0;
-            }
-
+            if (pos > size_)
+                pos = size_;
+            if (n > size_ - pos)
+                n = size_ - pos;
+
+            const   size_type   s_len = ::strnlen (s, capacity_ - pos);
+            const   size_type   tail =
+                std::min (size_ - pos - n, capacity_ - pos - s_len);
+
+           // Shift the tail into place and then fill the gap
+           //
+            ::memmove (string_ + pos + s_len, string_ + pos + n, tail);
+            ::memcpy (string_ + pos, s, s_len);
+            size_ = pos + s_len + tail;
+            string_ [size_] = 0;
             return (*this);
         }
 
+       // These return what vsnprintf() returns, the length the whole
+       // output would have had.
+       //
+        DMScu_FORMAT (2, 3)
         inline int printf (const char *format_str, ...) throw ()  {
 
             va_list     argument_ptr;
 
             va_start (argument_ptr, format_str);
 
-            const   int ret = ::vsprintf (string_, format_str, argument_ptr);
+            const   int ret = ::vsnprintf (string_, capacity_ + 1,
+                                           format_str, argument_ptr);
 
             va_end (argument_ptr);
+            _formatted (0, ret);
             return (ret);
         }
 
+        DMScu_FORMAT (2, 3)
         inline int append_printf (const char *format_str, ...) throw ()  {
 
             va_list     argument_ptr;
 
             va_start (argument_ptr, format_str);
 
-            const   int ret =
-                ::vsprintf (string_ + size (), format_str, argument_ptr);
+            const   int ret = ::vsnprintf (string_ + size_,
+                                           capacity_ - size_ + 1,
+                                           format_str, argument_ptr);
 
             va_end (argument_ptr);
+            _formatted (size_, ret);
             return (ret);
         }
 
+       // Formats the values one after the other, see above. Strings are
+       // cut at the capacity. A number that does not fit in the space left
+       // is left out.
+       //
+        template<class ... cu_TYPES>
+        inline DMScu_VirtualString &format (const cu_TYPES & ... values)
+            throw ()  {
+
+            size_ = 0;
+            return (append_format (values ...));
+        }
+
+        template<class ... cu_TYPES>
+        inline DMScu_VirtualString &
+        append_format (const cu_TYPES & ... values) throw ()  {
+
+            (_format (values), ...);
+            string_ [size_] = 0;
+            return (*this);
+        }
+
        // Comparison methods.
        //
         inline int compare (const_pointer rhs) const throw ()  {
@@ -203,7 +324,39 @@ class   DMScu_VirtualString  {
         }
         inline int compare (const DMScu_VirtualString &rhs) const throw ()  {
 
-            return (compare (rhs.c_str ()));
+            return (DMScu_StringSearch::compare (string_, size_,
+                                                 rhs.string_, rhs.size_));
+        }
+
+       // Case insensitive (ASCII only) compare, like strcasecmp()
+       //
+        inline int icompare (const_pointer rhs) const throw ()  {
+
+            return (DMScu_StringSearch::compare_icase (string_, size_,
+                                                       rhs, ::strlen (rhs)));
+        }
+        inline int icompare (const DMScu_VirtualString &rhs) const throw ()  {
+
+            return (DMScu_StringSearch::compare_icase (string_, size_,
+                                                       rhs.string_,
+                                                       rhs.size_));
+        }
+
+        inline bool starts_with (const_pointer prefix) const throw ()  {
+
+            return (starts_with (prefix, ::strlen (prefix)));
+        }
+        inline bool
+        starts_with (const DMScu_VirtualString &prefix) const throw ()  {
+
+            return (starts_with (prefix.string_, prefix.size_));
+        }
+        inline bool
+        starts_with (const_pointer prefix, size_type len) const throw ()  {
+
+            return (len <= size_ &&
+                    DMScu_StringSearch::mismatch (string_, prefix, len) ==
+                        len);
         }
 
         inline bool operator == (const_pointer rhs) const throw ()  {
@@ -213,7 +366,9 @@ class   DMScu_VirtualString  {
         inline bool
         operator == (const DMScu_VirtualString &rhs) const throw ()  {
 
-            return (*this == rhs.c_str ());
+            return (size_ == rhs.size_ &&
+                    DMScu_StringSearch::mismatch (string_, rhs.string_,
+                                                  size_) == size_);
         }
         inline bool operator != (const_pointer rhs) const throw ()  {
 
@@ -222,7 +377,7 @@ class   DMScu_VirtualString  {
         inline bool
         operator != (const DMScu_VirtualString &rhs) const throw ()  {
 
-            return (*this != rhs.c_str ());
+            return (! (*this == rhs));
         }
         inline bool operator > (const_pointer rhs) const throw ()  {
 
@@ -231,7 +386,7 @@ class   DMScu_VirtualString  {
         inline bool
         operator > (const DMScu_VirtualString &rhs) const throw ()  {
 
-            return (*this > rhs.c_str ());
+            return (compare (rhs) > 0);
         }
         inline bool operator < (const_pointer rhs) const throw ()  {
 
@@ -240,7 +395,7 @@ class   DMScu_VirtualString  {
         inline bool
         operator < (const DMScu_VirtualString &rhs) const throw ()  {
 
-            return (*this < rhs.c_str ());
+            return (compare (rhs) < 0);
         }
 
        // char based access methods.
@@ -254,7 +409,12 @@ class   DMScu_VirtualString  {
             return (string_ [index]);
         }
 
-        inline void clear () throw ()  { *string_ = 0; }
+        inline void clear () throw ()  { *string_ = 0; size_ = 0; }
+
+       // Recomputes the length after the characters were changed directly,
+       // see above
+       //
+        inline void sync_size () throw ()  { size_ = ::strlen (string_); }
 
        // const utility methods.
        //
@@ -263,12 +423,96 @@ class   DMScu_VirtualString  {
 
             return (offset != npos ? string_ + offset : NULL);
         }
-        inline size_type size () const throw () { return (::strlen(string_)); }
-        inline bool empty () const throw ()  { return (*string_ == 0); }
+        inline size_type size () const throw ()  { return (size_); }
+        inline bool empty () const throw ()  { return (size_ == 0); }
 
     private:
 
-        pointer string_;
+        static inline size_type
+        _offset (size_type pos, size_type found) throw ()  {
+
+            return (found != npos ? pos + found : npos);
+        }
+
+       // Sets the length after vsnprintf() wrote ret characters at pos
+       //
+        inline void _formatted (size_type pos, int ret) throw ()  {
+
+            if (ret >= 0)
+                size_ = std::min (pos + ret, capacity_);
+            else  {
+                size_ = pos;
+                string_ [pos] = 0;
+            }
+        }
+
+        inline void _format (const_pointer str) throw ()  {
+
+            const   size_type   len = ::strnlen (str, capacity_ - size_);
+
+            ::memcpy (string_ + size_, str, len);
+            size_ += len;
+        }
+        inline void _format (const DMScu_VirtualString &str) throw ()  {
+
+            const   size_type   len = std::min (str.size_, capacity_ - size_);
+
+            ::memmove (string_ + size_, str.string_, len);
+            size_ += len;
+        }
+        inline void _format (char c) throw ()  {
+
+            if (size_ < capacity_)
+                string_ [size_++] = c;
+        }
+
+        template<class cu_TYPE>
+        inline typename
+        std::enable_if<std::is_arithmetic<cu_TYPE>::value &&
+                       ! std::is_same<cu_TYPE, char>::value &&
+                       ! std::is_same<cu_TYPE, bool>::value>::type
+        _format (cu_TYPE value) throw ()  {
+
+            _to_chars (std::to_chars (string_ + size_, string_ + capacity_,
+                                      value));
+        }
+        template<class cu_TYPE>
+        inline void _format (const DMScu_Hex<cu_TYPE> &hex) throw ()  {
+
+           // Negative values are printed as their two's complement
+           //
+            typedef typename std::make_unsigned<cu_TYPE>::type  unsigned_type;
+
+            char                        digits [sizeof (cu_TYPE) * 2];
+            const   std::to_chars_result    res =
+                std::to_chars (digits, digits + sizeof (digits),
+                               static_cast<unsigned_type>(hex.value), 16);
+            const   size_type           len = res.ptr - digits;
+            const   size_type           pad =
+                hex.width > len ? hex.width - len : 0;
+
+            if (pad + len <= capacity_ - size_)  {
+                ::memset (string_ + size_, '0', pad);
+                ::memcpy (string_ + size_ + pad, digits, len);
+                size_ += pad + len;
+            }
+        }
+        inline void _format (const DMScu_Fixed &fixed) throw ()  {
+
+            _to_chars (std::to_chars (string_ + size_, string_ + capacity_,
+                                      fixed.value, std::chars_format::fixed,
+                                      fixed.precision));
+        }
+
+        inline void _to_chars (const std::to_chars_result &res) throw ()  {
+
+            if (res.ec == std::errc ())
+                size_ = res.ptr - string_;
+        }
+
+        pointer     string_;
+        size_type   size_;
+        size_type   capacity_;
 
        // The semantics of this class does not allow the following two
        // methods, therefore they are prohibited.
@@ -294,33 +538,32 @@ class   DMScu_FixedSizeString : public DMScu_VirtualString  {
     public:
 
         inline DMScu_FixedSizeString () throw ()
-            : DMScu_VirtualString (buffer_) { *buffer_ = 0; }
+            : DMScu_VirtualString (buffer_, cu_SIZE) { *buffer_ = 0; }
         inline DMScu_FixedSizeString (const_pointer str) throw ()
-            : DMScu_VirtualString (buffer_)  { *this = str; }
+            : DMScu_VirtualString (buffer_, cu_SIZE)  { *this = str; }
         inline DMScu_FixedSizeString (const DMScu_FixedSizeString &that)
             throw ()
-            : DMScu_VirtualString (buffer_)  { *this = that; }
+            : DMScu_VirtualString (buffer_, cu_SIZE)  { *this = that; }
         inline DMScu_FixedSizeString (const DMScu_VirtualString &that) throw ()
-            : DMScu_VirtualString (buffer_)  { *this = that; }
+            : DMScu_VirtualString (buffer_, cu_SIZE)  { *this = that; }
 
        // Assignment methods which cannot be inherited or virtual.
        //
         inline DMScu_FixedSizeString &
         operator = (const DMScu_FixedSizeString &rhs) throw ()  {
 
-            ::strcpy (buffer_, rhs.buffer_);
+            _assign (rhs.buffer_, rhs.size ());
             return (*this);
         }
         inline DMScu_FixedSizeString &operator = (const_pointer rhs) throw () {
 
-            ::strncpy (buffer_, rhs, cu_SIZE);
-            buffer_ [cu_SIZE] = 0;
+            _assign (rhs, ::strnlen (rhs, cu_SIZE));
             return (*this);
         }
         inline DMScu_FixedSizeString &
         operator = (const DMScu_VirtualString &rhs) throw ()  {
 
-            *this = rhs.c_str ();
+            _assign (rhs.c_str (), std::min (rhs.size (), cu_SIZE));
             return (*this);
         }
 
@@ -0,0 +1,522 @@
+// Hossein Moein
+// March 25, 2018
+// Copyright (C) 2018-2019 Hossein Moein
+// Distributed under the BSD Software License (see file License)
+
+// ----------------------------------------------------------------------------
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+#if defined (__x86_64__) && defined (__GNUC__)
+#include <immintrin.h>
+#define DMScu_STR_HAS_SIMD
+#define DMScu_STR_AVX2_TARGET __attribute__ ((target ("avx2")))
+#else
+#define DMScu_STR_AVX2_TARGET
+#endif // defined (__x86_64__) && defined (__GNUC__)
+
+// ----------------------------------------------------------------------------
+
+// The search and compare kernels behind DMScu_VirtualString. They all take
+// explicit lengths and never read outside [str, str + len), so they are
+// safe on a fixed buffer. Where a string is shorter than a vector, the
+// last block is loaded so that it ends at the end of the string
+// (overlapping the previous one), and strings shorter than one vector are
+// done a byte at a time.
+//
+// The finds run 32 bytes at a time on AVX2 CPUs and 16 bytes at a time
+// with SSE2 otherwise. The CPU is checked once. The compares are meant for
+// short keys, topic names, symbols, ..., and always use SSE2.
+// On other CPUs everything is plain C.
+//
+class   DMScu_StringSearch  {
+
+    public:
+
+        typedef unsigned int    size_type;
+
+        static  const   size_type   npos = static_cast<size_type>(-1);
+
+        enum SEARCH_TYPE { _scalar_ = 0, _sse2_ = 1, _avx2_ = 2 };
+
+        static inline SEARCH_TYPE best_search () throw ()  {
+
+            static  const   SEARCH_TYPE search = _detect_search ();
+
+            return (search);
+        }
+
+       // Returns the index of the first c in str, or npos
+       //
+        static inline size_type
+        find_char (const char *str, size_type len, char c) throw ()  {
+
+#ifdef DMScu_STR_HAS_SIMD
+            if (len >= 32 && best_search () == _avx2_)
+                return (_find_char_avx2 (str, len, c));
+            if (len >= 16)
+                return (_find_char_sse2 (str, len, c));
+#endif // DMScu_STR_HAS_SIMD
+
+            for (size_type i = 0; i < len; ++i)
+                if (str [i] == c)
+                    return (i);
+            return (npos);
+        }
+
+       // Returns the index of the first occurrence of token in str, or npos
+       //
+        static inline size_type
+        find (const char *str, size_type len,
+              const char *token, size_type token_len) throw ()  {
+
+            if (token_len == 0)
+                return (0);
+            if (token_len == 1)
+                return (find_char (str, len, *token));
+            if (token_len > len)
+                return (npos);
+
+           // Number of positions token can start at
+           //
+            const   size_type   positions = len - token_len + 1;
+
+#ifdef DMScu_STR_HAS_SIMD
+            if (positions >= 32 && best_search () == _avx2_)
+                return (_find_avx2 (str, positions, token, token_len));
+            if (positions >= 16)
+                return (_find_sse2 (str, positions, token, token_len));
+#endif // DMScu_STR_HAS_SIMD
+
+            for (size_type i = 0; i < positions; ++i)
+                if (str [i] == *token &&
+                    ::memcmp (str + i + 1, token + 1, token_len - 1) == 0)
+                    return (i);
+            return (npos);
+        }
+
+       // Returns the index of the first character of str that is in set,
+       // or npos
+       //
+        static inline size_type
+        find_first_of (const char *str, size_type len,
+                       const char *set, size_type set_len) throw ()  {
+
+            if (set_len <= 1)
+                return (set_len == 0 ? npos : find_char (str, len, *set));
+
+#ifdef DMScu_STR_HAS_SIMD
+            if (set_len <= 16)  {
+                if (len >= 32 && best_search () == _avx2_)
+                    return (_find_first_of_avx2 (str, len, set, set_len));
+                if (len >= 16)
+                    return (_find_first_of_sse2 (str, len, set, set_len));
+            }
+#endif // DMScu_STR_HAS_SIMD
+
+            uint64_t    bits [4] = { 0, 0, 0, 0 };
+
+            for (size_type i = 0; i < set_len; ++i)  {
+                const   unsigned char   c = set [i];
+
+                bits [c >> 6] |= uint64_t (1) << (c & 63);
+            }
+            for (size_type i = 0; i < len; ++i)  {
+                const   unsigned char   c = str [i];
+
+                if (bits [c >> 6] & (uint64_t (1) << (c & 63)))
+                    return (i);
+            }
+            return (npos);
+        }
+
+       // Returns the index of the first byte where lhs and rhs differ, or
+       // len if they are the same. With icase, ASCII letters are compared
+       // case insensitive.
+       //
+        static inline size_type
+        mismatch (const char *lhs, const char *rhs, size_type len) throw ()  {
+
+            return (_mismatch<false>(lhs, rhs, len));
+        }
+        static inline size_type
+        mismatch_icase (const char *lhs, const char *rhs, size_type len)
+            throw ()  {
+
+            return (_mismatch<true>(lhs, rhs, len));
+        }
+
+       // strcmp()/strcasecmp() of two strings of known lengths
+       //
+        static inline int
+        compare (const char *lhs, size_type lhs_len,
+                 const char *rhs, size_type rhs_len) throw ()  {
+
+            return (_compare<false>(lhs, lhs_len, rhs, rhs_len));
+        }
+        static inline int
+        compare_icase (const char *lhs, size_type lhs_len,
+                       const char *rhs, size_type rhs_len) throw ()  {
+
+            return (_compare<true>(lhs, lhs_len, rhs, rhs_len));
+        }
+
+        static inline unsigned char to_lower (unsigned char c) throw ()  {
+
+            return (c + (static_cast<unsigned char>(c - 'A') < 26 ? 32 : 0));
+        }
+
+    private:
+
+        static inline SEARCH_TYPE _detect_search () throw ()  {
+
+#ifdef DMScu_STR_HAS_SIMD
+            __builtin_cpu_init ();
+            if (__builtin_cpu_supports ("avx2"))
+                return (_avx2_);
+            return (_sse2_);
+#else
+            return (_scalar_);
+#endif // DMScu_STR_HAS_SIMD
+        }
+
+        template<bool cu_ICASE>
+        static inline int
+        _compare (const char *lhs, size_type lhs_len,
+                  const char *rhs, size_type rhs_len) throw ()  {
+
+            const   size_type   len = lhs_len < rhs_len ? lhs_len : rhs_len;
+            const   size_type   i = _mismatch<cu_ICASE>(lhs, rhs, len);
+
+            if (i < len)  {
+                const   unsigned char   l = lhs [i];
+                const   unsigned char   r = rhs [i];
+
+                return (cu_ICASE ? to_lower (l) - to_lower (r) : l - r);
+            }
+            return (lhs_len < rhs_len ? -1 : (lhs_len > rhs_len ? 1 : 0));
+        }
+
+        template<bool cu_ICASE>
+        static inline size_type
+        _mismatch (const char *lhs, const char *rhs, size_type len) throw ()  {
+
+            size_type   i = 0;
+
+#ifdef DMScu_STR_HAS_SIMD
+            if (len >= 16)  {
+                for (; i + 16 <= len; i += 16)  {
+                    const   unsigned int    diff =
+                        _diff_sse2<cu_ICASE>(lhs + i, rhs + i);
+
+                    if (diff != 0)
+                        return (i + __builtin_ctz (diff));
+                }
+                if (i < len)  {
+                    const   size_type       last = len - 16;
+                    const   unsigned int    diff =
+                        _diff_sse2<cu_ICASE>(lhs + last, rhs + last) >>
+                        (i - last);
+
+                    if (diff != 0)
+                        return (i + __builtin_ctz (diff));
+                }
+                return (len);
+            }
+#endif // DMScu_STR_HAS_SIMD
+
+            for (; i < len; ++i)
+                if (cu_ICASE ? to_lower (lhs [i]) != to_lower (rhs [i])
+                             : lhs [i] != rhs [i])
+                    break;
+            return (i);
+        }
+
+#ifdef DMScu_STR_HAS_SIMD
+        static inline __m128i _load_sse2 (const char *str) throw ()  {
+
+            return (_mm_loadu_si128 (reinterpret_cast<const __m128i *>(str)));
+        }
+
+       // Adds 0x20 to the bytes in 'A' .. 'Z'. Subtracting 'A' + 128 moves
+       // that range to the bottom of the signed bytes.
+       //
+        static inline __m128i _lower_sse2 (__m128i block) throw ()  {
+
+            const   __m128i shifted =
+                _mm_sub_epi8 (block, _mm_set1_epi8 ('A' + 128));
+            const   __m128i upper =
+                _mm_cmplt_epi8 (shifted, _mm_set1_epi8 (-128 + 26));
+
+            return (_mm_add_epi8 (block,
+                                  _mm_and_si128 (upper, _mm_set1_epi8 (32))));
+        }
+
+       // A bit set for every byte of the 16 that differs
+       //
+        template<bool cu_ICASE>
+        static inline unsigned int
+        _diff_sse2 (const char *lhs, const char *rhs) throw ()  {
+
+            __m128i l = _load_sse2 (lhs);
+            __m128i r = _load_sse2 (rhs);
+
+            if (cu_ICASE)  {
+                l = _lower_sse2 (l);
+                r = _lower_sse2 (r);
+            }
+            return (static_cast<unsigned int>(
+                        _mm_movemask_epi8 (_mm_cmpeq_epi8 (l, r))) ^ 0xFFFF);
+        }
+
+       // len >= 16
+       //
+        static inline size_type
+        _find_char_sse2 (const char *str, size_type len, char c) throw ()  {
+
+            const   __m128i chars = _mm_set1_epi8 (c);
+            size_type       i = 0;
+
+            for (; i + 16 <= len; i += 16)  {
+                const   unsigned int    found = _mm_movemask_epi8 (
+                    _mm_cmpeq_epi8 (_load_sse2 (str + i), chars));
+
+                if (found != 0)
+                    return (i + __builtin_ctz (found));
+            }
+            if (i < len)  {
+                const   size_type       last = len - 16;
+                const   unsigned int    found = _mm_movemask_epi8 (
+                    _mm_cmpeq_epi8 (_load_sse2 (str + last), chars)) >>
+                    (i - last);
+
+                if (found != 0)
+                    return (i + __builtin_ctz (found));
+            }
+            return (npos);
+        }
+
+       // Compares the first and the last character of token at 16
+       // positions at once, and memcmp()s only where both match. Like the
+       // other kernels, the last block overlaps the one before it.
+       // positions >= 16, token_len >= 2
+       //
+        static inline size_type
+        _find_sse2 (const char *str, size_type positions,
+                    const char *token, size_type token_len) throw ()  {
+
+            const   __m128i first = _mm_set1_epi8 (token [0]);
+            const   __m128i last = _mm_set1_epi8 (token [token_len - 1]);
+            size_type       i = 0;
+
+            while (true)  {
+                size_type       at = i;
+                size_type       skip = 0;
+
+                if (i + 16 > positions)  {
+                    if (i == positions)
+                        return (npos);
+                    at = positions - 16;
+                    skip = i - at;
+                }
+
+                const   __m128i both = _mm_and_si128 (
+                    _mm_cmpeq_epi8 (first, _load_sse2 (str + at)),
+                    _mm_cmpeq_epi8 (last,
+                                    _load_sse2 (str + at + token_len - 1)));
+                unsigned int    found = _mm_movemask_epi8 (both) >> skip;
+
+                while (found != 0)  {
+                    const   size_type   pos = i + __builtin_ctz (found);
+
+                    if (::memcmp (str + pos + 1, token + 1,
+                                  token_len - 2) == 0)
+                        return (pos);
+                    found &= found - 1;
+                }
+                if (skip != 0)
+                    return (npos);
+                i += 16;
+            }
+        }
+
+       // len >= 16, 2 <= set_len <= 16
+       //
+        static inline size_type
+        _find_first_of_sse2 (const char *str, size_type len,
+                             const char *set, size_type set_len) throw ()  {
+
+            __m128i     chars [16];
+            size_type   i = 0;
+
+            for (size_type s = 0; s < set_len; ++s)
+                chars [s] = _mm_set1_epi8 (set [s]);
+
+            for (; i + 16 <= len; i += 16)  {
+                const   unsigned int    found =
+                    _any_of_sse2 (_load_sse2 (str + i), chars, set_len);
+
+                if (found != 0)
+                    return (i + __builtin_ctz (found));
+            }
+            if (i < len)  {
+                const   size_type       last = len - 16;
+                const   unsigned int    found =
+                    _any_of_sse2 (_load_sse2 (str + last), chars, set_len) >>
+                    (i - last);
+
+                if (found != 0)
+                    return (i + __builtin_ctz (found));
+            }
+            return (npos);
+        }
+
+        static inline unsigned int
+        _any_of_sse2 (__m128i block, const __m128i *chars, size_type count)
+            throw ()  {
+
+            __m128i any = _mm_cmpeq_epi8 (block, chars [0]);
+
+            for (size_type s = 1; s < count; ++s)
+                any = _mm_or_si128 (any, _mm_cmpeq_epi8 (block, chars [s]));
+            return (_mm_movemask_epi8 (any));
+        }
+
+       // The AVX2 versions of the above, 32 bytes at a time. len >= 32
+       //
+        DMScu_STR_AVX2_TARGET
+        static inline __m256i _load_avx2 (const char *str) throw ()  {
+
+            return (_mm256_loadu_si256 (
+                        reinterpret_cast<const __m256i *>(str)));
+        }
+
+        DMScu_STR_AVX2_TARGET
+        static inline size_type
+        _find_char_avx2 (const char *str, size_type len, char c) throw ()  {
+
+            const   __m256i chars = _mm256_set1_epi8 (c);
+            size_type       i = 0;
+
+            for (; i + 32 <= len; i += 32)  {
+                const   unsigned int    found = _mm256_movemask_epi8 (
+                    _mm256_cmpeq_epi8 (_load_avx2 (str + i), chars));
+
+                if (found != 0)
+                    return (i + __builtin_ctz (found));
+            }
+            if (i < len)  {
+                const   size_type       last = len - 32;
+                const   unsigned int    found = static_cast<unsigned int>(
+                    _mm256_movemask_epi8 (
+                        _mm256_cmpeq_epi8 (_load_avx2 (str + last), chars))) >>
+                    (i - last);
+
+                if (found != 0)
+                    return (i + __builtin_ctz (found));
+            }
+            return (npos);
+        }
+
+        DMScu_STR_AVX2_TARGET
+        static inline size_type
+        _find_avx2 (const char *str, size_type positions,
+                    const char *token, size_type token_len) throw ()  {
+
+            const   __m256i first = _mm256_set1_epi8 (token [0]);
+            const   __m256i last = _mm256_set1_epi8 (token [token_len - 1]);
+            size_type       i = 0;
+
+            while (true)  {
+                size_type       at = i;
+                size_type       skip = 0;
+
+                if (i + 32 > positions)  {
+                    if (i == positions)
+                        return (npos);
+                    at = positions - 32;
+                    skip = i - at;
+                }
+
+                const   __m256i both = _mm256_and_si256 (
+                    _mm256_cmpeq_epi8 (first, _load_avx2 (str + at)),
+                    _mm256_cmpeq_epi8 (last,
+                                       _load_avx2 (str + at + token_len - 1)));
+                unsigned int    found = static_cast<unsigned int>(
+                    _mm256_movemask_epi8 (both)) >> skip;
+
+                while (found != 0)  {
+                    const   size_type   pos = i + __builtin_ctz (found);
+
+                    if (::memcmp (str + pos + 1, token + 1,
+                                  token_len - 2) == 0)
+                        return (pos);
+                    found &= found - 1;
+                }
+                if (skip != 0)
+                    return (npos);
+                i += 32;
+            }
+        }
+
+        DMScu_STR_AVX2_TARGET
+        static inline size_type
+        _find_first_of_avx2 (const char *str, size_type len,
+                             const char *set, size_type set_len) throw ()  {
+
+            __m256i     chars [16];
+            size_type   i = 0;
+
+            for (size_type s = 0; s < set_len; ++s)
+                chars [s] = _mm256_set1_epi8 (set [s]);
+
+            for (; i + 32 <= len; i += 32)  {
+                const   unsigned int    found =
+                    _any_of_avx2 (_load_avx2 (str + i), chars, set_len);
+
+                if (found != 0)
+                    return (i + __builtin_ctz (found));
+            }
+            if (i < len)  {
+                const   size_type       last = len - 32;
+                const   unsigned int    found =
+                    _any_of_avx2 (_load_avx2 (str + last), chars, set_len) >>
+                    (i - last);
+
+                if (found != 0)
+                    return (i + __builtin_ctz (found));
+            }
+            return (npos);
+        }
+
+        DMScu_STR_AVX2_TARGET
+        static inline unsigned int
+        _any_of_avx2 (__m256i block, const __m256i *chars, size_type count)
+            throw ()  {
+
+            __m256i any = _mm256_cmpeq_epi8 (block, chars [0]);
+
+            for (size_type s = 1; s < count; ++s)
+                any = _mm256_or_si256 (any,
+                                       _mm256_cmpeq_epi8 (block, chars [s]));
+            return (static_cast<unsigned int>(_mm256_movemask_epi8 (any)));
+        }
+#endif // DMScu_STR_HAS_SIMD
+
+       // These are not implemented
+       //
+        DMScu_StringSearch ();
+        DMScu_StringSearch (const DMScu_StringSearch &);
+        DMScu_StringSearch &operator = (const DMScu_StringSearch &);
+};
+
+// ----------------------------------------------------------------------------
+
+// Local Variables:
+// mode:C++
+// tab-width:4
+// c-basic-offset:4
+// End:
@@ -13,12 +13,23 @@ PROJECT_INCLUDE_DIR = ../../../include
 SRCS =
 
 HEADERS = $(LOCAL_INCLUDE_DIR)/DMScu_FixedSizeString.h \
-          $(LOCAL_INCLUDE_DIR)/DMScu_FASTProtocolUtilities.h
+          $(LOCAL_INCLUDE_DIR)/DMScu_FASTProtocolUtilities.h \
+          $(LOCAL_INCLUDE_DIR)/DMScu_FASTTemplateCodec.h \
+          $(LOCAL_INCLUDE_DIR)/DMScu_FASTTemplateCodec.tcc \
+          $(LOCAL_INCLUDE_DIR)/DMScu_FASTSchema.h \
+          $(LOCAL_INCLUDE_DIR)/DMScu_FASTStreamDecoder.h \
+          $(LOCAL_INCLUDE_DIR)/DMScu_FASTFrameIndexer.h \
+          $(LOCAL_INCLUDE_DIR)/DMScu_StringSearch.h
 
 LIB_NAME =
 TARGET_LIB =
 
-TARGETS += $(LOCAL_BIN_DIR)/fixsizestr_tester
+TARGETS += $(LOCAL_BIN_DIR)/fixsizestr_tester \
+           $(LOCAL_BIN_DIR)/fastproto_tester \
+           $(LOCAL_BIN_DIR)/fasttemplate_tester \
+           $(LOCAL_BIN_DIR)/fastschema_tester \
+           $(LOCAL_BIN_DIR)/faststream_tester \
+           $(LOCAL_BIN_DIR)/fastframe_tester
 
 # -----------------------------------------------------------------------------
 
@@ -65,6 +76,26 @@ FIXSIZESTR_TESTER_OBJ = $(LOCAL_OBJ_DIR)/fixsizestr_tester.o
 $(LOCAL_BIN_DIR)/fixsizestr_tester: $(TARGET_LIB) $(FIXSIZESTR_TESTER_OBJ)
 	$(CXX) -o $@ $(FIXSIZESTR_TESTER_OBJ) $(LIBS)
 
+FASTPROTO_TESTER_OBJ = $(LOCAL_OBJ_DIR)/fastproto_tester.o
+$(LOCAL_BIN_DIR)/fastproto_tester: $(TARGET_LIB) $(FASTPROTO_TESTER_OBJ)
+	$(CXX) -o $@ $(FASTPROTO_TESTER_OBJ) $(LIBS)
+
+FASTTEMPLATE_TESTER_OBJ = $(LOCAL_OBJ_DIR)/fasttemplate_tester.o
+$(LOCAL_BIN_DIR)/fasttemplate_tester: $(TARGET_LIB) $(FASTTEMPLATE_TESTER_OBJ)
+	$(CXX) -o $@ $(FASTTEMPLATE_TESTER_OBJ) $(LIBS)
+
+FASTSCHEMA_TESTER_OBJ = $(LOCAL_OBJ_DIR)/fastschema_tester.o
+$(LOCAL_BIN_DIR)/fastschema_tester: $(TARGET_LIB) $(FASTSCHEMA_TESTER_OBJ)
+	$(CXX) -o $@ $(FASTSCHEMA_TESTER_OBJ) $(LIBS)
+
+FASTSTREAM_TESTER_OBJ = $(LOCAL_OBJ_DIR)/faststream_tester.o
+$(LOCAL_BIN_DIR)/faststream_tester: $(TARGET_LIB) $(FASTSTREAM_TESTER_OBJ)
+	$(CXX) -o $@ $(FASTSTREAM_TESTER_OBJ) $(LIBS)
+
+FASTFRAME_TESTER_OBJ = $(LOCAL_OBJ_DIR)/fastframe_tester.o
+$(LOCAL_BIN_DIR)/fastframe_tester: $(TARGET_LIB) $(FASTFRAME_TESTER_OBJ)
+	$(CXX) -o $@ $(FASTFRAME_TESTER_OBJ) $(LIBS)
+
 # -----------------------------------------------------------------------------
 
 depend:
@@ -74,7 +105,9 @@ clean:
 	rm -f $(LIB_OBJS)
 
 clobber:
-	rm -f $(TARGETS) $(FIXSIZESTR_TESTER_OBJ)
+	rm -f $(TARGETS) $(FIXSIZESTR_TESTER_OBJ) $(FASTPROTO_TESTER_OBJ) \
+	      $(FASTTEMPLATE_TESTER_OBJ) $(FASTSCHEMA_TESTER_OBJ) \
+	      $(FASTSTREAM_TESTER_OBJ) $(FASTFRAME_TESTER_OBJ)
 
 install_lib:
 
@@ -0,0 +1,211 @@
+// Hossein Moein
+// March 25, 2018
+// Copyright (C) 2018-2019 Hossein Moein
+// Distributed under the BSD Software License (see file License)
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include <DMScu_FASTFrameIndexer.h>
+
+using namespace std;
+
+typedef DMScu_FASTProtocolUtilities FAST;
+typedef DMScu_FASTFrameIndexer      Indexer;
+
+// ----------------------------------------------------------------------------
+
+static  const   unsigned int    COUNT = 1000000;
+
+// ----------------------------------------------------------------------------
+
+// One frame at a time, the way Framer finds them: look for the header's
+// stop bit, decode it and check the body is all there
+//
+static unsigned int
+index_one_by_one (const unsigned char *buffer,
+                  unsigned int buffer_size,
+                  Indexer::Frame *frames)  {
+
+    unsigned int    pos = 0;
+    unsigned int    count = 0;
+
+    while (pos < buffer_size)  {
+        const   unsigned int    avail = buffer_size - pos;
+        unsigned int            i = 0;
+
+        while (i < avail && i < Indexer::MAX_HEADER_SIZE &&
+               ! FAST::is_final (buffer [pos + i]))
+            i += 1;
+        if (i == avail || i == Indexer::MAX_HEADER_SIZE)
+            break;
+
+        unsigned int    length;
+
+        FAST::decode_uinteger (buffer + pos, length);
+        if (length > avail - (i + 1))
+            break;
+        pos += i + 1;
+        frames [count].offset = pos;
+        frames [count].length = length;
+        count += 1;
+        pos += length;
+    }
+
+    return (count);
+}
+
+// ----------------------------------------------------------------------------
+
+static bool expect_throw (const unsigned char *buffer, unsigned int size)  {
+
+    Indexer::Frame  frames [4];
+    unsigned int    consumed;
+
+    try  {
+        Indexer::index (buffer, size, frames, 4, consumed);
+    }
+    catch (const std::runtime_error &)  {
+        return (true);
+    }
+
+    cout << "ERROR: malformed header of " << size
+         << " bytes was not detected" << endl;
+    return (false);
+}
+
+// ----------------------------------------------------------------------------
+
+int main (int argCnt, char *argVctr [])  {
+
+    cout << "\n\tTesting DMScu_FASTFrameIndexer ...\n" << endl;
+
+    mt19937                 gen (2468);
+    vector<unsigned int>    lengths (COUNT);
+    vector<unsigned char>   buffer;
+
+   // Mostly small messages, with a large one now and then, so headers of
+   // every size show up
+   //
+    for (unsigned int i = 0; i < COUNT; ++i)  {
+        lengths [i] = i % 1000 == 0 ? gen () % 100000 : gen () % 120;
+
+        unsigned char   header [Indexer::MAX_HEADER_SIZE];
+        const   unsigned int    header_len =
+            FAST::encode_uinteger (header, lengths [i]);
+
+        buffer.insert (buffer.end (), header, header + header_len);
+        buffer.resize (buffer.size () + lengths [i],
+                       static_cast<unsigned char>(gen ()));
+    }
+
+    const   unsigned int        size =
+        static_cast<unsigned int>(buffer.size ());
+    vector<Indexer::Frame>      frames (COUNT);
+    vector<Indexer::Frame>      expected (COUNT);
+    unsigned int                consumed = 0;
+
+    auto            start = chrono::steady_clock::now ();
+    unsigned int    count =
+        index_one_by_one (&(buffer [0]), size, &(expected [0]));
+    auto            ns = chrono::duration_cast<chrono::nanoseconds>
+                             (chrono::steady_clock::now () - start).count ();
+
+    cout << "One by one: " << static_cast<double>(ns) / COUNT
+         << " ns/frame" << endl;
+
+    start = chrono::steady_clock::now ();
+    count = Indexer::index (&(buffer [0]), size, &(frames [0]), COUNT,
+                            consumed);
+    ns = chrono::duration_cast<chrono::nanoseconds>
+             (chrono::steady_clock::now () - start).count ();
+    cout << "Indexer:    " << static_cast<double>(ns) / COUNT
+         << " ns/frame" << endl;
+
+    if (count != COUNT || consumed != size)  {
+        cout << "ERROR: indexed " << count << " frames, " << consumed
+             << " of " << size << " bytes" << endl;
+        return (EXIT_FAILURE);
+    }
+    for (unsigned int i = 0; i < COUNT; ++i)
+        if (frames [i].offset != expected [i].offset ||
+            frames [i].length != lengths [i])  {
+            cout << "ERROR: frame " << i << " indexed wrong" << endl;
+            return (EXIT_FAILURE);
+        }
+
+   // Cut the buffer everywhere within the first few frames. Only the
+   // frames before the cut are indexed, header or body cut alike.
+   //
+    for (unsigned int cut = 0; cut < expected [20].offset; ++cut)  {
+        vector<unsigned char>   part (&(buffer [0]), &(buffer [0]) + cut);
+        unsigned int            complete = 0;
+
+        while (complete < COUNT &&
+               expected [complete].offset + expected [complete].length <=
+                   cut)
+            complete += 1;
+
+        count = Indexer::index (part.data (), cut, &(frames [0]), COUNT,
+                                consumed);
+        if (count != complete ||
+            consumed != (complete == 0 ? 0
+                                       : expected [complete - 1].offset +
+                                         expected [complete - 1].length))  {
+            cout << "ERROR: buffer cut at " << cut << " indexed "
+                 << count << " frames instead of " << complete << endl;
+            return (EXIT_FAILURE);
+        }
+    }
+
+   // max_frames stops the indexer, and the next call picks up from there
+   //
+    count = Indexer::index (&(buffer [0]), size, &(frames [0]), 10, consumed);
+    if (count != 10 || consumed != expected [10].offset - 1 ||
+        Indexer::index (&(buffer [consumed]), size - consumed,
+                        &(frames [0]), 1, consumed) != 1 ||
+        frames [0].length != lengths [10])  {
+        cout << "ERROR: max_frames was not honored" << endl;
+        return (EXIT_FAILURE);
+    }
+
+   // Empty frames, and a header with no stop bit in 5 bytes, short and
+   // long buffers alike
+   //
+    unsigned char   raw [32];
+
+    ::memset (raw, 0x80, sizeof (raw));
+    if (Indexer::index (raw, sizeof (raw), &(frames [0]), 4, consumed) != 4 ||
+        consumed != 4 || frames [3].offset != 4 || frames [3].length != 0)  {
+        cout << "ERROR: empty frames indexed wrong" << endl;
+        return (EXIT_FAILURE);
+    }
+    ::memset (raw, 0x01, sizeof (raw));
+    if (! expect_throw (raw, Indexer::MAX_HEADER_SIZE) ||
+        ! expect_throw (raw, sizeof (raw)))
+        return (EXIT_FAILURE);
+
+   // 5 bytes of 7 bits overflow a 32-bit length
+   //
+    static  const   unsigned char   too_long [] = { 0x7F, 0x7F, 0x7F, 0x7F,
+                                                    0xFF };
+
+    if (! expect_throw (too_long, sizeof (too_long)))
+        return (EXIT_FAILURE);
+
+    cout << "SUCCESS: all frames indexed" << endl;
+    return (EXIT_SUCCESS);
+}
+
+// ----------------------------------------------------------------------------
+
+// Local Variables:
+// mode:C++
+// tab-width:4
+// c-basic-offset:4
+// End:
@@ -0,0 +1,440 @@
+// Hossein Moein
+// March 25, 2018
+// Copyright (C) 2018-2019 Hossein Moein
+// Distributed under the BSD Software License (see file License)
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include <DMScu_FASTProtocolUtilities.h>
+
+using namespace std;
+
+typedef DMScu_FASTProtocolUtilities FAST;
+
+// ----------------------------------------------------------------------------
+
+static  const   size_t  FIELD_COUNT = 1000000;
+static  const   int     ROUNDS = 20;
+
+// ----------------------------------------------------------------------------
+
+// Values of every length, so the stop bit branch of the scalar decoder
+// cannot be predicted
+//
+template<class cu_TYPE>
+static void make_values (vector<cu_TYPE> &values)  {
+
+    mt19937_64  gen (12345);
+
+    values.resize (FIELD_COUNT);
+    for (size_t i = 0; i < FIELD_COUNT; ++i)  {
+        const   uint64_t    bits = gen ();
+        const   int         shift = bits % (sizeof (cu_TYPE) * 8);
+
+        values [i] = static_cast<cu_TYPE>(gen () >> (64 - sizeof (cu_TYPE) * 8)
+                                              >> shift);
+        if (bits & 0x100)
+            values [i] = static_cast<cu_TYPE>(~values [i]);
+    }
+
+    return;
+}
+
+// ----------------------------------------------------------------------------
+
+template<class cu_TYPE, bool SIGNED>
+static size_t encode_values (const vector<cu_TYPE> &values,
+                             vector<unsigned char> &buffer)  {
+
+    buffer.resize (values.size () * 10 + FAST::DECODE_PADDING);
+
+    size_t  pos = 0;
+
+    for (size_t i = 0; i < values.size (); ++i)
+        pos += SIGNED ? FAST::encode_integer (&(buffer [pos]), values [i])
+                      : FAST::encode_uinteger (&(buffer [pos]), values [i]);
+
+    return (pos);
+}
+
+// ----------------------------------------------------------------------------
+
+template<class cu_TYPE, class DECODER>
+static bool run (const char *name,
+                 const vector<cu_TYPE> &values,
+                 const vector<unsigned char> &buffer,
+                 size_t encoded_size,
+                 DECODER decoder)  {
+
+    vector<cu_TYPE> decoded (values.size ());
+    const   auto    start = chrono::steady_clock::now ();
+
+    for (int r = 0; r < ROUNDS; ++r)  {
+        size_t  pos = 0;
+
+        for (size_t i = 0; i < decoded.size (); ++i)
+            pos += decoder (&(buffer [pos]), decoded [i]);
+        if (pos != encoded_size)  {
+            cout << "ERROR: " << name << " consumed " << pos
+                 << " bytes instead of " << encoded_size << endl;
+            return (false);
+        }
+    }
+
+    const   auto    ns = chrono::duration_cast<chrono::nanoseconds>
+                             (chrono::steady_clock::now () - start).count ();
+
+    if (decoded != values)  {
+        cout << "ERROR: " << name << " decoded the wrong values" << endl;
+        return (false);
+    }
+
+    cout << "    " << name << ": "
+         << static_cast<double>(ns) / (ROUNDS * values.size ())
+         << " ns/field" << endl;
+    return (true);
+}
+
+// ----------------------------------------------------------------------------
+
+template<class cu_TYPE>
+static bool test_unsigned (const char *type_name)  {
+
+    vector<cu_TYPE>         values;
+    vector<unsigned char>   buffer;
+
+    make_values (values);
+
+    const   size_t  encoded_size =
+        encode_values<cu_TYPE, false>(values, buffer);
+
+    cout << "Unsigned " << type_name << ", " << encoded_size << " bytes:"
+         << endl;
+
+    return (run ("scalar", values, buffer, encoded_size,
+                 [](const unsigned char *b, cu_TYPE &x)
+                     { return (FAST::decode_uinteger (b, x)); }) &&
+            run ("swar  ", values, buffer, encoded_size,
+                 [](const unsigned char *b, cu_TYPE &x)
+                     { return (FAST::decode_uinteger_swar (b, x)); }) &&
+            (FAST::best_decoder () != FAST::_bmi2_ ||
+             run ("bmi2  ", values, buffer, encoded_size,
+                  [](const unsigned char *b, cu_TYPE &x)
+                      { return (FAST::decode_uinteger_bmi2 (b, x)); })) &&
+            run ("wide  ", values, buffer, encoded_size,
+                 [](const unsigned char *b, cu_TYPE &x)
+                     { return (FAST::decode_uinteger_wide (b, x)); }));
+}
+
+// ----------------------------------------------------------------------------
+
+template<class cu_TYPE>
+static bool test_signed (const char *type_name)  {
+
+    vector<cu_TYPE>         values;
+    vector<unsigned char>   buffer;
+
+    make_values (values);
+
+    const   size_t  encoded_size =
+        encode_values<cu_TYPE, true>(values, buffer);
+
+    cout << "Signed " << type_name << ", " << encoded_size << " bytes:"
+         << endl;
+
+    return (run ("scalar", values, buffer, encoded_size,
+                 [](const unsigned char *b, cu_TYPE &x)
+                     { return (FAST::decode_integer (b, x)); }) &&
+            run ("swar  ", values, buffer, encoded_size,
+                 [](const unsigned char *b, cu_TYPE &x)
+                     { return (FAST::decode_integer_swar (b, x)); }) &&
+            (FAST::best_decoder () != FAST::_bmi2_ ||
+             run ("bmi2  ", values, buffer, encoded_size,
+                  [](const unsigned char *b, cu_TYPE &x)
+                      { return (FAST::decode_integer_bmi2 (b, x)); })) &&
+            run ("wide  ", values, buffer, encoded_size,
+                 [](const unsigned char *b, cu_TYPE &x)
+                     { return (FAST::decode_integer_wide (b, x)); }));
+}
+
+// ----------------------------------------------------------------------------
+
+template<class cu_TYPE, bool SIGNED>
+static bool test_arrays (const char *type_name)  {
+
+    vector<cu_TYPE>         values;
+    vector<unsigned char>   single;
+
+    make_values (values);
+
+    const   FAST::size_type count =
+        static_cast<FAST::size_type>(values.size ());
+    const   size_t          single_size =
+        encode_values<cu_TYPE, SIGNED>(values, single);
+    const   FAST::size_type exact_size =
+        SIGNED ? FAST::encoded_size_integers (&(values [0]), count)
+               : FAST::encoded_size_uintegers (&(values [0]), count);
+
+    cout << (SIGNED ? "Signed " : "Unsigned ") << type_name
+         << " arrays, " << exact_size << " bytes:" << endl;
+
+    vector<unsigned char>   buffer (
+        FAST::max_encoded_size<cu_TYPE>(count, SIGNED));
+    vector<cu_TYPE>         decoded (count);
+
+   // A buffer one byte short must be refused without being written to
+   //
+    if ((SIGNED ? FAST::encode_integers (&(buffer [0]), exact_size - 1,
+                                         &(values [0]), count)
+                : FAST::encode_uintegers (&(buffer [0]), exact_size - 1,
+                                          &(values [0]), count)) != 0 ||
+        buffer [0] != 0)  {
+        cout << "ERROR: encoded into a short buffer" << endl;
+        return (false);
+    }
+
+   // Checked, into a buffer with no slack at the end
+   //
+    vector<unsigned char>   tight (exact_size);
+
+    if ((SIGNED ? FAST::encode_integers (&(tight [0]), exact_size,
+                                         &(values [0]), count)
+                : FAST::encode_uintegers (&(tight [0]), exact_size,
+                                          &(values [0]), count)) !=
+            exact_size ||
+        (SIGNED ? FAST::decode_integers (&(tight [0]), exact_size,
+                                         &(decoded [0]), count)
+                : FAST::decode_uintegers (&(tight [0]), exact_size,
+                                          &(decoded [0]), count)) !=
+            exact_size ||
+        decoded != values)  {
+        cout << "ERROR: checked round trip failed" << endl;
+        return (false);
+    }
+
+   // The unsigned encoders produce the same bytes as encode_uinteger()
+   //
+    if (! SIGNED &&
+        (single_size != exact_size ||
+         ::memcmp (&(single [0]), &(tight [0]), exact_size) != 0))  {
+        cout << "ERROR: array encoding differs from encode_uinteger()"
+             << endl;
+        return (false);
+    }
+
+   // A truncated buffer must be detected
+   //
+    if ((SIGNED ? FAST::decode_integers (&(tight [0]), exact_size - 1,
+                                         &(decoded [0]), count)
+                : FAST::decode_uintegers (&(tight [0]), exact_size - 1,
+                                          &(decoded [0]), count)) != 0)  {
+        cout << "ERROR: decoded a truncated buffer" << endl;
+        return (false);
+    }
+
+    auto    start = chrono::steady_clock::now ();
+    size_t  encoded = 0;
+
+    for (int r = 0; r < ROUNDS; ++r)
+        encoded = SIGNED
+            ? FAST::encode_integers_unchecked (&(buffer [0]),
+                                               &(values [0]), count)
+            : FAST::encode_uintegers_unchecked (&(buffer [0]),
+                                                &(values [0]), count);
+
+    auto    ns = chrono::duration_cast<chrono::nanoseconds>
+                     (chrono::steady_clock::now () - start).count ();
+
+    cout << "    encode unchecked: "
+         << static_cast<double>(ns) / (ROUNDS * count) << " ns/field"
+         << endl;
+
+    start = chrono::steady_clock::now ();
+    for (int r = 0; r < ROUNDS; ++r)
+        encode_values<cu_TYPE, SIGNED>(values, single);
+    ns = chrono::duration_cast<chrono::nanoseconds>
+             (chrono::steady_clock::now () - start).count ();
+    cout << "    encode one by one: "
+         << static_cast<double>(ns) / (ROUNDS * count) << " ns/field"
+         << endl;
+
+    buffer.resize (encoded + FAST::DECODE_PADDING);
+    decoded.assign (count, 0);
+    start = chrono::steady_clock::now ();
+
+    size_t  consumed = 0;
+
+    for (int r = 0; r < ROUNDS; ++r)
+        consumed = SIGNED
+            ? FAST::decode_integers_unchecked (&(buffer [0]),
+                                               &(decoded [0]), count)
+            : FAST::decode_uintegers_unchecked (&(buffer [0]),
+                                                &(decoded [0]), count);
+    ns = chrono::duration_cast<chrono::nanoseconds>
+             (chrono::steady_clock::now () - start).count ();
+    cout << "    decode unchecked: "
+         << static_cast<double>(ns) / (ROUNDS * count) << " ns/field"
+         << endl;
+
+    if (encoded != exact_size || consumed != exact_size ||
+        decoded != values)  {
+        cout << "ERROR: unchecked round trip failed" << endl;
+        return (false);
+    }
+
+    return (true);
+}
+
+// ----------------------------------------------------------------------------
+
+// Reals must read back as the same value, with the shortest mantissa
+//
+template<class cu_TYPE>
+static bool test_reals (const char *type_name)  {
+
+    mt19937_64      gen (2468);
+    vector<cu_TYPE> values (FIELD_COUNT);
+
+    for (size_t i = 0; i < FIELD_COUNT; ++i)  {
+        switch (i % 4)  {
+            case 0:  // Prices
+                values [i] = static_cast<cu_TYPE>(
+                    static_cast<double>(static_cast<int>(gen () % 2000000) -
+                                        1000000) / 100.0);
+                break;
+            case 1:  // Not short decimals, e.g. 0.30000000000000004
+                values [i] = static_cast<cu_TYPE>(
+                    static_cast<double>(gen () % 1000000) / 3.0 + 0.1);
+                break;
+            case 2:  // Large and small magnitudes
+                values [i] = static_cast<cu_TYPE>(
+                    static_cast<double>(gen () % 1000) *
+                    (gen () % 2 != 0 ? 1e20 : 1e-20));
+                break;
+            default:
+                values [i] = static_cast<cu_TYPE>(gen () % 100);
+                break;
+        }
+    }
+
+    vector<unsigned char>   buffer (FIELD_COUNT * 12);
+    vector<cu_TYPE>         decoded (FIELD_COUNT);
+    size_t                  pos = 0;
+    auto                    start = chrono::steady_clock::now ();
+
+    for (size_t i = 0; i < FIELD_COUNT; ++i)
+        pos += FAST::encode_real (&(buffer [pos]), values [i]);
+
+    const   auto    ns = chrono::duration_cast<chrono::nanoseconds>
+                             (chrono::steady_clock::now () - start).count ();
+    const   size_t  encoded_size = pos;
+
+    cout << "Real " << type_name << ", " << encoded_size << " bytes:"
+         << endl << "    encode_real: "
+         << static_cast<double>(ns) / FIELD_COUNT << " ns/field" << endl;
+
+    if (! run ("decode_real", values, buffer, encoded_size,
+               [](const unsigned char *b, cu_TYPE &x)
+                   { return (FAST::decode_real (b, x)); }))
+        return (false);
+
+    FAST::Decimal   dec;
+    unsigned char   bytes [32];
+    cu_TYPE         x;
+
+    FAST::to_decimal (static_cast<cu_TYPE>(100.25), dec);
+    if (dec.mantissa != 10025 || dec.exponent != -2)  {
+        cout << "ERROR: 100.25 is " << dec.mantissa << "e" << dec.exponent
+             << endl;
+        return (false);
+    }
+    FAST::to_decimal (static_cast<cu_TYPE>(-4200), dec);
+    if (dec.mantissa != -42 || dec.exponent != 2)  {
+        cout << "ERROR: -4200 is " << dec.mantissa << "e" << dec.exponent
+             << endl;
+        return (false);
+    }
+
+   // Precision truncates the extra digits
+   //
+    FAST::encode_real (bytes, static_cast<cu_TYPE>(1.23456), 2);
+    FAST::decode_decimal (bytes, dec);
+    if (dec.mantissa != 123 || dec.exponent != -2)  {
+        cout << "ERROR: 1.23456 to 2 digits is " << dec.mantissa << "e"
+             << dec.exponent << endl;
+        return (false);
+    }
+
+    FAST::encode_real (bytes, static_cast<cu_TYPE>(::sqrt (-1)));
+    FAST::decode_real (bytes, x);
+    if (x == x)  {
+        cout << "ERROR: NaN did not round trip" << endl;
+        return (false);
+    }
+
+   // The exponents of these do not fit in the exponent byte for doubles
+   //
+    const   bool    is_double = sizeof (cu_TYPE) == sizeof (double);
+    const   cu_TYPE extremes [] = {
+        numeric_limits<cu_TYPE>::max (), -numeric_limits<cu_TYPE>::max (),
+        numeric_limits<cu_TYPE>::min (),
+        numeric_limits<cu_TYPE>::denorm_min (),
+        static_cast<cu_TYPE>(is_double ? 1e100 : 1e30),
+        static_cast<cu_TYPE>(is_double ? -1e-70 : -1e-30)
+    };
+
+    for (size_t i = 0; i < sizeof (extremes) / sizeof (extremes [0]); ++i)  {
+        const   FAST::size_type encoded = FAST::encode_real (bytes,
+                                                             extremes [i]);
+
+        if (FAST::decode_real (bytes, x) != encoded || x != extremes [i] ||
+            encoded > 16)  {
+            cout << "ERROR: " << extremes [i] << " read back as " << x
+                 << endl;
+            return (false);
+        }
+    }
+
+    return (true);
+}
+
+// ----------------------------------------------------------------------------
+
+int main (int argCnt, char *argVctr [])  {
+
+    const   char    *names [] = { "scalar", "swar", "bmi2" };
+
+    cout << "\n\tBenchmarking FAST integer decoders ...\n" << endl;
+    cout << "Best decoder on this CPU: " << names [FAST::best_decoder ()]
+         << endl;
+
+    if (! test_unsigned<unsigned int>("32-bit") ||
+        ! test_unsigned<unsigned long long int>("64-bit") ||
+        ! test_signed<int>("32-bit") ||
+        ! test_signed<long long int>("64-bit") ||
+        ! test_arrays<unsigned int, false>("32-bit") ||
+        ! test_arrays<unsigned long long int, false>("64-bit") ||
+        ! test_arrays<int, true>("32-bit") ||
+        ! test_arrays<long long int, true>("64-bit") ||
+        ! test_reals<double>("double") ||
+        ! test_reals<float>("float"))
+        return (EXIT_FAILURE);
+
+    cout << "SUCCESS: all decoders agree" << endl;
+    return (EXIT_SUCCESS);
+}
+
+// ----------------------------------------------------------------------------
+
+// Local Variables:
+// mode:C++
+// tab-width:4
+// c-basic-offset:4
+// End:
@@ -0,0 +1,213 @@
+// Hossein Moein
+// March 25, 2018
+// Copyright (C) 2018-2019 Hossein Moein
+// Distributed under the BSD Software License (see file License)
+
+#include <cfloat>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <DMScu_FASTSchema.h>
+
+using namespace std;
+
+typedef DMScu_FASTProtocolUtilities FAST;
+
+// ----------------------------------------------------------------------------
+
+struct  Order  {
+
+    uint32_t        id;
+    int64_t         quantity;
+    double          price;
+    unsigned short  side;
+    int             flags;
+    float           discount;
+};
+
+typedef DMScu_FASTSchema<DMScu_FASTField<&Order::id>,
+                         DMScu_FASTField<&Order::quantity>,
+                         DMScu_FASTField<&Order::price>,
+                         DMScu_FASTField<&Order::side>,
+                         DMScu_FASTField<&Order::flags>,
+                         DMScu_FASTField<&Order::discount>> OrderSchema;
+
+// 5 + 10 + 16 + 3 + 5 + 16
+//
+static_assert (OrderSchema::MAX_SIZE == 55, "Wrong OrderSchema::MAX_SIZE");
+// MAX_SIZE, plus a byte read past each integer by a malformed message
+//
+static_assert (OrderSchema::MAX_READ == 55 + 8, "Wrong OrderSchema::MAX_READ");
+static_assert (sizeof (OrderSchema::buffer_type) == OrderSchema::MAX_SIZE,
+               "Wrong OrderSchema::buffer_type");
+static_assert (FAST::max_encoded_size<uint64_t>(2, false) ==
+                   2 * 10 + FAST::ENCODE_PADDING,
+               "max_encoded_size() is not constexpr");
+
+// ----------------------------------------------------------------------------
+
+static  const   int     COUNT = 1000000;
+
+// ----------------------------------------------------------------------------
+
+static void make_orders (vector<Order> &orders)  {
+
+    mt19937_64  gen (777);
+
+    orders.resize (COUNT);
+    for (int i = 0; i < COUNT; ++i)  {
+        Order   &order = orders [i];
+
+        order.id = static_cast<uint32_t>(gen () >> (gen () % 64));
+        order.quantity = static_cast<int64_t>(gen ()) >> (gen () % 64);
+        order.price =
+            static_cast<double>(static_cast<int>(gen () % 200000) - 1000) /
+            100.0;
+        order.side = static_cast<unsigned short>(gen ());
+        order.flags = static_cast<int>(gen () >> 32) >> (gen () % 32);
+        order.discount = static_cast<float>(gen () % 100) / 4.0f;
+    }
+
+   // Reals whose exponents do not fit in the exponent byte
+   //
+    orders [0].price = -DBL_MAX;
+    orders [1].price = 4.9406564584124654e-324;
+    orders [2].price = 1e100;
+
+    return;
+}
+
+// ----------------------------------------------------------------------------
+
+static bool same (const Order &lhs, const Order &rhs)  {
+
+    return (lhs.id == rhs.id && lhs.quantity == rhs.quantity &&
+            lhs.price == rhs.price && lhs.side == rhs.side &&
+            lhs.flags == rhs.flags && lhs.discount == rhs.discount);
+}
+
+// ----------------------------------------------------------------------------
+
+// What a hand-written encoder would do with the primitives
+//
+static unsigned int
+encode_by_hand (unsigned char *buffer, const Order &order)  {
+
+    unsigned int    pos = FAST::encode_uinteger (buffer, order.id);
+
+    pos += FAST::encode_integer (buffer + pos, order.quantity);
+    pos += FAST::encode_real (buffer + pos, order.price);
+    pos += FAST::encode_uinteger (buffer + pos, order.side);
+    pos += FAST::encode_integer (buffer + pos, order.flags);
+    pos += FAST::encode_real (buffer + pos, order.discount);
+    return (pos);
+}
+
+// ----------------------------------------------------------------------------
+
+int main (int argCnt, char *argVctr [])  {
+
+    cout << "\n\tTesting DMScu_FASTSchema ...\n" << endl;
+
+    vector<Order>           orders;
+    vector<unsigned char>   buffer (COUNT * OrderSchema::MAX_SIZE);
+
+    make_orders (orders);
+
+    auto            start = chrono::steady_clock::now ();
+    unsigned int    pos = 0;
+
+    for (int i = 0; i < COUNT; ++i)
+        pos += OrderSchema::encode (&(buffer [pos]), orders [i]);
+
+    auto    ns = chrono::duration_cast<chrono::nanoseconds>
+                     (chrono::steady_clock::now () - start).count ();
+
+    cout << "Encode: " << static_cast<double>(ns) / COUNT << " ns/message, "
+         << pos << " bytes" << endl;
+
+    const   unsigned int    end = pos;
+
+   // Byte for byte what the primitives produce
+   //
+    for (int i = 0, by_hand_pos = 0; i < COUNT; ++i)  {
+        OrderSchema::buffer_type    by_hand;
+        const   unsigned int        size =
+            encode_by_hand (by_hand, orders [i]);
+
+        if (::memcmp (by_hand, &(buffer [by_hand_pos]), size) != 0)  {
+            cout << "ERROR: order " << i << " encoded differently" << endl;
+            return (EXIT_FAILURE);
+        }
+        by_hand_pos += size;
+    }
+
+    vector<Order>   decoded (COUNT);
+
+    start = chrono::steady_clock::now ();
+    pos = 0;
+    for (int i = 0; i < COUNT; ++i)
+        pos += OrderSchema::decode (&(buffer [pos]), end - pos, decoded [i]);
+    ns = chrono::duration_cast<chrono::nanoseconds>
+             (chrono::steady_clock::now () - start).count ();
+    cout << "Decode: " << static_cast<double>(ns) / COUNT << " ns/message"
+         << endl;
+
+    if (pos != end)  {
+        cout << "ERROR: decoded " << pos << " of " << end << " bytes" << endl;
+        return (EXIT_FAILURE);
+    }
+    for (int i = 0; i < COUNT; ++i)
+        if (! same (orders [i], decoded [i]))  {
+            cout << "ERROR: order " << i << " decoded wrong" << endl;
+            return (EXIT_FAILURE);
+        }
+
+   // Every prefix of a message is incomplete
+   //
+    OrderSchema::buffer_type    one;
+    const   unsigned int        size = OrderSchema::encode (one, orders [1]);
+    Order                       order;
+
+    for (unsigned int len = 0; len < size; ++len)
+        if (OrderSchema::decode (one, len, order) != 0)  {
+            cout << "ERROR: decoded a message of " << len << " bytes out of "
+                 << size << endl;
+            return (EXIT_FAILURE);
+        }
+    if (OrderSchema::decode (one, size, order) != size ||
+        ! same (order, orders [1]))  {
+        cout << "ERROR: complete message was not decoded" << endl;
+        return (EXIT_FAILURE);
+    }
+
+   // An overlong field fails, instead of waiting for more bytes forever
+   //
+    unsigned char   bad_id [16] = { };
+    unsigned char   bad_price [16] = { 0x81, 0x81, FAST::WIDE_EXPONENT };
+
+    if (OrderSchema::decode (bad_id, sizeof (bad_id), order) !=
+            OrderSchema::MALFORMED ||
+        OrderSchema::decode (bad_id, 4, order) != 0 ||
+        OrderSchema::decode (bad_price, sizeof (bad_price), order) !=
+            OrderSchema::MALFORMED ||
+        OrderSchema::decode (bad_price, 7, order) != 0)  {
+        cout << "ERROR: overlong field was not reported" << endl;
+        return (EXIT_FAILURE);
+    }
+
+    cout << "SUCCESS: all orders round trip" << endl;
+    return (EXIT_SUCCESS);
+}
+
+// ----------------------------------------------------------------------------
+
+// Local Variables:
+// mode:C++
+// tab-width:4
+// c-basic-offset:4
+// End:
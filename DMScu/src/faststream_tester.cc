@@ -0,0 +1,280 @@
+// Hossein Moein
+// March 25, 2018
+// Copyright (C) 2018-2019 Hossein Moein
+// Distributed under the BSD Software License (see file License)
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include <DMScu_FASTSchema.h>
+#include <DMScu_FASTStreamDecoder.h>
+
+using namespace std;
+
+typedef DMScu_FASTProtocolUtilities FAST;
+typedef DMScu_FASTStreamDecoder     Stream;
+
+// ----------------------------------------------------------------------------
+
+struct  Trade  {
+
+    uint64_t    id;
+    int         quantity;
+    double      price;
+    long long   timestamp;
+};
+
+typedef DMScu_FASTSchema<DMScu_FASTField<&Trade::id>,
+                         DMScu_FASTField<&Trade::quantity>,
+                         DMScu_FASTField<&Trade::price>,
+                         DMScu_FASTField<&Trade::timestamp>> TradeSchema;
+
+static  const   int COUNT = 1000000;
+
+// ----------------------------------------------------------------------------
+
+static bool same (const Trade &lhs, const Trade &rhs)  {
+
+    return (lhs.id == rhs.id && lhs.quantity == rhs.quantity &&
+            lhs.price == rhs.price && lhs.timestamp == rhs.timestamp);
+}
+
+// ----------------------------------------------------------------------------
+
+// Feeds the stream in chunks of 1 to max_chunk bytes, so fields straddle
+// chunks everywhere
+//
+static bool decode_in_chunks (const vector<unsigned char> &buffer,
+                              const vector<Trade> &trades,
+                              unsigned int max_chunk)  {
+
+    mt19937         gen (max_chunk);
+    Stream          stream;
+    Trade           trade;
+    size_t          pos = 0;
+    int             decoded = 0;
+    const   auto    start = chrono::steady_clock::now ();
+
+    while (pos < buffer.size ())  {
+        const   size_t  chunk =
+            min<size_t>(1 + gen () % max_chunk, buffer.size () - pos);
+
+        stream.feed (&(buffer [pos]), static_cast<unsigned int>(chunk));
+        pos += chunk;
+
+        Stream::STATUS  status;
+
+        while ((status = TradeSchema::decode (stream, trade)) ==
+                   Stream::_done_)  {
+            if (! same (trade, trades [decoded]))  {
+                cout << "ERROR: trade " << decoded << " decoded wrong with "
+                     << max_chunk << " byte chunks" << endl;
+                return (false);
+            }
+            decoded += 1;
+        }
+        if (status != Stream::_need_more_ || stream.available () != 0)  {
+            cout << "ERROR: stream stopped with " << stream.available ()
+                 << " bytes left" << endl;
+            return (false);
+        }
+    }
+
+    const   auto    ns = chrono::duration_cast<chrono::nanoseconds>
+                             (chrono::steady_clock::now () - start).count ();
+
+    if (decoded != COUNT || stream.field_index () != 0)  {
+        cout << "ERROR: decoded " << decoded << " trades" << endl;
+        return (false);
+    }
+
+    cout << "    chunks of up to " << max_chunk << " bytes: "
+         << static_cast<double>(ns) / COUNT << " ns/message" << endl;
+    return (true);
+}
+
+// ----------------------------------------------------------------------------
+
+// A hand-written message decoder, a switch on the field cursor, fed one
+// byte at a time
+//
+static bool test_fields ()  {
+
+    unsigned char   buffer [64];
+    unsigned int    size = 0;
+
+    buffer [size++] = 0xE0;  // pmap 11 then 0s
+    size += FAST::encode_uinteger (buffer + size, 300U);
+    size += FAST::encode_integer (buffer + size, -70000);
+    buffer [size++] = 'A';
+    buffer [size++] = 'B';
+    buffer [size++] = 'C' | 0x80;
+    buffer [size++] = 0x80;  // Empty string
+    size += FAST::encode_decimal (buffer + size, FAST::Decimal (-1234, -2));
+    size += FAST::encode_real (buffer + size, 0.5);
+
+    Stream          stream;
+    uint64_t        pmap = 0;
+    unsigned int    u = 0;
+    int             i = 0;
+    char            str [8];
+    char            empty [8];
+    unsigned int    len = 0;
+    unsigned int    empty_len = 99;
+    FAST::Decimal   dec;
+    double          real = 0;
+    Stream::STATUS  status = Stream::_need_more_;
+
+    for (unsigned int b = 0; b < size; ++b)  {
+        stream.feed (buffer + b, 1);
+
+        switch (stream.field_index ())  {
+            case 0:
+                if ((status = stream.decode_pmap (pmap)) != Stream::_done_)
+                    break;
+                stream.next_field ();
+                [[fallthrough]];
+            case 1:
+                if ((status = stream.decode_uinteger (u)) != Stream::_done_)
+                    break;
+                stream.next_field ();
+                [[fallthrough]];
+            case 2:
+                if ((status = stream.decode_integer (i)) != Stream::_done_)
+                    break;
+                stream.next_field ();
+                [[fallthrough]];
+            case 3:
+                if ((status = stream.decode_ascii (str, sizeof (str), len)) !=
+                        Stream::_done_)
+                    break;
+                stream.next_field ();
+                [[fallthrough]];
+            case 4:
+                if ((status = stream.decode_ascii (empty, sizeof (empty),
+                                                   empty_len)) !=
+                        Stream::_done_)
+                    break;
+                stream.next_field ();
+                [[fallthrough]];
+            case 5:
+                if ((status = stream.decode_decimal (dec)) != Stream::_done_)
+                    break;
+                stream.next_field ();
+                [[fallthrough]];
+            case 6:
+                if ((status = stream.decode_real (real)) != Stream::_done_)
+                    break;
+                stream.end_message ();
+        }
+        if (status == Stream::_malformed_)
+            break;
+    }
+
+    if (status != Stream::_done_ || pmap != 0xC000000000000000ULL ||
+        u != 300 || i != -70000 || len != 3 || ::strcmp (str, "ABC") != 0 ||
+        empty_len != 0 || empty [0] != 0 ||
+        dec.mantissa != -1234 || dec.exponent != -2 || real != 0.5)  {
+        cout << "ERROR: fields decoded wrong one byte at a time" << endl;
+        return (false);
+    }
+
+   // A 32-bit integer can not take more than 5 bytes
+   //
+    static  const   unsigned char   overlong [] = { 1, 1, 1, 1, 1, 0x81 };
+
+    stream.feed (overlong, sizeof (overlong));
+    if (stream.decode_uinteger (u) != Stream::_malformed_)  {
+        cout << "ERROR: overlong field was not detected" << endl;
+        return (false);
+    }
+
+   // The same in a chunk large enough for the wide decoders, and a 64-bit
+   // integer of 11 bytes
+   //
+    unsigned char       padded [32] = { 0 };
+    unsigned long long  wide = 0;
+    Stream::STATUS      statuses [3];
+
+    ::memcpy (padded, overlong, sizeof (overlong));
+    stream.feed (padded, sizeof (padded));
+    statuses [0] = stream.decode_uinteger (u);
+    stream.feed (padded, sizeof (padded));
+    statuses [1] = stream.decode_integer (i);
+    ::memset (padded, 1, 10);
+    padded [10] = 0x81;
+    stream.feed (padded, sizeof (padded));
+    statuses [2] = stream.decode_uinteger (wide);
+    if (statuses [0] != Stream::_malformed_ ||
+        statuses [1] != Stream::_malformed_ ||
+        statuses [2] != Stream::_malformed_)  {
+        cout << "ERROR: overlong field was not detected in a large chunk"
+             << endl;
+        return (false);
+    }
+
+   // An exponent that does not fit in the exponent byte, one byte at a time
+   //
+    size = FAST::encode_real (buffer, -1e-70);
+    stream.reset ();
+    status = Stream::_need_more_;
+    for (unsigned int b = 0; b < size && status == Stream::_need_more_; ++b)  {
+        stream.feed (buffer + b, 1);
+        status = stream.decode_real (real);
+    }
+    if (status != Stream::_done_ || real != -1e-70)  {
+        cout << "ERROR: wide exponent decoded wrong one byte at a time"
+             << endl;
+        return (false);
+    }
+
+    return (true);
+}
+
+// ----------------------------------------------------------------------------
+
+int main (int argCnt, char *argVctr [])  {
+
+    cout << "\n\tTesting DMScu_FASTStreamDecoder ...\n" << endl;
+
+    mt19937_64      gen (13579);
+    vector<Trade>   trades (COUNT);
+
+    for (int i = 0; i < COUNT; ++i)  {
+        trades [i].id = gen () >> (gen () % 64);
+        trades [i].quantity = static_cast<int>(gen () % 200000) - 100000;
+        trades [i].price =
+            static_cast<double>(gen () % 10000000) / 10000.0;
+        trades [i].timestamp = static_cast<long long>(gen () >> 1);
+    }
+
+    vector<unsigned char>   buffer (COUNT * TradeSchema::MAX_SIZE);
+    size_t                  pos = 0;
+
+    for (int i = 0; i < COUNT; ++i)
+        pos += TradeSchema::encode (&(buffer [pos]), trades [i]);
+    buffer.resize (pos);
+
+    cout << "Streaming " << COUNT << " trades, " << pos << " bytes:" << endl;
+    if (! decode_in_chunks (buffer, trades, 1) ||
+        ! decode_in_chunks (buffer, trades, 7) ||
+        ! decode_in_chunks (buffer, trades, 64) ||
+        ! decode_in_chunks (buffer, trades, 4096) ||
+        ! test_fields ())
+        return (EXIT_FAILURE);
+
+    cout << "SUCCESS: all trades decoded" << endl;
+    return (EXIT_SUCCESS);
+}
+
+// ----------------------------------------------------------------------------
+
+// Local Variables:
+// mode:C++
+// tab-width:4
+// c-basic-offset:4
+// End:
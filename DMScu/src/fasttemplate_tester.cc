@@ -0,0 +1,515 @@
+// Hossein Moein
+// March 25, 2018
+// Copyright (C) 2018-2019 Hossein Moein
+// Distributed under the BSD Software License (see file License)
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include <DMScu_FASTTemplateCodec.h>
+
+using namespace std;
+
+typedef DMScu_FASTTemplateCodec Codec;
+
+// ----------------------------------------------------------------------------
+
+static  const   char    *TEMPLATES =
+    "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+    "<templates xmlns=\"http://www.fixprotocol.org/ns/fast/td/1.1\">\n"
+    "  <!-- Market data incremental refresh -->\n"
+    "  <template name=\"MDIncRefresh\" id=\"1\">\n"
+    "    <string name=\"MessageType\"><constant value=\"X\"/></string>\n"
+    "    <uInt32 name=\"MsgSeqNum\"><increment/></uInt32>\n"
+    "    <uInt64 name=\"SendingTime\"><delta/></uInt64>\n"
+    "    <string name=\"SenderCompID\" presence=\"optional\">\n"
+    "      <copy value=\"EXCH\"/>\n"
+    "    </string>\n"
+    "    <sequence name=\"MDEntries\">\n"
+    "      <length name=\"NoMDEntries\"><copy/></length>\n"
+    "      <uInt32 name=\"MDUpdateAction\"><copy value=\"1\"/></uInt32>\n"
+    "      <string name=\"Symbol\"><copy/></string>\n"
+    "      <int32 name=\"SecurityID\"><delta/></int32>\n"
+    "      <decimal name=\"MDEntryPx\"><delta/></decimal>\n"
+    "      <int64 name=\"MDEntrySize\" presence=\"optional\">\n"
+    "        <delta/>\n"
+    "      </int64>\n"
+    "      <string name=\"QuoteCondition\" presence=\"optional\">\n"
+    "        <tail/>\n"
+    "      </string>\n"
+    "      <uInt32 name=\"NumberOfOrders\" presence=\"optional\"/>\n"
+    "      <decimal name=\"Factor\"><default value=\"1.5\"/></decimal>\n"
+    "    </sequence>\n"
+    "  </template>\n"
+    "  <template name=\"Heartbeat\" id=\"2\">\n"
+    "    <uInt32 name=\"MsgSeqNum\"><increment/></uInt32>\n"
+    "    <string name=\"Text\" presence=\"optional\"><delta/></string>\n"
+    "  </template>\n"
+    "</templates>\n";
+
+// ----------------------------------------------------------------------------
+
+struct  Entry  {
+
+    uint32_t                    action;
+    DMScu_FixedSizeString<15>   symbol;
+    int32_t                     security_id;
+    double                      px;
+    int64_t                     size;
+    bool                        has_size;
+    DMScu_FixedSizeString<7>    condition;
+    bool                        has_condition;
+    uint32_t                    orders;
+    bool                        has_orders;
+    double                      factor;
+};
+
+struct  Refresh  {
+
+    DMScu_FixedSizeString<3>    msg_type;
+    uint32_t                    seq;
+    uint64_t                    time;
+    DMScu_FixedSizeString<15>   sender;
+    bool                        has_sender;
+    Entry                       entries [8];
+    uint32_t                    entry_count;
+};
+
+struct  Heartbeat  {
+
+    uint32_t                    seq;
+    DMScu_FixedSizeString<63>   text;
+    bool                        has_text;
+};
+
+// ----------------------------------------------------------------------------
+
+static void load (Codec &codec)  {
+
+    codec.load_templates (TEMPLATES);
+
+    codec.bind (1, "MessageType", &Refresh::msg_type);
+    codec.bind (1, "MsgSeqNum", &Refresh::seq);
+    codec.bind (1, "SendingTime", &Refresh::time);
+    codec.bind (1, "SenderCompID", &Refresh::sender);
+    codec.bind_presence (1, "SenderCompID", &Refresh::has_sender);
+    codec.bind_sequence (1, "MDEntries",
+                         &Refresh::entries, &Refresh::entry_count);
+    codec.bind (1, "MDEntries.MDUpdateAction", &Entry::action);
+    codec.bind (1, "MDEntries.Symbol", &Entry::symbol);
+    codec.bind (1, "MDEntries.SecurityID", &Entry::security_id);
+    codec.bind (1, "MDEntries.MDEntryPx", &Entry::px);
+    codec.bind (1, "MDEntries.MDEntrySize", &Entry::size);
+    codec.bind_presence (1, "MDEntries.MDEntrySize", &Entry::has_size);
+    codec.bind (1, "MDEntries.QuoteCondition", &Entry::condition);
+    codec.bind_presence (1, "MDEntries.QuoteCondition",
+                         &Entry::has_condition);
+    codec.bind (1, "MDEntries.NumberOfOrders", &Entry::orders);
+    codec.bind_presence (1, "MDEntries.NumberOfOrders", &Entry::has_orders);
+    codec.bind (1, "MDEntries.Factor", &Entry::factor);
+
+    codec.bind (2, "MsgSeqNum", &Heartbeat::seq);
+    codec.bind (2, "Text", &Heartbeat::text);
+    codec.bind_presence (2, "Text", &Heartbeat::has_text);
+    return;
+}
+
+// ----------------------------------------------------------------------------
+
+static bool same (const Refresh &lhs, const Refresh &rhs)  {
+
+    if (! (lhs.msg_type == rhs.msg_type) || lhs.seq != rhs.seq ||
+        lhs.time != rhs.time || lhs.has_sender != rhs.has_sender ||
+        (lhs.has_sender && ! (lhs.sender == rhs.sender)) ||
+        lhs.entry_count != rhs.entry_count)
+        return (false);
+
+    for (uint32_t i = 0; i < lhs.entry_count; ++i)  {
+        const   Entry   &l = lhs.entries [i];
+        const   Entry   &r = rhs.entries [i];
+
+        if (l.action != r.action || ! (l.symbol == r.symbol) ||
+            l.security_id != r.security_id || l.px != r.px ||
+            l.has_size != r.has_size || (l.has_size && l.size != r.size) ||
+            l.has_condition != r.has_condition ||
+            (l.has_condition && ! (l.condition == r.condition)) ||
+            l.has_orders != r.has_orders ||
+            (l.has_orders && l.orders != r.orders) ||
+            l.factor != r.factor)
+            return (false);
+    }
+
+    return (true);
+}
+
+// ----------------------------------------------------------------------------
+
+static bool same (const Heartbeat &lhs, const Heartbeat &rhs)  {
+
+    return (lhs.seq == rhs.seq && lhs.has_text == rhs.has_text &&
+            (! lhs.has_text || lhs.text == rhs.text));
+}
+
+// ----------------------------------------------------------------------------
+
+// The Heartbeat messages worked out by hand from the FAST 1.1 spec
+//
+static bool test_wire_format ()  {
+
+    static  const   unsigned char   wire [] = {
+        0xE0, 0x82, 0x85, 0x81, 0x41, 0x42, 0xC3,  // seq 5, "ABC"
+        0x80, 0x82, 0xC4,                          // seq 6, "ABD"
+        0x80, 0x80                                 // seq 7, null
+    };
+    static  const   char            *texts [] = { "ABC", "ABD", NULL };
+
+    Codec           encoder;
+    Codec           decoder;
+    unsigned char   buffer [64];
+    unsigned int    pos = 0;
+
+    load (encoder);
+    load (decoder);
+
+    for (int i = 0; i < 3; ++i)  {
+        Heartbeat   msg;
+
+        msg.seq = 5 + i;
+        msg.has_text = texts [i] != NULL;
+        if (msg.has_text)
+            msg.text = texts [i];
+        pos += encoder.encode (buffer + pos, sizeof (buffer) - pos, 2, &msg);
+    }
+
+    if (pos != sizeof (wire) || ::memcmp (buffer, wire, pos) != 0)  {
+        cout << "ERROR: Heartbeats encoded to the wrong bytes" << endl;
+        return (false);
+    }
+
+    pos = 0;
+    for (int i = 0; i < 3; ++i)  {
+        Heartbeat       msg;
+        unsigned int    template_id;
+
+        pos += decoder.decode (wire + pos, sizeof (wire) - pos,
+                               template_id, &msg);
+        if (template_id != 2 || msg.seq != 5U + i ||
+            msg.has_text != (texts [i] != NULL) ||
+            (msg.has_text && ! (msg.text == texts [i])))  {
+            cout << "ERROR: Heartbeat " << i << " decoded wrong" << endl;
+            return (false);
+        }
+    }
+
+    return (true);
+}
+
+// ----------------------------------------------------------------------------
+
+static void make_refresh (mt19937 &gen, Refresh &msg)  {
+
+    static  const   char    *symbols [] = { "IBM", "MSFT", "ESZ9", "AAPL" };
+    static  const   char    *conditions [] = { "AB", "AC", "BC", "ZZ" };
+
+    msg.msg_type = "X";
+    msg.seq += 1;
+    msg.time += gen () % 5000;
+    msg.has_sender = gen () % 8 != 0;
+    msg.sender = gen () % 4 != 0 ? "EXCH" : "OTHER";
+    msg.entry_count = gen () % 9;
+    for (uint32_t i = 0; i < msg.entry_count; ++i)  {
+        Entry   &entry = msg.entries [i];
+
+        entry.action = gen () % 3;
+        entry.symbol = symbols [gen () % 4];
+        entry.security_id = static_cast<int32_t>(gen () % 2000) - 1000;
+        entry.px = static_cast<double>(
+                       static_cast<int>(gen () % 20000) - 5000) / 100.0;
+        entry.has_size = gen () % 4 != 0;
+        entry.size = entry.has_size
+            ? static_cast<int64_t>(gen ()) * 1000 - 1000000000000LL : 0;
+        entry.has_condition = gen () % 3 != 0;
+        entry.condition = entry.has_condition ? conditions [gen () % 4] : "";
+        entry.has_orders = gen () % 2 != 0;
+        entry.orders = entry.has_orders ? gen () % 100 : 0;
+        entry.factor = gen () % 2 != 0 ? 1.5 : 0.25;
+    }
+
+    return;
+}
+
+// ----------------------------------------------------------------------------
+
+// A stream of messages of both templates, encoded back to back and decoded
+// by another instance
+//
+static bool test_round_trip ()  {
+
+    const   int         COUNT = 10000;
+    mt19937             gen (4321);
+    Codec               encoder;
+    Codec               decoder;
+    vector<Refresh>     refreshes (COUNT);
+    vector<Heartbeat>   heartbeats (COUNT);
+    vector<bool>        is_heartbeat (COUNT);
+    Refresh             refresh = Refresh ();
+    Heartbeat           heartbeat = Heartbeat ();
+
+    load (encoder);
+    load (decoder);
+    for (int i = 0; i < COUNT; ++i)  {
+        is_heartbeat [i] = gen () % 10 == 0;
+        if (is_heartbeat [i])  {
+            static  const   char    *texts [] = {
+                "ping", "ping pong", "pong", "king pong"
+            };
+
+            heartbeat.seq = gen () % 2 != 0 ? heartbeat.seq + 1 : gen ();
+            heartbeat.has_text = gen () % 5 != 0;
+            heartbeat.text = texts [gen () % 4];
+            heartbeats [i] = heartbeat;
+        }
+        else  {
+            make_refresh (gen, refresh);
+            refreshes [i] = refresh;
+        }
+    }
+
+    vector<unsigned char>   buffer (COUNT * 512);
+    unsigned int            pos = 0;
+
+    for (int i = 0; i < COUNT; ++i)
+        pos += is_heartbeat [i]
+            ? encoder.encode (&(buffer [pos]), buffer.size () - pos,
+                              2, &(heartbeats [i]))
+            : encoder.encode (&(buffer [pos]), buffer.size () - pos,
+                              1, &(refreshes [i]));
+
+   // No slack at the end, so the last fields are read byte by byte
+   //
+    buffer.resize (pos);
+    cout << COUNT << " messages in " << pos << " bytes" << endl;
+
+    unsigned int    end = pos;
+
+    pos = 0;
+    for (int i = 0; i < COUNT; ++i)  {
+        const   unsigned int    peeked =
+            decoder.peek_template_id (&(buffer [pos]), end - pos);
+        unsigned int            template_id;
+        bool                    ok;
+
+        if (peeked == 2)  {
+            Heartbeat   msg;
+
+            pos += decoder.decode (&(buffer [pos]), end - pos,
+                                   template_id, &msg);
+            ok = is_heartbeat [i] && same (msg, heartbeats [i]);
+        }
+        else  {
+            Refresh msg;
+
+            pos += decoder.decode (&(buffer [pos]), end - pos,
+                                   template_id, &msg);
+            ok = ! is_heartbeat [i] && same (msg, refreshes [i]);
+        }
+        if (! ok || template_id != peeked)  {
+            cout << "ERROR: message " << i << " decoded wrong" << endl;
+            return (false);
+        }
+    }
+
+    if (pos != end)  {
+        cout << "ERROR: decoded " << pos << " of " << end << " bytes"
+             << endl;
+        return (false);
+    }
+
+    return (true);
+}
+
+// ----------------------------------------------------------------------------
+
+template<class cu_FUNC>
+static bool expect_throw (const char *what, cu_FUNC func)  {
+
+    try  {
+        func ();
+    }
+    catch (const std::runtime_error &ex)  {
+        cout << "    " << what << ": " << ex.what () << endl;
+        return (true);
+    }
+
+    cout << "ERROR: " << what << " did not throw" << endl;
+    return (false);
+}
+
+// ----------------------------------------------------------------------------
+
+static bool test_errors ()  {
+
+    Codec           codec;
+    Refresh         refresh = Refresh ();
+    unsigned char   buffer [4096];
+    unsigned int    template_id;
+
+    load (codec);
+
+    mt19937 gen (99);
+
+    make_refresh (gen, refresh);
+    refresh.entry_count = 8;
+    for (int i = 0; i < 8; ++i)
+        make_refresh (gen, refresh);
+    refresh.entry_count = 5;
+
+    const   unsigned int    size =
+        codec.encode (buffer, sizeof (buffer), 1, &refresh);
+
+    cout << "Errors:" << endl;
+    return (
+        expect_throw ("Truncated message", [&]()  {
+            Codec   decoder;
+
+            load (decoder);
+            decoder.decode (buffer, size - 1, template_id, &refresh);
+        }) &&
+        expect_throw ("Small buffer", [&]()  {
+            codec.reset ();
+            codec.encode (buffer, size - 1, 1, &refresh);
+        }) &&
+        expect_throw ("Long sequence", [&]()  {
+            refresh.entry_count = 9;
+            codec.reset ();
+            codec.encode (buffer, sizeof (buffer), 1, &refresh);
+        }) &&
+        expect_throw ("Unknown template", [&]()  {
+            codec.encode (buffer, sizeof (buffer), 7, &refresh);
+        }) &&
+        expect_throw ("Missing mandatory field", [&]()  {
+            static  const   unsigned char   wire [] = { 0xC0, 0x82, 0x80 };
+            Heartbeat                       msg;
+
+            codec.reset ();
+            codec.decode (wire, sizeof (wire), template_id, &msg);
+        }) &&
+        expect_throw ("Overlong integer", [&]()  {
+            unsigned char   wire [32] = { 0xC0 };
+
+            wire [11] = 0x82;  // Template id 2 in 11 bytes
+            codec.peek_template_id (wire, 12);
+        }) &&
+        expect_throw ("Overlong integer in a large buffer", [&]()  {
+            unsigned char   wire [32] = { 0xC0 };
+
+            wire [11] = 0x82;
+            codec.peek_template_id (wire, sizeof (wire));
+        }) &&
+        expect_throw ("Overlong signed integer in a large buffer", [&]()  {
+            Codec           decoder;
+            unsigned char   wire [32] = { 0xC0, 0x83 };
+            Heartbeat       msg;
+
+            decoder.load_templates ("<templates><template id=\"3\">"
+                                    "<int64 name=\"A\"/>"
+                                    "</template></templates>");
+            wire [13] = 0x81;  // 0 in 12 bytes
+            decoder.decode (wire, sizeof (wire), template_id, &msg);
+        }) &&
+        expect_throw ("uInt32 out of range", [&]()  {
+            Codec                           decoder;
+            static  const   unsigned char   wire [] = {
+                0xC0, 0x83, 0x10, 0x00, 0x00, 0x00, 0x80  // 2^32
+            };
+            Heartbeat                       msg;
+
+            decoder.load_templates ("<templates><template id=\"3\">"
+                                    "<uInt32 name=\"A\"/>"
+                                    "</template></templates>");
+            decoder.decode (wire, sizeof (wire), template_id, &msg);
+        }) &&
+        expect_throw ("Exponent out of range", [&]()  {
+            Codec                           decoder;
+            static  const   unsigned char   wire [] = {
+                0xC0, 0x83, 0x08, 0x00, 0x00, 0x00, 0x80, 0x81  // 2^31, 1
+            };
+            Heartbeat                       msg;
+
+            decoder.load_templates ("<templates><template id=\"3\">"
+                                    "<decimal name=\"D\"/>"
+                                    "</template></templates>");
+            decoder.decode (wire, sizeof (wire), template_id, &msg);
+        }) &&
+        expect_throw ("Exponent delta out of range", [&]()  {
+            Codec                           decoder;
+            static  const   unsigned char   wire [] = {
+                0xC0, 0x83, 0x08, 0x00, 0x00, 0x00, 0x80, 0x81  // 2^31, 1
+            };
+            Heartbeat                       msg;
+
+            decoder.load_templates ("<templates><template id=\"3\">"
+                                    "<decimal name=\"D\"><delta/></decimal>"
+                                    "</template></templates>");
+            decoder.decode (wire, sizeof (wire), template_id, &msg);
+        }) &&
+        expect_throw ("No template id", [&]()  {
+            static  const   unsigned char   wire [] = { 0x80 };
+
+            codec.reset ();
+            codec.peek_template_id (wire, sizeof (wire));
+        }) &&
+        expect_throw ("Unsupported group", [&]()  {
+            codec.load_templates ("<templates><template id=\"3\">"
+                                  "<group name=\"G\"/>"
+                                  "</template></templates>");
+        }) &&
+        expect_throw ("Mismatched end tag", [&]()  {
+            codec.load_templates ("<template id=\"3\">"
+                                  "<uInt32 name=\"A\"></int32>"
+                                  "</template>");
+        }) &&
+        expect_throw ("Constant without a value", [&]()  {
+            codec.load_templates ("<template id=\"3\">"
+                                  "<uInt32 name=\"A\"><constant/></uInt32>"
+                                  "</template>");
+        }) &&
+        expect_throw ("Wrong member type", [&]()  {
+            codec.bind (1, "MsgSeqNum", &Refresh::time);
+        }) &&
+        expect_throw ("Unknown field", [&]()  {
+            codec.bind (1, "MDEntries.Price", &Entry::px);
+        }));
+}
+
+// ----------------------------------------------------------------------------
+
+int main (int argCnt, char *argVctr [])  {
+
+    cout << "\n\tTesting DMScu_FASTTemplateCodec ...\n" << endl;
+
+    try  {
+        if (! test_wire_format () || ! test_round_trip () ||
+            ! test_errors ())
+            return (EXIT_FAILURE);
+    }
+    catch (const std::runtime_error &ex)  {
+        cout << "ERROR: " << ex.what () << endl;
+        return (EXIT_FAILURE);
+    }
+
+    cout << "SUCCESS: all messages round trip" << endl;
+    return (EXIT_SUCCESS);
+}
+
+// ----------------------------------------------------------------------------
+
+// Local Variables:
+// mode:C++
+// tab-width:4
+// c-basic-offset:4
+// End:
@@ -5,16 +5,135 @@
 
 #include <cstdlib>
 #include <string.h>
+#include <strings.h>
 #include <time.h>
 #include <iostream>
+#include <random>
 #include <string>
 
+#include <sys/mman.h>
+#include <unistd.h>
+
 #include <DMScu_FixedSizeString.h>
 
 using namespace std;
 
 // ----------------------------------------------------------------------------
 
+static int sign (int x)  { return ((x > 0) - (x < 0)); }
+
+// std::string::npos is a size_t
+//
+static unsigned int pos_of (size_t pos)  {
+
+    return (pos == string::npos ? DMScu_VirtualString::npos
+                                : static_cast<unsigned int>(pos));
+}
+
+// ----------------------------------------------------------------------------
+
+// Checks the vectorized finds and compares against std::string and libc,
+// on random strings of every length around the vector sizes. Each string
+// ends right before a page that can not be read, so reading past the end
+// would crash.
+//
+static bool test_search ()  {
+
+    const   long    page = ::sysconf (_SC_PAGESIZE);
+    char            *pages = static_cast<char *>(
+        ::mmap (NULL, 2 * page, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+
+    if (pages == MAP_FAILED || ::mprotect (pages + page, page, PROT_NONE))  {
+        cout << "ERROR: could not map the guard page" << endl;
+        return (false);
+    }
+
+    mt19937                     gen (97);
+    DMScu_FixedSizeString<127>  fixed;
+
+    for (int iter = 0; iter < 200000; ++iter)  {
+        const   unsigned int    len = gen () % 100;
+        char                    *str = pages + page - len;
+        char                    token [8];
+        const   unsigned int    token_len = gen () % 4;
+        char                    set [20];
+        const   unsigned int    set_len = gen () % 20;
+        const   unsigned int    pos = gen () % (len + 2);
+
+       // A small alphabet, with both cases, so there are plenty of hits
+       //
+        for (unsigned int i = 0; i < len; ++i)
+            str [i] = "abcdABCD" [gen () % 8];
+        for (unsigned int i = 0; i < token_len; ++i)
+            token [i] = "abcd" [gen () % 4];
+        token [token_len] = 0;
+        for (unsigned int i = 0; i < set_len; ++i)
+            set [i] = static_cast<char>('A' + gen () % 40);
+        set [set_len] = 0;
+
+        const   string  std_str (str, len);
+
+        fixed = std_str.c_str ();
+        if (fixed.find (token [0], pos) !=
+                pos_of (std_str.find (token [0], pos)) ||
+            fixed.find (token, pos) != pos_of (std_str.find (token, pos)) ||
+            fixed.find_first_of (set, pos) !=
+                pos_of (std_str.find_first_of (set, pos)))  {
+            cout << "ERROR: find '" << token << "' or set '" << set
+                 << "' at " << pos << " in '" << std_str << "'" << endl;
+            return (false);
+        }
+        if (DMScu_StringSearch::find (str, len, token, token_len) !=
+                pos_of (std_str.find (token)) ||
+            DMScu_StringSearch::find_char (str, len, 'd') !=
+                pos_of (std_str.find ('d')) ||
+            DMScu_StringSearch::find_first_of (str, len, set, set_len) !=
+                pos_of (std_str.find_first_of (set)))  {
+            cout << "ERROR: search at the end of a page" << endl;
+            return (false);
+        }
+
+       // Every other time, the other string is a prefix of this one, so
+       // long runs compare equal
+       //
+        string  other_str (gen () % 100, ' ');
+
+        for (unsigned int i = 0; i < other_str.size (); ++i)
+            other_str [i] = "abcdABCD" [gen () % 8];
+        if (iter % 2)
+            other_str = std_str.substr (0, other_str.size ());
+
+        const   unsigned int            copy_len = other_str.size ();
+        char                            *other = pages + page - copy_len;
+        DMScu_FixedSizeString<127>      rhs = other_str.c_str ();
+
+        ::memmove (other, other_str.c_str (), copy_len);
+
+        if (sign (fixed.compare (rhs)) !=
+                sign (::strcmp (std_str.c_str (), other_str.c_str ())) ||
+            sign (fixed.icompare (rhs)) !=
+                sign (::strcasecmp (std_str.c_str (), other_str.c_str ())) ||
+            fixed.starts_with (rhs) !=
+                (std_str.compare (0, copy_len, other_str) == 0) ||
+            (fixed == rhs) != (std_str == other_str))  {
+            cout << "ERROR: compare '" << std_str << "' to '" << other_str
+                 << "'" << endl;
+            return (false);
+        }
+        if (DMScu_StringSearch::mismatch_icase (
+                other, other_str.c_str (), copy_len) != copy_len)  {
+            cout << "ERROR: mismatch at the end of a page" << endl;
+            return (false);
+        }
+    }
+
+    ::munmap (pages, 2 * page);
+    return (true);
+}
+
+// ----------------------------------------------------------------------------
+
 int main (int arg_cnt, char *arg_vctr [])  {
 
     const   size_t                  the_size = 32;
@@ -285,6 +404,150 @@ int main (int arg_cnt, char *arg_vctr [])  {
         cout << " replace (5, 3, \"->>\"): " << str << " " << stdstr << endl;
     }
 
+    cout << "\n\n-- Testing the replace() at the capacity\n\n";
+    {
+        DMScu_FixedSizeString<7>    str = "USD/JPY";
+
+        str.replace (3, 1, "--->");
+        if (str.size () != 7 || str != "USD--->")  {
+            cout << "ERROR: replace() past the capacity gave '" << str
+                 << "'" << endl;
+            return (-1);
+        }
+        str = "USD/JPY";
+        str.replace (0, 1, "AB");
+        if (str.size () != 7 || str != "ABSD/JP")  {
+            cout << "ERROR: replace() did not cut the tail, '" << str
+                 << "'" << endl;
+            return (-1);
+        }
+        str = "USD";
+        str.replace (100, 2, "/JPY!");
+        if (str.size () != 7 || str != "USD/JPY")  {
+            cout << "ERROR: replace() past the end gave '" << str
+                 << "'" << endl;
+            return (-1);
+        }
+
+        cout << "SUCCESS: replace() stays in the capacity" << endl;
+    }
+
+    cout << "\n\n-- Testing the size tracking\n\n";
+    {
+        DMScu_FixedSizeString<63>   str = "USD/JPY";
+        DMScu_FixedSizeString<7>    short_str;
+        std::string                 stdstr = "USD/JPY";
+        DMScu_VirtualString         &vstr = str;
+
+        str.replace (0, 4, "");
+        stdstr.replace (0, 4, "");
+        str.replace (1, 100, "->>");
+        stdstr.replace (1, 100, "->>");
+        str.append (str);
+        stdstr.append (stdstr);
+        str += "!";
+        stdstr += "!";
+        str.append_printf ("%d", 42);
+        stdstr += "42";
+        if (str.size () != stdstr.size () || str != stdstr.c_str () ||
+            str.end () != str.begin () + stdstr.size ())  {
+            cout << "ERROR: size() is '" << str.size () << "' for '"
+                 << str << "', expected '" << stdstr << "'" << endl;
+            return (-1);
+        }
+        if (str.find ("->>", 2) != 5 || str.find ('!', 8) != 8 ||
+            str.find (str) != 0 || str.find ("42", 9) != 9)  {
+            cout << "ERROR: find() with the tracked size failed" << endl;
+            return (-1);
+        }
+
+        short_str = vstr;
+        if (short_str.size () != 7 || short_str != "J->>J->")  {
+            cout << "ERROR: assignment did not truncate to capacity" << endl;
+            return (-1);
+        }
+        short_str.ncopy ("AB", 5);
+        if (short_str.size () != 2 || short_str.compare ("ABC") >= 0 ||
+            short_str.compare ("AA") <= 0)  {
+            cout << "ERROR: ncopy()/compare() failed" << endl;
+            return (-1);
+        }
+        short_str [1] = 0;
+        short_str.sync_size ();
+        if (short_str.size () != 1 || ! (short_str < vstr))  {
+            cout << "ERROR: sync_size() failed" << endl;
+            return (-1);
+        }
+        str.clear ();
+        if (str.size () != 0 || ! str.empty ())  {
+            cout << "ERROR: clear() failed" << endl;
+            return (-1);
+        }
+
+        cout << "SUCCESS: size is tracked" << endl;
+    }
+
+    cout << "\n\n-- Testing the format()\n\n";
+    {
+        DMScu_FixedSizeString<127>  str;
+        DMScu_FixedSizeString<15>   name = "FixedSizeSocket";
+        char                        buffer [128];
+
+        str.format ("size ", 4294967295U, ' ', -12, " mask 0x",
+                    DMScu_hex (0xBEEF, 8), ' ', DMScu_hex (-1),
+                    " ratio ", DMScu_fixed (2.0 / 3.0, 3), ' ', 0.1, ' ',
+                    name);
+        ::snprintf (buffer, sizeof (buffer),
+                    "size %u %d mask 0x%08x %x ratio %.3f %g %s",
+                    4294967295U, -12, 0xBEEF, -1, 2.0 / 3.0, 0.1,
+                    name.c_str ());
+        cout << str << endl;
+        if (str != buffer || str.size () != ::strlen (buffer))  {
+            cout << "ERROR: format() gave '" << str << "'" << endl;
+            return (-1);
+        }
+
+       // Bounded by the capacity. A number that does not fit is left out.
+       //
+        DMScu_FixedSizeString<7>    small;
+
+        small.format ("abc", 12345);
+        small.append_format (678);
+        if (small != "abc678")  {
+            cout << "ERROR: format() overflowed: '" << small << "'" << endl;
+            return (-1);
+        }
+        small.format ("abc", 12, "defgh");
+        if (small != "abc12de" || small.size () != 7)  {
+            cout << "ERROR: format() did not truncate: '" << small << "'"
+                 << endl;
+            return (-1);
+        }
+        if (small.printf ("%s", "0123456789") != 10 || small != "0123456" ||
+            small.append_printf ("%d", 1) != 1 || small.size () != 7)  {
+            cout << "ERROR: printf() overflowed: '" << small << "'" << endl;
+            return (-1);
+        }
+
+        cout << "SUCCESS: format() is working" << endl;
+    }
+
+    cout << "\n\n-- Testing the vectorized search and compare\n\n";
+    {
+        DMScu_FixedSizeString<63>   topic = "MarketData.Equities.US.AAPL";
+
+        if (topic.find_first_of (".:", 11) != 19 ||
+            topic.icompare ("marketdata.equities.us.aapl") != 0 ||
+            ! topic.starts_with ("MarketData.") ||
+            topic.starts_with ("MarketData.Equities.US.AAPL.") ||
+            ! test_search ())
+            return (-1);
+        cout << "SUCCESS: search and compare are working ("
+             << (DMScu_StringSearch::best_search () ==
+                     DMScu_StringSearch::_avx2_ ? "AVX2" : "SSE2")
+             << ")" << endl;
+    }
+
     cout << "\n\n-- Testing Performance\n\n";
     {
         static  const   char        *STRING = "The is a test string";
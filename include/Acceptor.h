@@ -7,6 +7,8 @@
 
 #include <netinet/in.h>
 
+#include <IOStatus.h>
+
 // ----------------------------------------------------------------------------
 
 namespace hmcom
@@ -32,6 +34,38 @@ class   Acceptor : public com_BASE  {
 
          bool listen (typename BaseClass::size_type qsize = 5);
          BaseClass *accept ();
+
+        // The same as accept(), but a failure is returned instead of
+        // thrown, e.g. ECONNABORTED when a peer resets before it is
+        // accepted, or EAGAIN on a non-blocking acceptor. See IOStatus.
+        //
+         IOResult<BaseClass *> try_accept () throw ();
+
+        // These put the accepted socket in storage the caller owns, so
+        // connections can sit in a std::vector or a slab instead of one
+        // heap allocation each.
+        // try_accept_at() constructs it with placement new in storage,
+        // which must be sizeof (BaseClass) bytes aligned for a BaseClass.
+        // The caller destroys it with ->~BaseClass ().
+        // try_accept_into() moves it into an existing socket, closing that
+        // socket's own connection first.
+        //
+         IOResult<BaseClass *> try_accept_at (void *storage) throw ();
+         IOStatus try_accept_into (BaseClass &socket);
+
+        // Returns the accepted socket by value. Like accept(), it throws
+        // on a failure.
+        //
+         BaseClass accept_socket ();
+
+        // Returns just the accepted fd, e.g. for a ConnectionTable
+        //
+         IOResult<int> try_accept_fd () throw ();
+
+    private:
+
+         BaseClass *_construct_at (void *storage, int fd) throw ();
+         BaseClass _make_socket (int fd) throw ();
 };
 
 // ----------------------------------------------------------------------------
@@ -4,9 +4,11 @@
 // Distributed under the BSD Software License (see file License)
 
 #include <cerrno>
+#include <new>
 #include <stdexcept>
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <unistd.h>
 
 #include <DMScu_FixedSizeString.h>
 
@@ -36,39 +38,126 @@ bool Acceptor<com_BASE>::listen (typename BaseClass::size_type qsize)  {
 template<class com_BASE>
 com_BASE *Acceptor<com_BASE>::accept ()  {
 
-    struct  sockaddr_in addr_in;
-    struct  ip_mreqn    ipm_addr;
+    return (try_accept ().value ("Acceptor::accept()"));
+}
+
+// ----------------------------------------------------------------------------
+
+template<class com_BASE>
+IOResult<com_BASE *> Acceptor<com_BASE>::try_accept () throw ()  {
+
+    const   IOResult<int>   new_fd = try_accept_fd ();
+
+    if (! new_fd.ok ())
+        return (new_fd.status ());
+
+    void    *storage = ::operator new (sizeof (BaseClass), std::nothrow);
+
+    if (storage == NULL)  {
+        ::close (*new_fd);
+        return (IOStatus (IOStatus::_accept_, ENOMEM));
+    }
+
+    return (_construct_at (storage, *new_fd));
+}
+
+// ----------------------------------------------------------------------------
+
+template<class com_BASE>
+IOResult<com_BASE *>
+Acceptor<com_BASE>::try_accept_at (void *storage) throw ()  {
+
+    const   IOResult<int>   new_fd = try_accept_fd ();
+
+    if (! new_fd.ok ())
+        return (new_fd.status ());
+
+    return (_construct_at (storage, *new_fd));
+}
+
+// ----------------------------------------------------------------------------
+
+template<class com_BASE>
+IOStatus Acceptor<com_BASE>::try_accept_into (BaseClass &socket)  {
+
+    const   IOResult<int>   new_fd = try_accept_fd ();
+
+    if (new_fd.ok ())
+        socket = _make_socket (*new_fd);
 
-    BaseClass::_get_sock_addr_in (addr_in, ipm_addr);
+    return (new_fd.status ());
+}
+
+// ----------------------------------------------------------------------------
+
+template<class com_BASE>
+com_BASE Acceptor<com_BASE>::accept_socket ()  {
+
+    return (_make_socket (
+                try_accept_fd ().value ("Acceptor::accept_socket()")));
+}
 
-    socklen_t    addr_len = sizeof (addr_in);
-    const    int new_fd =
+// ----------------------------------------------------------------------------
+
+template<class com_BASE>
+IOResult<int> Acceptor<com_BASE>::try_accept_fd () throw ()  {
+
+   // ::accept() only fills in the peer address, so there is no need to
+   // resolve our own
+   //
+    struct  sockaddr_in addr_in;
+    socklen_t           addr_len = sizeof (addr_in);
+    const    int        new_fd =
         ::accept (BaseClass::get_fd (),
                   reinterpret_cast<struct ::sockaddr *> (&addr_in),
                   &addr_len);
 
-    if (new_fd < 0)  {
-        DMScu_FixedSizeString<2047> err;
+    if (new_fd < 0)
+        return (IOStatus (IOStatus::_accept_, errno));
 
-        err.printf ("Acceptor::accept(): ::accept(): (%d) %s",
-                    errno, strerror (errno));
-        throw std::runtime_error(err.c_str ());
-    }
+    return (new_fd);
+}
 
-    BaseClass    *ret_ptr = new BaseClass (BaseClass::get_name (),
-                                           BaseClass::_ipv4_,
-                                           BaseClass::_stream_,
-                                           BaseClass::_client_,
-                                           BaseClass::get_port (),
-                                           BaseClass::get_hostname_type (),
-                                           BaseClass::get_hostname ());
+// ----------------------------------------------------------------------------
 
-    ret_ptr->set_fd (new_fd);
+template<class com_BASE>
+com_BASE *
+Acceptor<com_BASE>::_construct_at (void *storage, int fd) throw ()  {
+
+    BaseClass    *ret_ptr = new (storage) BaseClass (
+                                BaseClass::get_name (),
+                                BaseClass::_ipv4_,
+                                BaseClass::_stream_,
+                                BaseClass::_client_,
+                                BaseClass::get_port (),
+                                BaseClass::get_hostname_type (),
+                                BaseClass::get_hostname ());
+
+    ret_ptr->set_fd (fd);
     ret_ptr->set_connected (true);
 
     return (ret_ptr);
 }
 
+// ----------------------------------------------------------------------------
+
+template<class com_BASE>
+com_BASE Acceptor<com_BASE>::_make_socket (int fd) throw ()  {
+
+    BaseClass   socket (BaseClass::get_name (),
+                        BaseClass::_ipv4_,
+                        BaseClass::_stream_,
+                        BaseClass::_client_,
+                        BaseClass::get_port (),
+                        BaseClass::get_hostname_type (),
+                        BaseClass::get_hostname ());
+
+    socket.set_fd (fd);
+    socket.set_connected (true);
+
+    return (socket);
+}
+
 } // namespace hmcom
 
 // ----------------------------------------------------------------------------
@@ -0,0 +1,209 @@
+// Hossein Moein
+// March 25, 2018
+// Copyright (C) 2018-2019 Hossein Moein
+// Distributed under the BSD Software License (see file License)
+
+#pragma once
+
+#include <cstdlib>
+#include <cstdint>
+#include <atomic>
+#include <type_traits>
+
+#include <sys/types.h>
+
+#include <Communication.h>
+#include <Futex.h>
+#include <WaitStrategy.h>
+
+// ----------------------------------------------------------------------------
+
+namespace hmcom
+{
+
+// This class is a single-writer, multi-reader broadcast ring in POSIX shared
+// memory. The writer publishes each message exactly once and every reader
+// (in any process) sees every message, tracking its own sequence number
+// privately. There is no back pressure. A reader that falls more than
+// capacity messages behind the writer has lost messages. That is detected
+// by sequence lag and reported once as _lagged_, after which the reader is
+// repositioned half way into the ring (see get_dropped()).
+//
+// The same com_TYPE restrictions as MessageQueue apply. com_TYPE is
+// memcpy()'ed in and out of shared memory.
+//
+// NOTE: A BroadcastBus has no file descriptor, so it cannot be added to a
+//       Selector. In blocking mode pop() sleeps on a futex in shared memory.
+//
+template <class com_TYPE>
+class   BroadcastBus : public Communication  {
+
+    public:
+
+        typedef Communication                   BaseClass;
+        typedef com_TYPE                        value_type;
+        typedef typename BaseClass::size_type   size_type;
+        typedef uint64_t                        sequence_type;
+
+        static_assert (std::is_trivially_copyable<value_type>::value,
+                       "BroadcastBus: com_TYPE must be trivially copyable");
+
+        enum MODE { _writer_, _reader_ };
+        enum RET_TYPE { _would_block_ = -2, _lagged_ = -3 };
+
+       // capacity is rounded up to the next power of 2. Readers take the
+       // capacity from the writer.
+       //
+        BroadcastBus (const char *name,
+                      MODE open_mode,
+                      size_type capacity = 4096,
+                      mode_t permission = 0640) throw ()
+            : BaseClass (name),
+              shm_fd_ (-1),
+              header_ (NULL),
+              slots_ (NULL),
+              mapped_size_ (0),
+              capacity_ (_round_up (capacity)),
+              permission_ (permission),
+              open_mode_ (open_mode),
+              next_seq_ (0),
+              dropped_ (0)  {   }
+
+        virtual ~BroadcastBus ()  { disconnect (); }
+
+       // Writer side. Returns sizeof(value_type)
+       //
+        size_type push (const value_type &data);
+
+       // Reader side. Returns sizeof(value_type), _would_block_ or _lagged_
+       //
+        size_type pop (value_type &data);
+
+       // Waits for a message according to strategy, regardless of the
+       // blocking mode. Returns sizeof(value_type) or _lagged_
+       //
+        size_type pop (value_type &data, WaitStrategy &strategy);
+
+        inline size_type operator >> (value_type &data)  {
+
+            return (pop (data));
+        }
+        inline size_type operator << (const value_type &data)  {
+
+            return (push (data));
+        }
+
+       // The sequence number the writer will publish next
+       //
+        sequence_type get_cursor () const throw ();
+
+       // The sequence number this reader will consume next
+       //
+        inline sequence_type get_sequence () const throw ()  {
+
+            return (next_seq_);
+        }
+
+       // How many published messages this reader has not consumed yet
+       //
+        inline sequence_type get_lag () const throw ()  {
+
+            return (get_cursor () - next_seq_);
+        }
+
+       // Total number of messages this reader lost by falling behind
+       //
+        inline sequence_type get_dropped () const throw ()  {
+
+            return (dropped_);
+        }
+
+       // Jumps over everything that is already published
+       //
+        inline void skip_to_latest () throw ()  { next_seq_ = get_cursor (); }
+
+        inline size_type get_capacity () const throw ()  { return (capacity_); }
+
+        void remove ();
+
+        virtual TYPE get_type () const throw ()  { return (_shared_mem_); }
+
+    protected:
+
+        virtual bool _make_blocking_hook ()  { return (true); }
+        virtual bool _make_nonblocking_hook ()  { return (true); }
+        virtual bool _connect_hook ();
+        virtual bool _disconnect_hook ();
+
+    private:
+
+        struct  Header  {
+
+            uint64_t                            magic;
+            uint32_t                            capacity;
+            uint32_t                            msg_size;
+
+           // These are on their own cache lines, since the writer stores to
+           // the cursor on every message and readers only spin on it.
+           //
+            alignas(64) std::atomic<sequence_type>  cursor;
+            alignas(64) Futex::WordType             futex_word;
+            std::atomic<uint32_t>                   waiters;
+        };
+
+        struct  Slot  {
+
+           // Holds sequence + 1 after the message with sequence is published.
+           // 0 means the slot is being written.
+           //
+            std::atomic<sequence_type>  stamp;
+            value_type                  data;
+        };
+
+        static const uint64_t   MAGIC = 0x484d42627573ULL;  // "HMBbus"
+
+        static inline size_type _round_up (size_type value) throw ()  {
+
+            size_type   result = 1;
+
+            while (result < value)
+                result <<= 1;
+            return (result);
+        }
+
+        size_type _try_pop (value_type &data) throw ();
+        void _wait_for (sequence_type seq,
+                        const struct timespec *timeout = NULL);
+
+        int                 shm_fd_;
+        Header              *header_;
+        Slot                *slots_;
+        size_t              mapped_size_;
+        size_type           capacity_;
+        const   mode_t      permission_;
+        const   MODE        open_mode_;
+        sequence_type       next_seq_;
+        sequence_type       dropped_;
+
+       // These are not implemented
+       //
+        BroadcastBus ();
+        BroadcastBus (const BroadcastBus &);
+        BroadcastBus &operator = (const BroadcastBus &);
+};
+
+} // namespace hmcom
+
+// ----------------------------------------------------------------------------
+
+#  ifdef DMS_INCLUDE_SOURCE
+#    include <BroadcastBus.tcc>
+#  endif // DMS_INCLUDE_SOURCE
+
+// ----------------------------------------------------------------------------
+
+// Local Variables:
+// mode:C++
+// tab-width:4
+// c-basic-offset:4
+// End:
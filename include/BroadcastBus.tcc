@@ -0,0 +1,324 @@
+// Hossein Moein
+// March 25, 2018
+// Copyright (C) 2018-2019 Hossein Moein
+// Distributed under the BSD Software License (see file License)
+
+#include <cerrno>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <string.h>
+
+#include <DMScu_FixedSizeString.h>
+
+#include <BroadcastBus.h>
+
+// ----------------------------------------------------------------------------
+
+namespace hmcom
+{
+
+template <class com_TYPE>
+bool BroadcastBus<com_TYPE>::_connect_hook ()  {
+
+    if (is_connected ())
+        return (false);
+
+    const   int oflag = open_mode_ == _writer_ ? O_CREAT | O_RDWR : O_RDWR;
+
+    shm_fd_ = ::shm_open (get_name (), oflag, permission_);
+    if (shm_fd_ < 0)  {
+        DMScu_FixedSizeString<1023> err;
+
+        err.printf ("BroadcastBus::_connect_hook(): "
+                    "::shm_open() (%d) %s",
+                    errno, strerror (errno));
+        throw std::runtime_error(err.c_str ());
+    }
+
+    if (open_mode_ == _writer_)  {
+        mapped_size_ = sizeof (Header) + capacity_ * sizeof (Slot);
+        if (::ftruncate (shm_fd_, mapped_size_) < 0)  {
+            ::close (shm_fd_);
+            shm_fd_ = -1;
+
+            DMScu_FixedSizeString<1023> err;
+
+            err.printf ("BroadcastBus::_connect_hook(): "
+                        "::ftruncate() (%d) %s",
+                        errno, strerror (errno));
+            throw std::runtime_error(err.c_str ());
+        }
+    }
+    else  {
+        struct  stat    st;
+
+        if (::fstat (shm_fd_, &st) < 0 ||
+            static_cast<size_t>(st.st_size) < sizeof (Header))  {
+            ::close (shm_fd_);
+            shm_fd_ = -1;
+
+            DMScu_FixedSizeString<1023> err;
+
+            err.printf ("BroadcastBus::_connect_hook(): "
+                        "'%s' has not been created by a writer",
+                        get_name ());
+            throw std::runtime_error(err.c_str ());
+        }
+        mapped_size_ = st.st_size;
+    }
+
+    void    *addr = ::mmap (NULL, mapped_size_,
+                            PROT_READ | PROT_WRITE, MAP_SHARED,
+                            shm_fd_, 0);
+
+    if (addr == MAP_FAILED)  {
+        ::close (shm_fd_);
+        shm_fd_ = -1;
+
+        DMScu_FixedSizeString<1023> err;
+
+        err.printf ("BroadcastBus::_connect_hook(): "
+                    "::mmap() (%d) %s",
+                    errno, strerror (errno));
+        throw std::runtime_error(err.c_str ());
+    }
+
+    header_ = reinterpret_cast<Header *>(addr);
+    slots_ = reinterpret_cast<Slot *>(header_ + 1);
+
+    if (open_mode_ == _writer_)  {
+       // A restarted writer with the same geometry carries on from where
+       // it left off. Otherwise the ring is wiped.
+       //
+        if (header_->magic != MAGIC ||
+            header_->capacity != capacity_ ||
+            header_->msg_size != sizeof (value_type))  {
+            ::memset (addr, 0, mapped_size_);
+            header_->capacity = capacity_;
+            header_->msg_size = sizeof (value_type);
+            std::atomic_thread_fence (std::memory_order_release);
+            header_->magic = MAGIC;
+        }
+    }
+    else  {
+        if (header_->magic != MAGIC ||
+            header_->msg_size != sizeof (value_type) ||
+            mapped_size_ <
+                sizeof (Header) + header_->capacity * sizeof (Slot))  {
+            const   unsigned int    msg_size = header_->msg_size;
+
+            ::munmap (addr, mapped_size_);
+            ::close (shm_fd_);
+            shm_fd_ = -1;
+            header_ = NULL;
+            slots_ = NULL;
+
+            DMScu_FixedSizeString<1023> err;
+
+            err.printf ("BroadcastBus::_connect_hook(): "
+                        "'%s' is not a bus of %u byte messages (%u)",
+                        get_name (),
+                        static_cast<unsigned int>(sizeof (value_type)),
+                        msg_size);
+            throw std::runtime_error(err.c_str ());
+        }
+        capacity_ = header_->capacity;
+        next_seq_ = header_->cursor.load (std::memory_order_acquire);
+        dropped_ = 0;
+    }
+
+    return (true);
+}
+
+// ----------------------------------------------------------------------------
+
+template <class com_TYPE>
+bool BroadcastBus<com_TYPE>::_disconnect_hook ()  {
+
+    if (is_connected ())  {
+        ::munmap (header_, mapped_size_);
+        ::close (shm_fd_);
+        shm_fd_ = -1;
+        header_ = NULL;
+        slots_ = NULL;
+        mapped_size_ = 0;
+        return (true);
+    }
+
+    return (false);
+}
+
+// ----------------------------------------------------------------------------
+
+template <class com_TYPE>
+typename BroadcastBus<com_TYPE>::sequence_type
+BroadcastBus<com_TYPE>::get_cursor () const throw ()  {
+
+    return (header_ ? header_->cursor.load (std::memory_order_acquire) : 0);
+}
+
+// ----------------------------------------------------------------------------
+
+template <class com_TYPE>
+typename BroadcastBus<com_TYPE>::size_type
+BroadcastBus<com_TYPE>::push (const value_type &data)  {
+
+    if (open_mode_ != _writer_)
+        throw std::runtime_error ("BroadcastBus::push(): "
+                                  "bus is opened for reading only.");
+
+    const   sequence_type   seq =
+        header_->cursor.load (std::memory_order_relaxed);
+    Slot                    &slot = slots_ [seq & (capacity_ - 1)];
+
+   // Readers copy the slot optimistically and compare the stamp before and
+   // after. So the stamp must be invalidated before the data changes.
+   //
+    slot.stamp.store (0, std::memory_order_relaxed);
+    std::atomic_thread_fence (std::memory_order_release);
+    ::memcpy (&(slot.data), &data, sizeof (value_type));
+    slot.stamp.store (seq + 1, std::memory_order_release);
+
+    header_->cursor.store (seq + 1, std::memory_order_seq_cst);
+    if (header_->waiters.load (std::memory_order_seq_cst) > 0)  {
+        header_->futex_word.fetch_add (1, std::memory_order_seq_cst);
+        Futex::wake (header_->futex_word);
+    }
+
+    return (sizeof (value_type));
+}
+
+// ----------------------------------------------------------------------------
+
+template <class com_TYPE>
+void BroadcastBus<com_TYPE>::
+_wait_for (sequence_type seq, const struct timespec *timeout)  {
+
+   // The writer only makes a futex system call if it sees a waiter. It
+   // stores the cursor before it looks at waiters, and here waiters is
+   // bumped before the cursor is looked at, so one of the two always
+   // sees the other.
+   //
+    header_->waiters.fetch_add (1, std::memory_order_seq_cst);
+
+    const   uint32_t    word =
+        header_->futex_word.load (std::memory_order_seq_cst);
+
+    if (header_->cursor.load (std::memory_order_seq_cst) <= seq)
+        Futex::wait (header_->futex_word, word, timeout);
+    header_->waiters.fetch_sub (1, std::memory_order_seq_cst);
+}
+
+// ----------------------------------------------------------------------------
+
+template <class com_TYPE>
+typename BroadcastBus<com_TYPE>::size_type
+BroadcastBus<com_TYPE>::_try_pop (value_type &data) throw ()  {
+
+    const   sequence_type   cursor =
+        header_->cursor.load (std::memory_order_acquire);
+
+    if (next_seq_ >= cursor)
+        return (static_cast<size_type>(_would_block_));
+
+    const   Slot    &slot = slots_ [next_seq_ & (capacity_ - 1)];
+
+    if (cursor - next_seq_ <= capacity_ &&
+        slot.stamp.load (std::memory_order_acquire) == next_seq_ + 1)  {
+        ::memcpy (&data, &(slot.data), sizeof (value_type));
+        std::atomic_thread_fence (std::memory_order_acquire);
+        if (slot.stamp.load (std::memory_order_relaxed) == next_seq_ + 1)  {
+            next_seq_ += 1;
+            return (sizeof (value_type));
+        }
+    }
+
+   // The writer has lapped this reader. Reposition half way into the
+   // ring, so there is some headroom before the writer laps us again.
+   //
+    const   sequence_type   latest =
+        header_->cursor.load (std::memory_order_acquire);
+    const   sequence_type   resume =
+        latest > capacity_ / 2 ? latest - capacity_ / 2 : 0;
+
+    if (resume > next_seq_)  {
+        dropped_ += resume - next_seq_;
+        next_seq_ = resume;
+    }
+    return (static_cast<size_type>(_lagged_));
+}
+
+// ----------------------------------------------------------------------------
+
+template <class com_TYPE>
+typename BroadcastBus<com_TYPE>::size_type
+BroadcastBus<com_TYPE>::pop (value_type &data)  {
+
+    if (open_mode_ != _reader_)
+        throw std::runtime_error ("BroadcastBus::pop(): "
+                                  "bus is opened for writing only.");
+
+    while (true)  {
+        const   size_type   ret = _try_pop (data);
+
+        if (ret != static_cast<size_type>(_would_block_) || ! is_blocking ())
+            return (ret);
+        _wait_for (next_seq_);
+    }
+}
+
+// ----------------------------------------------------------------------------
+
+template <class com_TYPE>
+typename BroadcastBus<com_TYPE>::size_type
+BroadcastBus<com_TYPE>::pop (value_type &data, WaitStrategy &strategy)  {
+
+    if (open_mode_ != _reader_)
+        throw std::runtime_error ("BroadcastBus::pop(): "
+                                  "bus is opened for writing only.");
+
+    size_type   ret = static_cast<size_type>(_would_block_);
+
+    strategy.wait (
+        [this, &data, &ret] () -> bool  {
+            ret = _try_pop (data);
+            return (ret != static_cast<size_type>(_would_block_));
+        },
+        [this] (const struct timespec *timeout)  {
+            _wait_for (next_seq_, timeout);
+        });
+
+    return (ret);
+}
+
+// ----------------------------------------------------------------------------
+
+template <class com_TYPE>
+void BroadcastBus<com_TYPE>::remove ()  {
+
+    disconnect ();
+    if (::shm_unlink (get_name ()) < 0)  {
+        DMScu_FixedSizeString<1023> err;
+
+        err.printf ("BroadcastBus::remove(): "
+                    "::shm_unlink() (%d) %s",
+                    errno, strerror (errno));
+        throw std::runtime_error(err.c_str ());
+    }
+
+    return;
+}
+
+} // namespace hmcom
+
+// ----------------------------------------------------------------------------
+
+// Local Variables:
+// mode:C++
+// tab-width:4
+// c-basic-offset:4
+// End:
@@ -6,7 +6,11 @@
 #pragma once
 
 #include <cstdlib>
+#include <memory>
 #include <string>
+#include <utility>
+
+#include <LatencyStats.h>
 
 // ----------------------------------------------------------------------------
 
@@ -19,7 +23,9 @@ class   Communication  {
 
         typedef unsigned int    size_type;
 
-        enum TYPE { _undefined_, _socket_, _pipe_, _message_q_ };
+        enum TYPE { _undefined_, _socket_, _pipe_, _message_q_,
+                    _shared_mem_, _in_process_, _event_fd_, _timer_fd_,
+                    _signal_fd_, _splice_relay_ };
         enum ERROR_CODE { _not_implemented_ = -1, _try_again_ = -2 };
 
         inline Communication (const char *name) throw ()
@@ -90,8 +96,43 @@ class   Communication  {
 
         virtual TYPE get_type () const throw ()  { return (_undefined_); }
 
+       // Starts recording the latency, bytes and messages of the sends and
+       // receives of this object. See LatencyStats. NULL until enabled.
+       //
+        inline void enable_latency_stats ()  {
+
+            if (! latency_stats_)
+                latency_stats_.reset (new LatencyStats);
+        }
+        inline LatencyStats *get_latency_stats () const throw ()  {
+
+            return (latency_stats_.get ());
+        }
+
     protected:
 
+       // Moving a Communication moves its name and state and leaves the
+       // source disconnected. Derived classes that own a descriptor move
+       // it along, see SocketBase.
+       //
+        inline Communication (Communication &&that) throw ()
+            : name_ (std::move (that.name_)),
+              latency_stats_ (std::move (that.latency_stats_)),
+              connected_ (that.connected_),
+              blocking_ (that.blocking_)  {
+
+            that.connected_ = false;
+        }
+        inline Communication &operator = (Communication &&that) throw ()  {
+
+            name_ = std::move (that.name_);
+            latency_stats_ = std::move (that.latency_stats_);
+            connected_ = that.connected_;
+            blocking_ = that.blocking_;
+            that.connected_ = false;
+            return (*this);
+        }
+
         virtual bool _connect_hook () = 0;
         virtual bool _disconnect_hook () = 0;
 
@@ -100,9 +141,25 @@ class   Communication  {
 
         inline void _set_blocking (bool value)  { blocking_ = value; }
 
+       // Derived classes bracket an operation with these. They cost a
+       // well predicted branch while the stats are not enabled.
+       //
+        inline LatencyStats::tick_type _latency_start () const throw ()  {
+
+            return (latency_stats_ ? LatencyStats::now () : 0);
+        }
+        inline void _latency_record (LatencyStats::OPERATION op,
+                                     LatencyStats::tick_type start,
+                                     size_type bytes) const throw ()  {
+
+            if (latency_stats_)
+                latency_stats_->record (op, start, bytes);
+        }
+
     private:
 
         std::string name_;
+        std::unique_ptr<LatencyStats>   latency_stats_;
         bool        connected_;
         bool        blocking_;
 };
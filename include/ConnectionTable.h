@@ -0,0 +1,239 @@
+// Hossein Moein
+// March 25, 2018
+// Copyright (C) 2018-2019 Hossein Moein
+// Distributed under the BSD Software License (see file License)
+
+#pragma once
+
+#include <stdint.h>
+#include <cerrno>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <netinet/in.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <DMScu_FixedSizeString.h>
+
+#include <IOStatus.h>
+
+// ----------------------------------------------------------------------------
+
+namespace hmcom
+{
+
+// A table of many, mostly idle, connected sockets (e.g. client sessions of
+// a server), for when a SocketBase per connection is too heavy. Every
+// session is a 32 byte Session record: the fd, a state, the framing
+// progress of the message in flight and the indices of its buffers in a
+// pool the caller keeps. There is no name, hostname or vtable per session.
+// Names are interned once in the table and sessions refer to them by id.
+// The peer address is looked up only when asked for.
+//
+// Records are allocated SLAB_SIZE at a time and never move, so a Session &
+// stays valid until the session is closed. for_each(), expire() and
+// broadcast() walk the slabs front to back. Sessions are found by handle,
+// e.g. the handle stored in epoll data, or by fd.
+//
+//     const   IOResult<int>   fd = acceptor.try_accept_fd ();
+//
+//     if (fd.ok ())
+//         table.add (*fd, now);
+//     ...
+//     table.expire (now, 300,
+//                   [] (handle_type, const Session &s)  { log (s.fd); });
+//
+// The table owns the fds. close() and the destructor close them.
+//
+class   ConnectionTable  {
+
+    public:
+
+        typedef unsigned int    size_type;
+        typedef unsigned int    handle_type;
+
+        static  const   handle_type NO_SESSION =
+            static_cast<handle_type>(-1);
+        static  const   uint32_t    NO_BUFFER = static_cast<uint32_t>(-1);
+        static  const   size_type   SLAB_SIZE = 4096;
+
+        enum STATE { _free_ = 0, _idle_ = 1, _reading_ = 2, _writing_ = 3,
+                     _closing_ = 4 };
+
+       // The fields other than fd and state are the caller's. The table
+       // only resets them on add(). last_active is in whatever unit the
+       // caller passes as now, e.g. seconds.
+       //
+        struct  Session  {
+
+            int         fd;
+            uint32_t    last_active;
+            uint32_t    expected;       // Bytes of the message in flight
+            uint32_t    done;           // and how many are read/written
+            uint32_t    read_buffer;
+            uint32_t    write_buffer;
+            uint32_t    tag;
+            uint16_t    name_id;
+            uint8_t     state;
+            uint8_t     flags;
+        };
+
+       // name is interned as name id 0
+       //
+        explicit ConnectionTable (const char *name = "");
+        ~ConnectionTable ();
+
+       // Takes over fd and returns the handle of its session. If fd is
+       // already in the table, it must have been closed behind the
+       // table's back and reused, so that session is reset and its
+       // handle returned. A negative fd returns NO_SESSION.
+       //
+        handle_type add (int fd, uint32_t now, uint16_t name_id = 0);
+
+       // Frees the session and returns its fd without closing it. A
+       // session that is already free (e.g. released twice, or closed in
+       // an on_expire callback) is left alone and -1 is returned.
+       //
+        int release (handle_type handle) throw ();
+        inline void close (handle_type handle) throw ()  {
+
+            const   int fd = release (handle);
+
+            if (fd >= 0)
+                ::close (fd);
+        }
+
+        inline Session &operator [] (handle_type handle) throw ()  {
+
+            return (slabs_ [handle / SLAB_SIZE] [handle % SLAB_SIZE]);
+        }
+        inline const Session &operator [] (handle_type handle) const throw ()
+        {
+
+            return (slabs_ [handle / SLAB_SIZE] [handle % SLAB_SIZE]);
+        }
+
+        inline handle_type find (int fd) const throw ()  {
+
+            return (fd >= 0 && static_cast<size_type>(fd) < by_fd_.size ()
+                        ? by_fd_ [fd] : NO_SESSION);
+        }
+
+        inline size_type size () const throw ()  { return (active_); }
+        inline size_type capacity () const throw ()  {
+
+            return (static_cast<size_type>(slabs_.size ()) * SLAB_SIZE);
+        }
+
+       // Names are kept once here. Interning a name that is already in
+       // the table returns its id. Meant for a handful of names, e.g. one
+       // per listener.
+       //
+        uint16_t intern (const char *name);
+        inline const char *get_name (handle_type handle) const throw ()  {
+
+            return (names_ [(*this) [handle].name_id].c_str ());
+        }
+
+       // Looks up the peer of the session with ::getpeername()
+       //
+        bool get_peer_host (handle_type handle,
+                            DMScu_VirtualString &hostname,
+                            in_port_t &port) const;
+
+        inline IOResult<size_type>
+        try_send (handle_type handle, const void *data, size_type the_size)
+            throw ()  {
+
+            const   ssize_t sent_size =
+                ::send ((*this) [handle].fd, data, the_size, MSG_NOSIGNAL);
+
+            if (sent_size < 0)
+                return (IOStatus (IOStatus::_send_, errno));
+
+            return (static_cast<size_type>(sent_size));
+        }
+        inline IOResult<size_type>
+        try_receive (handle_type handle, void *data, size_type the_size)
+            throw ()  {
+
+            const   ssize_t received_size =
+                ::recv ((*this) [handle].fd, data, the_size, 0);
+
+            if (received_size < 0)
+                return (IOStatus (IOStatus::_receive_, errno));
+
+            return (static_cast<size_type>(received_size));
+        }
+
+       // Calls func (handle, session) for every open session
+       //
+        template<class com_FUNC>
+        inline void for_each (com_FUNC func)  {
+
+            for (size_type slab = 0; slab < slabs_.size (); ++slab)  {
+                Session *const  sessions = slabs_ [slab].get ();
+
+                for (size_type i = 0; i < SLAB_SIZE; ++i)
+                    if (sessions [i].state != _free_)
+                        func (slab * SLAB_SIZE + i, sessions [i]);
+            }
+        }
+
+       // Closes the sessions that have not been active for more than
+       // max_idle, calling on_expire (handle, session) before each one.
+       // Returns how many were closed.
+       //
+        template<class com_FUNC>
+        inline size_type
+        expire (uint32_t now, uint32_t max_idle, com_FUNC on_expire)  {
+
+            size_type   count = 0;
+
+            for_each (
+                [this, now, max_idle, &on_expire, &count]
+                (handle_type handle, Session &session)  {
+                    if (now - session.last_active > max_idle)  {
+                        on_expire (handle, session);
+                        close (handle);
+                        count += 1;
+                    }
+                });
+            return (count);
+        }
+
+       // Sends the same message to every session that is not _closing_.
+       // Returns how many sessions took all of it.
+       //
+        size_type broadcast (const void *data, size_type the_size) throw ();
+
+    private:
+
+        typedef std::unique_ptr<Session []> SlabPtr;
+
+        void _grow ();
+
+        std::vector<SlabPtr>        slabs_;
+        std::vector<handle_type>    free_;
+        std::vector<handle_type>    by_fd_;
+        std::vector<std::string>    names_;
+        size_type                   active_;
+
+       // These are not implemented
+       //
+        ConnectionTable (const ConnectionTable &);
+        ConnectionTable &operator = (const ConnectionTable &);
+};
+
+} // namespace hmcom
+
+// ----------------------------------------------------------------------------
+
+// Local Variables:
+// mode:C++
+// tab-width:4
+// c-basic-offset:4
+// End:
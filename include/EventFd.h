@@ -0,0 +1,196 @@
+// Hossein Moein
+// March 25, 2018
+// Copyright (C) 2018-2019 Hossein Moein
+// Distributed under the BSD Software License (see file License)
+
+#pragma once
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <DMScu_FixedSizeString.h>
+
+#include <Communication.h>
+
+// ----------------------------------------------------------------------------
+
+namespace hmcom
+{
+
+// This class is a wake-up channel between threads (or related processes).
+// notify() adds to a kernel counter and makes the fd readable. wait()
+// returns the counter and resets it, or decrements it by one in semaphore
+// mode. Unlike a self-pipe, any number of notifications cost one fd and
+// never fill up.
+//
+class   EventFd : public Communication  {
+
+    public:
+
+        typedef Communication   BaseClass;
+        typedef uint64_t        value_type;
+
+        inline explicit
+        EventFd (const char *name = "",
+                 unsigned int initial_value = 0,
+                 bool semaphore = false) throw ()
+            : BaseClass (name),
+              fd_ (-1),
+              initial_value_ (initial_value),
+              semaphore_ (semaphore)  {   }
+
+        inline ~EventFd ()  { disconnect (); }
+
+       // Returns false if the counter would overflow in non-blocking mode
+       //
+        inline bool notify (value_type value = 1)  {
+
+            if (::write (fd_, &value, sizeof (value)) < 0)  {
+                if (errno == EAGAIN)
+                    return (false);
+
+                DMScu_FixedSizeString<1023> err;
+
+                err.printf ("EventFd::notify(): ::write(): (%d) %s",
+                            errno, strerror (errno));
+                throw std::runtime_error(err.c_str ());
+            }
+
+            return (true);
+        }
+
+       // Returns 0 if there was nothing to wait for in non-blocking mode
+       //
+        inline value_type wait ()  {
+
+            value_type  value = 0;
+
+            if (::read (fd_, &value, sizeof (value)) < 0)  {
+                if (errno == EAGAIN)
+                    return (0);
+
+                DMScu_FixedSizeString<1023> err;
+
+                err.printf ("EventFd::wait(): ::read(): (%d) %s",
+                            errno, strerror (errno));
+                throw std::runtime_error(err.c_str ());
+            }
+
+            return (value);
+        }
+
+       // These move one value_type at a time
+       //
+        virtual int send (const void *data, size_type the_size)  {
+
+            if (the_size != sizeof (value_type))
+                return (_not_implemented_);
+            return (notify (*reinterpret_cast<const value_type *>(data))
+                        ? static_cast<int>(sizeof (value_type))
+                        : static_cast<int>(_try_again_));
+        }
+        virtual int receive (void *data, size_type the_size)  {
+
+            if (the_size != sizeof (value_type))
+                return (_not_implemented_);
+
+            const   value_type  value = wait ();
+
+            *reinterpret_cast<value_type *>(data) = value;
+            return (value > 0
+                        ? static_cast<int>(sizeof (value_type))
+                        : static_cast<int>(_try_again_));
+        }
+
+        virtual int get_fd () const throw ()  { return (fd_); }
+        virtual TYPE get_type () const throw ()  { return (_event_fd_); }
+
+    protected:
+
+        inline bool _connect_hook ()  {
+
+            if (is_connected ())
+                return (false);
+
+            fd_ = ::eventfd (initial_value_,
+                             EFD_CLOEXEC |
+                                 (semaphore_ ? EFD_SEMAPHORE : 0) |
+                                 (is_blocking () ? 0 : EFD_NONBLOCK));
+            if (fd_ < 0)  {
+                DMScu_FixedSizeString<1023> err;
+
+                err.printf ("EventFd::_connect_hook(): ::eventfd(): (%d) %s",
+                            errno, strerror (errno));
+                throw std::runtime_error(err.c_str ());
+            }
+
+            return (true);
+        }
+
+        inline bool _disconnect_hook ()  {
+
+            if (! is_connected ())
+                return (false);
+
+            ::close (fd_);
+            fd_ = -1;
+            return (true);
+        }
+
+        inline bool _make_blocking_hook ()  {
+
+            return (_set_fd_flag (false));
+        }
+        inline bool _make_nonblocking_hook ()  {
+
+            return (_set_fd_flag (true));
+        }
+
+    private:
+
+        inline bool _set_fd_flag (bool nonblocking)  {
+
+            if (fd_ < 0)  // Applied on connect()
+                return (true);
+
+            const   int flags = ::fcntl (fd_, F_GETFL, 0);
+
+            if (flags < 0 ||
+                ::fcntl (fd_, F_SETFL,
+                         nonblocking ? flags | O_NONBLOCK
+                                     : flags & ~O_NONBLOCK) < 0)  {
+                DMScu_FixedSizeString<1023> err;
+
+                err.printf ("EventFd::_set_fd_flag(): ::fcntl(): (%d) %s",
+                            errno, strerror (errno));
+                throw std::runtime_error(err.c_str ());
+            }
+
+            return (true);
+        }
+
+        int                     fd_;
+        const   unsigned int    initial_value_;
+        const   bool            semaphore_;
+
+      // These are not implemented
+      //
+        EventFd (const EventFd &);
+        EventFd &operator = (const EventFd &);
+};
+
+} // namespace hmcom
+
+// ----------------------------------------------------------------------------
+
+// Local Variables:
+// mode:C++
+// tab-width:4
+// c-basic-offset:4
+// End:
@@ -66,15 +66,56 @@ class   FixedSizeSocket : public SocketBase  {
               use_fast_ (use_fast_proto),
               header_size_ (header_size)  {   }
 
+        inline FixedSizeSocket (FixedSizeSocket &&that) throw ()
+            : BaseClass (std::move (that)),
+              use_fast_ (that.use_fast_),
+              header_size_ (that.header_size_)  {   }
+        inline FixedSizeSocket &operator = (FixedSizeSocket &&that)  {
+
+            if (this != &that)  {
+                BaseClass::operator = (std::move (that));
+                use_fast_ = that.use_fast_;
+                header_size_ = that.header_size_;
+            }
+            return (*this);
+        }
         inline virtual ~FixedSizeSocket ()  {   }
 
         size_type write (const void *data,
                          size_type the_size,
                          const SocketWriteDetail *already_sent = NULL,
                          SocketWriteDetail *write_detail = NULL);
+
+       // Sends length bytes of file_fd, starting at offset, as one message.
+       // The header is written the same way as write() and the body is sent
+       // with ::sendfile(). In non-blocking mode, pass the write_detail of
+       // the previous call as already_sent to resume. Here msg_sent is the
+       // number of body bytes sent so far over all calls.
+       // Returns the number of body bytes sent by this call.
+       //
+        size_type send_file (int file_fd,
+                             off_t offset,
+                             size_type length,
+                             const SocketWriteDetail *already_sent = NULL,
+                             SocketWriteDetail *write_detail = NULL);
+
         size_type read (ReadBufferType **data, bool text_data = false);
         size_type read_fixed (ReadBufferType *data, bool text_data = false);
 
+       // The same as write() and read_fixed(), but a failure is returned
+       // instead of thrown. See IOStatus. In non-blocking mode, a body
+       // that does not fit in the socket buffer is a would_block() status,
+       // where write() returns _try_again_.
+       //
+        IOResult<size_type>
+        try_write (const void *data,
+                   size_type the_size,
+                   const SocketWriteDetail *already_sent = NULL,
+                   SocketWriteDetail *write_detail = NULL) throw ();
+        IOResult<size_type>
+        try_read_fixed (ReadBufferType *data, bool text_data = false)
+            throw ();
+
        // If the_size bytes are available in the socket buffer a true
        // is returned, otherwise a false is returned. The actual data is
        // not removed from the socket buffer.
@@ -89,12 +130,30 @@ class   FixedSizeSocket : public SocketBase  {
         virtual int send (const void *data, size_type the_size);
         virtual int receive (void *data, size_type the_size);
 
-        size_type _compute_size_for_read ();
+       // send() and receive() without the throw. A receive of fewer than
+       // the_size bytes is a failure (ECONNRESET).
+       //
+        IOResult<size_type>
+        _try_send (const void *data, size_type the_size) throw ();
+        IOResult<size_type>
+        _try_receive (void *data, size_type the_size) throw ();
+
+        IOResult<size_type> _compute_size_for_read () throw ();
+
+       // Returns true once the whole header is sent. In non-blocking mode,
+       // nothing is sent unless the header and body_space more bytes fit in
+       // the socket buffer.
+       //
+        IOResult<bool> _write_header (size_type the_size,
+                                      size_type body_space,
+                                      const SocketWriteDetail *already_sent,
+                                      SocketWriteDetail *write_detail)
+            throw ();
 
     private:
 
-        const   bool        use_fast_;
-        const   size_type   header_size_;
+        bool        use_fast_;
+        size_type   header_size_;
 };
 
 } // namespace hmcom
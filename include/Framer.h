@@ -0,0 +1,145 @@
+// Hossein Moein
+// March 25, 2018
+// Copyright (C) 2018-2019 Hossein Moein
+// Distributed under the BSD Software License (see file License)
+
+#pragma once
+
+#include <vector>
+
+#include <sys/types.h>
+#include <sys/uio.h>
+
+#include <Communication.h>
+
+// ----------------------------------------------------------------------------
+
+namespace hmcom
+{
+
+// This class preserves message boundaries over a byte stream Communication,
+// i.e. one whose get_type() is _socket_ or _pipe_ (Pipe, RegularSocket,
+// Unix domain sockets, StaticSocket and StaticPipe through a
+// CommunicationAdapter, ...). Each message is sent as a frame with a length
+// header, either a FAST encoded unsigned integer or a fixed size ASCII
+// number, the same as FixedSizeSocket.
+//
+// Message based types (MessageQueue, InProcChannel, ...) move one fixed
+// size value per call and already keep message boundaries. The constructor
+// throws for them.
+//
+// Reads are buffered. One recv() or read() on the fd brings in as many
+// frames as are available and read() hands them out one at a time without
+// a system call. The fd is used directly on both sides, so the framing of
+// the Communication itself (e.g. FixedSizeSocket's headers and MSG_WAITALL)
+// does not get in the way.
+// Writes are batched. write() queues frames until there is a buffer full or
+// flush() is called. A frame that does not fit in the buffer is sent together
+// with whatever is queued in one gather write (sendmsg() for sockets,
+// writev() for pipes), without being copied.
+//
+// In non-blocking mode, read() returns _would_block_ if no complete frame is
+// available. Anything write() or flush() could not send stays queued for the
+// next flush(). Once a buffer full is stuck, write() returns _would_block_.
+//
+// NOTE: When driven by a Selector, drain frame_ready() frames before going
+//       back to select(), since buffered frames do not make the fd readable.
+//
+class   Framer  {
+
+    public:
+
+        typedef Communication::size_type   size_type;
+        typedef unsigned char               ReadBufferType;
+
+        enum HEADER_TYPE { _fast_, _ascii_ };
+        enum RET_TYPE { _would_block_ = -2, _closed_ = -3 };
+
+        static  const   size_type   MAX_FAST_HEADER_SIZE;
+
+       // Throws if com is not a byte stream, see above
+       //
+        explicit
+        Framer (Communication &com,
+                HEADER_TYPE header_type = _fast_,
+                size_type header_size = 10,
+                size_type buffer_size = 64 * 1024);
+
+       // Queues one frame. Returns the_size or _would_block_
+       //
+        int write (const void *data, size_type the_size);
+
+       // Sends everything queued. Returns the number of bytes still queued,
+       // which is always 0 in blocking mode.
+       //
+        size_type flush ();
+
+       // Points data to the next frame and returns its size, or returns
+       // _would_block_ or _closed_. data is valid until the next read()
+       //
+        int read (const ReadBufferType **data);
+
+       // True if read() can return a frame without a system call
+       //
+        bool frame_ready () const;
+
+        inline size_type get_pending () const throw ()  {
+
+            return (wbuf_.size () - wpos_);
+        }
+
+        inline Communication &get_communication () throw ()  { return (com_); }
+
+    private:
+
+        typedef std::vector<ReadBufferType> Buffer;
+
+        size_type _encode_header (ReadBufferType *buffer,
+                                  size_type the_size) const;
+
+       // Returns false if the frame at the read position is not complete.
+       // needed is the size of the complete frame, when it is known.
+       //
+        bool _frame_length (size_type &header_len,
+                            size_type &the_size,
+                            size_type &needed) const;
+
+       // Sends the queued bytes followed by extra. Whatever could not be
+       // sent is queued.
+       //
+        void _send (const struct iovec *extra, int extra_cnt);
+        size_type _gather (struct iovec *iov, int cnt);
+
+       // Reads what is available, up to the_size bytes. Returns 0 at the
+       // end of the stream and -1 if it would block.
+       //
+        ssize_t _scatter (ReadBufferType *buffer, size_type the_size);
+
+        Communication       &com_;
+        const   HEADER_TYPE header_type_;
+        const   size_type   header_size_;
+        const   size_type   buffer_size_;
+
+        Buffer              rbuf_;
+        size_type           rpos_;
+        size_type           rend_;
+
+        Buffer              wbuf_;
+        size_type           wpos_;
+
+       // These are not implemented
+       //
+        Framer ();
+        Framer (const Framer &);
+        Framer &operator = (const Framer &);
+};
+
+} // namespace hmcom
+
+// ----------------------------------------------------------------------------
+
+// Local Variables:
+// mode:C++
+// tab-width:4
+// c-basic-offset:4
+// End:
@@ -0,0 +1,72 @@
+// Hossein Moein
+// March 25, 2018
+// Copyright (C) 2018-2019 Hossein Moein
+// Distributed under the BSD Software License (see file License)
+
+#pragma once
+
+#include <climits>
+#include <cstdint>
+#include <ctime>
+#include <atomic>
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// ----------------------------------------------------------------------------
+
+namespace hmcom
+{
+
+// Thin wrappers around futex(2). The words may live in memory that is shared
+// between processes, so the non-private futex operations are used.
+//
+class   Futex  {
+
+    public:
+
+        typedef std::atomic<uint32_t>   WordType;
+
+       // Sleeps as long as word still holds expected_value. A NULL timeout
+       // means wait forever. Returns 0 when woken up, otherwise -1 with errno
+       // set to EAGAIN (value had already changed), ETIMEDOUT or EINTR.
+       //
+        static inline int wait (WordType &word,
+                                uint32_t expected_value,
+                                const struct timespec *timeout = NULL) throw ()  {
+
+            return (static_cast<int>(
+                ::syscall (SYS_futex,
+                           reinterpret_cast<uint32_t *>(&word),
+                           FUTEX_WAIT,
+                           expected_value,
+                           timeout,
+                           NULL,
+                           0)));
+        }
+
+       // Returns the number of waiters that were woken up
+       //
+        static inline int wake (WordType &word, int count = INT_MAX) throw ()  {
+
+            return (static_cast<int>(
+                ::syscall (SYS_futex,
+                           reinterpret_cast<uint32_t *>(&word),
+                           FUTEX_WAKE,
+                           count,
+                           NULL,
+                           NULL,
+                           0)));
+        }
+};
+
+} // namespace hmcom
+
+// ----------------------------------------------------------------------------
+
+// Local Variables:
+// mode:C++
+// tab-width:4
+// c-basic-offset:4
+// End:
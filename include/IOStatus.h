@@ -0,0 +1,131 @@
+// Hossein Moein
+// March 25, 2018
+// Copyright (C) 2018-2019 Hossein Moein
+// Distributed under the BSD Software License (see file License)
+
+#pragma once
+
+#include <cerrno>
+
+// ----------------------------------------------------------------------------
+
+namespace hmcom
+{
+
+// The outcome of an I/O call, for the no-throw methods (try_send(),
+// try_receive(), try_write(), ...). It is an errno and the operation that
+// failed, 8 bytes returned in registers. Nothing is formatted or allocated
+// until throw_error() is called, so a failing call (a peer resetting the
+// connection, a full non-blocking socket, ...) costs about as much as the
+// system call itself.
+// Failures that do not come from a system call are reported with the
+// errno closest to them:
+//
+//     EINVAL      bad argument, e.g. NULL data with a non-zero size
+//     EBADF       the object is not open for the operation
+//     EMSGSIZE    the message size does not fit in the header
+//     EPROTO      a malformed header was received
+//     ECONNRESET  the peer went away in the middle of a message
+//     ENODATA     a file ended before the requested length was sent
+//     EIO         the system call made no progress where it should have
+//
+class   IOStatus  {
+
+    public:
+
+        enum OPERATION { _no_op_ = 0, _send_ = 1, _receive_ = 2,
+                         _send_header_ = 3, _receive_header_ = 4,
+                         _send_file_ = 5, _accept_ = 6, _socket_option_ = 7,
+                         _open_ = 8, _file_control_ = 9 };
+
+        inline IOStatus () throw () : error_ (0), operation_ (_no_op_)  {   }
+        inline IOStatus (OPERATION operation, int error) throw ()
+            : error_ (error), operation_ (operation)  {   }
+
+        inline bool ok () const throw ()  { return (error_ == 0); }
+        inline bool would_block () const throw ()  {
+
+            return (error_ == EAGAIN || error_ == EWOULDBLOCK);
+        }
+
+        inline int error () const throw ()  { return (error_); }
+        inline OPERATION operation () const throw ()  { return (operation_); }
+
+        static const char *operation_name (OPERATION operation) throw ();
+
+       // Throws std::runtime_error with a message like the throwing
+       // methods always had, "where: operation: (errno) text"
+       //
+        [[noreturn]] void throw_error (const char *where) const;
+
+        inline void check (const char *where) const  {
+
+            if (error_ != 0)
+                throw_error (where);
+        }
+
+    private:
+
+        int         error_;
+        OPERATION   operation_;
+};
+
+// ----------------------------------------------------------------------------
+
+// Either a value or the IOStatus of the failure, in the spirit of
+// std::expected. value() throws on a failure, for callers that prefer
+// exceptions after all.
+//
+template<class com_TYPE>
+class   IOResult  {
+
+    public:
+
+        typedef com_TYPE    value_type;
+
+        inline IOResult (const value_type &value) throw ()
+            : value_ (value), status_ ()  {   }
+        inline IOResult (const IOStatus &status) throw ()
+            : value_ (), status_ (status)  {   }
+
+        inline bool ok () const throw ()  { return (status_.ok ()); }
+        inline bool has_value () const throw ()  { return (status_.ok ()); }
+        inline bool would_block () const throw ()  {
+
+            return (status_.would_block ());
+        }
+
+        inline const IOStatus &status () const throw ()  { return (status_); }
+
+       // Only meaningful if ok()
+       //
+        inline const value_type &operator * () const throw ()  {
+
+            return (value_);
+        }
+
+        inline const value_type &value (const char *where) const  {
+
+            status_.check (where);
+            return (value_);
+        }
+        inline value_type value_or (const value_type &other) const throw ()  {
+
+            return (status_.ok () ? value_ : other);
+        }
+
+    private:
+
+        value_type  value_;
+        IOStatus    status_;
+};
+
+} // namespace hmcom
+
+// ----------------------------------------------------------------------------
+
+// Local Variables:
+// mode:C++
+// tab-width:4
+// c-basic-offset:4
+// End:
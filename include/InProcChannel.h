@@ -0,0 +1,164 @@
+// Hossein Moein
+// March 25, 2018
+// Copyright (C) 2018-2019 Hossein Moein
+// Distributed under the BSD Software License (see file License)
+
+#pragma once
+
+#include <cstdlib>
+#include <cstdint>
+#include <atomic>
+#include <type_traits>
+
+#include <Communication.h>
+#include <WaitStrategy.h>
+
+// ----------------------------------------------------------------------------
+
+namespace hmcom
+{
+
+// This class is a bounded, lock-free, multi-producer multi-consumer queue for
+// threads of the same process. It is paired with an eventfd, so it can be
+// added to a Selector like a Pipe.
+//
+// The eventfd is only written when the channel goes from empty to non-empty,
+// and only read when a consumer finds it empty. So a busy channel moves
+// messages without any system calls.
+//
+// send() and receive() move exactly one com_TYPE at a time.
+// The blocking mode applies to both ends of the channel. In blocking mode,
+// a consumer sleeps in poll() on the eventfd when the channel is empty and a
+// producer of a full channel yields until there is room.
+//
+// The same com_TYPE restrictions as MessageQueue apply.
+//
+template <class com_TYPE>
+class   InProcChannel : public Communication  {
+
+    public:
+
+        typedef Communication                   BaseClass;
+        typedef com_TYPE                        value_type;
+        typedef typename BaseClass::size_type   size_type;
+
+        static_assert (std::is_trivially_copyable<value_type>::value,
+                       "InProcChannel: com_TYPE must be trivially copyable");
+
+        enum RET_TYPE { _would_block_ = -2 };
+
+       // capacity is rounded up to the next power of 2
+       //
+        explicit
+        InProcChannel (const char *name = "", size_type capacity = 4096) throw ()
+            : BaseClass (name),
+              cells_ (NULL),
+              capacity_ (_round_up (capacity)),
+              event_fd_ (-1),
+              enqueue_pos_ (0),
+              dequeue_pos_ (0),
+              signalled_ (false)  {   }
+
+        virtual ~InProcChannel ()  { disconnect (); }
+
+       // Returns sizeof(value_type) or _would_block_
+       //
+        size_type push (const value_type &data);
+        size_type pop (value_type &data);
+
+       // Waits for a message according to strategy, regardless of the
+       // blocking mode
+       //
+        size_type pop (value_type &data, WaitStrategy &strategy);
+
+        inline size_type operator >> (value_type &data)  {
+
+            return (pop (data));
+        }
+        inline size_type operator << (const value_type &data)  {
+
+            return (push (data));
+        }
+
+        virtual int send (const void *data, size_type the_size);
+        virtual int receive (void *data, size_type the_size);
+
+       // This is only a snapshot when other threads are active
+       //
+        size_type num_of_msgs_inq () const throw ();
+
+        inline size_type get_capacity () const throw ()  { return (capacity_); }
+
+        virtual int get_fd () const throw ()  { return (event_fd_); }
+        virtual TYPE get_type () const throw ()  { return (_in_process_); }
+
+    protected:
+
+        virtual bool _make_blocking_hook ()  { return (true); }
+        virtual bool _make_nonblocking_hook ()  { return (true); }
+        virtual bool _connect_hook ();
+        virtual bool _disconnect_hook ();
+
+    private:
+
+        struct  Cell  {
+
+           // Position of the cell when it is free for the producer at that
+           // position, position + 1 when it holds data for the consumer at
+           // that position.
+           //
+            std::atomic<size_t> sequence;
+            value_type          data;
+        };
+
+        static inline size_type _round_up (size_type value) throw ()  {
+
+            size_type   result = 1;
+
+            while (result < value)
+                result <<= 1;
+            return (result);
+        }
+
+        bool _try_push (const value_type &data) throw ();
+        bool _try_pop (value_type &data) throw ();
+
+       // Called by a consumer that found the channel empty. It clears the
+       // eventfd and returns true if a message slipped in meanwhile. The
+       // eventfd is set again if more are left.
+       //
+        bool _rearm (value_type &data);
+        void _signal ();
+        void _wait (const struct timespec *timeout);
+
+        Cell                *cells_;
+        const   size_type   capacity_;
+        int                 event_fd_;
+
+       // Producers and consumers each have their own cache line
+       //
+        alignas(64) std::atomic<size_t> enqueue_pos_;
+        alignas(64) std::atomic<size_t> dequeue_pos_;
+        alignas(64) std::atomic<bool>   signalled_;
+
+       // These are not implemented
+       //
+        InProcChannel (const InProcChannel &);
+        InProcChannel &operator = (const InProcChannel &);
+};
+
+} // namespace hmcom
+
+// ----------------------------------------------------------------------------
+
+#  ifdef DMS_INCLUDE_SOURCE
+#    include <InProcChannel.tcc>
+#  endif // DMS_INCLUDE_SOURCE
+
+// ----------------------------------------------------------------------------
+
+// Local Variables:
+// mode:C++
+// tab-width:4
+// c-basic-offset:4
+// End:
@@ -0,0 +1,317 @@
+// Hossein Moein
+// March 25, 2018
+// Copyright (C) 2018-2019 Hossein Moein
+// Distributed under the BSD Software License (see file License)
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <poll.h>
+#include <sched.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <DMScu_FixedSizeString.h>
+
+#include <InProcChannel.h>
+
+// ----------------------------------------------------------------------------
+
+namespace hmcom
+{
+
+template <class com_TYPE>
+bool InProcChannel<com_TYPE>::_connect_hook ()  {
+
+    if (is_connected ())
+        return (false);
+
+    event_fd_ = ::eventfd (0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (event_fd_ < 0)  {
+        DMScu_FixedSizeString<1023> err;
+
+        err.printf ("InProcChannel::_connect_hook(): "
+                    "::eventfd() (%d) %s",
+                    errno, strerror (errno));
+        throw std::runtime_error(err.c_str ());
+    }
+
+    cells_ = new Cell [capacity_];
+    for (size_type i = 0; i < capacity_; ++i)
+        cells_ [i].sequence.store (i, std::memory_order_relaxed);
+    enqueue_pos_.store (0, std::memory_order_relaxed);
+    dequeue_pos_.store (0, std::memory_order_relaxed);
+    signalled_.store (false, std::memory_order_relaxed);
+
+    return (true);
+}
+
+// ----------------------------------------------------------------------------
+
+template <class com_TYPE>
+bool InProcChannel<com_TYPE>::_disconnect_hook ()  {
+
+    if (is_connected ())  {
+        ::close (event_fd_);
+        event_fd_ = -1;
+        delete[] cells_;
+        cells_ = NULL;
+        return (true);
+    }
+
+    return (false);
+}
+
+// ----------------------------------------------------------------------------
+
+template <class com_TYPE>
+bool InProcChannel<com_TYPE>::_try_push (const value_type &data) throw ()  {
+
+    size_t  pos = enqueue_pos_.load (std::memory_order_relaxed);
+    Cell    *cell;
+
+    while (true)  {
+        cell = &(cells_ [pos & (capacity_ - 1)]);
+
+        const   size_t      seq = cell->sequence.load (std::memory_order_acquire);
+        const   intptr_t    diff =
+            static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+
+        if (diff == 0)  {
+            if (enqueue_pos_.compare_exchange_weak (pos, pos + 1,
+                                                    std::memory_order_relaxed))
+                break;
+        }
+        else if (diff < 0)
+            return (false);  // Full
+        else
+            pos = enqueue_pos_.load (std::memory_order_relaxed);
+    }
+
+    ::memcpy (&(cell->data), &data, sizeof (value_type));
+    cell->sequence.store (pos + 1, std::memory_order_release);
+    return (true);
+}
+
+// ----------------------------------------------------------------------------
+
+template <class com_TYPE>
+bool InProcChannel<com_TYPE>::_try_pop (value_type &data) throw ()  {
+
+    size_t  pos = dequeue_pos_.load (std::memory_order_relaxed);
+    Cell    *cell;
+
+    while (true)  {
+        cell = &(cells_ [pos & (capacity_ - 1)]);
+
+        const   size_t      seq = cell->sequence.load (std::memory_order_acquire);
+        const   intptr_t    diff =
+            static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+
+        if (diff == 0)  {
+            if (dequeue_pos_.compare_exchange_weak (pos, pos + 1,
+                                                    std::memory_order_relaxed))
+                break;
+        }
+        else if (diff < 0)
+            return (false);  // Empty
+        else
+            pos = dequeue_pos_.load (std::memory_order_relaxed);
+    }
+
+    ::memcpy (&data, &(cell->data), sizeof (value_type));
+    cell->sequence.store (pos + capacity_, std::memory_order_release);
+    return (true);
+}
+
+// ----------------------------------------------------------------------------
+
+template <class com_TYPE>
+void InProcChannel<com_TYPE>::_signal ()  {
+
+   // This pairs with the fence in _rearm(). Either the consumer sees our
+   // message on its last look, or we see that it has cleared signalled_.
+   //
+    std::atomic_thread_fence (std::memory_order_seq_cst);
+    if (signalled_.load (std::memory_order_relaxed) ||
+        signalled_.exchange (true, std::memory_order_seq_cst))
+        return;
+
+    const   uint64_t    one = 1;
+
+    if (::write (event_fd_, &one, sizeof (one)) < 0 && errno != EAGAIN)  {
+        DMScu_FixedSizeString<1023> err;
+
+        err.printf ("InProcChannel::_signal(): "
+                    "::write() (%d) %s",
+                    errno, strerror (errno));
+        throw std::runtime_error(err.c_str ());
+    }
+
+    return;
+}
+
+// ----------------------------------------------------------------------------
+
+template <class com_TYPE>
+bool InProcChannel<com_TYPE>::_rearm (value_type &data)  {
+
+    uint64_t    count;
+
+    if (::read (event_fd_, &count, sizeof (count)) < 0 && errno != EAGAIN)  {
+        DMScu_FixedSizeString<1023> err;
+
+        err.printf ("InProcChannel::_rearm(): "
+                    "::read() (%d) %s",
+                    errno, strerror (errno));
+        throw std::runtime_error(err.c_str ());
+    }
+
+    signalled_.store (false, std::memory_order_seq_cst);
+    std::atomic_thread_fence (std::memory_order_seq_cst);
+    if (! _try_pop (data))
+        return (false);
+
+   // Pushes that saw the stale signalled_ before the store above did not
+   // write the eventfd. If they left more messages behind, signal them
+   // here, or the channel would not poll readable again.
+   //
+    if (num_of_msgs_inq () > 0)
+        _signal ();
+    return (true);
+}
+
+// ----------------------------------------------------------------------------
+
+template <class com_TYPE>
+void InProcChannel<com_TYPE>::_wait (const struct timespec *timeout)  {
+
+    struct  pollfd  pfd = { event_fd_, POLLIN, 0 };
+
+    if (::ppoll (&pfd, 1, timeout, NULL) < 0 && errno != EINTR)  {
+        DMScu_FixedSizeString<1023> err;
+
+        err.printf ("InProcChannel::_wait(): "
+                    "::ppoll() (%d) %s",
+                    errno, strerror (errno));
+        throw std::runtime_error(err.c_str ());
+    }
+
+    return;
+}
+
+// ----------------------------------------------------------------------------
+
+template <class com_TYPE>
+typename InProcChannel<com_TYPE>::size_type
+InProcChannel<com_TYPE>::push (const value_type &data)  {
+
+    while (! _try_push (data))  {
+        if (! is_blocking ())
+            return (static_cast<size_type>(_would_block_));
+        ::sched_yield ();
+    }
+
+    _signal ();
+    return (sizeof (value_type));
+}
+
+// ----------------------------------------------------------------------------
+
+template <class com_TYPE>
+typename InProcChannel<com_TYPE>::size_type
+InProcChannel<com_TYPE>::pop (value_type &data)  {
+
+    while (true)  {
+        if (_try_pop (data) || _rearm (data))
+            return (sizeof (value_type));
+        if (! is_blocking ())
+            return (static_cast<size_type>(_would_block_));
+        _wait (NULL);
+    }
+}
+
+// ----------------------------------------------------------------------------
+
+template <class com_TYPE>
+typename InProcChannel<com_TYPE>::size_type
+InProcChannel<com_TYPE>::pop (value_type &data, WaitStrategy &strategy)  {
+
+    bool    got = false;
+
+   // Only the park stage touches the eventfd, so spinning stays in user
+   // space.
+   //
+    strategy.wait (
+        [this, &data, &got] () -> bool  {
+            return (got || _try_pop (data));
+        },
+        [this, &data, &got] (const struct timespec *timeout)  {
+            if (_rearm (data))
+                got = true;
+            else
+                _wait (timeout);
+        });
+
+    return (sizeof (value_type));
+}
+
+// ----------------------------------------------------------------------------
+
+template <class com_TYPE>
+int InProcChannel<com_TYPE>::send (const void *data, size_type the_size)  {
+
+    if (the_size != sizeof (value_type))  {
+        DMScu_FixedSizeString<1023> err;
+
+        err.printf ("InProcChannel::send(): "
+                    "size (%u) is not the message size (%u)",
+                    the_size, static_cast<size_type>(sizeof (value_type)));
+        throw std::runtime_error(err.c_str ());
+    }
+
+    return (static_cast<int>(
+                push (*reinterpret_cast<const value_type *>(data))));
+}
+
+// ----------------------------------------------------------------------------
+
+template <class com_TYPE>
+int InProcChannel<com_TYPE>::receive (void *data, size_type the_size)  {
+
+    if (the_size != sizeof (value_type))  {
+        DMScu_FixedSizeString<1023> err;
+
+        err.printf ("InProcChannel::receive(): "
+                    "size (%u) is not the message size (%u)",
+                    the_size, static_cast<size_type>(sizeof (value_type)));
+        throw std::runtime_error(err.c_str ());
+    }
+
+    return (static_cast<int>(pop (*reinterpret_cast<value_type *>(data))));
+}
+
+// ----------------------------------------------------------------------------
+
+template <class com_TYPE>
+typename InProcChannel<com_TYPE>::size_type
+InProcChannel<com_TYPE>::num_of_msgs_inq () const throw ()  {
+
+    const   size_t  head = dequeue_pos_.load (std::memory_order_relaxed);
+    const   size_t  tail = enqueue_pos_.load (std::memory_order_relaxed);
+
+    if (tail <= head)
+        return (0);
+    return (tail - head < capacity_ ? tail - head : capacity_);
+}
+
+} // namespace hmcom
+
+// ----------------------------------------------------------------------------
+
+// Local Variables:
+// mode:C++
+// tab-width:4
+// c-basic-offset:4
+// End:
@@ -0,0 +1,256 @@
+// Hossein Moein
+// March 25, 2018
+// Copyright (C) 2018-2019 Hossein Moein
+// Distributed under the BSD Software License (see file License)
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <ctime>
+
+// ----------------------------------------------------------------------------
+
+namespace hmcom
+{
+
+// A log-linear (HDR style) histogram of latencies in ticks. Values below
+// SUB_BUCKETS have a bucket each. Above that, every power of 2 is split
+// into SUB_BUCKETS buckets, so a value is known to within 1/SUB_BUCKETS
+// (6%) of itself. Values of 2^MAX_BITS ticks (about 20 seconds) and more
+// go in the last bucket. It also keeps the number of messages, their
+// bytes, the total, min and max.
+//
+// record() is meant for one writer at a time. It does not use locked
+// instructions, so concurrent writers may lose a few counts. Readers can
+// read, merge() or percentile() while it is being written, and see the
+// counts of some recent moment.
+//
+class   LatencyHistogram  {
+
+    public:
+
+        typedef unsigned int            size_type;
+        typedef unsigned long long int  counter_type;
+
+        static  const   size_type   SUB_BUCKET_BITS = 4;
+        static  const   size_type   SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+        static  const   size_type   MAX_BITS = 36;
+        static  const   size_type   BUCKETS =
+            (MAX_BITS - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+        inline LatencyHistogram () throw ()  { reset (); }
+
+        inline void record (counter_type ticks, counter_type bytes) throw ()  {
+
+            _add (buckets_ [bucket_of (ticks)], 1);
+            _add (count_, 1);
+            _add (bytes_, bytes);
+            _add (total_, ticks);
+            if (ticks < min_.load (std::memory_order_relaxed))
+                min_.store (ticks, std::memory_order_relaxed);
+            if (ticks > max_.load (std::memory_order_relaxed))
+                max_.store (ticks, std::memory_order_relaxed);
+        }
+
+       // Adds the counts of that to this histogram
+       //
+        void merge (const LatencyHistogram &that) throw ();
+        void reset () throw ();
+
+       // The value that fraction (0 to 1) of the recorded values are at
+       // or below, as the top of its bucket. 0 if nothing is recorded.
+       //
+        counter_type percentile (double fraction) const throw ();
+
+        inline counter_type get_count () const throw ()  {
+
+            return (count_.load (std::memory_order_relaxed));
+        }
+        inline counter_type get_bytes () const throw ()  {
+
+            return (bytes_.load (std::memory_order_relaxed));
+        }
+        inline counter_type get_total () const throw ()  {
+
+            return (total_.load (std::memory_order_relaxed));
+        }
+        inline counter_type get_min () const throw ()  {
+
+            return (get_count () ? min_.load (std::memory_order_relaxed) : 0);
+        }
+        inline counter_type get_max () const throw ()  {
+
+            return (max_.load (std::memory_order_relaxed));
+        }
+        inline counter_type get_bucket (size_type bucket) const throw ()  {
+
+            return (buckets_ [bucket].load (std::memory_order_relaxed));
+        }
+
+        static inline size_type bucket_of (counter_type ticks) throw ()  {
+
+            if (ticks < SUB_BUCKETS)
+                return (static_cast<size_type>(ticks));
+            if (ticks >> MAX_BITS)
+                return (BUCKETS - 1);
+
+            const   size_type   shift =
+                63 - __builtin_clzll (ticks) - SUB_BUCKET_BITS;
+
+            return ((shift + 1) * SUB_BUCKETS +
+                    static_cast<size_type>((ticks >> shift) &
+                                           (SUB_BUCKETS - 1)));
+        }
+
+       // The highest value that goes in bucket
+       //
+        static inline counter_type bucket_top (size_type bucket) throw ()  {
+
+            if (bucket < SUB_BUCKETS)
+                return (bucket);
+
+            const   size_type   shift = bucket / SUB_BUCKETS - 1;
+
+            return (((static_cast<counter_type>(SUB_BUCKETS +
+                                                bucket % SUB_BUCKETS) + 1)
+                         << shift) - 1);
+        }
+
+    private:
+
+        typedef std::atomic<counter_type>   Counter;
+
+        static inline void _add (Counter &counter, counter_type value)
+            throw ()  {
+
+            counter.store (counter.load (std::memory_order_relaxed) + value,
+                           std::memory_order_relaxed);
+        }
+
+        Counter buckets_ [BUCKETS];
+        Counter count_;
+        Counter bytes_;
+        Counter total_;
+        Counter min_;
+        Counter max_;
+
+       // These are not implemented
+       //
+        LatencyHistogram (const LatencyHistogram &);
+        LatencyHistogram &operator = (const LatencyHistogram &);
+};
+
+// ----------------------------------------------------------------------------
+
+// The latencies of the sends and receives of a Communication, kept once
+// for the object and once for the calling thread. A thread's stats cover
+// all the objects it used and outlive the thread, so merge_threads() sees
+// every thread that ever recorded.
+//
+// Timestamps are TSC ticks on x86, nanoseconds elsewhere. Use to_ns() to
+// convert. A record() is a few nanoseconds: a rdtsc and a handful of
+// uncontended stores, on top of the rdtsc that started it.
+//
+// Communication keeps a LatencyStats once enable_latency_stats() is
+// called. Until then, the send and receive paths only test for it. It is
+// a runtime switch, per object, so every translation unit sees the same
+// Communication.
+//
+class   LatencyStats  {
+
+    public:
+
+        typedef LatencyHistogram::size_type     size_type;
+        typedef LatencyHistogram::counter_type  tick_type;
+
+        enum OPERATION { _send_ = 0, _receive_ = 1 };
+
+        static  const   size_type   OPERATIONS = 2;
+
+        inline LatencyStats () throw ()  {   }
+
+        static inline tick_type now () throw ()  {
+
+#if defined (__x86_64__) || defined (__i386__)
+            return (__builtin_ia32_rdtsc ());
+#else
+            struct  timespec    ts;
+
+            ::clock_gettime (CLOCK_MONOTONIC, &ts);
+            return (static_cast<tick_type>(ts.tv_sec) * 1000000000ULL +
+                    ts.tv_nsec);
+#endif // defined (__x86_64__) || defined (__i386__)
+        }
+
+       // The number of ticks in a nanosecond, measured on the first call
+       //
+        static double ticks_per_ns ();
+        static inline double to_ns (tick_type ticks)  {
+
+            return (static_cast<double>(ticks) / ticks_per_ns ());
+        }
+
+       // Records an operation that started at start (a now()) and moved
+       // bytes
+       //
+        inline void
+        record (OPERATION op, tick_type start, size_type bytes) throw ()  {
+
+            const   tick_type       ticks = now () - start;
+            LatencyStats *const     thread =
+                thread_stats_ || thread_failed_
+                    ? thread_stats_ : _register_thread ();
+
+            histograms_ [op].record (ticks, bytes);
+            if (thread)
+                thread->histograms_ [op].record (ticks, bytes);
+        }
+
+        inline const LatencyHistogram &get (OPERATION op) const throw ()  {
+
+            return (histograms_ [op]);
+        }
+
+        void merge (const LatencyStats &that) throw ();
+        void reset () throw ();
+
+       // The stats of the calling thread. NULL until it records something
+       //
+        static inline const LatencyStats *this_thread () throw ()  {
+
+            return (thread_stats_);
+        }
+
+       // Merges the stats of all threads into stats
+       //
+        static void merge_threads (LatencyStats &stats);
+
+    private:
+
+        static LatencyStats *_register_thread () throw ();
+
+        static  inline  thread_local    LatencyStats    *thread_stats_ = NULL;
+
+       // Set if the thread could not be registered, so it is not retried
+       // on every record()
+       //
+        static  inline  thread_local    bool            thread_failed_ = false;
+
+        LatencyHistogram    histograms_ [OPERATIONS];
+
+       // These are not implemented
+       //
+        LatencyStats (const LatencyStats &);
+        LatencyStats &operator = (const LatencyStats &);
+};
+
+} // namespace hmcom
+
+// ----------------------------------------------------------------------------
+
+// Local Variables:
+// mode:C++
+// tab-width:4
+// c-basic-offset:4
+// End:
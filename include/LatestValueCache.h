@@ -0,0 +1,178 @@
+// Hossein Moein
+// March 25, 2018
+// Copyright (C) 2018-2019 Hossein Moein
+// Distributed under the BSD Software License (see file License)
+
+#pragma once
+
+#include <cstdlib>
+#include <cstdint>
+#include <atomic>
+#include <functional>
+#include <type_traits>
+
+#include <sys/types.h>
+
+#include <Communication.h>
+
+// ----------------------------------------------------------------------------
+
+namespace hmcom
+{
+
+// This class is a fixed capacity table in POSIX shared memory that keeps only
+// the latest value for each key. Writers overwrite values in place. Readers
+// take a consistent snapshot of a value through a per-slot sequence lock,
+// without any lock or system call, so the cost of a read does not depend on
+// how fast the writers are publishing.
+//
+// The index is open addressing with linear probing over twice capacity
+// slots. Keys are never deleted. Keys are compared bytewise, so a key_TYPE
+// must not have padding with undefined content. hash_TYPE must produce the
+// same value for the same key in every process that opens the table.
+//
+// The same com_TYPE restrictions as MessageQueue apply to both key_TYPE and
+// com_TYPE. They are memcpy()'ed in and out of shared memory.
+//
+template <class key_TYPE,
+          class com_TYPE,
+          class hash_TYPE = std::hash<key_TYPE> >
+class   LatestValueCache : public Communication  {
+
+    public:
+
+        typedef Communication                   BaseClass;
+        typedef key_TYPE                        key_type;
+        typedef com_TYPE                        value_type;
+        typedef hash_TYPE                       hasher;
+        typedef typename BaseClass::size_type   size_type;
+        typedef uint32_t                        version_type;
+
+        static_assert (std::is_trivially_copyable<key_type>::value,
+                       "LatestValueCache: key_TYPE must be trivially copyable");
+        static_assert (std::is_trivially_copyable<value_type>::value,
+                       "LatestValueCache: com_TYPE must be trivially copyable");
+
+       // Writers create the table, if it doesn't exist. Readers attach to an
+       // existing table and take the capacity from it.
+       //
+        enum MODE { _writer_, _reader_ };
+
+        LatestValueCache (const char *name,
+                          MODE open_mode,
+                          size_type capacity = 1024,
+                          mode_t permission = 0640) throw ()
+            : BaseClass (name),
+              shm_fd_ (-1),
+              header_ (NULL),
+              slots_ (NULL),
+              mapped_size_ (0),
+              slot_count_ (_round_up (capacity * 2)),
+              capacity_ (capacity),
+              permission_ (permission),
+              open_mode_ (open_mode)  {   }
+
+        virtual ~LatestValueCache ()  { disconnect (); }
+
+       // Inserts or overwrites the value for key. A false return means the
+       // key is new and the table is already at capacity.
+       //
+        bool publish (const key_type &key, const value_type &value);
+
+       // A false return means the key has never been published.
+       // If version is not NULL, it is set to the number of times the key
+       // has been published. That lets a reader tell whether the value has
+       // changed since it last looked.
+       //
+        bool get (const key_type &key,
+                  value_type &value,
+                  version_type *version = NULL) const throw ();
+
+       // Number of keys in the table
+       //
+        size_type size () const throw ();
+        inline size_type get_capacity () const throw ()  { return (capacity_); }
+
+        void remove ();
+
+        virtual TYPE get_type () const throw ()  { return (_shared_mem_); }
+
+    protected:
+
+        virtual bool _make_blocking_hook ()  { return (true); }
+        virtual bool _make_nonblocking_hook ()  { return (true); }
+        virtual bool _connect_hook ();
+        virtual bool _disconnect_hook ();
+
+    private:
+
+        enum SLOT_STATE { _empty_ = 0, _claimed_ = 1, _ready_ = 2 };
+
+        struct  alignas(64) Header  {
+
+            uint64_t                magic;
+            uint32_t                capacity;
+            uint32_t                slot_count;
+            uint32_t                key_size;
+            uint32_t                value_size;
+            std::atomic<uint32_t>   count;
+        };
+
+        struct  alignas(64) Slot  {
+
+            std::atomic<uint32_t>   state;
+
+           // Sequence lock. It is odd while a writer is updating the value.
+           //
+            std::atomic<uint32_t>   seq;
+            key_type                key;
+            value_type              value;
+        };
+
+        static const uint64_t   MAGIC = 0x484d4c5643ULL;  // "HMLVC"
+
+        static inline size_type _round_up (size_type value) throw ()  {
+
+            size_type   result = 1;
+
+            while (result < value)
+                result <<= 1;
+            return (result);
+        }
+
+       // Returns the slot holding key or NULL. If claim is true, an empty
+       // slot is claimed for the key, as long as the table is not full.
+       //
+        Slot *_find (const key_type &key, bool claim) const throw ();
+
+        int                 shm_fd_;
+        Header              *header_;
+        Slot                *slots_;
+        size_t              mapped_size_;
+        size_type           slot_count_;
+        size_type           capacity_;
+        const   mode_t      permission_;
+        const   MODE        open_mode_;
+
+       // These are not implemented
+       //
+        LatestValueCache ();
+        LatestValueCache (const LatestValueCache &);
+        LatestValueCache &operator = (const LatestValueCache &);
+};
+
+} // namespace hmcom
+
+// ----------------------------------------------------------------------------
+
+#  ifdef DMS_INCLUDE_SOURCE
+#    include <LatestValueCache.tcc>
+#  endif // DMS_INCLUDE_SOURCE
+
+// ----------------------------------------------------------------------------
+
+// Local Variables:
+// mode:C++
+// tab-width:4
+// c-basic-offset:4
+// End:
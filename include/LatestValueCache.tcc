@@ -0,0 +1,330 @@
+// Hossein Moein
+// March 25, 2018
+// Copyright (C) 2018-2019 Hossein Moein
+// Distributed under the BSD Software License (see file License)
+
+#include <cerrno>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <string.h>
+
+#include <DMScu_FixedSizeString.h>
+
+#include <LatestValueCache.h>
+
+// ----------------------------------------------------------------------------
+
+namespace hmcom
+{
+
+template <class key_TYPE, class com_TYPE, class hash_TYPE>
+bool LatestValueCache<key_TYPE, com_TYPE, hash_TYPE>::_connect_hook ()  {
+
+    if (is_connected ())
+        return (false);
+
+    const   int oflag = open_mode_ == _writer_ ? O_CREAT | O_RDWR : O_RDWR;
+
+    shm_fd_ = ::shm_open (get_name (), oflag, permission_);
+    if (shm_fd_ < 0)  {
+        DMScu_FixedSizeString<1023> err;
+
+        err.printf ("LatestValueCache::_connect_hook(): "
+                    "::shm_open() (%d) %s",
+                    errno, strerror (errno));
+        throw std::runtime_error(err.c_str ());
+    }
+
+    struct  stat    st;
+
+    if (::fstat (shm_fd_, &st) < 0)  {
+        ::close (shm_fd_);
+        shm_fd_ = -1;
+
+        DMScu_FixedSizeString<1023> err;
+
+        err.printf ("LatestValueCache::_connect_hook(): "
+                    "::fstat() (%d) %s",
+                    errno, strerror (errno));
+        throw std::runtime_error(err.c_str ());
+    }
+
+   // The first writer sizes the segment. Everybody else maps what is there.
+   //
+    if (open_mode_ == _writer_ && st.st_size == 0)  {
+        mapped_size_ = sizeof (Header) + slot_count_ * sizeof (Slot);
+        if (::ftruncate (shm_fd_, mapped_size_) < 0)  {
+            ::close (shm_fd_);
+            shm_fd_ = -1;
+
+            DMScu_FixedSizeString<1023> err;
+
+            err.printf ("LatestValueCache::_connect_hook(): "
+                        "::ftruncate() (%d) %s",
+                        errno, strerror (errno));
+            throw std::runtime_error(err.c_str ());
+        }
+    }
+    else
+        mapped_size_ = st.st_size;
+
+    if (mapped_size_ < sizeof (Header))  {
+        ::close (shm_fd_);
+        shm_fd_ = -1;
+
+        DMScu_FixedSizeString<1023> err;
+
+        err.printf ("LatestValueCache::_connect_hook(): "
+                    "'%s' has not been created by a writer",
+                    get_name ());
+        throw std::runtime_error(err.c_str ());
+    }
+
+    void    *addr = ::mmap (NULL, mapped_size_,
+                            PROT_READ | PROT_WRITE, MAP_SHARED,
+                            shm_fd_, 0);
+
+    if (addr == MAP_FAILED)  {
+        ::close (shm_fd_);
+        shm_fd_ = -1;
+
+        DMScu_FixedSizeString<1023> err;
+
+        err.printf ("LatestValueCache::_connect_hook(): "
+                    "::mmap() (%d) %s",
+                    errno, strerror (errno));
+        throw std::runtime_error(err.c_str ());
+    }
+
+    header_ = reinterpret_cast<Header *>(addr);
+    slots_ = reinterpret_cast<Slot *>(
+        reinterpret_cast<char *>(addr) + sizeof (Header));
+
+   // ftruncate() zero fills, so a fresh segment has no magic yet. A freshly
+   // created table is empty, since _empty_ is 0.
+   //
+    if (open_mode_ == _writer_ && header_->magic == 0)  {
+        header_->capacity = capacity_;
+        header_->slot_count = slot_count_;
+        header_->key_size = sizeof (key_type);
+        header_->value_size = sizeof (value_type);
+        std::atomic_thread_fence (std::memory_order_release);
+        header_->magic = MAGIC;
+    }
+
+    if (header_->magic != MAGIC ||
+        header_->key_size != sizeof (key_type) ||
+        header_->value_size != sizeof (value_type) ||
+        mapped_size_ < sizeof (Header) + header_->slot_count * sizeof (Slot))  {
+        ::munmap (addr, mapped_size_);
+        ::close (shm_fd_);
+        shm_fd_ = -1;
+        header_ = NULL;
+        slots_ = NULL;
+
+        DMScu_FixedSizeString<1023> err;
+
+        err.printf ("LatestValueCache::_connect_hook(): "
+                    "'%s' is not a table of this key and value type",
+                    get_name ());
+        throw std::runtime_error(err.c_str ());
+    }
+
+    capacity_ = header_->capacity;
+    slot_count_ = header_->slot_count;
+    return (true);
+}
+
+// ----------------------------------------------------------------------------
+
+template <class key_TYPE, class com_TYPE, class hash_TYPE>
+bool LatestValueCache<key_TYPE, com_TYPE, hash_TYPE>::_disconnect_hook ()  {
+
+    if (is_connected ())  {
+        ::munmap (header_, mapped_size_);
+        ::close (shm_fd_);
+        shm_fd_ = -1;
+        header_ = NULL;
+        slots_ = NULL;
+        mapped_size_ = 0;
+        return (true);
+    }
+
+    return (false);
+}
+
+// ----------------------------------------------------------------------------
+
+template <class key_TYPE, class com_TYPE, class hash_TYPE>
+typename LatestValueCache<key_TYPE, com_TYPE, hash_TYPE>::Slot *
+LatestValueCache<key_TYPE, com_TYPE, hash_TYPE>::
+_find (const key_type &key, bool claim) const throw ()  {
+
+    const   size_type   mask = slot_count_ - 1;
+    size_type           idx = static_cast<size_type>(hasher () (key)) & mask;
+
+    for (size_type probe = 0; probe < slot_count_; ++probe)  {
+        Slot        &slot = slots_ [idx];
+        uint32_t    state = slot.state.load (std::memory_order_acquire);
+
+        if (state == _empty_)  {
+            if (! claim)
+                return (NULL);
+
+            if (header_->count.fetch_add (1, std::memory_order_relaxed) >=
+                    capacity_)  {
+                header_->count.fetch_sub (1, std::memory_order_relaxed);
+                return (NULL);
+            }
+            if (slot.state.compare_exchange_strong (
+                    state, _claimed_, std::memory_order_acquire))  {
+                ::memcpy (&(slot.key), &key, sizeof (key_type));
+                slot.state.store (_ready_, std::memory_order_release);
+                return (&slot);
+            }
+
+           // Another writer took this slot first. It may be for this key,
+           // so fall through and look at it again.
+           //
+            header_->count.fetch_sub (1, std::memory_order_relaxed);
+        }
+
+       // Another writer is in the middle of writing the key
+       //
+        while (state != _ready_)  {
+#if defined (__x86_64__) || defined (__i386__)
+            __builtin_ia32_pause ();
+#endif // defined (__x86_64__) || defined (__i386__)
+            state = slot.state.load (std::memory_order_acquire);
+        }
+
+        if (! ::memcmp (&(slot.key), &key, sizeof (key_type)))
+            return (&slot);
+
+        idx = (idx + 1) & mask;
+    }
+
+    return (NULL);
+}
+
+// ----------------------------------------------------------------------------
+
+template <class key_TYPE, class com_TYPE, class hash_TYPE>
+bool LatestValueCache<key_TYPE, com_TYPE, hash_TYPE>::
+publish (const key_type &key, const value_type &value)  {
+
+    if (open_mode_ != _writer_)
+        throw std::runtime_error ("LatestValueCache::publish(): "
+                                  "table is opened for reading only.");
+
+    Slot    *slot = _find (key, true);
+
+    if (slot == NULL)
+        return (false);
+
+   // Writers exclude each other by making the sequence odd
+   //
+    uint32_t    seq = slot->seq.load (std::memory_order_relaxed);
+
+    while ((seq & 1) ||
+           ! slot->seq.compare_exchange_weak (seq, seq + 1,
+                                              std::memory_order_acquire,
+                                              std::memory_order_relaxed))  {
+#if defined (__x86_64__) || defined (__i386__)
+        __builtin_ia32_pause ();
+#endif // defined (__x86_64__) || defined (__i386__)
+        seq = slot->seq.load (std::memory_order_relaxed);
+    }
+
+    std::atomic_thread_fence (std::memory_order_release);
+    ::memcpy (&(slot->value), &value, sizeof (value_type));
+    slot->seq.store (seq + 2, std::memory_order_release);
+
+    return (true);
+}
+
+// ----------------------------------------------------------------------------
+
+template <class key_TYPE, class com_TYPE, class hash_TYPE>
+bool LatestValueCache<key_TYPE, com_TYPE, hash_TYPE>::
+get (const key_type &key,
+     value_type &value,
+     version_type *version) const throw ()  {
+
+    const   Slot    *slot = _find (key, false);
+
+    if (slot == NULL)
+        return (false);
+
+    while (true)  {
+        const   uint32_t    seq1 = slot->seq.load (std::memory_order_acquire);
+
+        if (seq1 & 1)  {
+#if defined (__x86_64__) || defined (__i386__)
+            __builtin_ia32_pause ();
+#endif // defined (__x86_64__) || defined (__i386__)
+            continue;
+        }
+
+        ::memcpy (&value, &(slot->value), sizeof (value_type));
+        std::atomic_thread_fence (std::memory_order_acquire);
+
+        if (slot->seq.load (std::memory_order_relaxed) == seq1)  {
+           // The key is visible before its first value is written
+           //
+            if (seq1 == 0)
+                return (false);
+
+            if (version)
+                *version = seq1 / 2;
+            return (true);
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------
+
+template <class key_TYPE, class com_TYPE, class hash_TYPE>
+typename LatestValueCache<key_TYPE, com_TYPE, hash_TYPE>::size_type
+LatestValueCache<key_TYPE, com_TYPE, hash_TYPE>::size () const throw ()  {
+
+    if (header_ == NULL)
+        return (0);
+
+    const   size_type   count =
+        header_->count.load (std::memory_order_relaxed);
+
+    return (count < capacity_ ? count : capacity_);
+}
+
+// ----------------------------------------------------------------------------
+
+template <class key_TYPE, class com_TYPE, class hash_TYPE>
+void LatestValueCache<key_TYPE, com_TYPE, hash_TYPE>::remove ()  {
+
+    disconnect ();
+    if (::shm_unlink (get_name ()) < 0)  {
+        DMScu_FixedSizeString<1023> err;
+
+        err.printf ("LatestValueCache::remove(): "
+                    "::shm_unlink() (%d) %s",
+                    errno, strerror (errno));
+        throw std::runtime_error(err.c_str ());
+    }
+
+    return;
+}
+
+} // namespace hmcom
+
+// ----------------------------------------------------------------------------
+
+// Local Variables:
+// mode:C++
+// tab-width:4
+// c-basic-offset:4
+// End:
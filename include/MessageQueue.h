@@ -13,6 +13,8 @@
 #include <mqueue.h>
 
 #include <Communication.h>
+#include <IOStatus.h>
+#include <WaitStrategy.h>
 
 // ----------------------------------------------------------------------------
 
@@ -57,6 +59,27 @@ class   MessageQueue : public Communication  {
         size_type push (const value_type &data, priority_type priority = 1);
         size_type pop (value_type &data, priority_type *priority = NULL);
 
+       // The same as push() and pop(), but a failure is returned instead
+       // of thrown, and a full or empty non-blocking queue is a
+       // would_block() status. See IOStatus.
+       //
+        IOResult<size_type>
+        try_push (const value_type &data, priority_type priority = 1)
+            throw ();
+        IOResult<size_type>
+        try_pop (value_type &data, priority_type *priority = NULL) throw ();
+
+       // Waits for a message according to strategy, regardless of the
+       // blocking mode of the queue. A POSIX queue can only be looked at
+       // by the kernel, so every check of the spin, pause and yield stages
+       // is a ::mq_timedreceive() system call, not a user space load. Use
+       // a strategy with small spin and pause limits here. EINTR does not
+       // end the wait.
+       //
+        size_type pop (value_type &data,
+                       WaitStrategy &strategy,
+                       priority_type *priority = NULL);
+
         inline size_type operator >> (value_type &data)  {
 
             return (pop (data));
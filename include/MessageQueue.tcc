@@ -8,6 +8,8 @@
 #include <stdexcept>
 #include <sstream>
 
+#include <poll.h>
+
 #include <DMScu_FixedSizeString.h>
 
 #include <MessageQueue.h>
@@ -156,29 +158,40 @@ typename MessageQueue<com_TYPE>::size_type
 MessageQueue<com_TYPE>::push (const value_type &data,
                                      priority_type priority)  {
 
+    const   IOResult<size_type> result = try_push (data, priority);
+
+    if (! result.ok ())  {
+        if (result.would_block ())
+            return (static_cast<size_type>(_would_block_));
+        result.status ().throw_error ("MessageQueue::push()");
+    }
+
+    return (*result);
+}
+
+// ----------------------------------------------------------------------------
+
+template <class com_TYPE>
+IOResult<typename MessageQueue<com_TYPE>::size_type>
+MessageQueue<com_TYPE>::try_push (const value_type &data,
+                                  priority_type priority) throw ()  {
+
     if (open_mode_ == _read_)
-        throw std::runtime_error ("DMScu_MessageQueue::push(): "
-                                "message queue is read only.");
+        return (IOStatus (IOStatus::_send_, EBADF));
 
-    const   int ret_val =
+    const   LatencyStats::tick_type start = _latency_start ();
+    const   int                     ret_val =
         ::mq_send (mqdes_,
                    reinterpret_cast<const char *> (&data),
                    msg_size_,
                    priority);
 
     if (ret_val < 0)
-        if (errno == EAGAIN)
-            return (static_cast<size_type>(_would_block_));
-        else  {
-            DMScu_FixedSizeString<1023> err;
+        return (IOStatus (IOStatus::_send_, errno));
 
-            err.printf ("MessageQueue::push(): "
-                        "::mq_send() (%d) %s",
-                        errno, strerror (errno));
-            throw std::runtime_error(err.c_str ());
-        }
+    _latency_record (LatencyStats::_send_, start, msg_size_);
 
-    return (ret_val);
+    return (static_cast<size_type>(ret_val));
 }
 
 // ----------------------------------------------------------------------------
@@ -188,27 +201,85 @@ typename MessageQueue<com_TYPE>::size_type
 MessageQueue<com_TYPE>::pop (value_type &data,
                                     priority_type *priority)  {
 
+    const   IOResult<size_type> result = try_pop (data, priority);
+
+    if (! result.ok ())  {
+        if (result.would_block ())
+            return (static_cast<size_type>(_would_block_));
+        result.status ().throw_error ("MessageQueue::pop()");
+    }
+
+    return (*result);
+}
+
+// ----------------------------------------------------------------------------
+
+template <class com_TYPE>
+IOResult<typename MessageQueue<com_TYPE>::size_type>
+MessageQueue<com_TYPE>::try_pop (value_type &data,
+                                 priority_type *priority) throw ()  {
+
     if (open_mode_ == _write_)
-        throw std::runtime_error ("MessageQueue::pop(): "
-                                "message queue is write only.");
+        return (IOStatus (IOStatus::_receive_, EBADF));
 
-    const   int ret_val =
+    const   LatencyStats::tick_type start = _latency_start ();
+    const   int                     ret_val =
         ::mq_receive (mqdes_,
                       reinterpret_cast<char *> (&data),
                       msg_size_,
                       priority);
 
     if (ret_val < 0)
-        if (errno == EAGAIN)
-            return (static_cast<size_type>(_would_block_));
-        else  {
-            DMScu_FixedSizeString<1023> err;
+        return (IOStatus (IOStatus::_receive_, errno));
 
-            err.printf ("MessageQueue::pop(): "
-                        "::mq_receive() (%d) %s",
-                        errno, strerror (errno));
-            throw std::runtime_error(err.c_str ());
-        }
+    _latency_record (LatencyStats::_receive_, start, ret_val);
+
+    return (static_cast<size_type>(ret_val));
+}
+
+// ----------------------------------------------------------------------------
+
+template <class com_TYPE>
+typename MessageQueue<com_TYPE>::size_type
+MessageQueue<com_TYPE>::pop (value_type &data,
+                             WaitStrategy &strategy,
+                             priority_type *priority)  {
+
+    if (open_mode_ == _write_)
+        throw std::runtime_error ("MessageQueue::pop(): "
+                                "message queue is write only.");
+
+   // A deadline in the past makes ::mq_timedreceive() return right away
+   // on an empty queue, even if the queue is in blocking mode. A signal
+   // only makes this check fail, the wait goes on.
+   //
+    static  const   struct  timespec    past = { 0, 0 };
+    int                                 ret_val = -1;
+
+    strategy.wait (
+        [this, &data, priority, &ret_val] () -> bool  {
+            ret_val = ::mq_timedreceive (mqdes_,
+                                         reinterpret_cast<char *> (&data),
+                                         msg_size_,
+                                         priority,
+                                         &past);
+            return (ret_val >= 0 ||
+                    (errno != EAGAIN && errno != ETIMEDOUT && errno != EINTR));
+        },
+        [this] (const struct timespec *timeout)  {
+            struct  pollfd  pfd = { get_fd (), POLLIN, 0 };
+
+            ::ppoll (&pfd, 1, timeout, NULL);
+        });
+
+    if (ret_val < 0)  {
+        DMScu_FixedSizeString<1023> err;
+
+        err.printf ("MessageQueue::pop(): "
+                    "::mq_timedreceive() (%d) %s",
+                    errno, strerror (errno));
+        throw std::runtime_error(err.c_str ());
+    }
 
     return (ret_val);
 }
@@ -0,0 +1,246 @@
+// Hossein Moein
+// March 25, 2018
+// Copyright (C) 2018-2019 Hossein Moein
+// Distributed under the BSD Software License (see file License)
+
+#pragma once
+
+#include <cstdlib>
+#include <cstdint>
+#include <atomic>
+#include <type_traits>
+
+#include <sys/types.h>
+
+#include <DMScu_FixedSizeString.h>
+
+#include <Communication.h>
+#include <Futex.h>
+#include <WaitStrategy.h>
+
+// ----------------------------------------------------------------------------
+
+namespace hmcom
+{
+
+// This class is an append-only journal queue backed by mmap()'ed segment
+// files. Unlike a POSIX message queue, its content survives the crash of
+// either side and (depending on the sync policy) a reboot.
+//
+// name is a path prefix. Segments are named <name>.<segment #>.seg and
+// each holds a fixed number of messages. When a segment is full the writer
+// rolls over to the next one and keeps only the newest retained_segments
+// segments, counting the one being written.
+// Every reader has a consumer name and its read position is kept in
+// <name>.<consumer>.off, so a restarted reader carries on where it left off.
+// A reader whose position has been deleted by retention skips to the oldest
+// retained message.
+//
+// Messages are written into the page cache. That alone survives a process
+// crash. The sync policy decides when msync() is paid for to survive an
+// OS crash:
+//     _sync_never_:       Never, unless sync() is called
+//     _sync_every_n_:     After every sync_interval messages
+//     _sync_on_rollover_: When a segment is full
+//
+// The same com_TYPE restrictions as MessageQueue apply.
+//
+template <class com_TYPE>
+class   PersistentQueue : public Communication  {
+
+    public:
+
+        typedef Communication                   BaseClass;
+        typedef com_TYPE                        value_type;
+        typedef typename BaseClass::size_type   size_type;
+        typedef uint64_t                        sequence_type;
+
+        static_assert (std::is_trivially_copyable<value_type>::value,
+                       "PersistentQueue: com_TYPE must be trivially copyable");
+
+        enum MODE { _read_, _write_ };
+        enum RET_TYPE { _would_block_ = -2 };
+        enum SYNC_POLICY { _sync_never_, _sync_every_n_, _sync_on_rollover_ };
+
+        PersistentQueue (const char *name,
+                         MODE open_mode,
+                         const char *consumer = "default",
+                         size_type msgs_per_segment = 65536,
+                         size_type retained_segments = 8,
+                         SYNC_POLICY sync_policy = _sync_on_rollover_,
+                         size_type sync_interval = 1024,
+                         mode_t permission = 0640) throw ()
+            : BaseClass (name),
+              consumer_ (consumer),
+              segment_ (NULL),
+              segment_fd_ (-1),
+              segment_num_ (0),
+              offset_ (NULL),
+              offset_fd_ (-1),
+              next_seq_ (0),
+              unsynced_ (0),
+              msgs_per_segment_ (msgs_per_segment),
+              retained_segments_ (retained_segments > 0 ? retained_segments : 1),
+              sync_policy_ (sync_policy),
+              sync_interval_ (sync_interval > 0 ? sync_interval : 1),
+              permission_ (permission),
+              open_mode_ (open_mode)  {   }
+
+        virtual ~PersistentQueue ()  { disconnect (); }
+
+       // Returns sizeof(value_type)
+       //
+        size_type push (const value_type &data);
+
+       // Returns sizeof(value_type) or _would_block_. In blocking mode, it
+       // waits for the writer.
+       //
+        size_type pop (value_type &data);
+
+       // Waits for a message according to strategy, regardless of the
+       // blocking mode
+       //
+        size_type pop (value_type &data, WaitStrategy &strategy);
+
+        inline size_type operator >> (value_type &data)  {
+
+            return (pop (data));
+        }
+        inline size_type operator << (const value_type &data)  {
+
+            return (push (data));
+        }
+
+       // For a writer, the sequence of the next message to be written.
+       // For a reader, the sequence of the next message to be read.
+       //
+        inline sequence_type get_sequence () const throw ()  {
+
+            return (next_seq_);
+        }
+
+        size_type num_of_msgs_inq () const;
+
+       // Flushes the current segment (and the read position for readers) to
+       // disk, regardless of the sync policy
+       //
+        void sync ();
+
+       // Deletes all segments and read positions of this queue
+       //
+        void remove ();
+
+    protected:
+
+        virtual bool _make_blocking_hook ()  { return (true); }
+        virtual bool _make_nonblocking_hook ()  { return (true); }
+        virtual bool _connect_hook ();
+        virtual bool _disconnect_hook ();
+
+    private:
+
+        typedef DMScu_FixedSizeString<1023> PathStr;
+
+        struct  alignas(64) SegmentHeader  {
+
+            uint64_t                magic;
+            uint64_t                segment_num;
+            uint32_t                msg_size;
+            uint32_t                msgs_per_segment;
+
+           // Number of complete messages in this segment
+           //
+            std::atomic<uint64_t>   committed;
+
+           // Set once the writer has created the next segment
+           //
+            std::atomic<uint32_t>   sealed;
+
+            alignas(64) Futex::WordType futex_word;
+            std::atomic<uint32_t>       waiters;
+        };
+
+        struct  Record  {
+
+           // Holds sequence + 1 of the message, so torn or stale records
+           // can be told apart after a crash
+           //
+            uint64_t    stamp;
+            value_type  data;
+        };
+
+        struct  alignas(64) ConsumerOffset  {
+
+            uint64_t                magic;
+            std::atomic<uint64_t>   next_seq;
+        };
+
+        static const uint64_t   SEGMENT_MAGIC = 0x484d5051736567ULL;
+        static const uint64_t   OFFSET_MAGIC = 0x484d50516f6666ULL;
+
+        inline size_t _segment_size () const throw ()  {
+
+            return (sizeof (SegmentHeader) +
+                    static_cast<size_t>(msgs_per_segment_) * sizeof (Record));
+        }
+        inline Record *_records () const throw ()  {
+
+            return (reinterpret_cast<Record *>(segment_ + 1));
+        }
+
+        void _segment_path (PathStr &path, sequence_type segment_num) const;
+
+       // Finds the oldest and newest segment numbers on disk. A false
+       // return means there are no segments.
+       //
+        bool _scan_segments (sequence_type &first, sequence_type &last) const;
+
+       // Maps segment_num as the current segment. A false return means the
+       // segment does not exist and create was false.
+       //
+        bool _map_segment (sequence_type segment_num, bool create);
+        void _unmap_segment ();
+
+        void _recover ();
+        void _rollover ();
+        void _open_offset ();
+        size_type _try_pop (value_type &data);
+        bool _wait_for_writer (const struct timespec *timeout);
+
+        const   PathStr     consumer_;
+        SegmentHeader       *segment_;
+        int                 segment_fd_;
+        sequence_type       segment_num_;
+        ConsumerOffset      *offset_;
+        int                 offset_fd_;
+        sequence_type       next_seq_;
+        size_type           unsynced_;
+        const   size_type   msgs_per_segment_;
+        const   size_type   retained_segments_;
+        const   SYNC_POLICY sync_policy_;
+        const   size_type   sync_interval_;
+        const   mode_t      permission_;
+        const   MODE        open_mode_;
+
+       // These are not implemented
+       //
+        PersistentQueue ();
+        PersistentQueue (const PersistentQueue &);
+        PersistentQueue &operator = (const PersistentQueue &);
+};
+
+} // namespace hmcom
+
+// ----------------------------------------------------------------------------
+
+#  ifdef DMS_INCLUDE_SOURCE
+#    include <PersistentQueue.tcc>
+#  endif // DMS_INCLUDE_SOURCE
+
+// ----------------------------------------------------------------------------
+
+// Local Variables:
+// mode:C++
+// tab-width:4
+// c-basic-offset:4
+// End:
@@ -0,0 +1,687 @@
+// Hossein Moein
+// March 25, 2018
+// Copyright (C) 2018-2019 Hossein Moein
+// Distributed under the BSD Software License (see file License)
+
+#include <cerrno>
+#include <stdexcept>
+#include <ctime>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <string.h>
+
+#include <DMScu_FixedSizeString.h>
+
+#include <PersistentQueue.h>
+
+// ----------------------------------------------------------------------------
+
+namespace hmcom
+{
+
+template <class com_TYPE>
+void PersistentQueue<com_TYPE>::
+_segment_path (PathStr &path, sequence_type segment_num) const  {
+
+    path.printf ("%s.%010llu.seg",
+                 get_name (), static_cast<unsigned long long>(segment_num));
+}
+
+// ----------------------------------------------------------------------------
+
+template <class com_TYPE>
+bool PersistentQueue<com_TYPE>::
+_scan_segments (sequence_type &first, sequence_type &last) const  {
+
+    const   char    *name = get_name ();
+    const   char    *slash = ::strrchr (name, '/');
+    PathStr         dir_name;
+    PathStr         prefix;
+
+    if (slash == NULL)  {
+        dir_name = ".";
+        prefix = name;
+    }
+    else  {
+        dir_name.ncopy (name, slash == name ? 1 : slash - name);
+        prefix = slash + 1;
+    }
+    prefix += ".";
+
+    DIR *dir = ::opendir (dir_name.c_str ());
+
+    if (dir == NULL)  {
+        DMScu_FixedSizeString<1023> err;
+
+        err.printf ("PersistentQueue::_scan_segments(): "
+                    "::opendir('%s') (%d) %s",
+                    dir_name.c_str (), errno, strerror (errno));
+        throw std::runtime_error(err.c_str ());
+    }
+
+    const   size_t  prefix_len = prefix.size ();
+    bool            found = false;
+
+    for (const struct dirent *entry = ::readdir (dir); entry != NULL;
+         entry = ::readdir (dir))  {
+        const   char    *fname = entry->d_name;
+
+        if (::strncmp (fname, prefix.c_str (), prefix_len))
+            continue;
+
+        char                    *end = NULL;
+        const   sequence_type   seg_num =
+            ::strtoull (fname + prefix_len, &end, 10);
+
+        if (end == fname + prefix_len || ::strcmp (end, ".seg"))
+            continue;
+
+        if (! found || seg_num < first)
+            first = seg_num;
+        if (! found || seg_num > last)
+            last = seg_num;
+        found = true;
+    }
+
+    ::closedir (dir);
+    return (found);
+}
+
+// ----------------------------------------------------------------------------
+
+template <class com_TYPE>
+bool PersistentQueue<com_TYPE>::
+_map_segment (sequence_type segment_num, bool create)  {
+
+    PathStr path;
+
+    _segment_path (path, segment_num);
+
+    const   int fd = ::open (path.c_str (),
+                             create ? O_RDWR | O_CREAT : O_RDWR,
+                             permission_);
+
+    if (fd < 0)  {
+        if (! create && errno == ENOENT)
+            return (false);
+
+        DMScu_FixedSizeString<1023> err;
+
+        err.printf ("PersistentQueue::_map_segment(): "
+                    "::open('%s') (%d) %s",
+                    path.c_str (), errno, strerror (errno));
+        throw std::runtime_error(err.c_str ());
+    }
+
+    struct  stat    st;
+
+    if (::fstat (fd, &st) < 0)  {
+        ::close (fd);
+
+        DMScu_FixedSizeString<1023> err;
+
+        err.printf ("PersistentQueue::_map_segment(): "
+                    "::fstat('%s') (%d) %s",
+                    path.c_str (), errno, strerror (errno));
+        throw std::runtime_error(err.c_str ());
+    }
+
+    if (st.st_size == 0 && create)  {
+        if (::ftruncate (fd, _segment_size ()) < 0)  {
+            ::close (fd);
+
+            DMScu_FixedSizeString<1023> err;
+
+            err.printf ("PersistentQueue::_map_segment(): "
+                        "::ftruncate('%s') (%d) %s",
+                        path.c_str (), errno, strerror (errno));
+            throw std::runtime_error(err.c_str ());
+        }
+    }
+    else if (static_cast<size_t>(st.st_size) != _segment_size ())  {
+        ::close (fd);
+
+       // A reader may see a segment the writer is still creating
+       //
+        if (! create && st.st_size == 0)
+            return (false);
+
+        DMScu_FixedSizeString<1023> err;
+
+        err.printf ("PersistentQueue::_map_segment(): '%s' is %lld bytes. "
+                    "Expected %llu bytes",
+                    path.c_str (), static_cast<long long>(st.st_size),
+                    static_cast<unsigned long long>(_segment_size ()));
+        throw std::runtime_error(err.c_str ());
+    }
+
+    void    *addr = ::mmap (NULL, _segment_size (),
+                            PROT_READ | PROT_WRITE, MAP_SHARED,
+                            fd, 0);
+
+    if (addr == MAP_FAILED)  {
+        ::close (fd);
+
+        DMScu_FixedSizeString<1023> err;
+
+        err.printf ("PersistentQueue::_map_segment(): "
+                    "::mmap('%s') (%d) %s",
+                    path.c_str (), errno, strerror (errno));
+        throw std::runtime_error(err.c_str ());
+    }
+
+    SegmentHeader   *header = reinterpret_cast<SegmentHeader *>(addr);
+
+    if (create && header->magic == 0)  {
+        header->segment_num = segment_num;
+        header->msg_size = sizeof (value_type);
+        header->msgs_per_segment = msgs_per_segment_;
+        std::atomic_thread_fence (std::memory_order_release);
+        header->magic = SEGMENT_MAGIC;
+    }
+
+    if (header->magic != SEGMENT_MAGIC ||
+        header->segment_num != segment_num ||
+        header->msg_size != sizeof (value_type) ||
+        header->msgs_per_segment != msgs_per_segment_)  {
+        const   bool    not_ready = header->magic == 0 && ! create;
+
+        ::munmap (addr, _segment_size ());
+        ::close (fd);
+        if (not_ready)
+            return (false);
+
+        DMScu_FixedSizeString<1023> err;
+
+        err.printf ("PersistentQueue::_map_segment(): '%s' is not a segment "
+                    "of %u messages of %u bytes",
+                    path.c_str (), msgs_per_segment_,
+                    static_cast<unsigned int>(sizeof (value_type)));
+        throw std::runtime_error(err.c_str ());
+    }
+
+    _unmap_segment ();
+    segment_ = header;
+    segment_fd_ = fd;
+    segment_num_ = segment_num;
+    return (true);
+}
+
+// ----------------------------------------------------------------------------
+
+template <class com_TYPE>
+void PersistentQueue<com_TYPE>::_unmap_segment ()  {
+
+    if (segment_ != NULL)  {
+        ::munmap (segment_, _segment_size ());
+        ::close (segment_fd_);
+        segment_ = NULL;
+        segment_fd_ = -1;
+    }
+}
+
+// ----------------------------------------------------------------------------
+
+template <class com_TYPE>
+void PersistentQueue<com_TYPE>::_recover ()  {
+
+    sequence_type   first = 0;
+    sequence_type   last = 0;
+
+    _scan_segments (first, last);
+    _map_segment (last, true);
+
+   // The committed count may not have made it to disk, even though the
+   // records did, or the other way around. The stamps settle it.
+   //
+    const   sequence_type   base = last * msgs_per_segment_;
+    const   Record          *records = _records ();
+    uint64_t                committed =
+        segment_->committed.load (std::memory_order_acquire);
+
+    if (committed > msgs_per_segment_)
+        committed = msgs_per_segment_;
+    while (committed > 0 && records [committed - 1].stamp != base + committed)
+        committed -= 1;
+    while (committed < msgs_per_segment_ &&
+           records [committed].stamp == base + committed + 1)
+        committed += 1;
+
+    segment_->committed.store (committed, std::memory_order_release);
+    next_seq_ = base + committed;
+    if (committed == msgs_per_segment_)
+        _rollover ();
+}
+
+// ----------------------------------------------------------------------------
+
+template <class com_TYPE>
+void PersistentQueue<com_TYPE>::_rollover ()  {
+
+    if (sync_policy_ != _sync_never_)
+        sync ();
+
+   // Keep the full segment mapped until the next one exists, so readers
+   // waiting on it can be told to move on.
+   //
+    SegmentHeader           *full_segment = segment_;
+    const   int             full_fd = segment_fd_;
+    const   sequence_type   next_segment = segment_num_ + 1;
+
+    segment_ = NULL;
+    segment_fd_ = -1;
+    try  {
+        _map_segment (next_segment, true);
+    }
+    catch (...)  {
+        segment_ = full_segment;
+        segment_fd_ = full_fd;
+        throw;
+    }
+
+    full_segment->sealed.store (1, std::memory_order_seq_cst);
+    if (full_segment->waiters.load (std::memory_order_seq_cst) > 0)  {
+        full_segment->futex_word.fetch_add (1, std::memory_order_seq_cst);
+        Futex::wake (full_segment->futex_word);
+    }
+    ::munmap (full_segment, _segment_size ());
+    ::close (full_fd);
+
+    if (next_segment >= retained_segments_)  {
+        PathStr path;
+
+        for (sequence_type seg = next_segment - retained_segments_ + 1;
+             seg-- > 0; )  {
+            _segment_path (path, seg);
+            if (::unlink (path.c_str ()) < 0)
+                break;
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------
+
+template <class com_TYPE>
+void PersistentQueue<com_TYPE>::_open_offset ()  {
+
+    PathStr path;
+
+    path.printf ("%s.%s.off", get_name (), consumer_.c_str ());
+    offset_fd_ = ::open (path.c_str (), O_RDWR | O_CREAT, permission_);
+    if (offset_fd_ < 0)  {
+        DMScu_FixedSizeString<1023> err;
+
+        err.printf ("PersistentQueue::_open_offset(): "
+                    "::open('%s') (%d) %s",
+                    path.c_str (), errno, strerror (errno));
+        throw std::runtime_error(err.c_str ());
+    }
+
+    if (::ftruncate (offset_fd_, sizeof (ConsumerOffset)) < 0)  {
+        ::close (offset_fd_);
+        offset_fd_ = -1;
+
+        DMScu_FixedSizeString<1023> err;
+
+        err.printf ("PersistentQueue::_open_offset(): "
+                    "::ftruncate('%s') (%d) %s",
+                    path.c_str (), errno, strerror (errno));
+        throw std::runtime_error(err.c_str ());
+    }
+
+    void    *addr = ::mmap (NULL, sizeof (ConsumerOffset),
+                            PROT_READ | PROT_WRITE, MAP_SHARED,
+                            offset_fd_, 0);
+
+    if (addr == MAP_FAILED)  {
+        ::close (offset_fd_);
+        offset_fd_ = -1;
+
+        DMScu_FixedSizeString<1023> err;
+
+        err.printf ("PersistentQueue::_open_offset(): "
+                    "::mmap('%s') (%d) %s",
+                    path.c_str (), errno, strerror (errno));
+        throw std::runtime_error(err.c_str ());
+    }
+
+    offset_ = reinterpret_cast<ConsumerOffset *>(addr);
+    if (offset_->magic != OFFSET_MAGIC)  {
+        sequence_type   first = 0;
+        sequence_type   last = 0;
+
+        offset_->next_seq.store (
+            _scan_segments (first, last) ? first * msgs_per_segment_ : 0,
+            std::memory_order_release);
+        offset_->magic = OFFSET_MAGIC;
+    }
+    next_seq_ = offset_->next_seq.load (std::memory_order_acquire);
+}
+
+// ----------------------------------------------------------------------------
+
+template <class com_TYPE>
+bool PersistentQueue<com_TYPE>::_connect_hook ()  {
+
+    if (is_connected ())
+        return (false);
+
+    if (msgs_per_segment_ == 0)
+        throw std::runtime_error ("PersistentQueue::_connect_hook(): "
+                                  "msgs_per_segment cannot be 0.");
+
+    if (open_mode_ == _write_)
+        _recover ();
+    else
+        _open_offset ();
+
+    unsynced_ = 0;
+    return (true);
+}
+
+// ----------------------------------------------------------------------------
+
+template <class com_TYPE>
+bool PersistentQueue<com_TYPE>::_disconnect_hook ()  {
+
+    if (is_connected ())  {
+        if (open_mode_ == _write_ && sync_policy_ != _sync_never_)
+            sync ();
+
+        _unmap_segment ();
+        if (offset_ != NULL)  {
+            ::munmap (offset_, sizeof (ConsumerOffset));
+            ::close (offset_fd_);
+            offset_ = NULL;
+            offset_fd_ = -1;
+        }
+        return (true);
+    }
+
+    return (false);
+}
+
+// ----------------------------------------------------------------------------
+
+template <class com_TYPE>
+typename PersistentQueue<com_TYPE>::size_type
+PersistentQueue<com_TYPE>::push (const value_type &data)  {
+
+    if (open_mode_ != _write_)
+        throw std::runtime_error ("PersistentQueue::push(): "
+                                  "queue is opened for reading only.");
+
+    const   uint64_t    idx = next_seq_ - segment_num_ * msgs_per_segment_;
+    Record              &record = _records () [idx];
+
+    ::memcpy (&(record.data), &data, sizeof (value_type));
+    record.stamp = next_seq_ + 1;
+    segment_->committed.store (idx + 1, std::memory_order_seq_cst);
+    next_seq_ += 1;
+
+    if (segment_->waiters.load (std::memory_order_seq_cst) > 0)  {
+        segment_->futex_word.fetch_add (1, std::memory_order_seq_cst);
+        Futex::wake (segment_->futex_word);
+    }
+
+    if (sync_policy_ == _sync_every_n_ && ++unsynced_ >= sync_interval_)
+        sync ();
+    if (idx + 1 == msgs_per_segment_)
+        _rollover ();
+
+    return (sizeof (value_type));
+}
+
+// ----------------------------------------------------------------------------
+
+template <class com_TYPE>
+bool PersistentQueue<com_TYPE>::
+_wait_for_writer (const struct timespec *timeout)  {
+
+    if (segment_ == NULL)  {
+        ::nanosleep (timeout, NULL);
+        return (false);
+    }
+
+   // Same protocol as BroadcastBus. The writer stores committed before it
+   // looks at waiters.
+   //
+    const   uint64_t    idx = next_seq_ - segment_num_ * msgs_per_segment_;
+
+    segment_->waiters.fetch_add (1, std::memory_order_seq_cst);
+
+    const   uint32_t    word =
+        segment_->futex_word.load (std::memory_order_seq_cst);
+    const   bool        ready =
+        segment_->committed.load (std::memory_order_seq_cst) > idx ||
+        segment_->sealed.load (std::memory_order_seq_cst) != 0;
+
+    if (! ready)
+        Futex::wait (segment_->futex_word, word, timeout);
+    segment_->waiters.fetch_sub (1, std::memory_order_seq_cst);
+    return (ready);
+}
+
+// ----------------------------------------------------------------------------
+
+template <class com_TYPE>
+typename PersistentQueue<com_TYPE>::size_type
+PersistentQueue<com_TYPE>::_try_pop (value_type &data)  {
+
+    while (true)  {
+        const   sequence_type   seg = next_seq_ / msgs_per_segment_;
+
+        if (segment_ == NULL || segment_num_ != seg)  {
+            if (! _map_segment (seg, false))  {
+                sequence_type   first = 0;
+                sequence_type   last = 0;
+
+                if (_scan_segments (first, last) && first > seg)  {
+                    next_seq_ = first * msgs_per_segment_;
+                    offset_->next_seq.store (next_seq_,
+                                             std::memory_order_release);
+                    continue;
+                }
+                return (static_cast<size_type>(_would_block_));
+            }
+        }
+
+        const   uint64_t    idx = next_seq_ - seg * msgs_per_segment_;
+
+        if (idx < segment_->committed.load (std::memory_order_acquire))  {
+            ::memcpy (&data, &(_records () [idx].data), sizeof (value_type));
+            next_seq_ += 1;
+            offset_->next_seq.store (next_seq_, std::memory_order_release);
+            return (sizeof (value_type));
+        }
+
+        return (static_cast<size_type>(_would_block_));
+    }
+}
+
+// ----------------------------------------------------------------------------
+
+template <class com_TYPE>
+typename PersistentQueue<com_TYPE>::size_type
+PersistentQueue<com_TYPE>::pop (value_type &data)  {
+
+    if (open_mode_ != _read_)
+        throw std::runtime_error ("PersistentQueue::pop(): "
+                                  "queue is opened for writing only.");
+
+    static  const   struct  timespec    timeout = { 0, 100000000 };  // 100ms
+
+    while (true)  {
+        const   size_type   ret = _try_pop (data);
+
+        if (ret != static_cast<size_type>(_would_block_) || ! is_blocking ())
+            return (ret);
+
+       // The timeout covers a writer that restarts and never touches the
+       // segment we are waiting on again.
+       //
+        _wait_for_writer (&timeout);
+    }
+}
+
+// ----------------------------------------------------------------------------
+
+template <class com_TYPE>
+typename PersistentQueue<com_TYPE>::size_type
+PersistentQueue<com_TYPE>::pop (value_type &data, WaitStrategy &strategy)  {
+
+    if (open_mode_ != _read_)
+        throw std::runtime_error ("PersistentQueue::pop(): "
+                                  "queue is opened for writing only.");
+
+    size_type   ret = static_cast<size_type>(_would_block_);
+
+    strategy.wait (
+        [this, &data, &ret] () -> bool  {
+            ret = _try_pop (data);
+            return (ret != static_cast<size_type>(_would_block_));
+        },
+        [this] (const struct timespec *timeout)  {
+            _wait_for_writer (timeout);
+        });
+
+    return (ret);
+}
+
+// ----------------------------------------------------------------------------
+
+template <class com_TYPE>
+typename PersistentQueue<com_TYPE>::size_type
+PersistentQueue<com_TYPE>::num_of_msgs_inq () const  {
+
+    sequence_type   first = 0;
+    sequence_type   last = 0;
+
+    if (! _scan_segments (first, last))
+        return (0);
+
+    sequence_type   written = last * msgs_per_segment_;
+
+    if (open_mode_ == _write_)
+        written = next_seq_;
+    else if (segment_ != NULL && segment_num_ == last)
+        written += segment_->committed.load (std::memory_order_acquire);
+    else  {
+        PathStr path;
+
+        _segment_path (path, last);
+
+        const   int fd = ::open (path.c_str (), O_RDONLY);
+
+        if (fd >= 0)  {
+            SegmentHeader   header;
+
+            if (::pread (fd, &header, sizeof (header), 0) ==
+                    static_cast<ssize_t>(sizeof (header)))
+                written += header.committed.load (std::memory_order_relaxed);
+            ::close (fd);
+        }
+    }
+
+    const   sequence_type   oldest = first * msgs_per_segment_;
+    const   sequence_type   from =
+        open_mode_ == _read_ && next_seq_ > oldest ? next_seq_ : oldest;
+
+    return (written > from ? static_cast<size_type>(written - from) : 0);
+}
+
+// ----------------------------------------------------------------------------
+
+template <class com_TYPE>
+void PersistentQueue<com_TYPE>::sync ()  {
+
+    if (segment_ != NULL &&
+        ::msync (segment_, _segment_size (), MS_SYNC) < 0)  {
+        DMScu_FixedSizeString<1023> err;
+
+        err.printf ("PersistentQueue::sync(): ::msync() (%d) %s",
+                    errno, strerror (errno));
+        throw std::runtime_error(err.c_str ());
+    }
+    if (offset_ != NULL &&
+        ::msync (offset_, sizeof (ConsumerOffset), MS_SYNC) < 0)  {
+        DMScu_FixedSizeString<1023> err;
+
+        err.printf ("PersistentQueue::sync(): ::msync() (%d) %s",
+                    errno, strerror (errno));
+        throw std::runtime_error(err.c_str ());
+    }
+
+    unsynced_ = 0;
+    return;
+}
+
+// ----------------------------------------------------------------------------
+
+template <class com_TYPE>
+void PersistentQueue<com_TYPE>::remove ()  {
+
+    disconnect ();
+
+    const   char    *name = get_name ();
+    const   char    *slash = ::strrchr (name, '/');
+    PathStr         dir_name;
+    PathStr         prefix;
+
+    if (slash == NULL)  {
+        dir_name = ".";
+        prefix = name;
+    }
+    else  {
+        dir_name.ncopy (name, slash == name ? 1 : slash - name);
+        prefix = slash + 1;
+    }
+    prefix += ".";
+
+    DIR *dir = ::opendir (dir_name.c_str ());
+
+    if (dir == NULL)  {
+        DMScu_FixedSizeString<1023> err;
+
+        err.printf ("PersistentQueue::remove(): "
+                    "::opendir('%s') (%d) %s",
+                    dir_name.c_str (), errno, strerror (errno));
+        throw std::runtime_error(err.c_str ());
+    }
+
+    const   size_t  prefix_len = prefix.size ();
+    PathStr         path;
+
+    for (const struct dirent *entry = ::readdir (dir); entry != NULL;
+         entry = ::readdir (dir))  {
+        const   char    *fname = entry->d_name;
+        const   size_t  len = ::strlen (fname);
+
+        if (::strncmp (fname, prefix.c_str (), prefix_len) || len < 4 ||
+            (::strcmp (fname + len - 4, ".seg") &&
+             ::strcmp (fname + len - 4, ".off")))
+            continue;
+
+        path = dir_name;
+        path += "/";
+        path += fname;
+        ::unlink (path.c_str ());
+    }
+
+    ::closedir (dir);
+    return;
+}
+
+} // namespace hmcom
+
+// ----------------------------------------------------------------------------
+
+// Local Variables:
+// mode:C++
+// tab-width:4
+// c-basic-offset:4
+// End:
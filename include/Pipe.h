@@ -5,10 +5,14 @@
 
 #pragma once
 
+#include <cerrno>
 #include <unistd.h>
+#include <fcntl.h>
+#include <sys/uio.h>
 #include <stdexcept>
 
 #include <Communication.h>
+#include <IOStatus.h>
 
 // ----------------------------------------------------------------------------
 
@@ -27,9 +31,13 @@ class   Pipe : public Communication  {
 
         enum SELECT_RESULT { _ready_, _exception_, _timedout_ };
 
-        inline explicit Pipe (const char *name = "") throw ()
+       // A non-zero capacity is applied with set_capacity() on connect()
+       //
+        inline explicit
+        Pipe (const char *name = "", size_type capacity = 0) throw ()
 		    : BaseClass (name),
-              filedes_ ()  {
+              filedes_ (),
+              capacity_ (capacity)  {
 
             filedes_ [0] = -1;
             filedes_ [1] = -1;
@@ -54,6 +62,21 @@ class   Pipe : public Communication  {
                 throw std::runtime_error(err.c_str ());
             }
 
+           // Unprivileged processes cannot go over pipe-max-size. Do not
+           // leak the fds of the failed connect().
+           //
+            if (capacity_ > 0)  {
+                try  {
+                    _set_capacity (capacity_);
+                }
+                catch (...)  {
+                    ::close (filedes_ [0]);
+                    ::close (filedes_ [1]);
+                    filedes_ [0] = -1;
+                    filedes_ [1] = -1;
+                    throw;
+                }
+            }
             return (true);
         }
 
@@ -142,32 +165,124 @@ class   Pipe : public Communication  {
 
         virtual int receive (void *data, size_type the_size)  {
 
+            return (try_receive (data, the_size).value ("Pipe::read()"));
+        }
+
+        virtual int send (const void *data, size_type the_size)  {
+
+            return (try_send (data, the_size).value ("Pipe::write()"));
+        }
+
+       // The same as receive() and send(), but a failure is returned
+       // instead of thrown. See IOStatus.
+       //
+        inline IOResult<size_type>
+        try_receive (void *data, size_type the_size) throw ()  {
+
+            const   LatencyStats::tick_type start = _latency_start ();
             const   int received_size = ::read (get_read_fd(), data, the_size);
 
-            if (received_size < 0)  {
+            if (received_size < 0)
+                return (IOStatus (IOStatus::_receive_, errno));
+
+            _latency_record (LatencyStats::_receive_, start, received_size);
+            return (static_cast<size_type>(received_size));
+        }
+
+        inline IOResult<size_type>
+        try_send (const void *data, size_type the_size) throw ()  {
+
+            const   LatencyStats::tick_type start = _latency_start ();
+            const   int sent_size = ::write (get_write_fd (), data, the_size);
+
+            if (sent_size < 0)
+                return (IOStatus (IOStatus::_send_, errno));
+
+            _latency_record (LatencyStats::_send_, start, sent_size);
+            return (static_cast<size_type>(sent_size));
+        }
+
+       // Sets the pipe buffer size with F_SETPIPE_SZ. The kernel rounds it
+       // up to a power of 2 pages and an unprivileged process cannot go
+       // over /proc/sys/fs/pipe-max-size. Returns the actual size.
+       //
+        inline size_type set_capacity (size_type capacity)  {
+
+            capacity_ = capacity;
+            return (is_connected () ? _set_capacity (capacity) : 0);
+        }
+        inline size_type get_capacity () const  {
+
+            const   int result = ::fcntl (get_write_fd (), F_GETPIPE_SZ);
+
+            if (result < 0)  {
                 DMScu_FixedSizeString<1023> err;
 
-                err.printf ("Pipe::read(): ::read(): (%d) %s",
+                err.printf ("Pipe::get_capacity(): ::fcntl(): (%d) %s",
                             errno, strerror (errno));
                 throw std::runtime_error(err.c_str ());
             }
 
-            return (received_size);
+            return (result);
         }
 
-        virtual int send (const void *data, size_type the_size)  {
+       // Maps the user pages of data into the pipe instead of copying them.
+       // The pages are referenced by the pipe until the reader consumes
+       // them, so data must not be modified or freed until then. Page
+       // aligned buffers that are multiples of the page size benefit most.
+       // Returns the number of bytes moved, which may be short of the_size
+       // if the pipe fills up, or _try_again_ with SPLICE_F_NONBLOCK.
+       //
+        inline int send_vmsplice (const void *data,
+                                  size_type the_size,
+                                  unsigned int flags = 0)  {
 
-            const   int sent_size = ::write (get_write_fd (), data, the_size);
+            struct  iovec   iov;
+
+            iov.iov_base = const_cast<void *>(data);
+            iov.iov_len = the_size;
+
+            const   ssize_t sent_size =
+                ::vmsplice (get_write_fd (), &iov, 1, flags);
 
             if (sent_size < 0)  {
+                if (errno == EAGAIN)
+                    return (_try_again_);
+
                 DMScu_FixedSizeString<1023> err;
 
-                err.printf ("Pipe::write(): ::write(): (%d) %s",
+                err.printf ("Pipe::send_vmsplice(): ::vmsplice(): (%d) %s",
                             errno, strerror (errno));
                 throw std::runtime_error(err.c_str ());
             }
 
-            return (sent_size);
+            return (static_cast<int>(sent_size));
+        }
+
+       // Moves up to the_size bytes from the pipe into fd (a socket, a file,
+       // another pipe ...) without copying them through user space. offset
+       // is used and advanced for a seekable fd, otherwise the fd offset is.
+       // Returns the number of bytes moved, 0 on EOF, or _try_again_ with
+       // SPLICE_F_NONBLOCK.
+       //
+        inline int splice_to (int fd,
+                              size_type the_size,
+                              loff_t *offset = NULL,
+                              unsigned int flags = SPLICE_F_MOVE)  {
+
+            return (_splice (get_read_fd (), NULL, fd, offset, the_size, flags,
+                             "Pipe::splice_to()"));
+        }
+
+       // Moves up to the_size bytes from fd into the pipe. Same as above
+       //
+        inline int splice_from (int fd,
+                                size_type the_size,
+                                loff_t *offset = NULL,
+                                unsigned int flags = SPLICE_F_MOVE)  {
+
+            return (_splice (fd, offset, get_write_fd (), NULL, the_size, flags,
+                             "Pipe::splice_from()"));
         }
 
         virtual int get_read_fd () const throw ()  { return (filedes_ [0]); }
@@ -177,7 +292,49 @@ class   Pipe : public Communication  {
 
     private:
 
-        int filedes_ [2];
+        inline size_type _set_capacity (size_type capacity)  {
+
+            const   int result =
+                ::fcntl (get_write_fd (), F_SETPIPE_SZ, capacity);
+
+            if (result < 0)  {
+                DMScu_FixedSizeString<1023> err;
+
+                err.printf ("Pipe::set_capacity(): ::fcntl(): (%d) %s",
+                            errno, strerror (errno));
+                throw std::runtime_error(err.c_str ());
+            }
+
+            return (result);
+        }
+
+        static inline int _splice (int fd_in,
+                                   loff_t *off_in,
+                                   int fd_out,
+                                   loff_t *off_out,
+                                   size_type the_size,
+                                   unsigned int flags,
+                                   const char *caller)  {
+
+            const   ssize_t moved_size =
+                ::splice (fd_in, off_in, fd_out, off_out, the_size, flags);
+
+            if (moved_size < 0)  {
+                if (errno == EAGAIN)
+                    return (_try_again_);
+
+                DMScu_FixedSizeString<1023> err;
+
+                err.printf ("%s: ::splice(): (%d) %s",
+                            caller, errno, strerror (errno));
+                throw std::runtime_error(err.c_str ());
+            }
+
+            return (static_cast<int>(moved_size));
+        }
+
+        int         filedes_ [2];
+        size_type   capacity_;
 
       // These are not implemented
       //
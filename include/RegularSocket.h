@@ -35,10 +35,25 @@ class   RegularSocket : public SocketBase  {
                          hostname_type,
                          hostname,
                          orientation)  {   }
+        inline RegularSocket (RegularSocket &&that) throw ()
+            : BaseClass (std::move (that))  {   }
+        inline RegularSocket &operator = (RegularSocket &&that)  {
+
+            BaseClass::operator = (std::move (that));
+            return (*this);
+        }
         inline virtual ~RegularSocket ()  {   }
 
         virtual int send (const void *data, size_type the_size);
         virtual int receive (void *data, size_type the_size);
+
+       // The same as send() and receive(), but a failure, including
+       // EAGAIN, is returned instead of thrown. See IOStatus.
+       //
+        IOResult<size_type>
+        try_send (const void *data, size_type the_size) throw ();
+        IOResult<size_type>
+        try_receive (void *data, size_type the_size) throw ();
 };
 
 } // namespace hmcom
@@ -103,23 +103,28 @@ class   Selector  {
 
             int max_fd = 0;
 
+           // Each fd is fetched once per object, since get_read_fd() and
+           // get_write_fd() are virtual
+           //
             for (CommunicationVector::const_iterator citr = comm_vec_.begin ();
                  citr != comm_vec_.end (); ++citr)  {
+                const   int read_fd = (*citr)->get_read_fd ();
+                const   int write_fd = (*citr)->get_write_fd ();
+
                 if (operation & _read_) {
-                    FD_SET ((*citr)->get_read_fd (), &readfds);
-                    if ((*citr)->get_read_fd () > max_fd)
-                        max_fd = (*citr)->get_read_fd ();
+                    FD_SET (read_fd, &readfds);
+                    if (read_fd > max_fd)
+                        max_fd = read_fd;
                     if (operation & _error_)
-                        FD_SET ((*citr)->get_read_fd (), &errorfds);
+                        FD_SET (read_fd, &errorfds);
                 }
 
                 if (operation & _write_) {
-                    FD_SET ((*citr)->get_write_fd (), &writefds);
-                    if ((*citr)->get_write_fd () > max_fd)
-                        max_fd = (*citr)->get_write_fd ();
-                    if (operation & _error_ &&
-                        (*citr)->get_write_fd () != (*citr)->get_read_fd ())
-                        FD_SET ((*citr)->get_write_fd (), &errorfds);
+                    FD_SET (write_fd, &writefds);
+                    if (write_fd > max_fd)
+                        max_fd = write_fd;
+                    if (operation & _error_ && write_fd != read_fd)
+                        FD_SET (write_fd, &errorfds);
                 }
             }
 
@@ -145,17 +150,21 @@ class   Selector  {
             result_vec_.reserve (4);
 
             for (CommunicationVector::const_iterator citr = comm_vec_.begin ();
-                 citr != comm_vec_.end (); ++citr)
-                if (FD_ISSET ((*citr)->get_read_fd (), &errorfds) ||
-                    FD_ISSET ((*citr)->get_write_fd (), &errorfds))
+                 citr != comm_vec_.end (); ++citr)  {
+                const   int read_fd = (*citr)->get_read_fd ();
+                const   int write_fd = (*citr)->get_write_fd ();
+
+                if (FD_ISSET (read_fd, &errorfds) ||
+                    FD_ISSET (write_fd, &errorfds))
                     result_vec_.push_back (SelectResult (*citr, _exception_));
-                else if (FD_ISSET ((*citr)->get_read_fd (), &writefds) &&
-                         FD_ISSET ((*citr)->get_write_fd (), &readfds))
+                else if (FD_ISSET (read_fd, &writefds) &&
+                         FD_ISSET (write_fd, &readfds))
                     result_vec_.push_back (SelectResult (*citr, _rw_ready_));
-                else if (FD_ISSET ((*citr)->get_write_fd (), &writefds))
+                else if (FD_ISSET (write_fd, &writefds))
                     result_vec_.push_back (SelectResult(*citr, _write_ready_));
-                else if (FD_ISSET ((*citr)->get_read_fd (), &readfds))
+                else if (FD_ISSET (read_fd, &readfds))
                     result_vec_.push_back (SelectResult (*citr, _read_ready_));
+            }
 
             return (true);
         }
@@ -0,0 +1,94 @@
+// Hossein Moein
+// March 25, 2018
+// Copyright (C) 2018-2019 Hossein Moein
+// Distributed under the BSD Software License (see file License)
+
+#pragma once
+
+#include <cerrno>
+#include <csignal>
+#include <ctime>
+#include <exception>
+
+#include <pthread.h>
+
+// ----------------------------------------------------------------------------
+
+namespace hmcom
+{
+
+// ::splice() and ::sendfile() into a socket whose peer is gone raise SIGPIPE,
+// which kills the process by default, and they have no MSG_NOSIGNAL. While
+// a SigPipeGuard is alive, SIGPIPE is blocked in the calling thread, so the
+// call fails with EPIPE instead. On destruction, the signal mask is restored
+// and errno is preserved. Blocking and restoring the mask are the only
+// syscalls on the success path. The SIGPIPE raised by a failed call is only
+// consumed if the guard goes out of scope with errno set to EPIPE, or by an
+// exception, e.g. the one that reports the EPIPE. If SIGPIPE was already
+// blocked in the thread, the guard changes nothing and leaves any SIGPIPE
+// pending for the caller, as the call would without the guard.
+//
+//     {
+//         SigPipeGuard    guard;
+//
+//         ret = ::sendfile (sock_fd, file_fd, &offset, length);
+//     }
+//
+class   SigPipeGuard  {
+
+    public:
+
+        inline SigPipeGuard () throw ()
+            : exceptions_ (std::uncaught_exceptions ()), was_blocked_ (true)  {
+
+            sigset_t    sigpipe;
+
+            ::sigemptyset (&sigpipe);
+            ::sigaddset (&sigpipe, SIGPIPE);
+            if (::pthread_sigmask (SIG_BLOCK, &sigpipe, &old_mask_) == 0)
+                was_blocked_ = ::sigismember (&old_mask_, SIGPIPE) == 1;
+        }
+
+        inline ~SigPipeGuard ()  {
+
+            if (was_blocked_)
+                return;
+
+            const   int saved_errno = errno;
+
+            if (saved_errno == EPIPE ||
+                std::uncaught_exceptions () > exceptions_)  {
+                static  const   struct  timespec    no_wait = { 0, 0 };
+                sigset_t                            sigpipe;
+
+                ::sigemptyset (&sigpipe);
+                ::sigaddset (&sigpipe, SIGPIPE);
+                while (::sigtimedwait (&sigpipe, NULL, &no_wait) < 0 &&
+                       errno == EINTR)
+                    ;
+            }
+            ::pthread_sigmask (SIG_SETMASK, &old_mask_, NULL);
+            errno = saved_errno;
+        }
+
+    private:
+
+        sigset_t    old_mask_;
+        const   int exceptions_;
+        bool        was_blocked_;
+
+       // These are not implemented
+       //
+        SigPipeGuard (const SigPipeGuard &);
+        SigPipeGuard &operator = (const SigPipeGuard &);
+};
+
+} // namespace hmcom
+
+// ----------------------------------------------------------------------------
+
+// Local Variables:
+// mode:C++
+// tab-width:4
+// c-basic-offset:4
+// End:
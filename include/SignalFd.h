@@ -0,0 +1,185 @@
+// Hossein Moein
+// March 25, 2018
+// Copyright (C) 2018-2019 Hossein Moein
+// Distributed under the BSD Software License (see file License)
+
+#pragma once
+
+#include <cerrno>
+#include <cstring>
+#include <csignal>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/signalfd.h>
+#include <unistd.h>
+
+#include <DMScu_FixedSizeString.h>
+
+#include <Communication.h>
+
+// ----------------------------------------------------------------------------
+
+namespace hmcom
+{
+
+// This class delivers signals through a file descriptor, so they can be
+// handled in a Selector loop instead of in a signal handler.
+//
+// connect() blocks the signals in the calling thread, otherwise they would
+// still go to their default disposition. Threads created before connect()
+// must block them too (or the signals must be blocked before any thread is
+// created). disconnect() does not unblock them.
+//
+class   SignalFd : public Communication  {
+
+    public:
+
+        typedef Communication               BaseClass;
+        typedef struct signalfd_siginfo     value_type;
+
+        inline explicit SignalFd (const char *name = "") throw ()
+            : BaseClass (name), fd_ (-1)  { sigemptyset (&mask_); }
+
+        inline ~SignalFd ()  { disconnect (); }
+
+       // Signals added after connect() take effect right away
+       //
+        inline void add_signal (int signum)  {
+
+            sigaddset (&mask_, signum);
+            if (is_connected ())
+                _set_mask ();
+        }
+
+       // Returns false if no signal is pending in non-blocking mode
+       //
+        inline bool read_signal (value_type &info)  {
+
+            if (::read (fd_, &info, sizeof (info)) < 0)  {
+                if (errno == EAGAIN)
+                    return (false);
+
+                DMScu_FixedSizeString<1023> err;
+
+                err.printf ("SignalFd::read_signal(): ::read(): (%d) %s",
+                            errno, strerror (errno));
+                throw std::runtime_error(err.c_str ());
+            }
+
+            return (true);
+        }
+
+        virtual int receive (void *data, size_type the_size)  {
+
+            if (the_size != sizeof (value_type))
+                return (_not_implemented_);
+            return (read_signal (*reinterpret_cast<value_type *>(data))
+                        ? static_cast<int>(sizeof (value_type))
+                        : static_cast<int>(_try_again_));
+        }
+
+        virtual int get_fd () const throw ()  { return (fd_); }
+        virtual TYPE get_type () const throw ()  { return (_signal_fd_); }
+
+    protected:
+
+        inline bool _connect_hook ()  {
+
+            if (is_connected ())
+                return (false);
+
+            _set_mask ();
+            return (true);
+        }
+
+        inline bool _disconnect_hook ()  {
+
+            if (! is_connected ())
+                return (false);
+
+            ::close (fd_);
+            fd_ = -1;
+            return (true);
+        }
+
+        inline bool _make_blocking_hook ()  {
+
+            return (_set_fd_flag (false));
+        }
+        inline bool _make_nonblocking_hook ()  {
+
+            return (_set_fd_flag (true));
+        }
+
+    private:
+
+        inline void _set_mask ()  {
+
+            const   int rc = ::pthread_sigmask (SIG_BLOCK, &mask_, NULL);
+
+            if (rc != 0)  {
+                DMScu_FixedSizeString<1023> err;
+
+                err.printf ("SignalFd::_set_mask(): "
+                            "::pthread_sigmask(): (%d) %s",
+                            rc, strerror (rc));
+                throw std::runtime_error(err.c_str ());
+            }
+
+            const   int fd =
+                ::signalfd (fd_, &mask_,
+                            SFD_CLOEXEC | (is_blocking () ? 0 : SFD_NONBLOCK));
+
+            if (fd < 0)  {
+                DMScu_FixedSizeString<1023> err;
+
+                err.printf ("SignalFd::_set_mask(): ::signalfd(): (%d) %s",
+                            errno, strerror (errno));
+                throw std::runtime_error(err.c_str ());
+            }
+
+            fd_ = fd;
+            return;
+        }
+
+        inline bool _set_fd_flag (bool nonblocking)  {
+
+            if (fd_ < 0)  // Applied on connect()
+                return (true);
+
+            const   int flags = ::fcntl (fd_, F_GETFL, 0);
+
+            if (flags < 0 ||
+                ::fcntl (fd_, F_SETFL,
+                         nonblocking ? flags | O_NONBLOCK
+                                     : flags & ~O_NONBLOCK) < 0)  {
+                DMScu_FixedSizeString<1023> err;
+
+                err.printf ("SignalFd::_set_fd_flag(): ::fcntl(): (%d) %s",
+                            errno, strerror (errno));
+                throw std::runtime_error(err.c_str ());
+            }
+
+            return (true);
+        }
+
+        int         fd_;
+        sigset_t    mask_;
+
+      // These are not implemented
+      //
+        SignalFd (const SignalFd &);
+        SignalFd &operator = (const SignalFd &);
+};
+
+} // namespace hmcom
+
+// ----------------------------------------------------------------------------
+
+// Local Variables:
+// mode:C++
+// tab-width:4
+// c-basic-offset:4
+// End:
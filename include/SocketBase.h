@@ -6,10 +6,12 @@
 #pragma once
 
 #include <netinet/in.h>
+#include <sys/types.h>
 
 #include <DMScu_FixedSizeString.h>
 
 #include <Communication.h>
+#include <IOStatus.h>
 
 // ----------------------------------------------------------------------------
 
@@ -56,6 +58,42 @@ class   SocketBase : public Communication  {
               hostname_ (hostname ? hostname : ""),
               orientation_ (orientation)  {   }
 
+       // A socket is moved, not copied. The fd goes with it, and the
+       // source is left disconnected, so its destructor does not close
+       // anything. The target's own connection, if any, is closed first.
+       //
+        inline SocketBase (SocketBase &&that) throw ()
+            : BaseClass (std::move (that)),
+              fd_ (that.fd_),
+              ip_address_type_ (that.ip_address_type_),
+              socket_type_ (that.socket_type_),
+              socket_rule_ (that.socket_rule_),
+              port_ (that.port_),
+              hostname_type_ (that.hostname_type_),
+              hostname_ (that.hostname_),
+              orientation_ (that.orientation_)  {
+
+            that.fd_ = -1;
+        }
+        inline SocketBase &operator = (SocketBase &&that)  {
+
+            if (this != &that)  {
+                if (is_connected ())
+                    disconnect ();
+                BaseClass::operator = (std::move (that));
+                fd_ = that.fd_;
+                ip_address_type_ = that.ip_address_type_;
+                socket_type_ = that.socket_type_;
+                socket_rule_ = that.socket_rule_;
+                port_ = that.port_;
+                hostname_type_ = that.hostname_type_;
+                hostname_ = that.hostname_;
+                orientation_ = that.orientation_;
+                that.fd_ = -1;
+            }
+            return (*this);
+        }
+
         inline virtual ~SocketBase ()  {
 
             if (is_connected ())
@@ -66,9 +104,26 @@ class   SocketBase : public Communication  {
         bool set_receive_buffer_size (int buf_size);
 
         int get_free_send_buffer_space ();
+        IOResult<int> try_free_send_buffer_space () throw ();
 
         bool disable_nagel_algorithm ();
 
+       // Sends length bytes of file_fd, starting at offset, with
+       // ::sendfile(). The file data does not go through user space.
+       // offset is advanced past what was sent. In blocking mode, it returns
+       // when all is sent or the file ends. In non-blocking mode, it sends
+       // until the socket buffer is full and returns what was sent so far,
+       // so the caller can resume from offset. A peer that is gone is an
+       // EPIPE error, not a SIGPIPE.
+       //
+        size_type send_file (int file_fd, off_t &offset, size_type length);
+
+       // The same as above, but a failure is returned instead of thrown.
+       // See IOStatus.
+       //
+        IOResult<size_type>
+        try_send_file (int file_fd, off_t &offset, size_type length) throw ();
+
         inline IP_ADDRESS_TYPE get_ip_address_type () const throw ()  {
 
             return (ip_address_type_);
@@ -125,14 +180,16 @@ class   SocketBase : public Communication  {
 
     private:
 
-        int                     fd_;
-        const   IP_ADDRESS_TYPE ip_address_type_;
-        const   SOCKET_TYPE     socket_type_;
-        const   SOCKET_RULE     socket_rule_;
-        const   in_port_t       port_;
-        const   HOSTNAME_TYPE   hostname_type_;
-        const   HostNameStr     hostname_;
-        const   ORIENTATION     orientation_;
+       // Not const, only so sockets can be move assigned
+       //
+        int             fd_;
+        IP_ADDRESS_TYPE ip_address_type_;
+        SOCKET_TYPE     socket_type_;
+        SOCKET_RULE     socket_rule_;
+        in_port_t       port_;
+        HOSTNAME_TYPE   hostname_type_;
+        HostNameStr     hostname_;
+        ORIENTATION     orientation_;
 
     public:
 
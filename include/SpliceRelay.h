@@ -0,0 +1,144 @@
+// Hossein Moein
+// March 25, 2018
+// Copyright (C) 2018-2019 Hossein Moein
+// Distributed under the BSD Software License (see file License)
+
+#pragma once
+
+#include <SocketBase.h>
+#include <Pipe.h>
+
+// ----------------------------------------------------------------------------
+
+namespace hmcom
+{
+
+// This class forwards everything read from a source socket to a destination
+// socket through a pipe with splice(), so the payload never crosses user
+// space.
+//
+// relay() moves as much as it can without blocking and returns. It is meant
+// to be driven by a readiness loop: get_read_fd() is the source and
+// get_write_fd() is the destination, so a relay can be added to a Selector.
+// wants_read() and wants_write() tell which side is worth waiting on. The
+// pipe is the only buffer. While the pipe is full, nothing more is read from
+// the source, so a slow destination pushes back on the source through TCP
+// flow control.
+//
+// A failed splice() throws, the same as Pipe::splice_to(). SIGPIPE is
+// blocked while relay() runs, so a destination whose peer is gone throws
+// with EPIPE instead of killing the process.
+//
+// NOTE: Both sockets must be in non-blocking mode, otherwise relay() can
+//       block in splice() on either of them. The relay does not own the
+//       sockets.
+//
+class   SpliceRelay : public Communication  {
+
+    public:
+
+        typedef Communication   BaseClass;
+        typedef unsigned long long int  counter_type;
+
+        enum RET_TYPE { _closed_ = -3 };
+
+       // A non-zero pipe_capacity is applied to the pipe with F_SETPIPE_SZ
+       //
+        SpliceRelay (const char *name,
+                     SocketBase &source,
+                     SocketBase &destination,
+                     size_type pipe_capacity = 0,
+                     size_type chunk_size = 64 * 1024) throw ()
+            : BaseClass (name),
+              source_ (source),
+              destination_ (destination),
+              pipe_ (name, pipe_capacity),
+              pipe_capacity_ (0),
+              chunk_size_ (chunk_size),
+              source_eof_ (false),
+              bytes_in_ (0),
+              bytes_out_ (0),
+              splices_ (0)  {   }
+
+        virtual ~SpliceRelay ()  { disconnect (); }
+
+       // Returns the number of bytes written to the destination by this
+       // call, or _closed_ once the source is at EOF and everything read
+       // from it has been written to the destination.
+       //
+        int relay ();
+
+        inline bool wants_read () const throw ()  {
+
+            return (! source_eof_ && get_pending () < pipe_capacity_);
+        }
+        inline bool wants_write () const throw ()  {
+
+            return (get_pending () > 0);
+        }
+
+       // Bytes read from the source, bytes written to the destination and
+       // bytes sitting in the pipe in between
+       //
+        inline counter_type get_bytes_in () const throw ()  {
+
+            return (bytes_in_);
+        }
+        inline counter_type get_bytes_out () const throw ()  {
+
+            return (bytes_out_);
+        }
+        inline counter_type get_pending () const throw ()  {
+
+            return (bytes_in_ - bytes_out_);
+        }
+        inline counter_type get_splices () const throw ()  {
+
+            return (splices_);
+        }
+        inline bool is_source_eof () const throw ()  { return (source_eof_); }
+
+        virtual int get_read_fd () const throw ()  {
+
+            return (source_.get_fd ());
+        }
+        virtual int get_write_fd () const throw ()  {
+
+            return (destination_.get_fd ());
+        }
+
+        virtual TYPE get_type () const throw ()  { return (_splice_relay_); }
+
+    protected:
+
+        virtual bool _connect_hook ();
+        virtual bool _disconnect_hook ();
+
+    private:
+
+        SocketBase          &source_;
+        SocketBase          &destination_;
+        Pipe                pipe_;
+        size_type           pipe_capacity_;
+        const   size_type   chunk_size_;
+        bool                source_eof_;
+        counter_type        bytes_in_;
+        counter_type        bytes_out_;
+        counter_type        splices_;
+
+       // These are not implemented
+       //
+        SpliceRelay ();
+        SpliceRelay (const SpliceRelay &);
+        SpliceRelay &operator = (const SpliceRelay &);
+};
+
+} // namespace hmcom
+
+// ----------------------------------------------------------------------------
+
+// Local Variables:
+// mode:C++
+// tab-width:4
+// c-basic-offset:4
+// End:
@@ -0,0 +1,400 @@
+// Hossein Moein
+// March 25, 2018
+// Copyright (C) 2018-2019 Hossein Moein
+// Distributed under the BSD Software License (see file License)
+
+#pragma once
+
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <utility>
+
+#include <Communication.h>
+#include <IOStatus.h>
+
+// ----------------------------------------------------------------------------
+
+namespace hmcom
+{
+
+// The transports in this file are the compile time counterparts of
+// RegularSocket and Pipe. Nothing in them is virtual. A transport derives
+// from StaticCommunication<itself> and implements
+//
+//     IOResult<size_type> try_send (const void *data, size_type the_size);
+//     IOResult<size_type> try_receive (void *data, size_type the_size);
+//     int get_read_fd () const;
+//     int get_write_fd () const;
+//
+// and gets send(), receive() and the blocking mode from the base. Code that
+// is a template on the transport inlines all of it, e.g.
+//
+//     template<class T>
+//     void pump (T &from, T &to)  {
+//         ...
+//         to.send (buffer, from.receive (buffer, sizeof (buffer)));
+//     }
+//
+// CommunicationAdapter below wraps a transport in a Communication, for
+// Selector and other code that takes a Communication *.
+//
+template<class com_DERIVED>
+class   StaticCommunication  {
+
+    public:
+
+        typedef Communication::size_type    size_type;
+
+       // These throw on a failure, like Communication::send() and
+       // receive(). In non-blocking mode, EAGAIN returns _try_again_.
+       //
+        inline int send (const void *data, size_type the_size)  {
+
+            const   IOResult<size_type> result =
+                _derived ().try_send (data, the_size);
+
+            if (! result.ok ())  {
+                if (! blocking_ && result.would_block ())
+                    return (Communication::_try_again_);
+                result.status ().throw_error ("StaticCommunication::send()");
+            }
+
+            return (static_cast<int>(*result));
+        }
+        inline int receive (void *data, size_type the_size)  {
+
+            const   IOResult<size_type> result =
+                _derived ().try_receive (data, the_size);
+
+            if (! result.ok ())  {
+                if (! blocking_ && result.would_block ())
+                    return (Communication::_try_again_);
+                result.status ().throw_error (
+                    "StaticCommunication::receive()");
+            }
+
+            return (static_cast<int>(*result));
+        }
+
+        inline bool is_blocking () const throw ()  { return (blocking_); }
+
+        inline IOStatus make_blocking () throw ()  {
+
+            return (_set_blocking (true));
+        }
+        inline IOStatus make_nonblocking () throw ()  {
+
+            return (_set_blocking (false));
+        }
+
+    protected:
+
+        inline StaticCommunication () throw () : blocking_ (true)  {   }
+        inline StaticCommunication (StaticCommunication &&that) throw ()
+            : blocking_ (that.blocking_)  {   }
+        inline StaticCommunication &
+        operator = (StaticCommunication &&that) throw ()  {
+
+            blocking_ = that.blocking_;
+            return (*this);
+        }
+        inline ~StaticCommunication ()  {   }
+
+    private:
+
+        inline com_DERIVED &_derived () throw ()  {
+
+            return (static_cast<com_DERIVED &>(*this));
+        }
+        inline const com_DERIVED &_derived () const throw ()  {
+
+            return (static_cast<const com_DERIVED &>(*this));
+        }
+
+        inline IOStatus _set_blocking (bool blocking) throw ()  {
+
+            const   int fds [2] = { _derived ().get_read_fd (),
+                                    _derived ().get_write_fd () };
+
+            for (int i = 0; i < (fds [0] == fds [1] ? 1 : 2); ++i)  {
+                const   int flags = ::fcntl (fds [i], F_GETFL);
+
+                if (flags < 0 ||
+                    ::fcntl (fds [i], F_SETFL,
+                             blocking ? flags & ~O_NONBLOCK
+                                      : flags | O_NONBLOCK) < 0)
+                    return (IOStatus (IOStatus::_file_control_, errno));
+            }
+
+            blocking_ = blocking;
+            return (IOStatus ());
+        }
+
+        bool    blocking_;
+
+       // These are not implemented
+       //
+        StaticCommunication (const StaticCommunication &);
+        StaticCommunication &operator = (const StaticCommunication &);
+};
+
+// ----------------------------------------------------------------------------
+
+// A connected socket, stream or datagram. It owns the fd it is given, e.g.
+// one that is accept()'ed or made with ::socketpair(), and closes it on
+// destruction unless it is release()'d first. It can be moved, not
+// copied, so sockets can be kept by value in a std::vector.
+//
+class   StaticSocket : public StaticCommunication<StaticSocket>  {
+
+    public:
+
+        typedef StaticCommunication<StaticSocket>   BaseClass;
+
+        inline explicit StaticSocket (int fd = -1) throw () : fd_ (fd)  {   }
+        inline StaticSocket (StaticSocket &&that) throw ()
+            : BaseClass (std::move (that)), fd_ (that.release ())  {   }
+        inline StaticSocket &operator = (StaticSocket &&that) throw ()  {
+
+            if (this != &that)  {
+                close ();
+                BaseClass::operator = (std::move (that));
+                fd_ = that.release ();
+            }
+            return (*this);
+        }
+        inline ~StaticSocket ()  { close (); }
+
+        inline IOResult<size_type>
+        try_send (const void *data, size_type the_size) throw ()  {
+
+            const   ssize_t sent_size =
+                ::send (fd_, data, the_size, MSG_NOSIGNAL);
+
+            if (sent_size < 0)
+                return (IOStatus (IOStatus::_send_, errno));
+
+            return (static_cast<size_type>(sent_size));
+        }
+        inline IOResult<size_type>
+        try_receive (void *data, size_type the_size) throw ()  {
+
+            const   ssize_t received_size = ::recv (fd_, data, the_size, 0);
+
+            if (received_size < 0)
+                return (IOStatus (IOStatus::_receive_, errno));
+
+            return (static_cast<size_type>(received_size));
+        }
+
+        inline int get_fd () const throw ()  { return (fd_); }
+        inline int get_read_fd () const throw ()  { return (fd_); }
+        inline int get_write_fd () const throw ()  { return (fd_); }
+
+        static inline Communication::TYPE get_type () throw ()  {
+
+            return (Communication::_socket_);
+        }
+
+        inline bool is_open () const throw ()  { return (fd_ >= 0); }
+        inline void close () throw ()  {
+
+            if (fd_ >= 0)  {
+                ::close (fd_);
+                fd_ = -1;
+            }
+        }
+
+       // Gives up the fd without closing it
+       //
+        inline int release () throw ()  {
+
+            const   int fd = fd_;
+
+            fd_ = -1;
+            return (fd);
+        }
+
+    private:
+
+        int fd_;
+
+       // These are not implemented
+       //
+        StaticSocket (const StaticSocket &);
+        StaticSocket &operator = (const StaticSocket &);
+};
+
+// ----------------------------------------------------------------------------
+
+class   StaticPipe : public StaticCommunication<StaticPipe>  {
+
+    public:
+
+        inline StaticPipe () throw ()  {
+
+            filedes_ [0] = -1;
+            filedes_ [1] = -1;
+        }
+        inline ~StaticPipe ()  { close (); }
+
+        inline IOStatus open () throw ()  {
+
+            if (is_open ())
+                return (IOStatus (IOStatus::_open_, EBUSY));
+            if (::pipe (filedes_) < 0)
+                return (IOStatus (IOStatus::_open_, errno));
+            return (IOStatus ());
+        }
+
+        inline IOResult<size_type>
+        try_send (const void *data, size_type the_size) throw ()  {
+
+            const   ssize_t sent_size =
+                ::write (filedes_ [1], data, the_size);
+
+            if (sent_size < 0)
+                return (IOStatus (IOStatus::_send_, errno));
+
+            return (static_cast<size_type>(sent_size));
+        }
+        inline IOResult<size_type>
+        try_receive (void *data, size_type the_size) throw ()  {
+
+            const   ssize_t received_size =
+                ::read (filedes_ [0], data, the_size);
+
+            if (received_size < 0)
+                return (IOStatus (IOStatus::_receive_, errno));
+
+            return (static_cast<size_type>(received_size));
+        }
+
+        inline int get_read_fd () const throw ()  { return (filedes_ [0]); }
+        inline int get_write_fd () const throw ()  { return (filedes_ [1]); }
+
+        static inline Communication::TYPE get_type () throw ()  {
+
+            return (Communication::_pipe_);
+        }
+
+        inline bool is_open () const throw ()  { return (filedes_ [0] >= 0); }
+        inline void close () throw ()  {
+
+            if (filedes_ [0] >= 0)  {
+                ::close (filedes_ [0]);
+                ::close (filedes_ [1]);
+                filedes_ [0] = -1;
+                filedes_ [1] = -1;
+            }
+        }
+
+    private:
+
+        int filedes_ [2];
+
+       // These are not implemented
+       //
+        StaticPipe (const StaticPipe &);
+        StaticPipe &operator = (const StaticPipe &);
+};
+
+// ----------------------------------------------------------------------------
+
+// Makes a static transport look like a Communication. The transport is
+// referenced, not owned, and it is opened and closed on its own, so
+// connect() and disconnect() only flip the connected flag. Calls through
+// the adapter are virtual again, so keep it to the places that need a
+// Communication, e.g.
+//
+//     StaticSocket                         socket (fd);
+//     CommunicationAdapter<StaticSocket>   adapter (socket, "feed");
+//
+//     selector.add_communication (&adapter);
+//
+template<class com_TRANSPORT>
+class   CommunicationAdapter : public Communication  {
+
+    public:
+
+        typedef Communication   BaseClass;
+        typedef com_TRANSPORT   transport_type;
+
+        inline explicit
+        CommunicationAdapter (transport_type &transport,
+                              const char *name = "") throw ()
+            : BaseClass (name), transport_ (transport)  {
+
+            set_connected (transport.is_open ());
+            _set_blocking (transport.is_blocking ());
+        }
+        inline virtual ~CommunicationAdapter ()  {   }
+
+        virtual int send (const void *data, size_type the_size)  {
+
+            return (transport_.send (data, the_size));
+        }
+        virtual int receive (void *data, size_type the_size)  {
+
+            return (transport_.receive (data, the_size));
+        }
+
+        virtual int get_fd () const throw ()  {
+
+            return (transport_.get_read_fd ());
+        }
+        virtual int get_read_fd () const throw ()  {
+
+            return (transport_.get_read_fd ());
+        }
+        virtual int get_write_fd () const throw ()  {
+
+            return (transport_.get_write_fd ());
+        }
+
+        virtual TYPE get_type () const throw ()  {
+
+            return (transport_type::get_type ());
+        }
+
+        inline transport_type &get_transport () const throw ()  {
+
+            return (transport_);
+        }
+
+    protected:
+
+        virtual bool _connect_hook ()  { return (transport_.is_open ()); }
+        virtual bool _disconnect_hook ()  { return (true); }
+
+        virtual bool _make_blocking_hook ()  {
+
+            return (transport_.make_blocking ().ok ());
+        }
+        virtual bool _make_nonblocking_hook ()  {
+
+            return (transport_.make_nonblocking ().ok ());
+        }
+
+    private:
+
+        transport_type  &transport_;
+
+       // These are not implemented
+       //
+        CommunicationAdapter (const CommunicationAdapter &);
+        CommunicationAdapter &operator = (const CommunicationAdapter &);
+};
+
+} // namespace hmcom
+
+// ----------------------------------------------------------------------------
+
+// Local Variables:
+// mode:C++
+// tab-width:4
+// c-basic-offset:4
+// End:
@@ -0,0 +1,204 @@
+// Hossein Moein
+// March 25, 2018
+// Copyright (C) 2018-2019 Hossein Moein
+// Distributed under the BSD Software License (see file License)
+
+#pragma once
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include <DMScu_FixedSizeString.h>
+
+#include <Communication.h>
+
+// ----------------------------------------------------------------------------
+
+namespace hmcom
+{
+
+// This class is a timer that is delivered through a file descriptor, so it
+// can be waited on in the same Selector as sockets, instead of on its own
+// thread. The fd becomes readable when the timer expires. expirations()
+// returns the number of expirations since the last call.
+//
+class   TimerFd : public Communication  {
+
+    public:
+
+        typedef Communication   BaseClass;
+        typedef uint64_t        value_type;
+
+        inline explicit
+        TimerFd (const char *name = "",
+                 clockid_t clock_id = CLOCK_MONOTONIC) throw ()
+            : BaseClass (name), fd_ (-1), clock_id_ (clock_id)  {   }
+
+        inline ~TimerFd ()  { disconnect (); }
+
+       // The timer first expires after initial_usec and then every
+       // interval_usec. An interval of 0 makes it a one-shot timer.
+       //
+        inline void start (long long int initial_usec,
+                           long long int interval_usec = 0)  {
+
+            struct  itimerspec  spec;
+
+            spec.it_value.tv_sec = initial_usec / 1000000LL;
+            spec.it_value.tv_nsec = (initial_usec % 1000000LL) * 1000LL;
+            spec.it_interval.tv_sec = interval_usec / 1000000LL;
+            spec.it_interval.tv_nsec = (interval_usec % 1000000LL) * 1000LL;
+
+           // A zero it_value would disarm the timer
+           //
+            if (spec.it_value.tv_sec == 0 && spec.it_value.tv_nsec == 0)
+                spec.it_value.tv_nsec = 1;
+            _set_time (spec);
+        }
+        inline void stop ()  {
+
+            struct  itimerspec  spec;
+
+            ::memset (&spec, 0, sizeof (spec));
+            _set_time (spec);
+        }
+
+       // Returns 0 if the timer has not expired in non-blocking mode
+       //
+        inline value_type expirations ()  {
+
+            value_type  value = 0;
+
+            if (::read (fd_, &value, sizeof (value)) < 0)  {
+                if (errno == EAGAIN)
+                    return (0);
+
+                DMScu_FixedSizeString<1023> err;
+
+                err.printf ("TimerFd::expirations(): ::read(): (%d) %s",
+                            errno, strerror (errno));
+                throw std::runtime_error(err.c_str ());
+            }
+
+            return (value);
+        }
+
+        virtual int receive (void *data, size_type the_size)  {
+
+            if (the_size != sizeof (value_type))
+                return (_not_implemented_);
+
+            const   value_type  value = expirations ();
+
+            *reinterpret_cast<value_type *>(data) = value;
+            return (value > 0
+                        ? static_cast<int>(sizeof (value_type))
+                        : static_cast<int>(_try_again_));
+        }
+
+        virtual int get_fd () const throw ()  { return (fd_); }
+        virtual TYPE get_type () const throw ()  { return (_timer_fd_); }
+
+    protected:
+
+        inline bool _connect_hook ()  {
+
+            if (is_connected ())
+                return (false);
+
+            fd_ = ::timerfd_create (clock_id_,
+                                    TFD_CLOEXEC |
+                                        (is_blocking () ? 0 : TFD_NONBLOCK));
+            if (fd_ < 0)  {
+                DMScu_FixedSizeString<1023> err;
+
+                err.printf ("TimerFd::_connect_hook(): "
+                            "::timerfd_create(): (%d) %s",
+                            errno, strerror (errno));
+                throw std::runtime_error(err.c_str ());
+            }
+
+            return (true);
+        }
+
+        inline bool _disconnect_hook ()  {
+
+            if (! is_connected ())
+                return (false);
+
+            ::close (fd_);
+            fd_ = -1;
+            return (true);
+        }
+
+        inline bool _make_blocking_hook ()  {
+
+            return (_set_fd_flag (false));
+        }
+        inline bool _make_nonblocking_hook ()  {
+
+            return (_set_fd_flag (true));
+        }
+
+    private:
+
+        inline void _set_time (const struct itimerspec &spec)  {
+
+            if (::timerfd_settime (fd_, 0, &spec, NULL) < 0)  {
+                DMScu_FixedSizeString<1023> err;
+
+                err.printf ("TimerFd::_set_time(): "
+                            "::timerfd_settime(): (%d) %s",
+                            errno, strerror (errno));
+                throw std::runtime_error(err.c_str ());
+            }
+
+            return;
+        }
+
+        inline bool _set_fd_flag (bool nonblocking)  {
+
+            if (fd_ < 0)  // Applied on connect()
+                return (true);
+
+            const   int flags = ::fcntl (fd_, F_GETFL, 0);
+
+            if (flags < 0 ||
+                ::fcntl (fd_, F_SETFL,
+                         nonblocking ? flags | O_NONBLOCK
+                                     : flags & ~O_NONBLOCK) < 0)  {
+                DMScu_FixedSizeString<1023> err;
+
+                err.printf ("TimerFd::_set_fd_flag(): ::fcntl(): (%d) %s",
+                            errno, strerror (errno));
+                throw std::runtime_error(err.c_str ());
+            }
+
+            return (true);
+        }
+
+        int                 fd_;
+        const   clockid_t   clock_id_;
+
+      // These are not implemented
+      //
+        TimerFd (const TimerFd &);
+        TimerFd &operator = (const TimerFd &);
+};
+
+} // namespace hmcom
+
+// ----------------------------------------------------------------------------
+
+// Local Variables:
+// mode:C++
+// tab-width:4
+// c-basic-offset:4
+// End:
@@ -0,0 +1,172 @@
+// Hossein Moein
+// March 25, 2018
+// Copyright (C) 2018-2019 Hossein Moein
+// Distributed under the BSD Software License (see file License)
+
+#pragma once
+
+#include <climits>
+#include <ctime>
+
+#include <sched.h>
+
+// ----------------------------------------------------------------------------
+
+namespace hmcom
+{
+
+// This class is how a consumer waits for a queue to become non-empty. It
+// goes through up to four stages, each with its own limit:
+//
+//     spin:  Busy loop re-checking the queue
+//     pause: Busy loop with a CPU pause between checks. This is kinder to
+//            the sibling hyper-thread and to the memory bus
+//     yield: sched_yield() between checks
+//     park:  Sleep in the kernel (futex, poll(), ...) for up to park_timeout
+//            at a time, until the queue wakes us up or the time is up
+//
+// A limit of 0 skips a stage. A spin limit of UINT_MAX never leaves the spin
+// stage. So a latency sensitive consumer can stay hot, and a background
+// consumer can give its core back right away.
+//
+// Each consumer should have its own instance. The counters show how far the
+// waits of that consumer had to go.
+//
+class   WaitStrategy  {
+
+    public:
+
+        typedef unsigned int            size_type;
+        typedef unsigned long long int  counter_type;
+
+        struct  Counters  {
+
+            counter_type    waits;       // Number of wait() calls
+            counter_type    spin_hits;   // Satisfied in the spin stage
+            counter_type    pause_hits;  // Satisfied in the pause stage
+            counter_type    yield_hits;  // Satisfied in the yield stage
+            counter_type    park_hits;   // Satisfied in the park stage
+            counter_type    parks;       // Number of times the park ran
+        };
+
+        inline explicit
+        WaitStrategy (size_type spin_limit = 128,
+                      size_type pause_limit = 1024,
+                      size_type yield_limit = 64,
+                      long park_timeout_usec = 1000) throw ()
+            : spin_limit_ (spin_limit),
+              pause_limit_ (pause_limit),
+              yield_limit_ (yield_limit),
+              counters_ ()  {
+
+            park_timeout_.tv_sec = park_timeout_usec / 1000000L;
+            park_timeout_.tv_nsec = (park_timeout_usec % 1000000L) * 1000L;
+        }
+
+        static inline WaitStrategy busy_spin () throw ()  {
+
+            return (WaitStrategy (UINT_MAX, 0, 0));
+        }
+        static inline WaitStrategy low_latency () throw ()  {
+
+            return (WaitStrategy (1024, 16384, 256, 100));
+        }
+        static inline WaitStrategy background () throw ()  {
+
+            return (WaitStrategy (0, 0, 0, 100000));
+        }
+
+       // ready is a callable returning true when the wait is over. It is
+       // expected to do the actual non-blocking dequeue, so it should stop
+       // being called as soon as it returns true.
+       // park is a callable taking a const struct timespec * timeout. It
+       // should sleep until the producer signals or the timeout expires.
+       //
+        template<class READY, class PARK>
+        inline void wait (READY ready, PARK park)  {
+
+            counters_.waits += 1;
+
+            for (size_type i = 0; i < spin_limit_ || spin_limit_ == UINT_MAX;
+                 ++i)
+                if (ready ())  {
+                    counters_.spin_hits += 1;
+                    return;
+                }
+
+            for (size_type i = 0; i < pause_limit_; ++i)  {
+                cpu_relax ();
+                if (ready ())  {
+                    counters_.pause_hits += 1;
+                    return;
+                }
+            }
+
+            for (size_type i = 0; i < yield_limit_; ++i)  {
+                ::sched_yield ();
+                if (ready ())  {
+                    counters_.yield_hits += 1;
+                    return;
+                }
+            }
+
+            while (true)  {
+                counters_.parks += 1;
+                park (&park_timeout_);
+                if (ready ())  {
+                    counters_.park_hits += 1;
+                    return;
+                }
+            }
+        }
+
+        inline const Counters &get_counters () const throw ()  {
+
+            return (counters_);
+        }
+        inline void reset_counters () throw ()  { counters_ = Counters (); }
+
+        inline size_type get_spin_limit () const throw ()  {
+
+            return (spin_limit_);
+        }
+        inline size_type get_pause_limit () const throw ()  {
+
+            return (pause_limit_);
+        }
+        inline size_type get_yield_limit () const throw ()  {
+
+            return (yield_limit_);
+        }
+        inline const struct timespec &get_park_timeout () const throw ()  {
+
+            return (park_timeout_);
+        }
+
+        static inline void cpu_relax () throw ()  {
+
+#if defined (__x86_64__) || defined (__i386__)
+            __builtin_ia32_pause ();
+#elif defined (__aarch64__)
+            asm volatile ("yield" ::: "memory");
+#endif // defined (__x86_64__) || defined (__i386__)
+        }
+
+    private:
+
+        size_type       spin_limit_;
+        size_type       pause_limit_;
+        size_type       yield_limit_;
+        struct timespec park_timeout_;
+        Counters        counters_;
+};
+
+} // namespace hmcom
+
+// ----------------------------------------------------------------------------
+
+// Local Variables:
+// mode:C++
+// tab-width:4
+// c-basic-offset:4
+// End:
@@ -10,27 +10,72 @@ PROJECT_INCLUDE_DIR = ../../include
 
 # -----------------------------------------------------------------------------
 
-SRCS = SocketBase.cc \
+SRCS = IOStatus.cc \
+       LatencyStats.cc \
+       SocketBase.cc \
+       ConnectionTable.cc \
        RegularSocket.cc \
+       Framer.cc \
+       SpliceRelay.cc \
        socket_tester.cc \
-       messageq_tester.cc
+       messageq_tester.cc \
+       shmem_tester.cc \
+       persistq_tester.cc \
+       inproc_tester.cc \
+       pipe_tester.cc \
+       relay_tester.cc \
+       sendfile_tester.cc \
+       fd_tester.cc \
+       static_tester.cc \
+       conntable_tester.cc \
+       latency_tester.cc
 HEADERS = $(LOCAL_INCLUDE_DIR)/Communication.h \
+          $(LOCAL_INCLUDE_DIR)/LatencyStats.h \
+          $(LOCAL_INCLUDE_DIR)/IOStatus.h \
           $(LOCAL_INCLUDE_DIR)/SocketBase.h \
+          $(LOCAL_INCLUDE_DIR)/SigPipeGuard.h \
           $(LOCAL_INCLUDE_DIR)/Selector.h \
+          $(LOCAL_INCLUDE_DIR)/StaticCommunication.h \
           $(LOCAL_INCLUDE_DIR)/Pipe.h \
+          $(LOCAL_INCLUDE_DIR)/EventFd.h \
+          $(LOCAL_INCLUDE_DIR)/TimerFd.h \
+          $(LOCAL_INCLUDE_DIR)/SignalFd.h \
           $(LOCAL_INCLUDE_DIR)/RegularSocket.h \
           $(LOCAL_INCLUDE_DIR)/FixedSizeSocket.h \
+          $(LOCAL_INCLUDE_DIR)/Framer.h \
+          $(LOCAL_INCLUDE_DIR)/SpliceRelay.h \
           $(LOCAL_INCLUDE_DIR)/Acceptor.h \
           $(LOCAL_INCLUDE_DIR)/Acceptor.tcc \
+          $(LOCAL_INCLUDE_DIR)/ConnectionTable.h \
           $(LOCAL_INCLUDE_DIR)/MessageQueue.h \
-          $(LOCAL_INCLUDE_DIR)/MessageQueue.tcc
+          $(LOCAL_INCLUDE_DIR)/MessageQueue.tcc \
+          $(LOCAL_INCLUDE_DIR)/Futex.h \
+          $(LOCAL_INCLUDE_DIR)/WaitStrategy.h \
+          $(LOCAL_INCLUDE_DIR)/BroadcastBus.h \
+          $(LOCAL_INCLUDE_DIR)/BroadcastBus.tcc \
+          $(LOCAL_INCLUDE_DIR)/LatestValueCache.h \
+          $(LOCAL_INCLUDE_DIR)/LatestValueCache.tcc \
+          $(LOCAL_INCLUDE_DIR)/PersistentQueue.h \
+          $(LOCAL_INCLUDE_DIR)/PersistentQueue.tcc \
+          $(LOCAL_INCLUDE_DIR)/InProcChannel.h \
+          $(LOCAL_INCLUDE_DIR)/InProcChannel.tcc
 
 LIB_NAME = Comm
 TARGET_LIB = $(LOCAL_LIB_DIR)/lib$(LIB_NAME).a
 
 TARGETS = $(TARGET_LIB) \
           $(LOCAL_BIN_DIR)/socket_tester \
-          $(LOCAL_BIN_DIR)/messageq_tester
+          $(LOCAL_BIN_DIR)/messageq_tester \
+          $(LOCAL_BIN_DIR)/shmem_tester \
+          $(LOCAL_BIN_DIR)/persistq_tester \
+          $(LOCAL_BIN_DIR)/inproc_tester \
+          $(LOCAL_BIN_DIR)/pipe_tester \
+          $(LOCAL_BIN_DIR)/relay_tester \
+          $(LOCAL_BIN_DIR)/sendfile_tester \
+          $(LOCAL_BIN_DIR)/fd_tester \
+          $(LOCAL_BIN_DIR)/static_tester \
+          $(LOCAL_BIN_DIR)/conntable_tester \
+          $(LOCAL_BIN_DIR)/latency_tester
 
 # -----------------------------------------------------------------------------
 
@@ -45,9 +90,14 @@ DEFINES = -D_REENTRANT -DDMS_INCLUDE_SOURCE \
 
 # object file
 #
-LIB_OBJS = $(LOCAL_OBJ_DIR)/SocketBase.o \
+LIB_OBJS = $(LOCAL_OBJ_DIR)/IOStatus.o \
+           $(LOCAL_OBJ_DIR)/LatencyStats.o \
+           $(LOCAL_OBJ_DIR)/SocketBase.o \
+           $(LOCAL_OBJ_DIR)/ConnectionTable.o \
            $(LOCAL_OBJ_DIR)/RegularSocket.o \
-           $(LOCAL_OBJ_DIR)/FixedSizeSocket.o
+           $(LOCAL_OBJ_DIR)/FixedSizeSocket.o \
+           $(LOCAL_OBJ_DIR)/Framer.o \
+           $(LOCAL_OBJ_DIR)/SpliceRelay.o
 
 # -----------------------------------------------------------------------------
 
@@ -83,13 +133,57 @@ MESSAGEQ_TESTER_OBJ = $(LOCAL_OBJ_DIR)/messageq_tester.o
 $(LOCAL_BIN_DIR)/messageq_tester: $(MESSAGEQ_TESTER_OBJ) $(HEADERS)
 	$(CXX) -o $@ $(MESSAGEQ_TESTER_OBJ) $(LIBS)
 
+SHMEM_TESTER_OBJ = $(LOCAL_OBJ_DIR)/shmem_tester.o
+$(LOCAL_BIN_DIR)/shmem_tester: $(SHMEM_TESTER_OBJ) $(HEADERS)
+	$(CXX) -o $@ $(SHMEM_TESTER_OBJ) $(LIBS)
+
+PERSISTQ_TESTER_OBJ = $(LOCAL_OBJ_DIR)/persistq_tester.o
+$(LOCAL_BIN_DIR)/persistq_tester: $(PERSISTQ_TESTER_OBJ) $(HEADERS)
+	$(CXX) -o $@ $(PERSISTQ_TESTER_OBJ) $(LIBS)
+
+INPROC_TESTER_OBJ = $(LOCAL_OBJ_DIR)/inproc_tester.o
+$(LOCAL_BIN_DIR)/inproc_tester: $(INPROC_TESTER_OBJ) $(HEADERS)
+	$(CXX) -o $@ $(INPROC_TESTER_OBJ) $(LIBS)
+
+PIPE_TESTER_OBJ = $(LOCAL_OBJ_DIR)/pipe_tester.o
+$(LOCAL_BIN_DIR)/pipe_tester: $(PIPE_TESTER_OBJ) $(HEADERS)
+	$(CXX) -o $@ $(PIPE_TESTER_OBJ) $(LIBS)
+
+RELAY_TESTER_OBJ = $(LOCAL_OBJ_DIR)/relay_tester.o
+$(LOCAL_BIN_DIR)/relay_tester: $(RELAY_TESTER_OBJ) $(HEADERS)
+	$(CXX) -o $@ $(RELAY_TESTER_OBJ) $(LIBS)
+
+SENDFILE_TESTER_OBJ = $(LOCAL_OBJ_DIR)/sendfile_tester.o
+$(LOCAL_BIN_DIR)/sendfile_tester: $(SENDFILE_TESTER_OBJ) $(HEADERS)
+	$(CXX) -o $@ $(SENDFILE_TESTER_OBJ) $(LIBS)
+
+FD_TESTER_OBJ = $(LOCAL_OBJ_DIR)/fd_tester.o
+$(LOCAL_BIN_DIR)/fd_tester: $(FD_TESTER_OBJ) $(HEADERS)
+	$(CXX) -o $@ $(FD_TESTER_OBJ) $(LIBS)
+
+STATIC_TESTER_OBJ = $(LOCAL_OBJ_DIR)/static_tester.o
+$(LOCAL_BIN_DIR)/static_tester: $(STATIC_TESTER_OBJ) $(HEADERS)
+	$(CXX) -o $@ $(STATIC_TESTER_OBJ) $(LIBS)
+
+CONNTABLE_TESTER_OBJ = $(LOCAL_OBJ_DIR)/conntable_tester.o
+$(LOCAL_BIN_DIR)/conntable_tester: $(CONNTABLE_TESTER_OBJ) $(HEADERS)
+	$(CXX) -o $@ $(CONNTABLE_TESTER_OBJ) $(LIBS)
+
+LATENCY_TESTER_OBJ = $(LOCAL_OBJ_DIR)/latency_tester.o
+$(LOCAL_BIN_DIR)/latency_tester: $(LATENCY_TESTER_OBJ) $(HEADERS)
+	$(CXX) -o $@ $(LATENCY_TESTER_OBJ) $(LIBS)
+
 # -----------------------------------------------------------------------------
 
 depend:
 	makedepend $(CXXFLAGS) -Y $(SRC)
 
 clobber:
-	rm -f $(LIB_OBJS) $(TARGETS) $(SOCKET_TESTER_OBJ) $(MESSAGEQ_TESTER_OBJ)
+	rm -f $(LIB_OBJS) $(TARGETS) $(SOCKET_TESTER_OBJ) $(MESSAGEQ_TESTER_OBJ) \
+	      $(SHMEM_TESTER_OBJ) $(PERSISTQ_TESTER_OBJ) $(INPROC_TESTER_OBJ) \
+	      $(PIPE_TESTER_OBJ) $(RELAY_TESTER_OBJ) $(SENDFILE_TESTER_OBJ) \
+	      $(FD_TESTER_OBJ) $(STATIC_TESTER_OBJ) $(CONNTABLE_TESTER_OBJ) \
+	      $(LATENCY_TESTER_OBJ)
 
 install_lib:
 	cp -pf $(TARGET_LIB) $(PROJECT_LIB_DIR)/.
@@ -0,0 +1,162 @@
+// Hossein Moein
+// March 25, 2018
+// Copyright (C) 2018-2019 Hossein Moein
+// Distributed under the BSD Software License (see file License)
+
+#include <stdexcept>
+
+#include <SocketBase.h>
+#include <ConnectionTable.h>
+
+// ----------------------------------------------------------------------------
+
+namespace hmcom
+{
+
+const   ConnectionTable::handle_type    ConnectionTable::NO_SESSION;
+const   uint32_t                        ConnectionTable::NO_BUFFER;
+const   ConnectionTable::size_type      ConnectionTable::SLAB_SIZE;
+
+// ----------------------------------------------------------------------------
+
+ConnectionTable::ConnectionTable (const char *name)
+    : slabs_ (), free_ (), by_fd_ (), names_ (), active_ (0)  {
+
+    names_.push_back (name);
+}
+
+// ----------------------------------------------------------------------------
+
+ConnectionTable::~ConnectionTable ()  {
+
+    for_each ([] (handle_type, Session &session)  {
+                  ::close (session.fd);
+              });
+}
+
+// ----------------------------------------------------------------------------
+
+ConnectionTable::handle_type
+ConnectionTable::add (int fd, uint32_t now, uint16_t name_id)  {
+
+    if (fd < 0)
+        return (NO_SESSION);
+
+    handle_type handle = find (fd);
+
+    if (handle == NO_SESSION)  {
+        if (free_.empty ())
+            _grow ();
+        if (static_cast<size_type>(fd) >= by_fd_.size ())
+            by_fd_.resize (fd + 1, NO_SESSION);
+
+        handle = free_.back ();
+        free_.pop_back ();
+        by_fd_ [fd] = handle;
+        active_ += 1;
+    }
+
+    Session &session = (*this) [handle];
+
+    session.fd = fd;
+    session.last_active = now;
+    session.expected = 0;
+    session.done = 0;
+    session.read_buffer = NO_BUFFER;
+    session.write_buffer = NO_BUFFER;
+    session.tag = 0;
+    session.name_id = name_id;
+    session.state = _idle_;
+    session.flags = 0;
+
+    return (handle);
+}
+
+// ----------------------------------------------------------------------------
+
+int ConnectionTable::release (handle_type handle) throw ()  {
+
+    Session     &session = (*this) [handle];
+    const   int fd = session.fd;
+
+    if (session.state == _free_)
+        return (-1);
+
+    session.state = _free_;
+    session.fd = -1;
+    by_fd_ [fd] = NO_SESSION;
+    free_.push_back (handle);
+    active_ -= 1;
+
+    return (fd);
+}
+
+// ----------------------------------------------------------------------------
+
+// free_ is a stack, so the most recently freed (and likely cached) record
+// is reused first. A new slab is pushed in reverse, to be handed out front
+// to back. free_ has room for every handle, so release() never allocates.
+//
+void ConnectionTable::_grow ()  {
+
+    const   handle_type first = capacity ();
+
+    slabs_.push_back (SlabPtr (new Session [SLAB_SIZE] ()));
+    free_.reserve (free_.size () + SLAB_SIZE);
+    for (size_type i = SLAB_SIZE; i > 0; --i)
+        free_.push_back (first + i - 1);
+}
+
+// ----------------------------------------------------------------------------
+
+uint16_t ConnectionTable::intern (const char *name)  {
+
+    for (size_type i = 0; i < names_.size (); ++i)
+        if (names_ [i] == name)
+            return (static_cast<uint16_t>(i));
+
+    if (names_.size () > 0xFFFF)
+        throw std::runtime_error ("ConnectionTable::intern(): "
+                                  "Too many names.");
+
+    names_.push_back (name);
+    return (static_cast<uint16_t>(names_.size () - 1));
+}
+
+// ----------------------------------------------------------------------------
+
+bool ConnectionTable::get_peer_host (handle_type handle,
+                                     DMScu_VirtualString &hostname,
+                                     in_port_t &port) const  {
+
+    return (SocketBase::get_peername_by_fd ((*this) [handle].fd,
+                                            hostname,
+                                            port));
+}
+
+// ----------------------------------------------------------------------------
+
+ConnectionTable::size_type
+ConnectionTable::broadcast (const void *data, size_type the_size) throw ()  {
+
+    size_type   count = 0;
+
+    for_each ([this, data, the_size, &count]
+              (handle_type handle, Session &session)  {
+                  if (session.state != _closing_ &&
+                      try_send (handle, data, the_size).value_or (0) ==
+                          the_size)
+                      count += 1;
+              });
+    return (count);
+}
+
+} // namespace hmcom
+
+// ----------------------------------------------------------------------------
+
+// Local Variables:
+// mode:C++
+// tab-width:4
+// c-basic-offset:4
+// End:
@@ -5,11 +5,13 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <unistd.h>
 #include <cerrno>
+#include <charconv>
 #include <stdexcept>
 
 #include <DMScu_FixedSizeString.h>
@@ -41,69 +43,71 @@ peek (size_type the_size, void *buffer) throw ()  {
 
 int FixedSizeSocket::send (const void *data, size_type the_size)  {
 
+    const   IOResult<size_type> result = _try_send (data, the_size);
+
+    if (! result.ok ())  {
+        if (! is_blocking () && result.would_block ())
+            return (_try_again_);
+        result.status ().throw_error ("FixedSizeSocket::send()");
+    }
+
+    return (*result);
+}
+
+// ----------------------------------------------------------------------------
+
+IOResult<FixedSizeSocket::size_type>
+FixedSizeSocket::_try_send (const void *data, size_type the_size) throw ()  {
+
     const   int sent_size =
         get_socket_type () == _stream_  // TCP
             ? ::send (get_fd (), data, the_size, MSG_NOSIGNAL)  // TCP
             : ::send (get_fd (), data, the_size, MSG_CONFIRM);  // UDP
 
-    if (sent_size < 0)  {
-        if (! is_blocking () && errno == EAGAIN)
-            return (_try_again_);
-
-        DMScu_FixedSizeString<2047> err;
+    if (sent_size < 0)
+        return (IOStatus (IOStatus::_send_, errno));
 
-        err.printf ("FixedSizeSocket::send(): ::send(): (%d) %s",
-                    errno, strerror (errno));
-        throw std::runtime_error(err.c_str ());
-    }
-
-    return (sent_size);
+    return (static_cast<size_type>(sent_size));
 }
 
 // ----------------------------------------------------------------------------
 
 int FixedSizeSocket::receive (void *data, size_type the_size)  {
 
-    const   int recved_size =
-        ::recv (get_fd (), data, the_size, MSG_WAITALL | MSG_NOSIGNAL);
+    const   IOResult<size_type> result = _try_receive (data, the_size);
 
-    if (recved_size < 0)  {
-        if (! is_blocking () && errno == EAGAIN)
+    if (! result.ok ())  {
+        if (! is_blocking () && result.would_block ())
             return (_try_again_);
-
-        DMScu_FixedSizeString<2047> err;
-
-        err.printf ("FixedSizeSocket::receive(): ::recv(): (%d) %s",
-                    errno, strerror (errno));
-        throw std::runtime_error(err.c_str ());
-    }
-    else if (recved_size < the_size)  {
-        DMScu_FixedSizeString<2047> err;
-
-        err.printf ("FixedSizeSocket::receive(): ::recv(): "
-                    "returned only %u bytes of %u requested",
-                    recved_size, the_size);
-        throw std::runtime_error(err.c_str ());
+        result.status ().throw_error ("FixedSizeSocket::receive()");
     }
 
-    return (recved_size);
+    return (*result);
 }
 
 // ----------------------------------------------------------------------------
 
-FixedSizeSocket::size_type
-FixedSizeSocket::write (const void *data,
-                               size_type the_size,
-                               const SocketWriteDetail *already_sent,
-                               SocketWriteDetail *write_detail)  {
+IOResult<FixedSizeSocket::size_type>
+FixedSizeSocket::_try_receive (void *data, size_type the_size) throw ()  {
 
-    if (the_size != 0 && data == NULL)  {
-        DMScu_FixedSizeString<1023> err;
+    const   int recved_size =
+        ::recv (get_fd (), data, the_size, MSG_WAITALL | MSG_NOSIGNAL);
 
-        err.printf ("FixedSizeSocket::write(): "
-                    "data pointer is NULL and size is %lu.", the_size);
-        throw std::runtime_error(err.c_str ());
-    }
+    if (recved_size < 0)
+        return (IOStatus (IOStatus::_receive_, errno));
+    else if (static_cast<size_type>(recved_size) < the_size)
+        return (IOStatus (IOStatus::_receive_, ECONNRESET));
+
+    return (static_cast<size_type>(recved_size));
+}
+
+// ----------------------------------------------------------------------------
+
+IOResult<bool> FixedSizeSocket::
+_write_header (size_type the_size,
+               size_type body_space,
+               const SocketWriteDetail *already_sent,
+               SocketWriteDetail *write_detail) throw ()  {
 
     const   bool    has_hdr_sent =
         (already_sent ? already_sent->has_hdr_sent : false);
@@ -114,97 +118,208 @@ FixedSizeSocket::write (const void *data,
         const   size_type   header_size =
             DMScu_FASTProtocolUtilities::encode_uinteger (buffer, the_size);
 
-        if (! is_blocking () &&
-            get_free_send_buffer_space () < the_size + header_size)  {
-            if (write_detail)
-                *write_detail = SocketWriteDetail (0);
+        if (! is_blocking ())  {
+            const   IOResult<int>   space = try_free_send_buffer_space ();
+
+            if (! space.ok ())
+                return (space.status ());
+            if (static_cast<size_type>(*space) < body_space + header_size)  {
+                if (write_detail)
+                    *write_detail = SocketWriteDetail (0);
 
-            return (0);
+                return (false);
+            }
         }
 
-        if (send (buffer, header_size) < header_size)  {
-            DMScu_FixedSizeString<1023> err;
+        const   IOResult<size_type> sent = _try_send (buffer, header_size);
 
-            err.printf ("FixedSizeSocket::write(): ::send() msg size: "
-                        "could not send msg size");
-            throw std::runtime_error(err.c_str ());
+        if (! sent.ok ())  {
+           // Nothing was sent, so the caller can try again from scratch
+           //
+            if (! is_blocking () && sent.would_block ())  {
+                if (write_detail)
+                    *write_detail = SocketWriteDetail (0);
+
+                return (false);
+            }
+            return (IOStatus (IOStatus::_send_header_,
+                              sent.status ().error ()));
         }
+        if (*sent < header_size)
+            return (IOStatus (IOStatus::_send_header_, EIO));
 
         hdr_sent = header_size;
         if (write_detail)
             *write_detail = SocketWriteDetail (0, hdr_sent);
     }
     else if (! use_fast_ && (hdr_sent < get_header_size ()))  {
-        if (! has_hdr_sent && ! is_blocking () &&
-            get_free_send_buffer_space () < the_size + get_header_size ())  {
-            if (write_detail)
-                *write_detail = SocketWriteDetail (0);
+        if (! has_hdr_sent && ! is_blocking ())  {
+            const   IOResult<int>   space = try_free_send_buffer_space ();
+
+            if (! space.ok ())
+                return (space.status ());
+            if (static_cast<size_type>(*space) <
+                    body_space + get_header_size ())  {
+                if (write_detail)
+                    *write_detail = SocketWriteDetail (0);
 
-            return (0);
+                return (false);
+            }
         }
 
-        char    buffer [get_header_size ()];
+        char                        buffer [get_header_size ()];
+        const   std::to_chars_result    res =
+            std::to_chars (buffer, buffer + get_header_size (), the_size);
+
+        if (res.ec != std::errc ())
+            return (IOStatus (IOStatus::_send_header_, EMSGSIZE));
+        ::memset (res.ptr, 0, buffer + get_header_size () - res.ptr);
+
+        const   IOResult<size_type> sent =
+            _try_send (buffer + hdr_sent, get_header_size () - hdr_sent);
 
-        ::sprintf (buffer, "%d", the_size);
+        if (! sent.ok () && (is_blocking () || ! sent.would_block ()))
+            return (IOStatus (IOStatus::_send_header_,
+                              sent.status ().error ()));
 
-        hdr_sent += send (buffer + hdr_sent, get_header_size () - hdr_sent);
+        hdr_sent += sent.value_or (0);
         if (write_detail)
             *write_detail = SocketWriteDetail (0, hdr_sent);
 
         if (hdr_sent < get_header_size ())
-            return (0);
+            return (false);
+    }
+
+    return (true);
+}
+
+// ----------------------------------------------------------------------------
+
+FixedSizeSocket::size_type
+FixedSizeSocket::write (const void *data,
+                               size_type the_size,
+                               const SocketWriteDetail *already_sent,
+                               SocketWriteDetail *write_detail)  {
+
+    const   IOResult<size_type> result =
+        try_write (data, the_size, already_sent, write_detail);
+
+    if (! result.ok ())  {
+        if (! is_blocking () && result.would_block ())
+            return (static_cast<size_type>(_try_again_));
+        result.status ().throw_error ("FixedSizeSocket::write()");
     }
 
-    const   int sent_size = the_size > 0 ? send (data, the_size) : 0;
+    return (*result);
+}
+
+// ----------------------------------------------------------------------------
 
-    if (is_blocking () && sent_size <= 0 && the_size > 0) {
-        DMScu_FixedSizeString<2047> err;
+IOResult<FixedSizeSocket::size_type>
+FixedSizeSocket::try_write (const void *data,
+                            size_type the_size,
+                            const SocketWriteDetail *already_sent,
+                            SocketWriteDetail *write_detail) throw ()  {
+
+    if (the_size != 0 && data == NULL)
+        return (IOStatus (IOStatus::_send_, EINVAL));
+
+    const   LatencyStats::tick_type start = _latency_start ();
+    const   IOResult<bool>          header_sent =
+        _write_header (the_size, the_size, already_sent, write_detail);
+
+    if (! header_sent.ok ())
+        return (header_sent.status ());
+    if (! *header_sent)
+        return (0);
+
+    if (the_size == 0)  {
+        if (write_detail)
+            write_detail->msg_sent = 0;
+        return (0);
+    }
+
+    const   IOResult<size_type> sent = _try_send (data, the_size);
+
+    if (! sent.ok ())
+        return (sent);
+    if (is_blocking () && *sent == 0)
+        return (IOStatus (IOStatus::_send_, EIO));
+
+    if (write_detail)
+        write_detail->msg_sent = *sent;
+
+    _latency_record (LatencyStats::_send_, start, *sent);
+    return (sent);
+}
 
-        err.printf ("FixedSizeSocket::write(): ::send(): "
-                    "could not send msg");
+// ----------------------------------------------------------------------------
+
+FixedSizeSocket::size_type
+FixedSizeSocket::send_file (int file_fd,
+                            off_t offset,
+                            size_type length,
+                            const SocketWriteDetail *already_sent,
+                            SocketWriteDetail *write_detail)  {
+
+    const   size_type   body_sent = already_sent ? already_sent->msg_sent : 0;
+    SocketWriteDetail   detail =
+        already_sent ? *already_sent : SocketWriteDetail ();
+
+   // The body does not have to fit in the socket buffer, only the header
+   //
+    if (! _write_header (length, 0, already_sent, &detail).value (
+              "FixedSizeSocket::send_file()"))  {
+        if (write_detail)
+            *write_detail = detail;
+        return (0);
+    }
+
+    off_t               pos = offset + body_sent;
+    const   size_type   sent_size =
+        length > body_sent ? SocketBase::send_file (file_fd,
+                                                    pos,
+                                                    length - body_sent)
+                           : 0;
+
+    if (is_blocking () && body_sent + sent_size < length)  {
+        DMScu_FixedSizeString<1023> err;
+
+        err.printf ("FixedSizeSocket::send_file(): "
+                    "file ended after %u bytes of %u",
+                    body_sent + sent_size, length);
         throw std::runtime_error(err.c_str ());
     }
 
+    detail.msg_sent = body_sent + sent_size;
     if (write_detail)
-        write_detail->msg_sent = sent_size;
+        *write_detail = detail;
 
     return (sent_size);
 }
 
 // ----------------------------------------------------------------------------
 
-FixedSizeSocket::size_type
-FixedSizeSocket::_compute_size_for_read ()  {
+IOResult<FixedSizeSocket::size_type>
+FixedSizeSocket::_compute_size_for_read () throw ()  {
 
     if (use_fast_)  {
         unsigned    char    buffer [MAX_FAST_HEADER_SIZE];
-        unsigned    char    *tmp = buffer;
         size_type           rec_size = 0;
 
         do  {
-            if (receive (tmp++, 1) != 1)  {
-                DMScu_FixedSizeString<1023> err;
-
-                err.printf ("FixedSizeSocket::"
-                            "_compute_size_for_read(): "
-                            "Could not read message size.  "
-                            "Read 0 bytes now and %u so far.",
-                            rec_size);
-                throw std::runtime_error(err.c_str ());
-            }
+            if (rec_size == MAX_FAST_HEADER_SIZE)
+                return (IOStatus (IOStatus::_receive_header_, EPROTO));
+
+            const   IOResult<size_type> received =
+                _try_receive (buffer + rec_size, 1);
 
+            if (! received.ok ())
+                return (IOStatus (IOStatus::_receive_header_,
+                                  received.status ().error ()));
             rec_size += 1;
-            if (rec_size > MAX_FAST_HEADER_SIZE)  {
-                DMScu_FixedSizeString<1023> err;
-
-                err.printf ("FixedSizeSocket::"
-                            "_compute_size_for_read(): "
-                            "Header was too big.  Expected max %lu; "
-                            "read %lu bytes so far.",
-                            MAX_FAST_HEADER_SIZE, rec_size);
-                throw std::runtime_error(err.c_str ());
-            }
-        } while (! DMScu_FASTProtocolUtilities::is_final (*(tmp - 1)));
+        } while (! DMScu_FASTProtocolUtilities::is_final (
+                       buffer [rec_size - 1]));
 
         size_type   the_size = 0;
 
@@ -213,31 +328,21 @@ FixedSizeSocket::_compute_size_for_read ()  {
         return (the_size);
     }
     else  {
-        char        buffer [header_size_ + 1];
-        const   int rec_size = receive (buffer, get_header_size ());
-
-        if (rec_size < get_header_size ())  {
-            DMScu_FixedSizeString<1023> err;
+        char                        buffer [header_size_ + 1];
+        const   IOResult<size_type> received =
+            _try_receive (buffer, get_header_size ());
 
-            err.printf ("FixedSizeSocket::_compute_size_for_read(): "
-                        "Expected to get %lu bytes but read %d bytes.",
-                        get_header_size (), rec_size);
-            throw std::runtime_error(err.c_str ());
-        }
+        if (! received.ok ())
+            return (IOStatus (IOStatus::_receive_header_,
+                              received.status ().error ()));
 
         buffer [get_header_size ()] = 0;
         errno = 0;
 
         const   long    long    int msg_size = ::strtoll (buffer, NULL, 0);
 
-        if (msg_size >= ULONG_MAX || msg_size < 0 || errno > 0)  {
-            DMScu_FixedSizeString<1023> err;
-
-            err.printf ("FixedSizeSocket::_compute_size_for_read(): "
-                        "::strtol('%s'): (%d) %s",
-                        buffer, errno, strerror (errno));
-            throw std::runtime_error(err.c_str ());
-        }
+        if (msg_size >= ULONG_MAX || msg_size < 0 || errno > 0)
+            return (IOStatus (IOStatus::_receive_header_, EPROTO));
 
         return (static_cast<size_type>(msg_size));
     }
@@ -248,7 +353,9 @@ FixedSizeSocket::_compute_size_for_read ()  {
 FixedSizeSocket::size_type
 FixedSizeSocket::read (ReadBufferType **data, bool text_data)  {
 
-    const   size_type   the_size = _compute_size_for_read ();
+    const   LatencyStats::tick_type start = _latency_start ();
+    const   size_type               the_size =
+        _compute_size_for_read ().value ("FixedSizeSocket::read()");
 
     if (the_size > 0)  {
         *data = new ReadBufferType [text_data ? the_size + 1 : the_size];
@@ -263,6 +370,7 @@ FixedSizeSocket::read (ReadBufferType **data, bool text_data)  {
             *data = NULL;
             throw;
         }
+        _latency_record (LatencyStats::_receive_, start, the_size);
     }
     else
         *data = NULL;
@@ -279,12 +387,28 @@ FixedSizeSocket::read (ReadBufferType **data, bool text_data)  {
 FixedSizeSocket::size_type
 FixedSizeSocket::read_fixed (ReadBufferType *data, bool text_data)  {
 
-    const   size_type   the_size = _compute_size_for_read ();
+    return (try_read_fixed (data, text_data).value (
+                "FixedSizeSocket::read_fixed()"));
+}
+
+// ----------------------------------------------------------------------------
 
-    if (the_size > 0)  {
-        receive (data, the_size);
+IOResult<FixedSizeSocket::size_type>
+FixedSizeSocket::try_read_fixed (ReadBufferType *data, bool text_data)
+    throw ()  {
+
+    const   LatencyStats::tick_type start = _latency_start ();
+    const   IOResult<size_type>     the_size = _compute_size_for_read ();
+
+    if (the_size.ok () && *the_size > 0)  {
+        const   IOResult<size_type> received =
+            _try_receive (data, *the_size);
+
+        if (! received.ok ())
+            return (received);
         if (text_data)
-            data [the_size] = 0;
+            data [*the_size] = 0;
+        _latency_record (LatencyStats::_receive_, start, *the_size);
     }
 
     return (the_size);
@@ -0,0 +1,380 @@
+// Hossein Moein
+// March 25, 2018
+// Copyright (C) 2018-2019 Hossein Moein
+// Distributed under the BSD Software License (see file License)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cerrno>
+#include <charconv>
+#include <stdexcept>
+
+#include <DMScu_FixedSizeString.h>
+#include <DMScu_FASTProtocolUtilities.h>
+
+#include <Framer.h>
+
+// ----------------------------------------------------------------------------
+
+namespace hmcom
+{
+
+const   Framer::size_type   Framer::
+    MAX_FAST_HEADER_SIZE =
+        DMScu_FASTProtocolUtilities::bytes_required (sizeof(size_type), false);
+
+// ----------------------------------------------------------------------------
+
+Framer::Framer (Communication &com,
+                HEADER_TYPE header_type,
+                size_type header_size,
+                size_type buffer_size)
+    : com_ (com),
+      header_type_ (header_type),
+      header_size_ (header_size),
+      buffer_size_ (buffer_size),
+      rbuf_ (buffer_size),
+      rpos_ (0),
+      rend_ (0),
+      wbuf_ (),
+      wpos_ (0)  {
+
+    if (com.get_type () != Communication::_socket_ &&
+        com.get_type () != Communication::_pipe_)  {
+        DMScu_FixedSizeString<1023> err;
+
+        err.printf ("Framer::Framer(): '%s' is not a byte stream "
+                    "(type %d). Only sockets and pipes can be framed.",
+                    com.get_name (), static_cast<int>(com.get_type ()));
+        throw std::runtime_error(err.c_str ());
+    }
+
+    wbuf_.reserve (buffer_size);
+}
+
+// ----------------------------------------------------------------------------
+
+Framer::size_type
+Framer::_encode_header (ReadBufferType *buffer, size_type the_size) const  {
+
+    if (header_type_ == _fast_)
+        return (DMScu_FASTProtocolUtilities::encode_uinteger (buffer,
+                                                              the_size));
+
+    char                        *str = reinterpret_cast<char *>(buffer);
+    const   std::to_chars_result    res =
+        std::to_chars (str, str + header_size_, the_size);
+
+    if (res.ec != std::errc ())  {
+        DMScu_FixedSizeString<1023> err;
+
+        err.format ("Framer::write(): size ", the_size, " does not fit in a ",
+                    header_size_, " bytes header");
+        throw std::runtime_error(err.c_str ());
+    }
+
+    ::memset (res.ptr, 0, str + header_size_ - res.ptr);
+    return (header_size_);
+}
+
+// ----------------------------------------------------------------------------
+
+bool Framer::_frame_length (size_type &header_len,
+                            size_type &the_size,
+                            size_type &needed) const  {
+
+    const   size_type       avail = rend_ - rpos_;
+    const   ReadBufferType  *buffer = rbuf_.data () + rpos_;
+
+    needed = 0;
+    if (header_type_ == _fast_)  {
+        size_type   i = 0;
+
+        while (i < avail && i < MAX_FAST_HEADER_SIZE &&
+               ! DMScu_FASTProtocolUtilities::is_final (buffer [i]))
+            i += 1;
+
+        if (i >= MAX_FAST_HEADER_SIZE)  {
+            DMScu_FixedSizeString<1023> err;
+
+            err.printf ("Framer::read(): "
+                        "Header was too big.  Expected max %u bytes.",
+                        MAX_FAST_HEADER_SIZE);
+            throw std::runtime_error(err.c_str ());
+        }
+        if (i == avail)
+            return (false);
+
+        header_len = i + 1;
+        DMScu_FASTProtocolUtilities::decode_uinteger (buffer, the_size);
+    }
+    else  {
+        if (avail < header_size_)
+            return (false);
+
+        char    str [header_size_ + 1];
+
+        ::memcpy (str, buffer, header_size_);
+        str [header_size_] = 0;
+        errno = 0;
+
+        const   long    long    int msg_size = ::strtoll (str, NULL, 10);
+
+        if (msg_size >= UINT_MAX || msg_size < 0 || errno > 0)  {
+            DMScu_FixedSizeString<1023> err;
+
+            err.printf ("Framer::read(): ::strtoll('%s'): (%d) %s",
+                        str, errno, strerror (errno));
+            throw std::runtime_error(err.c_str ());
+        }
+
+        header_len = header_size_;
+        the_size = static_cast<size_type>(msg_size);
+    }
+
+    needed = header_len + the_size;
+    return (avail >= needed);
+}
+
+// ----------------------------------------------------------------------------
+
+Framer::size_type Framer::_gather (struct iovec *iov, int cnt)  {
+
+    ssize_t sent_size = 0;
+
+    if (com_.get_type () == Communication::_socket_)  {
+        struct  msghdr  msg;
+
+        ::memset (&msg, 0, sizeof (msg));
+        msg.msg_iov = iov;
+        msg.msg_iovlen = cnt;
+        sent_size = ::sendmsg (com_.get_write_fd (), &msg, MSG_NOSIGNAL);
+    }
+    else  // The constructor let only sockets and pipes in
+        sent_size = ::writev (com_.get_write_fd (), iov, cnt);
+
+    if (sent_size < 0)  {
+        if (errno == EAGAIN || errno == EWOULDBLOCK)
+            return (0);
+
+        DMScu_FixedSizeString<1023> err;
+
+        err.printf ("Framer::_gather(): %s: (%d) %s",
+                    com_.get_type () == Communication::_socket_
+                        ? "::sendmsg()" : "::writev()",
+                    errno, strerror (errno));
+        throw std::runtime_error(err.c_str ());
+    }
+
+    return (static_cast<size_type>(sent_size));
+}
+
+// ----------------------------------------------------------------------------
+
+// The fd is read directly, the same as _gather() writes it. The receive()
+// of some types would wait for the whole buffer, e.g. FixedSizeSocket's
+// MSG_WAITALL.
+//
+ssize_t Framer::_scatter (ReadBufferType *buffer, size_type the_size)  {
+
+    ssize_t received_size = 0;
+
+    do  {
+        if (com_.get_type () == Communication::_socket_)
+            received_size =
+                ::recv (com_.get_read_fd (), buffer, the_size, 0);
+        else
+            received_size = ::read (com_.get_read_fd (), buffer, the_size);
+    } while (received_size < 0 && errno == EINTR);
+
+    if (received_size < 0)  {
+        if (errno == EAGAIN || errno == EWOULDBLOCK)
+            return (-1);
+
+        DMScu_FixedSizeString<1023> err;
+
+        err.printf ("Framer::_scatter(): %s: (%d) %s",
+                    com_.get_type () == Communication::_socket_
+                        ? "::recv()" : "::read()",
+                    errno, strerror (errno));
+        throw std::runtime_error(err.c_str ());
+    }
+
+    return (received_size);
+}
+
+// ----------------------------------------------------------------------------
+
+void Framer::_send (const struct iovec *extra, int extra_cnt)  {
+
+    struct  iovec   iov [4];
+    int             cnt = 0;
+    const   size_type   queued = get_pending ();
+
+    if (queued > 0)  {
+        iov [cnt].iov_base = wbuf_.data () + wpos_;
+        iov [cnt].iov_len = queued;
+        cnt += 1;
+    }
+
+    const   int first_extra = cnt;
+
+    for (int i = 0; i < extra_cnt; ++i)
+        iov [cnt++] = extra [i];
+
+    size_type   total_sent = 0;
+    int         first = 0;
+
+    while (first < cnt)  {
+        size_type   sent = _gather (iov + first, cnt - first);
+
+        if (sent == 0)
+            break;
+
+        total_sent += sent;
+        while (first < cnt && sent >= iov [first].iov_len)  {
+            sent -= iov [first].iov_len;
+            first += 1;
+        }
+        if (first < cnt)  {
+            iov [first].iov_base =
+                reinterpret_cast<char *>(iov [first].iov_base) + sent;
+            iov [first].iov_len -= sent;
+        }
+    }
+
+    wpos_ += total_sent < queued ? total_sent : queued;
+    if (wpos_ == wbuf_.size ())  {
+        wbuf_.clear ();
+        wpos_ = 0;
+    }
+
+   // Whatever is left of extra is queued behind what is left of the
+   // queued bytes
+   //
+    for (int i = first > first_extra ? first : first_extra; i < cnt; ++i)  {
+        const   ReadBufferType  *begin =
+            reinterpret_cast<const ReadBufferType *>(iov [i].iov_base);
+
+        wbuf_.insert (wbuf_.end (), begin, begin + iov [i].iov_len);
+    }
+
+    return;
+}
+
+// ----------------------------------------------------------------------------
+
+int Framer::write (const void *data, size_type the_size)  {
+
+    if (the_size != 0 && data == NULL)  {
+        DMScu_FixedSizeString<1023> err;
+
+        err.printf ("Framer::write(): "
+                    "data pointer is NULL and size is %u.", the_size);
+        throw std::runtime_error(err.c_str ());
+    }
+
+    if (get_pending () >= buffer_size_ && flush () >= buffer_size_)
+        return (_would_block_);
+
+    ReadBufferType  header [header_type_ == _fast_
+                                ? MAX_FAST_HEADER_SIZE : header_size_];
+    const   size_type   header_len = _encode_header (header, the_size);
+
+    if (get_pending () + header_len + the_size <= buffer_size_)  {
+        if (wpos_ > 0)  {
+            wbuf_.erase (wbuf_.begin (), wbuf_.begin () + wpos_);
+            wpos_ = 0;
+        }
+
+        const   ReadBufferType  *begin =
+            reinterpret_cast<const ReadBufferType *>(data);
+
+        wbuf_.insert (wbuf_.end (), header, header + header_len);
+        wbuf_.insert (wbuf_.end (), begin, begin + the_size);
+        return (the_size);
+    }
+
+    struct  iovec   extra [2];
+
+    extra [0].iov_base = header;
+    extra [0].iov_len = header_len;
+    extra [1].iov_base = const_cast<void *>(data);
+    extra [1].iov_len = the_size;
+    _send (extra, 2);
+
+    return (the_size);
+}
+
+// ----------------------------------------------------------------------------
+
+Framer::size_type Framer::flush ()  {
+
+    if (get_pending () > 0)
+        _send (NULL, 0);
+
+    return (get_pending ());
+}
+
+// ----------------------------------------------------------------------------
+
+int Framer::read (const ReadBufferType **data)  {
+
+    while (true)  {
+        size_type   header_len = 0;
+        size_type   the_size = 0;
+        size_type   needed = 0;
+
+        if (_frame_length (header_len, the_size, needed))  {
+            *data = rbuf_.data () + rpos_ + header_len;
+            rpos_ += header_len + the_size;
+            return (the_size);
+        }
+
+       // Move the partial frame to the front and make room for all of it
+       //
+        if (rpos_ > 0)  {
+            ::memmove (rbuf_.data (), rbuf_.data () + rpos_, rend_ - rpos_);
+            rend_ -= rpos_;
+            rpos_ = 0;
+        }
+        if (needed > rbuf_.size ())
+            rbuf_.resize (needed);
+
+        const   ssize_t received =
+            _scatter (rbuf_.data () + rend_, rbuf_.size () - rend_);
+
+        if (received == 0)
+            return (_closed_);
+        if (received < 0)
+            return (_would_block_);
+
+        rend_ += received;
+    }
+}
+
+// ----------------------------------------------------------------------------
+
+bool Framer::frame_ready () const  {
+
+    size_type   header_len = 0;
+    size_type   the_size = 0;
+    size_type   needed = 0;
+
+    return (_frame_length (header_len, the_size, needed));
+}
+
+} // namespace hmcom
+
+// ----------------------------------------------------------------------------
+
+// Local Variables:
+// mode:C++
+// tab-width:4
+// c-basic-offset:4
+// End:
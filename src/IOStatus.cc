@@ -0,0 +1,54 @@
+// Hossein Moein
+// March 25, 2018
+// Copyright (C) 2018-2019 Hossein Moein
+// Distributed under the BSD Software License (see file License)
+
+#include <string.h>
+#include <stdexcept>
+
+#include <DMScu_FixedSizeString.h>
+
+#include <IOStatus.h>
+
+// ----------------------------------------------------------------------------
+
+namespace hmcom
+{
+
+const char *IOStatus::operation_name (OPERATION operation) throw ()  {
+
+    switch (operation)  {
+        case _send_: return ("send");
+        case _receive_: return ("receive");
+        case _send_header_: return ("send header");
+        case _receive_header_: return ("receive header");
+        case _send_file_: return ("send file");
+        case _accept_: return ("accept");
+        case _socket_option_: return ("socket option");
+        case _open_: return ("open");
+        case _file_control_: return ("file control");
+        default: return ("no operation");
+    }
+}
+
+// ----------------------------------------------------------------------------
+
+void IOStatus::throw_error (const char *where) const  {
+
+    DMScu_FixedSizeString<1023> err;
+
+    err.printf ("%s: %s: (%d) %s",
+                where, operation_name (operation_), error_,
+                strerror (error_));
+    throw std::runtime_error(err.c_str ());
+}
+
+} // namespace hmcom
+
+// ----------------------------------------------------------------------------
+
+// Local Variables:
+// mode:C++
+// tab-width:4
+// c-basic-offset:4
+// End:
@@ -0,0 +1,226 @@
+// Hossein Moein
+// March 25, 2018
+// Copyright (C) 2018-2019 Hossein Moein
+// Distributed under the BSD Software License (see file License)
+
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
+
+#include <LatencyStats.h>
+
+// ----------------------------------------------------------------------------
+
+namespace hmcom
+{
+
+const   LatencyHistogram::size_type LatencyHistogram::SUB_BUCKET_BITS;
+const   LatencyHistogram::size_type LatencyHistogram::SUB_BUCKETS;
+const   LatencyHistogram::size_type LatencyHistogram::MAX_BITS;
+const   LatencyHistogram::size_type LatencyHistogram::BUCKETS;
+const   LatencyStats::size_type     LatencyStats::OPERATIONS;
+
+// ----------------------------------------------------------------------------
+
+void LatencyHistogram::merge (const LatencyHistogram &that) throw ()  {
+
+    if (that.get_count () == 0)
+        return;
+
+    for (size_type i = 0; i < BUCKETS; ++i)
+        _add (buckets_ [i], that.get_bucket (i));
+    _add (count_, that.get_count ());
+    _add (bytes_, that.get_bytes ());
+    _add (total_, that.get_total ());
+    if (that.get_min () < min_.load (std::memory_order_relaxed))
+        min_.store (that.get_min (), std::memory_order_relaxed);
+    if (that.get_max () > max_.load (std::memory_order_relaxed))
+        max_.store (that.get_max (), std::memory_order_relaxed);
+}
+
+// ----------------------------------------------------------------------------
+
+void LatencyHistogram::reset () throw ()  {
+
+    for (size_type i = 0; i < BUCKETS; ++i)
+        buckets_ [i].store (0, std::memory_order_relaxed);
+    count_.store (0, std::memory_order_relaxed);
+    bytes_.store (0, std::memory_order_relaxed);
+    total_.store (0, std::memory_order_relaxed);
+    min_.store (~0ULL, std::memory_order_relaxed);
+    max_.store (0, std::memory_order_relaxed);
+}
+
+// ----------------------------------------------------------------------------
+
+LatencyHistogram::counter_type
+LatencyHistogram::percentile (double fraction) const throw ()  {
+
+   // The buckets are read once, so the answer is consistent even if they
+   // are being written
+   //
+    counter_type    counts [BUCKETS];
+    counter_type    count = 0;
+
+    for (size_type i = 0; i < BUCKETS; ++i)
+        count += (counts [i] = get_bucket (i));
+    if (count == 0)
+        return (0);
+
+    const   counter_type    rank =
+        std::max (static_cast<counter_type>(fraction * count + 0.5),
+                  static_cast<counter_type>(1));
+    counter_type            seen = 0;
+
+    for (size_type i = 0; i < BUCKETS; ++i)  {
+        seen += counts [i];
+        if (seen >= rank)
+            return (std::min (bucket_top (i), get_max ()));
+    }
+
+    return (get_max ());
+}
+
+// ----------------------------------------------------------------------------
+
+double LatencyStats::ticks_per_ns ()  {
+
+#if defined (__x86_64__) || defined (__i386__)
+    static  const   double  rate = [] () -> double  {
+        const   auto        start = std::chrono::steady_clock::now ();
+        const   tick_type   start_ticks = now ();
+
+        std::this_thread::sleep_for (std::chrono::milliseconds (20));
+
+        const   tick_type   ticks = now () - start_ticks;
+        const   auto        ns =
+            std::chrono::duration_cast<std::chrono::nanoseconds>
+                (std::chrono::steady_clock::now () - start).count ();
+
+        return (static_cast<double>(ticks) / ns);
+    } ();
+
+    return (rate);
+#else
+    return (1.0);
+#endif // defined (__x86_64__) || defined (__i386__)
+}
+
+// ----------------------------------------------------------------------------
+
+void LatencyStats::merge (const LatencyStats &that) throw ()  {
+
+    for (size_type op = 0; op < OPERATIONS; ++op)
+        histograms_ [op].merge (that.histograms_ [op]);
+}
+
+// ----------------------------------------------------------------------------
+
+void LatencyStats::reset () throw ()  {
+
+    for (size_type op = 0; op < OPERATIONS; ++op)
+        histograms_ [op].reset ();
+}
+
+// ----------------------------------------------------------------------------
+
+// The stats of the running threads, and the sum of the ones that ended.
+// They are never destroyed, so a thread may end after main() returns.
+//
+static std::mutex &_thread_mutex ()  {
+
+    static  std::mutex  *const  mutex = new std::mutex;
+
+    return (*mutex);
+}
+
+static std::vector<LatencyStats *> &_running_threads ()  {
+
+    static  std::vector<LatencyStats *> *const  threads =
+        new std::vector<LatencyStats *>;
+
+    return (*threads);
+}
+
+static LatencyStats &_ended_threads ()  {
+
+    static  LatencyStats    *const  stats = new LatencyStats;
+
+    return (*stats);
+}
+
+// ----------------------------------------------------------------------------
+
+LatencyStats *LatencyStats::_register_thread () throw ()  {
+
+   // Folds the stats of the thread into the ended ones when it exits
+   //
+    struct  ThreadEnd  {
+
+        LatencyStats    *stats;
+
+        ~ThreadEnd ()  {
+
+            if (! stats)
+                return;
+
+            const   std::lock_guard<std::mutex> guard (_thread_mutex ());
+            std::vector<LatencyStats *>         &threads =
+                _running_threads ();
+
+            _ended_threads ().merge (*stats);
+            threads.erase (std::find (threads.begin (), threads.end (),
+                                      stats));
+            thread_stats_ = NULL;
+            delete stats;
+        }
+    };
+
+    static  thread_local    ThreadEnd   thread_end = { NULL };
+
+    try  {
+        LatencyStats                        *stats = new LatencyStats;
+        const   std::lock_guard<std::mutex> guard (_thread_mutex ());
+
+        try  {
+            _running_threads ().push_back (stats);
+        }
+        catch (...)  {
+            delete stats;
+            throw;
+        }
+        thread_end.stats = stats;
+        thread_stats_ = stats;
+    }
+    catch (...)  {
+        thread_failed_ = true;
+        return (NULL);
+    }
+
+    return (thread_stats_);
+}
+
+// ----------------------------------------------------------------------------
+
+void LatencyStats::merge_threads (LatencyStats &stats)  {
+
+    const   std::lock_guard<std::mutex> guard (_thread_mutex ());
+    std::vector<LatencyStats *>         &threads = _running_threads ();
+
+    stats.merge (_ended_threads ());
+    for (size_type i = 0; i < threads.size (); ++i)
+        stats.merge (*threads [i]);
+}
+
+} // namespace hmcom
+
+// ----------------------------------------------------------------------------
+
+// Local Variables:
+// mode:C++
+// tab-width:4
+// c-basic-offset:4
+// End:
@@ -7,9 +7,6 @@
 #include <sys/socket.h>
 #include <unistd.h>
 #include <cerrno>
-#include <stdexcept>
-
-#include <DMScu_FixedSizeString.h>
 
 #include <RegularSocket.h>
 
@@ -20,6 +17,22 @@ namespace hmcom
 
 int RegularSocket::send (const void *data, size_type the_size)  {
 
+    const   IOResult<size_type> result = try_send (data, the_size);
+
+    if (! result.ok ())  {
+        if (! is_blocking () && result.would_block ())
+            return (_try_again_);
+        result.status ().throw_error ("RegularSocket::send()");
+    }
+
+    return (*result);
+}
+
+// ----------------------------------------------------------------------------
+
+IOResult<RegularSocket::size_type>
+RegularSocket::try_send (const void *data, size_type the_size) throw ()  {
+
     int sent_size = 0;
 
     if (get_socket_type () == _stream_)    // TCP
@@ -27,23 +40,31 @@ int RegularSocket::send (const void *data, size_type the_size)  {
     else    // UDP
         sent_size = ::send (get_fd (), data, the_size, MSG_CONFIRM);
 
-    if (sent_size < 0)  {
-        if (! is_blocking () && errno == EAGAIN)
-            return (_try_again_);
+    if (sent_size < 0)
+        return (IOStatus (IOStatus::_send_, errno));
 
-        DMScu_FixedSizeString<2047> err;
+    return (static_cast<size_type>(sent_size));
+}
 
-        err.printf ("RegularSocket::send(): ::send(): (%d) %s",
-                    errno, strerror (errno));
-        throw std::runtime_error(err.c_str ());
+// ----------------------------------------------------------------------------
+
+int RegularSocket::receive (void *data, size_type the_size)  {
+
+    const   IOResult<size_type> result = try_receive (data, the_size);
+
+    if (! result.ok ())  {
+        if (! is_blocking () && result.would_block ())
+            return (_try_again_);
+        result.status ().throw_error ("RegularSocket::receive()");
     }
 
-    return (sent_size);
+    return (*result);
 }
 
 // ----------------------------------------------------------------------------
 
-int RegularSocket::receive (void *data, size_type the_size)  {
+IOResult<RegularSocket::size_type>
+RegularSocket::try_receive (void *data, size_type the_size) throw ()  {
 
     socklen_t   slug = 0;
     const   int received_size =
@@ -52,18 +73,10 @@ int RegularSocket::receive (void *data, size_type the_size)  {
             ? ::recv (get_fd (), data, the_size, MSG_NOSIGNAL)
             : ::recvfrom (get_fd(), data, the_size, MSG_NOSIGNAL, NULL, &slug);
 
-    if (received_size < 0)  {
-        if (! is_blocking () && errno == EAGAIN)
-            return (_try_again_);
-
-        DMScu_FixedSizeString<2047> err;
-
-        err.printf ("RegularSocket::receive(): ::recv(): (%d) %s",
-                    errno, strerror (errno));
-        throw std::runtime_error(err.c_str ());
-    }
+    if (received_size < 0)
+        return (IOStatus (IOStatus::_receive_, errno));
 
-    return (received_size);
+    return (static_cast<size_type>(received_size));
 }
 
 } // namespace hmcom
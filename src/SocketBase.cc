@@ -10,6 +10,7 @@
 #include <sys/select.h>
 #include <sys/time.h>
 #include <sys/ioctl.h>
+#include <sys/sendfile.h>
 
 #include <netinet/tcp.h>
 #include <netdb.h>
@@ -22,6 +23,7 @@ extern  int h_errno;
 
 #include <string.h>
 
+#include <SigPipeGuard.h>
 #include <SocketBase.h>
 
 // ----------------------------------------------------------------------------
@@ -257,6 +259,15 @@ bool SocketBase::set_receive_buffer_size (int buf_size)  {
 
 int SocketBase::get_free_send_buffer_space ()  {
 
+    const   IOResult<int>   result = try_free_send_buffer_space ();
+
+    return (result.value ("SocketBase::get_free_send_buffer_space()"));
+}
+
+// ----------------------------------------------------------------------------
+
+IOResult<int> SocketBase::try_free_send_buffer_space () throw ()  {
+
     int         buf_size = 0;
     socklen_t   t_size = sizeof (buf_size);
 
@@ -264,27 +275,57 @@ int SocketBase::get_free_send_buffer_space ()  {
                       SOL_SOCKET,
                       SO_SNDBUF,
                       reinterpret_cast<void *>(&buf_size),
-                      &t_size) < 0)  {
-        DMScu_FixedSizeString<1023> err;
-
-        err.printf ("SocketBase::get_free_send_buffer_space (): "
-                    "::getsockopt(SNDBUF): (%d) %s",
-                    errno, strerror (errno));
-        throw std::runtime_error(err.c_str ());
-    }
+                      &t_size) < 0)
+        return (IOStatus (IOStatus::_socket_option_, errno));
 
     int used_buf_size = 0;
 
-    if (::ioctl (get_fd (), TIOCOUTQ, &used_buf_size) < 0)  {
-        DMScu_FixedSizeString<1023> err;
+    if (::ioctl (get_fd (), TIOCOUTQ, &used_buf_size) < 0)
+        return (IOStatus (IOStatus::_socket_option_, errno));
 
-        err.printf ("SocketBase::get_free_send_buffer_space (): "
-                    "::ioctl(TIOCOUTQ): (%d) %s",
-                    errno, strerror (errno));
-        throw std::runtime_error(err.c_str ());
+    return (buf_size - used_buf_size);
+}
+
+// ----------------------------------------------------------------------------
+
+SocketBase::size_type
+SocketBase::send_file (int file_fd, off_t &offset, size_type length)  {
+
+    const   IOResult<size_type> result =
+        try_send_file (file_fd, offset, length);
+
+    return (result.value ("SocketBase::send_file()"));
+}
+
+// ----------------------------------------------------------------------------
+
+IOResult<SocketBase::size_type>
+SocketBase::try_send_file (int file_fd, off_t &offset, size_type length)
+    throw ()  {
+
+   // ::sendfile() has no MSG_NOSIGNAL. A peer that is gone is EPIPE
+   //
+    const   SigPipeGuard    guard;
+    size_type               total = 0;
+
+    while (total < length)  {
+        const   ssize_t sent_size =
+            ::sendfile (get_fd (), file_fd, &offset, length - total);
+
+        if (sent_size < 0)  {
+            if (errno == EINTR)
+                continue;
+            if (! is_blocking () && errno == EAGAIN)
+                break;
+            return (IOStatus (IOStatus::_send_file_, errno));
+        }
+
+        if (sent_size == 0)  // The file is shorter than length
+            break;
+        total += sent_size;
     }
 
-    return (buf_size - used_buf_size);
+    return (total);
 }
 
 // ----------------------------------------------------------------------------
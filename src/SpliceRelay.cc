@@ -0,0 +1,98 @@
+// Hossein Moein
+// March 25, 2018
+// Copyright (C) 2018-2019 Hossein Moein
+// Distributed under the BSD Software License (see file License)
+
+#include <fcntl.h>
+#include <cerrno>
+#include <stdexcept>
+
+#include <DMScu_FixedSizeString.h>
+
+#include <SigPipeGuard.h>
+#include <SpliceRelay.h>
+
+// ----------------------------------------------------------------------------
+
+namespace hmcom
+{
+
+bool SpliceRelay::_connect_hook ()  {
+
+    if (is_connected ())
+        return (false);
+
+    pipe_.connect ();
+    pipe_capacity_ = pipe_.get_capacity ();
+    source_eof_ = false;
+    return (true);
+}
+
+// ----------------------------------------------------------------------------
+
+bool SpliceRelay::_disconnect_hook ()  {
+
+    if (! is_connected ())
+        return (false);
+
+    pipe_.disconnect ();
+    pipe_capacity_ = 0;
+    return (true);
+}
+
+// ----------------------------------------------------------------------------
+
+int SpliceRelay::relay ()  {
+
+    static  const   unsigned    int flags = SPLICE_F_MOVE | SPLICE_F_NONBLOCK;
+
+    const   SigPipeGuard    guard;
+    int                     moved_out = 0;
+    bool                    progress = true;
+
+    while (progress)  {
+        progress = false;
+
+        if (wants_read ())  {
+            const   int moved_in =
+                pipe_.splice_from (source_.get_fd (), chunk_size_, NULL, flags);
+
+            splices_ += 1;
+            if (moved_in == 0)
+                source_eof_ = true;
+            else if (moved_in > 0)  {
+                bytes_in_ += moved_in;
+                progress = true;
+            }
+        }
+
+        if (wants_write ())  {
+            const   int moved =
+                pipe_.splice_to (destination_.get_fd (),
+                                 static_cast<size_type>(get_pending ()),
+                                 NULL,
+                                 flags);
+
+            splices_ += 1;
+            if (moved > 0)  {
+                bytes_out_ += moved;
+                moved_out += moved;
+                progress = true;
+            }
+        }
+    }
+
+    if (source_eof_ && get_pending () == 0)
+        return (_closed_);
+    return (moved_out);
+}
+
+} // namespace hmcom
+
+// ----------------------------------------------------------------------------
+
+// Local Variables:
+// mode:C++
+// tab-width:4
+// c-basic-offset:4
+// End:
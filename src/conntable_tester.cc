@@ -0,0 +1,267 @@
+// Hossein Moein
+// March 25, 2018
+// Copyright (C) 2018-2019 Hossein Moein
+// Distributed under the BSD Software License (see file License)
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <RegularSocket.h>
+#include <Acceptor.h>
+#include <ConnectionTable.h>
+
+using namespace hmcom;
+
+typedef ConnectionTable::handle_type    Handle;
+typedef ConnectionTable::Session        Session;
+
+// ----------------------------------------------------------------------------
+
+static  const   unsigned int    COUNT = 5000;
+static  const   in_port_t       PORT = 27493;
+
+// ----------------------------------------------------------------------------
+
+// Half of the sessions go idle and are expired. Their peers see EOF, the
+// others get the broadcast.
+//
+static bool test_sessions ()  {
+
+    ConnectionTable     table ("sessions");
+    std::vector<int>    peers (COUNT);
+    std::vector<Handle> handles (COUNT);
+
+    for (unsigned int i = 0; i < COUNT; ++i)  {
+        int fds [2];
+
+        if (::socketpair (AF_UNIX, SOCK_STREAM, 0, fds) < 0)  {
+            std::cout << "ERROR: cannot make socket pair " << i << std::endl;
+            return (false);
+        }
+        peers [i] = fds [1];
+        handles [i] = table.add (fds [0], i % 2 == 0 ? 100 : 10);
+        if (handles [i] == ConnectionTable::NO_SESSION ||
+            table.find (fds [0]) != handles [i] || table [handles [i]].fd !=
+            fds [0])  {
+            std::cout << "ERROR: session " << i << " was not added"
+                      << std::endl;
+            return (false);
+        }
+    }
+    if (table.size () != COUNT || table.capacity () < COUNT)  {
+        std::cout << "ERROR: table has " << table.size () << " sessions"
+                  << std::endl;
+        return (false);
+    }
+
+    unsigned int    expired = 0;
+    const   auto    start = std::chrono::steady_clock::now ();
+    const   ConnectionTable::size_type  closed =
+        table.expire (105, 60,
+                      [&expired] (Handle, const Session &session)  {
+                          expired += session.last_active == 10 ? 1 : 0;
+                      });
+    const   auto    us =
+        std::chrono::duration_cast<std::chrono::microseconds>
+            (std::chrono::steady_clock::now () - start).count ();
+
+    if (closed != COUNT / 2 || expired != COUNT / 2 ||
+        table.size () != COUNT / 2)  {
+        std::cout << "ERROR: expired " << closed << " sessions" << std::endl;
+        return (false);
+    }
+    std::cout << "Expired " << closed << " of " << COUNT << " sessions in "
+              << us << " us" << std::endl;
+
+    static  const   char    message [] = "broadcast";
+
+    if (table.broadcast (message, sizeof (message)) != COUNT / 2)  {
+        std::cout << "ERROR: broadcast did not reach all sessions"
+                  << std::endl;
+        return (false);
+    }
+
+    for (unsigned int i = 0; i < COUNT; ++i)  {
+        char            buffer [sizeof (message)];
+        const   ssize_t received = ::recv (peers [i], buffer, sizeof (buffer),
+                                           MSG_DONTWAIT);
+
+        if (i % 2 == 0 ? received != sizeof (message) ||
+                             ::memcmp (buffer, message, sizeof (message))
+                       : received != 0)  {
+            std::cout << "ERROR: peer " << i << " received " << received
+                      << " bytes" << std::endl;
+            return (false);
+        }
+        ::close (peers [i]);
+    }
+
+   // Freed records are reused before the table grows
+   //
+    const   ConnectionTable::size_type  capacity = table.capacity ();
+    int                                 fds [2];
+
+    ::socketpair (AF_UNIX, SOCK_STREAM, 0, fds);
+    if (table.add (fds [0], 200) != handles [COUNT - 1] ||
+        table.capacity () != capacity)  {
+        std::cout << "ERROR: a freed record was not reused" << std::endl;
+        return (false);
+    }
+    ::close (fds [1]);
+
+    const   int fd = table.release (table.find (fds [0]));
+
+    if (fd != fds [0] || table.find (fd) != ConnectionTable::NO_SESSION)  {
+        std::cout << "ERROR: release() did not free the session" << std::endl;
+        return (false);
+    }
+    ::close (fd);
+
+    return (true);
+}
+
+// ----------------------------------------------------------------------------
+
+// A session released twice, or closed by its own on_expire callback, is
+// freed only once
+//
+static bool test_double_release ()  {
+
+    ConnectionTable table ("double");
+    int             fds [2];
+    int             peers [2];
+
+    ::socketpair (AF_UNIX, SOCK_STREAM, 0, fds);
+
+    const   Handle  handle = table.add (fds [0], 10);
+
+    if (table.release (handle) != fds [0] || table.release (handle) != -1 ||
+        table.size () != 0)  {
+        std::cout << "ERROR: a session was released twice" << std::endl;
+        return (false);
+    }
+    table.close (handle);
+    peers [0] = fds [1];
+    table.add (fds [0], 10);
+    ::socketpair (AF_UNIX, SOCK_STREAM, 0, fds);
+    peers [1] = fds [1];
+    table.add (fds [0], 10);
+
+    const   ConnectionTable::size_type  closed =
+        table.expire (100, 60,
+                      [&table] (Handle h, const Session &)  {
+                          table.close (h);
+                      });
+    char                                buffer [4];
+
+    if (closed != 2 || table.size () != 0 ||
+        ::recv (peers [0], buffer, sizeof (buffer), MSG_DONTWAIT) != 0 ||
+        ::recv (peers [1], buffer, sizeof (buffer), MSG_DONTWAIT) != 0)  {
+        std::cout << "ERROR: expire() with a closing callback left "
+                  << table.size () << " sessions" << std::endl;
+        return (false);
+    }
+
+   // Every freed handle is handed out once
+   //
+    Handle  added [2];
+
+    for (int i = 0; i < 2; ++i)  {
+        ::close (peers [i]);
+        ::socketpair (AF_UNIX, SOCK_STREAM, 0, fds);
+        ::close (fds [1]);
+        added [i] = table.add (fds [0], 200);
+    }
+    if (table.size () != 2 || added [0] == added [1])  {
+        std::cout << "ERROR: a freed handle was handed out twice"
+                  << std::endl;
+        return (false);
+    }
+
+    return (true);
+}
+
+// ----------------------------------------------------------------------------
+
+// Accepted fds go straight into the table. The name is interned and the
+// peer is looked up when asked.
+//
+static bool test_accept ()  {
+
+    RegularAcceptor acceptor ("table_test", PORT,
+                              SocketBase::_ip_address_, "127.0.0.1");
+    ConnectionTable table;
+    const   uint16_t    name_id = table.intern ("table_test");
+
+    acceptor.connect ();
+    acceptor.listen ();
+
+    RegularSocket   client ("table_client",
+                            SocketBase::_ipv4_,
+                            SocketBase::_stream_,
+                            SocketBase::_client_,
+                            PORT,
+                            SocketBase::_ip_address_,
+                            "127.0.0.1");
+
+    client.connect ();
+
+    const   IOResult<int>   fd = acceptor.try_accept_fd ();
+    const   Handle          handle =
+        table.add (fd.value ("test_accept()"), 0, name_id);
+
+    DMScu_FixedSizeString<63>   host;
+    in_port_t                   port = 0;
+    char                        c = 0;
+
+    if (table.intern ("table_test") != name_id ||
+        ::strcmp (table.get_name (handle), "table_test") ||
+        ! table.get_peer_host (handle, host, port) || port == 0 ||
+        client.send ("y", 1) != 1 ||
+        table.try_receive (handle, &c, 1).value_or (0) != 1 || c != 'y')  {
+        std::cout << "ERROR: accepted session does not work" << std::endl;
+        return (false);
+    }
+
+    return (true);
+}
+
+// ----------------------------------------------------------------------------
+
+int main (int argCnt, char *argVctr [])  {
+
+    try  {
+        std::cout << "\n\tTesting ConnectionTable ...\n" << std::endl;
+
+        std::cout << "A session takes " << sizeof (Session)
+                  << " bytes, a RegularSocket " << sizeof (RegularSocket)
+                  << " bytes plus its name" << std::endl;
+
+        if (! test_sessions () || ! test_double_release () ||
+            ! test_accept ())
+            return (EXIT_FAILURE);
+
+        std::cout << "SUCCESS: ConnectionTable is working" << std::endl;
+    }
+    catch (const std::exception &ex)  {
+        std::cout << "Exception: " << ex.what () << std::endl;
+        return (EXIT_FAILURE);
+    }
+
+    return (EXIT_SUCCESS);
+}
+
+// ----------------------------------------------------------------------------
+
+// Local Variables:
+// mode:C++
+// tab-width:4
+// c-basic-offset:4
+// End:
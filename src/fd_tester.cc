@@ -0,0 +1,117 @@
+// Hossein Moein
+// March 25, 2018
+// Copyright (C) 2018-2019 Hossein Moein
+// Distributed under the BSD Software License (see file License)
+
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+
+#include <signal.h>
+#include <unistd.h>
+
+#include <DMScu_FixedSizeString.h>
+
+#include <Selector.h>
+#include <EventFd.h>
+#include <TimerFd.h>
+#include <SignalFd.h>
+
+using namespace hmcom;
+
+// ----------------------------------------------------------------------------
+
+int main (int argCnt, char *argVctr [])  {
+
+    try  {
+        std::cout << "\n\tTesting EventFd, TimerFd and SignalFd ...\n"
+                  << std::endl;
+
+       // This must be done before any thread is created, so the signal is
+       // blocked everywhere
+       //
+        SignalFd    sigfd ("signals");
+
+        sigfd.add_signal (SIGUSR1);
+        sigfd.make_nonblocking ();
+        sigfd.connect ();
+
+        EventFd     evfd ("wakeup");
+        TimerFd     tmfd ("timer");
+
+        evfd.make_nonblocking ();
+        evfd.connect ();
+        tmfd.make_nonblocking ();
+        tmfd.connect ();
+        tmfd.start (10000, 10000);  // Every 10ms
+
+        std::thread notifier ([&evfd] ()  {
+            for (int i = 0; i < 3; ++i)  {
+                std::this_thread::sleep_for (std::chrono::milliseconds (5));
+                evfd.notify ();
+            }
+            ::kill (::getpid (), SIGUSR1);
+        });
+
+        Selector    selector (3);
+
+        selector.add_communication (&evfd);
+        selector.add_communication (&tmfd);
+        selector.add_communication (&sigfd);
+
+        EventFd::value_type wakeups = 0;
+        TimerFd::value_type ticks = 0;
+        bool                got_signal = false;
+
+        while (wakeups < 3 || ticks < 5 || ! got_signal)  {
+            if (! selector.select (Selector::_read_, 5))  {
+                std::cout << "ERROR: select() timed out" << std::endl;
+                return (EXIT_FAILURE);
+            }
+
+            const   Selector::ResultVector  &res = selector.get_result ();
+
+            for (Selector::ResultVector::const_iterator citr = res.begin ();
+                 citr != res.end (); ++citr)  {
+                if (citr->com == &evfd)
+                    wakeups += evfd.wait ();
+                else if (citr->com == &tmfd)
+                    ticks += tmfd.expirations ();
+                else if (citr->com == &sigfd)  {
+                    SignalFd::value_type    info;
+
+                    while (sigfd.read_signal (info))
+                        if (info.ssi_signo == SIGUSR1)
+                            got_signal = true;
+                }
+            }
+        }
+        notifier.join ();
+        tmfd.stop ();
+
+        if (evfd.wait () != 0)  {
+            std::cout << "ERROR: EventFd is not empty" << std::endl;
+            return (EXIT_FAILURE);
+        }
+
+        std::cout << "Wakeups: " << wakeups << "  Timer ticks: " << ticks
+                  << "  Got SIGUSR1: " << got_signal << std::endl;
+        std::cout << "SUCCESS: EventFd, TimerFd and SignalFd are working"
+                  << std::endl;
+    }
+    catch (const std::exception &ex)  {
+        std::cout << "Exception: " << ex.what () << std::endl;
+        return (EXIT_FAILURE);
+    }
+
+    return (EXIT_SUCCESS);
+}
+
+// ----------------------------------------------------------------------------
+
+// Local Variables:
+// mode:C++
+// tab-width:4
+// c-basic-offset:4
+// End:
@@ -0,0 +1,174 @@
+// Hossein Moein
+// March 25, 2018
+// Copyright (C) 2018-2019 Hossein Moein
+// Distributed under the BSD Software License (see file License)
+
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+
+#include <DMScu_FixedSizeString.h>
+
+#include <Selector.h>
+#include <InProcChannel.h>
+
+using namespace hmcom;
+
+// ----------------------------------------------------------------------------
+
+struct  test_data  {
+
+    unsigned int        producer;
+    unsigned long long  id;
+};
+
+typedef InProcChannel<test_data>    Channel;
+
+static  const   unsigned    int         PRODUCERS = 4;
+static  const   unsigned    long long   MSG_COUNT = 250000;
+
+// ----------------------------------------------------------------------------
+
+static void producer (Channel &chan, unsigned int producer_id)  {
+
+    test_data   data;
+
+    data.producer = producer_id;
+    for (unsigned long long i = 0; i < MSG_COUNT; ++i)  {
+        data.id = i;
+
+       // The channel may be in non-blocking mode for the consumer
+       //
+        while (chan.send (&data, sizeof (data)) == Channel::_would_block_)
+            std::this_thread::yield ();
+    }
+
+    return;
+}
+
+// ----------------------------------------------------------------------------
+
+// With drain, every readable select() is followed by receives until the
+// channel is empty. Otherwise there is one receive per select(), so a
+// message left behind without a wakeup times the select() out.
+//
+static bool test_selector (bool drain)  {
+
+    std::cout << "\n\tTesting InProcChannel with Selector ("
+              << (drain ? "draining" : "one receive per select") << ") ...\n"
+              << std::endl;
+
+    Channel             chan ("inproc", 1000);
+    Selector            sel (1);
+    unsigned long long  next_id [PRODUCERS] = { 0 };
+    unsigned long long  received = 0;
+    unsigned long long  wakeups = 0;
+    test_data           data;
+
+    chan.connect ();
+    chan.make_nonblocking ();
+    sel.add_communication (&chan);
+
+    if (chan.receive (&data, sizeof (data)) != Channel::_would_block_)  {
+        std::cout << "ERROR: received from an empty channel" << std::endl;
+        return (false);
+    }
+
+    std::thread producers [PRODUCERS];
+
+    for (unsigned int i = 0; i < PRODUCERS; ++i)
+        producers [i] = std::thread (&producer, std::ref (chan), i);
+
+    while (received < PRODUCERS * MSG_COUNT)  {
+        if (! sel.select (Selector::_read_, 5))  {
+            std::cout << "ERROR: select() timed out after " << received
+                      << " messages" << std::endl;
+            return (false);
+        }
+        wakeups += 1;
+
+        do  {
+            if (chan.receive (&data, sizeof (data)) == Channel::_would_block_)
+                break;
+            if (data.id != next_id [data.producer])  {
+                std::cout << "ERROR: producer " << data.producer
+                          << " expected " << next_id [data.producer]
+                          << " but received " << data.id << std::endl;
+                return (false);
+            }
+            next_id [data.producer] += 1;
+            received += 1;
+        } while (drain);
+    }
+
+    for (unsigned int i = 0; i < PRODUCERS; ++i)
+        producers [i].join ();
+
+    std::cout << "Received " << received << " messages in " << wakeups
+              << " wakeups" << std::endl;
+    std::cout << "SUCCESS: InProcChannel with Selector is working"
+              << std::endl;
+    return (true);
+}
+
+// ----------------------------------------------------------------------------
+
+static bool test_blocking ()  {
+
+    std::cout << "\n\tTesting blocking InProcChannel ...\n" << std::endl;
+
+    Channel         chan ("inproc", 16);
+    WaitStrategy    ws;
+    test_data       data;
+
+    chan.connect ();
+
+    std::thread p (&producer, std::ref (chan), 0);
+
+    for (unsigned long long i = 0; i < MSG_COUNT; ++i)  {
+        if (i & 1)
+            chan >> data;
+        else
+            chan.pop (data, ws);
+        if (data.id != i)  {
+            std::cout << "ERROR: expected " << i << " but received "
+                      << data.id << std::endl;
+            return (false);
+        }
+    }
+    p.join ();
+
+    if (chan.num_of_msgs_inq () != 0)  {
+        std::cout << "ERROR: channel is not empty" << std::endl;
+        return (false);
+    }
+
+    std::cout << "SUCCESS: blocking InProcChannel is working" << std::endl;
+    return (true);
+}
+
+// ----------------------------------------------------------------------------
+
+int main (int argCnt, char *argVctr [])  {
+
+    try  {
+        if (! test_selector (true) || ! test_selector (false) ||
+            ! test_blocking ())
+            return (EXIT_FAILURE);
+    }
+    catch (const std::exception &ex)  {
+        std::cout << "Exception: " << ex.what () << std::endl;
+        return (EXIT_FAILURE);
+    }
+
+    return (EXIT_SUCCESS);
+}
+
+// ----------------------------------------------------------------------------
+
+// Local Variables:
+// mode:C++
+// tab-width:4
+// c-basic-offset:4
+// End:
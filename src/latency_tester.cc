@@ -0,0 +1,299 @@
+// Hossein Moein
+// March 25, 2018
+// Copyright (C) 2018-2019 Hossein Moein
+// Distributed under the BSD Software License (see file License)
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+
+#include <FixedSizeSocket.h>
+#include <Acceptor.h>
+#include <Pipe.h>
+#include <MessageQueue.h>
+#include <LatencyStats.h>
+
+using namespace hmcom;
+
+typedef LatencyHistogram::counter_type  counter_type;
+
+// ----------------------------------------------------------------------------
+
+static  const   in_port_t       PORT = 27495;
+static  const   unsigned int    COUNT = 1000;
+
+// ----------------------------------------------------------------------------
+
+static void print (const char *name, const LatencyHistogram &histogram)  {
+
+    std::cout << name << ": " << histogram.get_count () << " messages, "
+              << histogram.get_bytes () << " bytes, p50 "
+              << LatencyStats::to_ns (histogram.percentile (0.5))
+              << " ns, p99 "
+              << LatencyStats::to_ns (histogram.percentile (0.99))
+              << " ns, max "
+              << LatencyStats::to_ns (histogram.get_max ()) << " ns"
+              << std::endl;
+}
+
+// ----------------------------------------------------------------------------
+
+// Every value is within its bucket and a bucket is at most 1/16 of its
+// values wide
+//
+static bool test_histogram ()  {
+
+    for (counter_type value = 0; value < (1ULL << 40);
+         value += value / 7 + 1)  {
+        const   LatencyHistogram::size_type bucket =
+            LatencyHistogram::bucket_of (value);
+
+        if (bucket >= LatencyHistogram::BUCKETS ||
+            (bucket < LatencyHistogram::BUCKETS - 1 &&
+             (LatencyHistogram::bucket_top (bucket) < value ||
+              (bucket > 0 &&
+               LatencyHistogram::bucket_top (bucket - 1) >= value) ||
+              LatencyHistogram::bucket_top (bucket) - value >
+                  value / LatencyHistogram::SUB_BUCKETS)))  {
+            std::cout << "ERROR: " << value << " is in bucket " << bucket
+                      << std::endl;
+            return (false);
+        }
+    }
+
+    LatencyHistogram    histogram;
+    LatencyHistogram    merged;
+
+    for (counter_type value = 1; value <= COUNT; ++value)
+        histogram.record (value, 10);
+    merged.merge (histogram);
+    merged.merge (histogram);
+
+    const   counter_type    median = merged.percentile (0.5);
+
+    if (merged.get_count () != 2 * COUNT ||
+        merged.get_bytes () != 20 * COUNT ||
+        merged.get_min () != 1 || merged.get_max () != COUNT ||
+        median < COUNT / 2 || median > COUNT / 2 + COUNT / 32 ||
+        merged.percentile (1.0) != COUNT ||
+        LatencyHistogram ().percentile (0.5) != 0)  {
+        std::cout << "ERROR: histogram percentiles are off" << std::endl;
+        return (false);
+    }
+
+    return (true);
+}
+
+// ----------------------------------------------------------------------------
+
+// The timestamp is most of the cost. Under some hypervisors, rdtsc traps
+// and takes tens of nanoseconds. A now() reads the clock, so the compiler
+// keeps it even though its value is dropped.
+//
+static void measure_record ()  {
+
+    const   unsigned int    records = 10000000;
+    LatencyStats            stats;
+    auto                    start = LatencyStats::now ();
+
+    for (unsigned int i = 0; i < records; ++i)
+        LatencyStats::now ();
+
+    const   double  now_ns =
+        LatencyStats::to_ns (LatencyStats::now () - start) / records;
+
+    start = LatencyStats::now ();
+    for (unsigned int i = 0; i < records; ++i)
+        stats.record (LatencyStats::_send_, start, 64);
+
+    std::cout << "A now() takes " << now_ns << " ns, a record() "
+              << LatencyStats::to_ns (LatencyStats::now () - start) / records
+                     - now_ns
+              << " ns plus a now()" << std::endl;
+}
+
+// ----------------------------------------------------------------------------
+
+// A pipe is written by this thread and another one. The pipe has all the
+// writes, the threads have their own.
+//
+static bool test_pipe ()  {
+
+    Pipe    pipe ("latency_pipe", 1 << 20);
+    Pipe    quiet ("quiet_pipe");
+    char    buffer [64] = { 0 };
+
+    pipe.connect ();
+    quiet.connect ();
+    pipe.enable_latency_stats ();
+
+    const   counter_type    sent_before =
+        LatencyStats::this_thread ()
+            ? LatencyStats::this_thread ()->get (LatencyStats::_send_)
+                  .get_count ()
+            : 0;
+
+    std::thread writer ([&pipe, &buffer] ()  {
+                            for (unsigned int i = 0; i < COUNT; ++i)
+                                pipe.send (buffer, sizeof (buffer));
+                        });
+
+    for (unsigned int i = 0; i < COUNT; ++i)
+        pipe.send (buffer, sizeof (buffer) / 2);
+    writer.join ();
+    for (unsigned int i = 0; i < COUNT * 3 / 2; ++i)
+        pipe.receive (buffer, sizeof (buffer));
+    quiet.send (buffer, 1);
+    quiet.receive (buffer, 1);
+
+    const   LatencyStats   &stats = *pipe.get_latency_stats ();
+    const   LatencyStats   &mine = *LatencyStats::this_thread ();
+    LatencyStats            threads;
+
+    LatencyStats::merge_threads (threads);
+    print ("Pipe send", stats.get (LatencyStats::_send_));
+    print ("Pipe receive", stats.get (LatencyStats::_receive_));
+
+   // Two writers may race on the pipe's histogram and lose a count
+   //
+    if (quiet.get_latency_stats () ||
+        stats.get (LatencyStats::_send_).get_count () < 2 * COUNT - 10 ||
+        stats.get (LatencyStats::_receive_).get_count () != COUNT * 3 / 2 ||
+        stats.get (LatencyStats::_receive_).get_bytes () !=
+            COUNT * sizeof (buffer) * 3 / 2 ||
+        mine.get (LatencyStats::_send_).get_count () !=
+            sent_before + COUNT ||
+        threads.get (LatencyStats::_send_).get_count () <
+            sent_before + 2 * COUNT)  {
+        std::cout << "ERROR: pipe stats are off" << std::endl;
+        return (false);
+    }
+
+    return (true);
+}
+
+// ----------------------------------------------------------------------------
+
+static bool test_queue ()  {
+
+    MessageQueue<counter_type>  queue ("/latency_test",
+                                       MessageQueue<counter_type>::
+                                           _read_write_,
+                                       10);
+    counter_type                value = 0;
+
+    queue.connect ();
+    queue.enable_latency_stats ();
+    for (unsigned int i = 0; i < COUNT; ++i)  {
+        queue.push (i);
+        queue.pop (value);
+    }
+    queue.remove ();
+
+    const   LatencyStats    &stats = *queue.get_latency_stats ();
+
+    print ("MessageQueue push", stats.get (LatencyStats::_send_));
+    print ("MessageQueue pop", stats.get (LatencyStats::_receive_));
+    if (stats.get (LatencyStats::_send_).get_count () != COUNT ||
+        stats.get (LatencyStats::_receive_).get_bytes () !=
+            COUNT * sizeof (value))  {
+        std::cout << "ERROR: queue stats are off" << std::endl;
+        return (false);
+    }
+
+    return (true);
+}
+
+// ----------------------------------------------------------------------------
+
+static bool test_socket ()  {
+
+    FixedSizeAcceptor   acceptor ("latency_test", PORT,
+                                  SocketBase::_ip_address_, "127.0.0.1");
+
+    acceptor.connect ();
+    acceptor.listen ();
+
+    FixedSizeSocket client ("latency_client",
+                            SocketBase::_ipv4_,
+                            SocketBase::_stream_,
+                            SocketBase::_client_,
+                            PORT,
+                            SocketBase::_ip_address_,
+                            "127.0.0.1");
+
+    client.connect ();
+    client.enable_latency_stats ();
+
+    FixedSizeSocket server = acceptor.accept_socket ();
+
+    server.enable_latency_stats ();
+
+   // The header and body are sent separately, so Nagle would hold the
+   // body until the header is acked
+   //
+    client.disable_nagel_algorithm ();
+    server.disable_nagel_algorithm ();
+
+    const   char                        message [] = "latency";
+    FixedSizeSocket::ReadBufferType     buffer [sizeof (message) + 1];
+
+    for (unsigned int i = 0; i < COUNT; ++i)  {
+        FixedSizeSocket::ReadBufferType *data = NULL;
+
+        client.write (message, sizeof (message));
+        server.read_fixed (buffer);
+        server.write (message, sizeof (message));
+        client.read (&data);
+        delete[] data;
+    }
+
+    const   LatencyStats    &stats = *client.get_latency_stats ();
+
+    print ("FixedSizeSocket write", stats.get (LatencyStats::_send_));
+    print ("FixedSizeSocket read", stats.get (LatencyStats::_receive_));
+    if (stats.get (LatencyStats::_send_).get_count () != COUNT ||
+        stats.get (LatencyStats::_receive_).get_count () != COUNT ||
+        server.get_latency_stats ()->get (LatencyStats::_receive_)
+            .get_bytes () != COUNT * sizeof (message))  {
+        std::cout << "ERROR: socket stats are off" << std::endl;
+        return (false);
+    }
+
+    return (true);
+}
+
+// ----------------------------------------------------------------------------
+
+int main (int argCnt, char *argVctr [])  {
+
+    try  {
+        std::cout << "\n\tTesting LatencyStats ...\n" << std::endl;
+
+        std::cout << LatencyStats::ticks_per_ns () << " ticks per ns"
+                  << std::endl;
+        measure_record ();
+
+        if (! test_histogram () || ! test_pipe () || ! test_queue () ||
+            ! test_socket ())
+            return (EXIT_FAILURE);
+
+        std::cout << "SUCCESS: LatencyStats is working" << std::endl;
+    }
+    catch (const std::exception &ex)  {
+        std::cout << "Exception: " << ex.what () << std::endl;
+        return (EXIT_FAILURE);
+    }
+
+    return (EXIT_SUCCESS);
+}
+
+// ----------------------------------------------------------------------------
+
+// Local Variables:
+// mode:C++
+// tab-width:4
+// c-basic-offset:4
+// End:
@@ -136,27 +136,18 @@ extern "C" void *pusher (void *)  {
 
 extern "C" void *popper (void *)  {
 
-    struct ::timespec   rqt;
-
-    rqt.tv_sec = 1;
-    rqt.tv_nsec = 0;
-
     try  {
         MessageQueue<test_data>  mq (
             "/hossein_test",
             MessageQueue<test_data>::_read_,
             Q_SIZE);
         test_data                       data;
+        WaitStrategy                    ws;
 
         mq.connect ();
         mq.make_nonblocking ();
         while (true)  {
-            if ((mq >> data) ==
-                    MessageQueue<test_data>::_would_block_)  {
-                std::cout << "message queue is empty\n";
-                nanosleep (&rqt, NULL);
-                continue;
-            }
+            mq.pop (data, ws);
 
             std::cout << data.i1 << "\n"
                       << data.d1 << "\n"
@@ -168,6 +159,15 @@ extern "C" void *popper (void *)  {
                 break;
         }
 
+        const   WaitStrategy::Counters  &c = ws.get_counters ();
+
+        std::cout << "Waits: " << c.waits
+                  << "  spin: " << c.spin_hits
+                  << "  pause: " << c.pause_hits
+                  << "  yield: " << c.yield_hits
+                  << "  park: " << c.park_hits
+                  << " (" << c.parks << " parks)" << std::endl;
+
         mq.disconnect ();
         // mq.remove (); // It should be already removed above
     }
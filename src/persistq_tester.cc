@@ -0,0 +1,190 @@
+// Hossein Moein
+// March 25, 2018
+// Copyright (C) 2018-2019 Hossein Moein
+// Distributed under the BSD Software License (see file License)
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+
+#include <PersistentQueue.h>
+
+using namespace hmcom;
+
+// ----------------------------------------------------------------------------
+
+struct  test_data  {
+
+    unsigned long long  id;
+    char                name [32];
+};
+
+typedef PersistentQueue<test_data>  Queue;
+
+static  const   char                *Q_NAME = "/tmp/hmcom_persistq_test";
+static  const   unsigned    int     MSGS_PER_SEG = 100;
+static  const   unsigned    int     RETAINED = 3;
+
+// ----------------------------------------------------------------------------
+
+static bool push_range (unsigned long long from, unsigned long long to)  {
+
+    Queue       writer (Q_NAME, Queue::_write_, "", MSGS_PER_SEG, RETAINED,
+                        Queue::_sync_never_);
+    test_data   data;
+
+    writer.connect ();
+    if (writer.get_sequence () != from)  {
+        std::cout << "ERROR: writer recovered at " << writer.get_sequence ()
+                  << " instead of " << from << std::endl;
+        return (false);
+    }
+
+    for (unsigned long long i = from; i < to; ++i)  {
+        data.id = i;
+        ::snprintf (data.name, sizeof (data.name), "message %llu", i);
+        writer << data;
+    }
+    writer.disconnect ();
+    return (true);
+}
+
+// ----------------------------------------------------------------------------
+
+static bool pop_range (const char *consumer,
+                       unsigned long long from,
+                       unsigned long long to)  {
+
+    Queue       reader (Q_NAME, Queue::_read_, consumer, MSGS_PER_SEG);
+    test_data   data;
+
+    reader.connect ();
+    reader.make_nonblocking ();
+    for (unsigned long long i = from; i < to; ++i)  {
+        if ((reader >> data) ==
+                static_cast<Queue::size_type>(Queue::_would_block_))  {
+            std::cout << "ERROR: " << consumer << " ran dry at " << i
+                      << std::endl;
+            return (false);
+        }
+        if (data.id != i)  {
+            std::cout << "ERROR: " << consumer << " expected " << i
+                      << " but read " << data.id << std::endl;
+            return (false);
+        }
+    }
+    reader.disconnect ();
+    return (true);
+}
+
+// ----------------------------------------------------------------------------
+
+int main (int argCnt, char *argVctr [])  {
+
+    try  {
+        {
+            Queue   q (Q_NAME, Queue::_write_);
+
+            q.remove ();
+        }
+
+        std::cout << "\n\tTesting restart of writer and readers ...\n"
+                  << std::endl;
+
+        if (! push_range (0, 150) || ! push_range (150, 250))
+            return (EXIT_FAILURE);
+        if (! pop_range ("reader_a", 0, 120) ||
+            ! pop_range ("reader_a", 120, 250) ||
+            ! pop_range ("reader_b", 0, 10))
+            return (EXIT_FAILURE);
+
+        {
+            Queue       reader (Q_NAME, Queue::_read_, "reader_a",
+                                MSGS_PER_SEG);
+            test_data   data;
+
+            reader.connect ();
+            reader.make_nonblocking ();
+            if ((reader >> data) !=
+                    static_cast<Queue::size_type>(Queue::_would_block_))  {
+                std::cout << "ERROR: read past the end" << std::endl;
+                return (EXIT_FAILURE);
+            }
+        }
+
+        std::cout << "SUCCESS: positions survive restarts" << std::endl;
+
+        std::cout << "\n\tTesting retention ...\n" << std::endl;
+
+       // reader_b is at 10, but segments 0 - 7 will be gone. The writer
+       // has already rolled over to (empty) segment 10.
+       //
+        if (! push_range (250, 1000))
+            return (EXIT_FAILURE);
+
+        {
+            Queue   reader (Q_NAME, Queue::_read_, "reader_b", MSGS_PER_SEG);
+
+            reader.connect ();
+            if (reader.num_of_msgs_inq () != 200)  {
+                std::cout << "ERROR: num_of_msgs_inq() is "
+                          << reader.num_of_msgs_inq () << std::endl;
+                return (EXIT_FAILURE);
+            }
+        }
+        if (! pop_range ("reader_b", 800, 1000))
+            return (EXIT_FAILURE);
+
+        std::cout << "SUCCESS: retention is working" << std::endl;
+
+        std::cout << "\n\tTesting blocking pop() ...\n" << std::endl;
+
+        bool        ok = true;
+        std::thread rt ([&ok] ()  {
+            Queue       reader (Q_NAME, Queue::_read_, "reader_b",
+                                MSGS_PER_SEG);
+            test_data   data;
+
+            reader.connect ();
+            for (unsigned long long i = 1000; i < 1250; ++i)  {
+                reader >> data;
+                if (data.id != i)  {
+                    std::cout << "ERROR: blocking reader expected " << i
+                              << " but read " << data.id << std::endl;
+                    ok = false;
+                    return;
+                }
+            }
+        });
+
+        std::this_thread::sleep_for (std::chrono::milliseconds (200));
+
+        if (! push_range (1000, 1250))
+            return (EXIT_FAILURE);
+        rt.join ();
+        if (! ok)
+            return (EXIT_FAILURE);
+
+        std::cout << "SUCCESS: blocking pop() is working" << std::endl;
+
+        Queue   q (Q_NAME, Queue::_write_);
+
+        q.remove ();
+    }
+    catch (const std::exception &ex)  {
+        std::cout << "Exception: " << ex.what () << std::endl;
+        return (EXIT_FAILURE);
+    }
+
+    return (EXIT_SUCCESS);
+}
+
+// ----------------------------------------------------------------------------
+
+// Local Variables:
+// mode:C++
+// tab-width:4
+// c-basic-offset:4
+// End:
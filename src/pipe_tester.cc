@@ -0,0 +1,397 @@
+// Hossein Moein
+// March 25, 2018
+// Copyright (C) 2018-2019 Hossein Moein
+// Distributed under the BSD Software License (see file License)
+
+#include <cerrno>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <DMScu_FixedSizeString.h>
+
+#include <Pipe.h>
+#include <FixedSizeSocket.h>
+#include <Acceptor.h>
+#include <Framer.h>
+#include <InProcChannel.h>
+
+using namespace hmcom;
+
+// ----------------------------------------------------------------------------
+
+static  const   Communication::size_type    PIPE_SIZE = 1024 * 1024;
+static  const   Communication::size_type    BLOB_SIZE = 8 * 1024 * 1024;
+static  const   char                        *FILE_NAME =
+    "/tmp/hmcom_pipe_test.dat";
+static  const   in_port_t                   PORT = 27497;
+
+// ----------------------------------------------------------------------------
+
+static void writer (Pipe &pipe, const char *blob)  {
+
+    Communication::size_type    sent = 0;
+
+    while (sent < BLOB_SIZE)
+        sent += pipe.send_vmsplice (blob + sent, BLOB_SIZE - sent);
+
+    return;
+}
+
+// ----------------------------------------------------------------------------
+
+static  const   unsigned    int FRAME_COUNT = 20000;
+
+// Every 1000th frame is bigger than the Framer buffer, the rest are batched
+//
+static inline Communication::size_type frame_size (unsigned int i)  {
+
+    return (i % 1000 == 999 ? 200000 + i : (i * 37) % 3000);
+}
+
+// ----------------------------------------------------------------------------
+
+static void frame_writer (Pipe &pipe,
+                          Framer::HEADER_TYPE header_type,
+                          const char *blob)  {
+
+    Framer  framer (pipe, header_type);
+
+    for (unsigned int i = 0; i < FRAME_COUNT; ++i)
+        framer.write (blob + i % 4096, frame_size (i));
+    framer.flush ();
+
+    return;
+}
+
+// ----------------------------------------------------------------------------
+
+static bool test_framer (Framer::HEADER_TYPE header_type, const char *blob)  {
+
+    Pipe    pipe ("framer_test");
+    Framer  framer (pipe, header_type);
+
+    pipe.connect ();
+
+    std::thread wt (&frame_writer, std::ref (pipe), header_type, blob);
+
+    for (unsigned int i = 0; i < FRAME_COUNT; ++i)  {
+        const   Framer::ReadBufferType  *data;
+        const   int                     the_size = framer.read (&data);
+
+        if (the_size != static_cast<int>(frame_size (i)) ||
+            ::memcmp (data, blob + i % 4096, the_size))  {
+            std::cout << "ERROR: frame " << i << " has " << the_size
+                      << " bytes instead of " << frame_size (i) << std::endl;
+            wt.detach ();
+            return (false);
+        }
+    }
+    wt.join ();
+
+    if (framer.frame_ready ())  {
+        std::cout << "ERROR: extra frames" << std::endl;
+        return (false);
+    }
+
+    return (true);
+}
+
+// ----------------------------------------------------------------------------
+
+// FixedSizeSocket's own receive() waits for the whole buffer. A Framer
+// reads what is there.
+//
+static bool test_framer_socket (const char *blob)  {
+
+    FixedSizeAcceptor   acceptor ("framer_acceptor", PORT,
+                                  SocketBase::_ip_address_, "127.0.0.1");
+
+    acceptor.connect ();
+    acceptor.listen ();
+
+    FixedSizeSocket client ("framer_client",
+                            SocketBase::_ipv4_,
+                            SocketBase::_stream_,
+                            SocketBase::_client_,
+                            PORT,
+                            SocketBase::_ip_address_,
+                            "127.0.0.1");
+
+    client.connect ();
+
+    FixedSizeSocket server = acceptor.accept_socket ();
+    Framer          writer (client);
+    Framer          reader (server);
+
+    for (unsigned int i = 0; i < 3; ++i)
+        writer.write (blob + i, frame_size (i + 1));
+    writer.flush ();
+
+    for (unsigned int i = 0; i < 3; ++i)  {
+        const   Framer::ReadBufferType  *data;
+        const   int                     the_size = reader.read (&data);
+
+        if (the_size != static_cast<int>(frame_size (i + 1)) ||
+            ::memcmp (data, blob + i, the_size))  {
+            std::cout << "ERROR: socket frame " << i << " has " << the_size
+                      << " bytes" << std::endl;
+            return (false);
+        }
+    }
+
+    const   Framer::ReadBufferType  *data;
+
+    server.make_nonblocking ();
+    if (reader.read (&data) != Framer::_would_block_)  {
+        std::cout << "ERROR: empty socket did not block" << std::endl;
+        return (false);
+    }
+
+    return (true);
+}
+
+// ----------------------------------------------------------------------------
+
+// A capacity over pipe-max-size fails connect() without leaking the fds of
+// the pipe. The size is also over what root can set.
+//
+static bool test_capacity_failure ()  {
+
+    Pipe        pipe ("too_big", 0xFFFFFFFFU);
+    const   int next_fd = ::dup (0);
+    bool        thrown = false;
+
+    ::close (next_fd);
+    try  {
+        pipe.connect ();
+    }
+    catch (const std::runtime_error &)  {
+        thrown = true;
+    }
+
+    const   int after_fd = ::dup (0);
+
+    ::close (after_fd);
+    if (! thrown || pipe.is_connected () || pipe.get_read_fd () != -1 ||
+        after_fd != next_fd)  {
+        std::cout << "ERROR: failed connect() leaked the pipe" << std::endl;
+        return (false);
+    }
+
+    return (true);
+}
+
+// ----------------------------------------------------------------------------
+
+// An empty non-blocking pipe and a closed pipe fail without a throw, and
+// the throwing calls still throw
+//
+static bool test_status ()  {
+
+    Pipe    pipe ("status_test");
+    char    buffer [16];
+
+    pipe.connect ();
+    ::fcntl (pipe.get_read_fd (), F_SETFL, O_NONBLOCK);
+
+    const   IOResult<Communication::size_type>  empty =
+        pipe.try_receive (buffer, sizeof (buffer));
+
+    if (empty.ok () || ! empty.would_block () ||
+        empty.status ().operation () != IOStatus::_receive_)  {
+        std::cout << "ERROR: empty pipe did not report EAGAIN" << std::endl;
+        return (false);
+    }
+
+    if (pipe.try_send ("status", 6).value_or (0) != 6 ||
+        pipe.try_receive (buffer, sizeof (buffer)).value_or (0) != 6)  {
+        std::cout << "ERROR: try_send()/try_receive() failed" << std::endl;
+        return (false);
+    }
+
+   // Time the failure path both ways
+   //
+    const   int     count = 100000;
+    auto            start = std::chrono::steady_clock::now ();
+    int             failed = 0;
+
+    for (int i = 0; i < count; ++i)
+        failed += pipe.try_receive (buffer, sizeof (buffer)).ok () ? 0 : 1;
+
+    const   auto    status_ns =
+        std::chrono::duration_cast<std::chrono::nanoseconds>
+            (std::chrono::steady_clock::now () - start).count ();
+
+    start = std::chrono::steady_clock::now ();
+    for (int i = 0; i < count; ++i)  {
+        try  {
+            pipe.receive (buffer, sizeof (buffer));
+        }
+        catch (const std::runtime_error &)  {
+            failed += 1;
+        }
+    }
+
+    const   auto    throw_ns =
+        std::chrono::duration_cast<std::chrono::nanoseconds>
+            (std::chrono::steady_clock::now () - start).count ();
+
+    if (failed != 2 * count)  {
+        std::cout << "ERROR: " << failed << " of " << 2 * count
+                  << " reads failed" << std::endl;
+        return (false);
+    }
+    std::cout << "Failed read with status: "
+              << static_cast<double>(status_ns) / count
+              << " ns, with exception: "
+              << static_cast<double>(throw_ns) / count << " ns" << std::endl;
+
+    pipe.disconnect ();
+
+    const   IOResult<Communication::size_type>  closed =
+        pipe.try_send ("status", 6);
+
+    if (closed.ok () || closed.status ().error () != EBADF)  {
+        std::cout << "ERROR: closed pipe did not report EBADF" << std::endl;
+        return (false);
+    }
+
+    return (true);
+}
+
+// ----------------------------------------------------------------------------
+
+int main (int argCnt, char *argVctr [])  {
+
+    try  {
+        std::cout << "\n\tTesting Pipe capacity ...\n" << std::endl;
+
+        Pipe    pipe ("pipe_test", PIPE_SIZE);
+
+        pipe.connect ();
+        if (pipe.get_capacity () < PIPE_SIZE)  {
+            std::cout << "ERROR: capacity is " << pipe.get_capacity ()
+                      << std::endl;
+            return (EXIT_FAILURE);
+        }
+        std::cout << "SUCCESS: capacity is " << pipe.get_capacity ()
+                  << std::endl;
+
+        std::cout << "\n\tTesting vmsplice() into and splice() out of Pipe ...\n"
+                  << std::endl;
+
+       // The writer must not touch the blob until it is all consumed
+       //
+        std::vector<char>   blob (BLOB_SIZE);
+
+        for (Communication::size_type i = 0; i < BLOB_SIZE; ++i)
+            blob [i] = static_cast<char>(i * 7 + (i >> 12));
+
+        const   int fd = ::open (FILE_NAME, O_CREAT | O_TRUNC | O_RDWR, 0640);
+
+        if (fd < 0)  {
+            std::cout << "ERROR: cannot open " << FILE_NAME << std::endl;
+            return (EXIT_FAILURE);
+        }
+
+        std::thread                 wt (&writer, std::ref (pipe), &(blob [0]));
+        Communication::size_type    moved = 0;
+
+        while (moved < BLOB_SIZE)  {
+            const   int ret = pipe.splice_to (fd, BLOB_SIZE - moved);
+
+            if (ret <= 0)  {
+                std::cout << "ERROR: splice_to() returned " << ret
+                          << std::endl;
+                return (EXIT_FAILURE);
+            }
+            moved += ret;
+        }
+        wt.join ();
+
+        std::vector<char>   copy (BLOB_SIZE);
+
+        if (::pread (fd, &(copy [0]), BLOB_SIZE, 0) !=
+                static_cast<ssize_t>(BLOB_SIZE) ||
+            ::memcmp (&(copy [0]), &(blob [0]), BLOB_SIZE))  {
+            std::cout << "ERROR: file content does not match" << std::endl;
+            return (EXIT_FAILURE);
+        }
+
+        std::cout << "SUCCESS: moved " << moved << " bytes" << std::endl;
+
+        std::cout << "\n\tTesting splice() into Pipe ...\n" << std::endl;
+
+        loff_t  offset = 4096;
+
+        if (pipe.splice_from (fd, 100, &offset) != 100 || offset != 4196)  {
+            std::cout << "ERROR: splice_from() failed" << std::endl;
+            return (EXIT_FAILURE);
+        }
+
+        char    buffer [100];
+
+        if (pipe.receive (buffer, sizeof (buffer)) != sizeof (buffer) ||
+            ::memcmp (buffer, &(blob [4096]), sizeof (buffer)))  {
+            std::cout << "ERROR: received content does not match" << std::endl;
+            return (EXIT_FAILURE);
+        }
+
+        std::cout << "SUCCESS: splice() into Pipe is working" << std::endl;
+
+        std::cout << "\n\tTesting Framer over Pipe ...\n" << std::endl;
+
+        if (! test_framer (Framer::_fast_, &(blob [0])) ||
+            ! test_framer (Framer::_ascii_, &(blob [0])) ||
+            ! test_framer_socket (&(blob [0])))
+            return (EXIT_FAILURE);
+
+        InProcChannel<int>  channel ("framer_channel");
+        bool                rejected = false;
+
+        try  {
+            Framer  framer (channel);
+        }
+        catch (const std::runtime_error &)  {
+            rejected = true;
+        }
+        if (! rejected)  {
+            std::cout << "ERROR: Framer took a message channel" << std::endl;
+            return (EXIT_FAILURE);
+        }
+
+        std::cout << "SUCCESS: Framer is working" << std::endl;
+
+        std::cout << "\n\tTesting Pipe no-throw calls ...\n" << std::endl;
+
+        if (! test_status () || ! test_capacity_failure ())
+            return (EXIT_FAILURE);
+
+        std::cout << "SUCCESS: no-throw calls are working" << std::endl;
+
+        ::close (fd);
+        ::unlink (FILE_NAME);
+    }
+    catch (const std::exception &ex)  {
+        std::cout << "Exception: " << ex.what () << std::endl;
+        return (EXIT_FAILURE);
+    }
+
+    return (EXIT_SUCCESS);
+}
+
+// ----------------------------------------------------------------------------
+
+// Local Variables:
+// mode:C++
+// tab-width:4
+// c-basic-offset:4
+// End:
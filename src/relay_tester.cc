@@ -0,0 +1,242 @@
+// Hossein Moein
+// March 25, 2018
+// Copyright (C) 2018-2019 Hossein Moein
+// Distributed under the BSD Software License (see file License)
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <DMScu_FixedSizeString.h>
+
+#include <RegularSocket.h>
+#include <SpliceRelay.h>
+
+using namespace hmcom;
+
+// ----------------------------------------------------------------------------
+
+static  const   unsigned    long long   TOTAL_BYTES = 64ULL * 1024 * 1024;
+
+// ----------------------------------------------------------------------------
+
+// Wraps one end of a socketpair() in a RegularSocket
+//
+static void adopt (RegularSocket &soc, int fd)  {
+
+    soc.set_fd (fd);
+    soc.set_connected (true);
+    return;
+}
+
+// ----------------------------------------------------------------------------
+
+static void producer (int fd)  {
+
+    unsigned    char        buffer [64 * 1024];
+    unsigned    long long   sent = 0;
+
+    while (sent < TOTAL_BYTES)  {
+        for (unsigned int i = 0; i < sizeof (buffer); ++i)
+            buffer [i] = static_cast<unsigned char>((sent + i) % 251);
+
+        for (size_t done = 0; done < sizeof (buffer); )  {
+            const   ssize_t ret =
+                ::send (fd, buffer + done, sizeof (buffer) - done, 0);
+
+            if (ret <= 0)
+                return;
+            done += ret;
+        }
+        sent += sizeof (buffer);
+    }
+    ::shutdown (fd, SHUT_WR);
+
+    return;
+}
+
+// ----------------------------------------------------------------------------
+
+static void consumer (int fd, bool &ok)  {
+
+    unsigned    char        buffer [32 * 1024];
+    unsigned    long long   received = 0;
+
+    ok = false;
+    while (true)  {
+        const   ssize_t ret = ::recv (fd, buffer, sizeof (buffer), 0);
+
+        if (ret <= 0)
+            break;
+        for (ssize_t i = 0; i < ret; ++i)
+            if (buffer [i] !=
+                    static_cast<unsigned char>((received + i) % 251))  {
+                std::cout << "ERROR: corrupt byte at " << received + i
+                          << std::endl;
+                return;
+            }
+        received += ret;
+
+       // Be slower than the producer now and then, to exercise
+       // back pressure
+       //
+        if ((received / sizeof (buffer)) % 256 == 0)
+            std::this_thread::sleep_for (std::chrono::milliseconds (1));
+    }
+
+    ok = received == TOTAL_BYTES;
+    if (! ok)
+        std::cout << "ERROR: received " << received << " bytes" << std::endl;
+    return;
+}
+
+// ----------------------------------------------------------------------------
+
+// A destination whose peer is gone makes relay() throw EPIPE. Without
+// SIGPIPE blocked, it would kill the process.
+//
+static bool test_reset_peer ()  {
+
+    int in_fds [2];
+    int out_fds [2];
+
+    if (::socketpair (AF_UNIX, SOCK_STREAM, 0, in_fds) < 0 ||
+        ::socketpair (AF_UNIX, SOCK_STREAM, 0, out_fds) < 0)  {
+        std::cout << "ERROR: socketpair() failed" << std::endl;
+        return (false);
+    }
+
+    RegularSocket   source ("source", RegularSocket::_ipv4_,
+                            RegularSocket::_stream_,
+                            RegularSocket::_server_, 0);
+    RegularSocket   destination ("destination", RegularSocket::_ipv4_,
+                                 RegularSocket::_stream_,
+                                 RegularSocket::_client_, 0);
+
+    adopt (source, in_fds [1]);
+    adopt (destination, out_fds [0]);
+    source.make_nonblocking ();
+    destination.make_nonblocking ();
+
+    SpliceRelay relay ("reset_relay", source, destination);
+    bool        failed = false;
+
+    relay.connect ();
+    ::close (out_fds [1]);
+    ::send (in_fds [0], "lost", 4, 0);
+    try  {
+        relay.relay ();
+    }
+    catch (const std::runtime_error &ex)  {
+        failed = ::strstr (ex.what (), ::strerror (EPIPE)) != NULL;
+    }
+    ::close (in_fds [0]);
+
+    if (! failed || relay.get_type () != Communication::_splice_relay_)  {
+        std::cout << "ERROR: relay to a closed peer did not fail with EPIPE"
+                  << std::endl;
+        return (false);
+    }
+
+    return (true);
+}
+
+// ----------------------------------------------------------------------------
+
+int main (int argCnt, char *argVctr [])  {
+
+    try  {
+        std::cout << "\n\tTesting SpliceRelay ...\n" << std::endl;
+
+        int in_fds [2];
+        int out_fds [2];
+
+        if (::socketpair (AF_UNIX, SOCK_STREAM, 0, in_fds) < 0 ||
+            ::socketpair (AF_UNIX, SOCK_STREAM, 0, out_fds) < 0)  {
+            std::cout << "ERROR: socketpair() failed" << std::endl;
+            return (EXIT_FAILURE);
+        }
+
+        RegularSocket   source ("source", RegularSocket::_ipv4_,
+                                RegularSocket::_stream_,
+                                RegularSocket::_server_, 0);
+        RegularSocket   destination ("destination", RegularSocket::_ipv4_,
+                                     RegularSocket::_stream_,
+                                     RegularSocket::_client_, 0);
+
+        adopt (source, in_fds [1]);
+        adopt (destination, out_fds [0]);
+        source.make_nonblocking ();
+        destination.make_nonblocking ();
+
+        SpliceRelay relay ("relay", source, destination, 256 * 1024);
+
+        relay.connect ();
+
+        bool        ok = false;
+        std::thread pt (&producer, in_fds [0]);
+        std::thread ct (&consumer, out_fds [1], std::ref (ok));
+
+        while (true)  {
+            struct  pollfd  pfds [2];
+            nfds_t          n = 0;
+
+            if (relay.wants_read ())  {
+                pfds [n].fd = relay.get_read_fd ();
+                pfds [n++].events = POLLIN;
+            }
+            if (relay.wants_write ())  {
+                pfds [n].fd = relay.get_write_fd ();
+                pfds [n++].events = POLLOUT;
+            }
+            if (::poll (pfds, n, 5000) <= 0)  {
+                std::cout << "ERROR: poll() timed out" << std::endl;
+                return (EXIT_FAILURE);
+            }
+
+            if (relay.relay () == SpliceRelay::_closed_)
+                break;
+        }
+
+        destination.disconnect ();
+        pt.join ();
+        ct.join ();
+        if (! ok || relay.get_bytes_out () != TOTAL_BYTES)
+            return (EXIT_FAILURE);
+
+        std::cout << "Relayed " << relay.get_bytes_out () << " bytes in "
+                  << relay.get_splices () << " splices" << std::endl;
+        std::cout << "SUCCESS: SpliceRelay is working" << std::endl;
+
+        relay.disconnect ();
+        source.disconnect ();
+        ::close (in_fds [0]);
+        ::close (out_fds [1]);
+
+        if (! test_reset_peer ())
+            return (EXIT_FAILURE);
+        std::cout << "SUCCESS: a reset peer is an error, not a SIGPIPE"
+                  << std::endl;
+    }
+    catch (const std::exception &ex)  {
+        std::cout << "Exception: " << ex.what () << std::endl;
+        return (EXIT_FAILURE);
+    }
+
+    return (EXIT_SUCCESS);
+}
+
+// ----------------------------------------------------------------------------
+
+// Local Variables:
+// mode:C++
+// tab-width:4
+// c-basic-offset:4
+// End:
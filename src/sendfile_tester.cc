@@ -0,0 +1,213 @@
+// Hossein Moein
+// March 25, 2018
+// Copyright (C) 2018-2019 Hossein Moein
+// Distributed under the BSD Software License (see file License)
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <DMScu_FixedSizeString.h>
+
+#include <FixedSizeSocket.h>
+
+using namespace hmcom;
+
+// ----------------------------------------------------------------------------
+
+static  const   char                        *FILE_NAME =
+    "/tmp/hmcom_sendfile_test.dat";
+static  const   FixedSizeSocket::size_type  FILE_SIZE = 3 * 1024 * 1024 + 17;
+
+// ----------------------------------------------------------------------------
+
+static void adopt (FixedSizeSocket &soc, int fd)  {
+
+    soc.set_fd (fd);
+    soc.set_connected (true);
+    return;
+}
+
+// ----------------------------------------------------------------------------
+
+static void receiver (FixedSizeSocket &soc,
+                      const std::vector<char> &content,
+                      off_t offset,
+                      FixedSizeSocket::size_type length,
+                      bool &ok)  {
+
+    FixedSizeSocket::ReadBufferType *data = NULL;
+
+    ok = false;
+    try  {
+        const   FixedSizeSocket::size_type  the_size = soc.read (&data);
+
+        if (the_size != length)
+            std::cout << "ERROR: received " << the_size << " bytes instead of "
+                      << length << std::endl;
+        else if (::memcmp (data, &(content [offset]), length))
+            std::cout << "ERROR: received content does not match"
+                      << std::endl;
+        else
+            ok = true;
+    }
+    catch (const std::exception &ex)  {
+        std::cout << "receiver(): Exception: " << ex.what () << std::endl;
+    }
+
+    delete[] data;
+    return;
+}
+
+// ----------------------------------------------------------------------------
+
+static bool test_send_file (bool use_fast,
+                            bool blocking,
+                            int file_fd,
+                            const std::vector<char> &content,
+                            off_t offset,
+                            FixedSizeSocket::size_type length)  {
+
+    int fds [2];
+
+    if (::socketpair (AF_UNIX, SOCK_STREAM, 0, fds) < 0)  {
+        std::cout << "ERROR: socketpair() failed" << std::endl;
+        return (false);
+    }
+
+    FixedSizeSocket sender ("sender", FixedSizeSocket::_ipv4_,
+                            FixedSizeSocket::_stream_,
+                            FixedSizeSocket::_client_, 0,
+                            FixedSizeSocket::_name_, NULL,
+                            FixedSizeSocket::_connected_, use_fast);
+    FixedSizeSocket recver ("receiver", FixedSizeSocket::_ipv4_,
+                            FixedSizeSocket::_stream_,
+                            FixedSizeSocket::_server_, 0,
+                            FixedSizeSocket::_name_, NULL,
+                            FixedSizeSocket::_connected_, use_fast);
+
+    adopt (sender, fds [0]);
+    adopt (recver, fds [1]);
+    if (! blocking)
+        sender.make_nonblocking ();
+
+    bool        ok = false;
+    std::thread rt (&receiver, std::ref (recver), std::cref (content),
+                    offset, length, std::ref (ok));
+
+    FixedSizeSocket::SocketWriteDetail  detail;
+    unsigned    int                     calls = 0;
+
+    sender.send_file (file_fd, offset, length, NULL, &detail);
+    calls += 1;
+    while (! detail.has_hdr_sent || detail.msg_sent < length)  {
+        struct  pollfd  pfd = { sender.get_fd (), POLLOUT, 0 };
+
+        ::poll (&pfd, 1, 1000);
+        sender.send_file (file_fd, offset, length, &detail, &detail);
+        calls += 1;
+    }
+    rt.join ();
+
+    std::cout << (use_fast ? "FAST" : "ASCII") << " header, "
+              << (blocking ? "blocking" : "non-blocking") << ": sent "
+              << detail.msg_sent << " bytes in " << calls << " calls"
+              << std::endl;
+    return (ok);
+}
+
+// ----------------------------------------------------------------------------
+
+// Without SIGPIPE blocked, ::sendfile() to a closed peer kills the process
+//
+static bool test_reset_peer (int file_fd)  {
+
+    int fds [2];
+
+    if (::socketpair (AF_UNIX, SOCK_STREAM, 0, fds) < 0)  {
+        std::cout << "ERROR: socketpair() failed" << std::endl;
+        return (false);
+    }
+
+    FixedSizeSocket sender ("sender", FixedSizeSocket::_ipv4_,
+                            FixedSizeSocket::_stream_,
+                            FixedSizeSocket::_client_, 0);
+    off_t           offset = 0;
+
+    adopt (sender, fds [0]);
+    ::close (fds [1]);
+
+    const   IOResult<FixedSizeSocket::size_type>    result =
+        sender.try_send_file (file_fd, offset, FILE_SIZE);
+
+    if (result.ok () || result.status ().error () != EPIPE)  {
+        std::cout << "ERROR: send_file() to a closed peer did not fail "
+                     "with EPIPE" << std::endl;
+        return (false);
+    }
+
+    return (true);
+}
+
+// ----------------------------------------------------------------------------
+
+int main (int argCnt, char *argVctr [])  {
+
+    try  {
+        std::cout << "\n\tTesting FixedSizeSocket::send_file() ...\n"
+                  << std::endl;
+
+        std::vector<char>   content (FILE_SIZE);
+
+        for (FixedSizeSocket::size_type i = 0; i < FILE_SIZE; ++i)
+            content [i] = static_cast<char>(i % 253);
+
+        const   int fd = ::open (FILE_NAME, O_CREAT | O_TRUNC | O_RDWR, 0640);
+
+        if (fd < 0 ||
+            ::write (fd, &(content [0]), FILE_SIZE) !=
+                static_cast<ssize_t>(FILE_SIZE))  {
+            std::cout << "ERROR: cannot write " << FILE_NAME << std::endl;
+            return (EXIT_FAILURE);
+        }
+
+        if (! test_send_file (true, true, fd, content, 0, FILE_SIZE) ||
+            ! test_send_file (true, false, fd, content, 0, FILE_SIZE) ||
+            ! test_send_file (false, false, fd, content, 1000, 500000) ||
+            ! test_send_file (false, true, fd, content, 4096, 0))
+            return (EXIT_FAILURE);
+
+        std::cout << "SUCCESS: send_file() is working" << std::endl;
+
+        if (! test_reset_peer (fd))
+            return (EXIT_FAILURE);
+        std::cout << "SUCCESS: a reset peer is an error, not a SIGPIPE"
+                  << std::endl;
+
+        ::close (fd);
+        ::unlink (FILE_NAME);
+    }
+    catch (const std::exception &ex)  {
+        std::cout << "Exception: " << ex.what () << std::endl;
+        return (EXIT_FAILURE);
+    }
+
+    return (EXIT_SUCCESS);
+}
+
+// ----------------------------------------------------------------------------
+
+// Local Variables:
+// mode:C++
+// tab-width:4
+// c-basic-offset:4
+// End:
@@ -0,0 +1,261 @@
+// Hossein Moein
+// March 25, 2018
+// Copyright (C) 2018-2019 Hossein Moein
+// Distributed under the BSD Software License (see file License)
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <thread>
+#include <atomic>
+
+#include <BroadcastBus.h>
+#include <LatestValueCache.h>
+
+using namespace hmcom;
+
+// ----------------------------------------------------------------------------
+
+struct  tick_data  {
+
+    unsigned long long  id;
+    char                symbol [8];
+    double              price;
+    unsigned long long  check;
+};
+
+static  const   char                *BUS_NAME = "/hmcom_bus_test";
+static  const   char                *CACHE_NAME = "/hmcom_cache_test";
+static  const   unsigned long long  MSG_COUNT = 1000000ULL;
+static  const   unsigned int        KEY_COUNT = 100;
+
+// ----------------------------------------------------------------------------
+
+static bool bus_reader (int reader_id, bool &ok)  {
+
+    typedef BroadcastBus<tick_data> Bus;
+
+    ok = false;
+    try  {
+        Bus                 bus (BUS_NAME, Bus::_reader_);
+        tick_data           data;
+        unsigned long long  received = 0;
+        unsigned long long  last_id = 0;
+        bool                first = true;
+        WaitStrategy        ws = WaitStrategy::low_latency ();
+
+        bus.connect ();
+        while (true)  {
+           // The second reader waits through a WaitStrategy instead of
+           // blocking in the kernel right away
+           //
+            const   Bus::size_type  ret =
+                reader_id == 2 ? bus.pop (data, ws) : bus >> data;
+
+            if (ret == static_cast<Bus::size_type>(Bus::_lagged_))
+                continue;
+
+            if (! first && data.id <= last_id)  {
+                std::cout << "Reader " << reader_id << ": out of order id "
+                          << data.id << " after " << last_id << std::endl;
+                return (false);
+            }
+            if (data.check != data.id * 3 || ::strcmp (data.symbol, "IBM"))  {
+                std::cout << "Reader " << reader_id << ": torn message "
+                          << data.id << std::endl;
+                return (false);
+            }
+
+            first = false;
+            last_id = data.id;
+            received += 1;
+            if (data.id == MSG_COUNT - 1)
+                break;
+        }
+
+        std::cout << "Reader " << reader_id << ": received " << received
+                  << " dropped " << bus.get_dropped () << std::endl;
+        if (reader_id == 2)
+            std::cout << "Reader 2: waits " << ws.get_counters ().waits
+                      << " parks " << ws.get_counters ().parks << std::endl;
+        bus.disconnect ();
+    }
+    catch (const std::exception &ex)  {
+        std::cout << "Reader " << reader_id << ": Exception: "
+                  << ex.what () << std::endl;
+        return (false);
+    }
+
+    ok = true;
+    return (true);
+}
+
+// ----------------------------------------------------------------------------
+
+static bool test_broadcast_bus ()  {
+
+    typedef BroadcastBus<tick_data> Bus;
+
+    std::cout << "\n\tTesting BroadcastBus ...\n" << std::endl;
+
+    Bus writer (BUS_NAME, Bus::_writer_, 1000);
+
+    writer.connect ();
+    if (writer.get_capacity () != 1024)  {
+        std::cout << "ERROR: capacity was not rounded up" << std::endl;
+        return (false);
+    }
+
+    {
+        Bus         reader (BUS_NAME, Bus::_reader_);
+        tick_data   data;
+
+        reader.connect ();
+        reader.make_nonblocking ();
+        if ((reader >> data) != static_cast<Bus::size_type>(Bus::_would_block_))  {
+            std::cout << "ERROR: empty bus did not return _would_block_"
+                      << std::endl;
+            return (false);
+        }
+    }
+
+    bool        ok1 = false;
+    bool        ok2 = false;
+    std::thread r1 (&bus_reader, 1, std::ref (ok1));
+    std::thread r2 (&bus_reader, 2, std::ref (ok2));
+    tick_data   data;
+
+   // Give the readers a chance to attach before publishing starts
+   //
+    std::this_thread::sleep_for (std::chrono::milliseconds (200));
+
+    ::memset (&data, 0, sizeof (data));
+    ::strcpy (data.symbol, "IBM");
+    for (unsigned long long i = 0; i < MSG_COUNT; ++i)  {
+        data.id = i;
+        data.price = 100.0 + i;
+        data.check = i * 3;
+        writer << data;
+    }
+
+    r1.join ();
+    r2.join ();
+    writer.remove ();
+
+    if (! ok1 || ! ok2)  {
+        std::cout << "ERROR: BroadcastBus readers failed" << std::endl;
+        return (false);
+    }
+
+    std::cout << "SUCCESS: BroadcastBus is working" << std::endl;
+    return (true);
+}
+
+// ----------------------------------------------------------------------------
+
+static bool test_latest_value_cache ()  {
+
+    typedef LatestValueCache<unsigned int, tick_data>   Cache;
+
+    std::cout << "\n\tTesting LatestValueCache ...\n" << std::endl;
+
+    Cache   writer (CACHE_NAME, Cache::_writer_, KEY_COUNT);
+    Cache   reader (CACHE_NAME, Cache::_reader_);
+
+    writer.connect ();
+    reader.connect ();
+
+    tick_data   data;
+
+    ::memset (&data, 0, sizeof (data));
+    ::strcpy (data.symbol, "IBM");
+    if (reader.get (7, data))  {
+        std::cout << "ERROR: found a key that was never published"
+                  << std::endl;
+        return (false);
+    }
+
+    for (unsigned int key = 0; key < KEY_COUNT; ++key)
+        writer.publish (key, data);
+    if (writer.publish (KEY_COUNT, data))  {
+        std::cout << "ERROR: published past capacity" << std::endl;
+        return (false);
+    }
+    if (reader.size () != KEY_COUNT)  {
+        std::cout << "ERROR: size() is " << reader.size () << std::endl;
+        return (false);
+    }
+
+    std::atomic<bool>   done (false);
+    std::thread wt ([&writer, &done] ()  {
+        tick_data   data;
+
+        ::memset (&data, 0, sizeof (data));
+        ::strcpy (data.symbol, "IBM");
+        for (unsigned long long i = 1; i <= MSG_COUNT; ++i)  {
+            data.id = i;
+            data.check = i * 3;
+            writer.publish (static_cast<unsigned int>(i % KEY_COUNT), data);
+        }
+        done = true;
+    });
+
+    unsigned long long  reads = 0;
+    unsigned long long  last_id [KEY_COUNT] = { 0 };
+
+    while (! done)  {
+        for (unsigned int key = 0; key < KEY_COUNT; ++key, ++reads)  {
+            Cache::version_type version;
+
+            if (! reader.get (key, data, &version))  {
+                std::cout << "ERROR: lost key " << key << std::endl;
+                wt.join ();
+                return (false);
+            }
+            if (data.check != data.id * 3 || data.id < last_id [key] ||
+                (data.id != 0 && data.id % KEY_COUNT != key))  {
+                std::cout << "ERROR: torn or stale value for key " << key
+                          << std::endl;
+                wt.join ();
+                return (false);
+            }
+            last_id [key] = data.id;
+        }
+    }
+    wt.join ();
+
+    reader.get (1, data);
+    if (data.id != (MSG_COUNT - 1) / KEY_COUNT * KEY_COUNT + 1)  {
+        std::cout << "ERROR: key 1 does not hold the latest value"
+                  << std::endl;
+        return (false);
+    }
+
+    std::cout << "Reader took " << reads << " snapshots" << std::endl;
+    reader.disconnect ();
+    writer.remove ();
+
+    std::cout << "SUCCESS: LatestValueCache is working" << std::endl;
+    return (true);
+}
+
+// ----------------------------------------------------------------------------
+
+int main (int argCnt, char *argVctr [])  {
+
+    if (! test_broadcast_bus ())
+        return (EXIT_FAILURE);
+    if (! test_latest_value_cache ())
+        return (EXIT_FAILURE);
+
+    return (EXIT_SUCCESS);
+}
+
+// ----------------------------------------------------------------------------
+
+// Local Variables:
+// mode:C++
+// tab-width:4
+// c-basic-offset:4
+// End:
@@ -14,6 +14,7 @@
 #include <RegularSocket.h>
 #include <Acceptor.h>
 #include <Pipe.h>
+#include <Framer.h>
 #include <Selector.h>
 
 using namespace hmcom;
@@ -177,6 +178,7 @@ class   PipeServer  {
 
                 struct   timespec       rqt;
                 const    unsigned   int max_count = 10;
+                Framer                  framer (pipe_);
 
                 for (unsigned int i = 0; i < max_count; ++i)  {
                     rqt.tv_sec = 5;
@@ -186,7 +188,10 @@ class   PipeServer  {
                     DMScu_FixedSizeString<31>  buffer;
 
                     buffer.printf ("%02d", i);
-                    pipe_.send (buffer.c_str (), 2);
+                    framer.write (buffer.c_str (), buffer.size ());
+                    buffer.printf ("message %02d", i);
+                    framer.write (buffer.c_str (), buffer.size ());
+                    framer.flush ();
                     std::cout << "PipeServer wrote: '" << buffer.c_str ()
                               << "'." << std::endl;
                 }
@@ -216,6 +221,7 @@ class   PipeClient  {
             try  {
                 struct  timespec                      rqt;
                 const   unsigned    int               max_count = 10;
+                Framer                                framer (pipe_);
                 const    Pipe::SELECT_RESULT   sr =
                     pipe_.select (true, 300);
 
@@ -234,14 +240,21 @@ class   PipeClient  {
                     rqt.tv_nsec = 0;
                     nanosleep (&rqt, NULL);
 
-                    char                                        buffer [3];
-                    const   FixedSizeSocket::size_type   the_size =
-                        pipe_.receive (&buffer, 2);
-
-                    if (the_size > 0)  {
-                        buffer [the_size] = 0;
-                        std::cout << "PipeClient read: '" << buffer << "'."
-                                  << std::endl;
+                   // Each read() returns exactly one message, although
+                   // both messages of a round arrive in one pipe read.
+                   //
+                    for (unsigned int j = 0; j < 2; ++j)  {
+                        const   Framer::ReadBufferType  *data;
+                        const   int                     the_size =
+                            framer.read (&data);
+
+                        if (the_size >= 0)
+                            std::cout << "PipeClient read: '"
+                                      << std::string (
+                                             reinterpret_cast<const char *>
+                                                 (data),
+                                             the_size)
+                                      << "'." << std::endl;
                     }
                 }
             }
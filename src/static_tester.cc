@@ -0,0 +1,255 @@
+// Hossein Moein
+// March 25, 2018
+// Copyright (C) 2018-2019 Hossein Moein
+// Distributed under the BSD Software License (see file License)
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <sys/socket.h>
+
+#include <RegularSocket.h>
+#include <Acceptor.h>
+#include <Selector.h>
+#include <StaticCommunication.h>
+
+using namespace hmcom;
+
+// ----------------------------------------------------------------------------
+
+// The same code for every transport, with no virtual call in it
+//
+template<class com_TRANSPORT>
+static bool round_trip (com_TRANSPORT &from, com_TRANSPORT &to)  {
+
+    static  const   char    message [] = "static dispatch";
+    char                    buffer [sizeof (message)];
+
+    if (from.send (message, sizeof (message)) != sizeof (message) ||
+        to.receive (buffer, sizeof (buffer)) != sizeof (buffer) ||
+        ::memcmp (buffer, message, sizeof (message)))  {
+        std::cout << "ERROR: round trip failed" << std::endl;
+        return (false);
+    }
+
+   // Nothing left to read. try_receive() reports it, receive() returns
+   // _try_again_.
+   //
+    if (! to.make_nonblocking ().ok ())  {
+        std::cout << "ERROR: make_nonblocking() failed" << std::endl;
+        return (false);
+    }
+
+    const   IOResult<Communication::size_type>  empty =
+        to.try_receive (buffer, sizeof (buffer));
+
+    if (! empty.would_block () ||
+        to.receive (buffer, sizeof (buffer)) != Communication::_try_again_)  {
+        std::cout << "ERROR: empty transport did not report EAGAIN"
+                  << std::endl;
+        return (false);
+    }
+
+    return (to.make_blocking ().ok ());
+}
+
+// ----------------------------------------------------------------------------
+
+static  const   in_port_t   PORT = 27491;
+
+static inline RegularSocket make_client ()  {
+
+    return (RegularSocket ("move_client",
+                           SocketBase::_ipv4_,
+                           SocketBase::_stream_,
+                           SocketBase::_client_,
+                           PORT,
+                           SocketBase::_ip_address_,
+                           "127.0.0.1"));
+}
+
+// ----------------------------------------------------------------------------
+
+// Connections kept by value in vectors, that move them as they grow, and
+// accepted all three ways
+//
+static bool test_moves ()  {
+
+    RegularAcceptor acceptor ("move_test", PORT,
+                              SocketBase::_ip_address_, "127.0.0.1");
+
+    acceptor.connect ();
+    acceptor.listen ();
+
+    std::vector<RegularSocket>  clients;
+
+    for (int i = 0; i < 3; ++i)  {
+        RegularSocket   client = make_client ();
+
+        client.connect ();
+
+        const   int fd = client.get_fd ();
+
+        clients.push_back (std::move (client));
+        if (client.is_connected () || clients.back ().get_fd () != fd)  {
+            std::cout << "ERROR: the fd did not move" << std::endl;
+            return (false);
+        }
+    }
+
+    std::vector<RegularSocket>  servers;
+
+    servers.push_back (acceptor.accept_socket ());
+    servers.push_back (make_client ());
+    if (! acceptor.try_accept_into (servers.back ()).ok ())  {
+        std::cout << "ERROR: try_accept_into() failed" << std::endl;
+        return (false);
+    }
+
+    alignas (RegularSocket) unsigned char   storage [sizeof (RegularSocket)];
+    const   IOResult<RegularSocket *>       at =
+        acceptor.try_accept_at (storage);
+
+    if (! at.ok () || static_cast<void *>(*at) != storage)  {
+        std::cout << "ERROR: try_accept_at() failed" << std::endl;
+        return (false);
+    }
+    servers.push_back (std::move (**at));
+    (*at)->~RegularSocket ();
+
+    for (int i = 0; i < 3; ++i)  {
+        const   char    sent = static_cast<char>('a' + i);
+        char            received = 0;
+
+        if (clients [i].send (&sent, 1) != 1 ||
+            servers [i].receive (&received, 1) != 1 || received != sent)  {
+            std::cout << "ERROR: connection " << i << " is crossed"
+                      << std::endl;
+            return (false);
+        }
+    }
+
+   // Moving over a connected socket closes the old connection, so its
+   // client reads EOF
+   //
+    char    c;
+
+    servers [0] = std::move (servers [2]);
+    if (clients [0].receive (&c, 1) != 0 || servers [2].is_connected ())  {
+        std::cout << "ERROR: move assignment did not close" << std::endl;
+        return (false);
+    }
+
+    acceptor.make_nonblocking ();
+
+    RegularSocket   none = make_client ();
+
+    if (! acceptor.try_accept_into (none).would_block ())  {
+        std::cout << "ERROR: empty acceptor did not report EAGAIN"
+                  << std::endl;
+        return (false);
+    }
+
+    return (true);
+}
+
+// ----------------------------------------------------------------------------
+
+int main (int argCnt, char *argVctr [])  {
+
+    try  {
+        std::cout << "\n\tTesting StaticPipe ...\n" << std::endl;
+
+        StaticPipe  pipe;
+
+        if (! pipe.open ().ok () || ! round_trip (pipe, pipe))
+            return (EXIT_FAILURE);
+        if (pipe.open ().error () != EBUSY)  {
+            std::cout << "ERROR: pipe was opened twice" << std::endl;
+            return (EXIT_FAILURE);
+        }
+        std::cout << "SUCCESS: StaticPipe is working" << std::endl;
+
+        std::cout << "\n\tTesting StaticSocket ...\n" << std::endl;
+
+        int fds [2];
+
+        if (::socketpair (AF_UNIX, SOCK_STREAM, 0, fds) < 0)  {
+            std::cout << "ERROR: cannot make a socket pair" << std::endl;
+            return (EXIT_FAILURE);
+        }
+
+        StaticSocket    left (fds [0]);
+        StaticSocket    right (fds [1]);
+
+        if (! round_trip (left, right) || ! round_trip (right, left))
+            return (EXIT_FAILURE);
+        std::cout << "SUCCESS: StaticSocket is working" << std::endl;
+
+        std::cout << "\n\tTesting CommunicationAdapter with Selector ...\n"
+                  << std::endl;
+
+        CommunicationAdapter<StaticSocket>  adapter (right, "right");
+        CommunicationAdapter<StaticPipe>    pipe_adapter (pipe, "pipe");
+        Selector                            selector (2);
+
+        selector.add_communication (&adapter);
+        selector.add_communication (&pipe_adapter);
+        left.send ("x", 1);
+
+        if (! selector.select (Selector::_read_, 5) ||
+            selector.get_result ().size () != 1 ||
+            selector.get_result () [0].com != &adapter ||
+            selector.get_result () [0].result != Selector::_read_ready_)  {
+            std::cout << "ERROR: Selector did not see the adapter ready"
+                      << std::endl;
+            return (EXIT_FAILURE);
+        }
+
+        char    c = 0;
+
+        if (selector.get_result () [0].com->receive (&c, 1) != 1 ||
+            c != 'x' || adapter.get_type () != Communication::_socket_ ||
+            pipe_adapter.get_read_fd () != pipe.get_read_fd ())  {
+            std::cout << "ERROR: adapter does not forward" << std::endl;
+            return (EXIT_FAILURE);
+        }
+        std::cout << "SUCCESS: CommunicationAdapter is working" << std::endl;
+
+        std::cout << "\n\tTesting socket moves and Acceptor ...\n"
+                  << std::endl;
+
+        std::vector<StaticSocket>   sockets;
+
+        sockets.push_back (std::move (left));
+        sockets.push_back (StaticSocket (right.release ()));
+        if (left.is_open () || right.is_open () ||
+            ! round_trip (sockets [0], sockets [1]))  {
+            std::cout << "ERROR: StaticSocket did not move" << std::endl;
+            return (EXIT_FAILURE);
+        }
+
+        if (! test_moves ())
+            return (EXIT_FAILURE);
+        std::cout << "SUCCESS: sockets move and Acceptor is working"
+                  << std::endl;
+    }
+    catch (const std::exception &ex)  {
+        std::cout << "Exception: " << ex.what () << std::endl;
+        return (EXIT_FAILURE);
+    }
+
+    return (EXIT_SUCCESS);
+}
+
+// ----------------------------------------------------------------------------
+
+// Local Variables:
+// mode:C++
+// tab-width:4
+// c-basic-offset:4
+// End: